@@ -1,6 +1,7 @@
 // ignore_for_file: non_constant_identifier_names, constant_identifier_names
 
 import 'dart:async';
+import 'dart:convert';
 import 'dart:ffi';
 import 'dart:io';
 import 'dart:isolate';
@@ -40,12 +41,171 @@ String mediaxx_get_label_malloc() {
   return str;
 }
 
+/// 请求取消句柄
+/// - 可在任意时刻调用 [cancel]，正在执行或排队中的请求都会尽快结束，返回 -2
+/// - 需要在所有使用它的请求结束后才能调用 [dispose]
+class MediaxxCancelToken {
+  final Pointer<Void> _ptr = _bindings.mediaxx_cancel_token_create();
+
+  bool _isDispose = false;
+
+  void cancel() {
+    assert(false == _isDispose);
+    _bindings.mediaxx_cancel_token_cancel(_ptr);
+  }
+
+  bool get isCancelled {
+    assert(false == _isDispose);
+    return _bindings.mediaxx_cancel_token_is_cancelled(_ptr) != 0;
+  }
+
+  void dispose() {
+    if (_isDispose) {
+      return;
+    }
+    _isDispose = true;
+    _bindings.mediaxx_cancel_token_free(_ptr);
+  }
+}
+
+Pointer<MediaxxRequestOptions> _createRequestOptions(
+  MediaxxCancelToken? cancelToken,
+  int timeoutMs, {
+  bool streamDetails = false,
+  int resultFormat = MEDIAXX_RESULT_FORMAT_JSON,
+  int fieldMask = 0,
+  int logMode = MEDIAXX_LOG_MODE_TEXT,
+  int maxTagSize = 0,
+}) {
+  final options = malloc<MediaxxRequestOptions>();
+  options.ref.cancelToken = cancelToken?._ptr ?? nullptr;
+  options.ref.timeoutMs = timeoutMs;
+  options.ref.streamDetails = streamDetails ? 1 : 0;
+  options.ref.resultFormat = resultFormat;
+  options.ref.fieldMask = fieldMask;
+  options.ref.logMode = logMode;
+  options.ref.maxTagSize = maxTagSize;
+  return options;
+}
+
+/// 二进制格式的音视频信息
+/// - 直接在原生内存上读取，不经过 json 编码和解析；布局见 [MediaxxInfoHeader]
+/// - 用完后需要调用 [dispose] 释放，之后不能再访问取出的结构体
+class MediaxxInfo {
+  final Pointer<MediaxxInfoHeader> _ptr;
+  // [_ptr] 所在的 [MediaxxResultBlock]，释放时整块释放
+  final Pointer<MediaxxResultBlock> _block;
+
+  bool _isDispose = false;
+
+  MediaxxInfo._(this._ptr, this._block) {
+    assert(_ptr.ref.magic == MEDIAXX_INFO_MAGIC);
+  }
+
+  Pointer<Uint8> get _base => _ptr.cast<Uint8>();
+
+  MediaxxInfoHeader get header {
+    assert(false == _isDispose);
+    return _ptr.ref;
+  }
+
+  /// 不存在时返回 null
+  String? string(MediaxxInfoString str) {
+    assert(false == _isDispose);
+    if (str.offset == 0) {
+      return null;
+    }
+    return (_base + str.offset).cast<Utf8>().toDartString(length: str.length);
+  }
+
+  String? get filename => string(header.filename);
+
+  String? get formatName => string(header.formatName);
+
+  int get streamCount => header.streamCount;
+
+  MediaxxInfoStream stream(int index) {
+    assert(index >= 0 && index < streamCount);
+    final header = this.header;
+    return (_base + header.streamOffset + index * header.streamSize)
+        .cast<MediaxxInfoStream>()
+        .ref;
+  }
+
+  /// 格式级别的标签；指定 [stream] 时为该流的标签
+  Map<String, String> tags([MediaxxInfoStream? stream]) {
+    final offset = stream?.tagOffset ?? header.tagOffset;
+    final count = stream?.tagCount ?? header.tagCount;
+    final tagPtr = (_base + offset).cast<MediaxxInfoTag>();
+    final result = <String, String>{};
+    for (int i = 0; i < count; ++i) {
+      final tag = (tagPtr + i).ref;
+      result[string(tag.key)!] = string(tag.value)!;
+    }
+    return result;
+  }
+
+  /// 值被截断的标签名 -> 完整长度（字节），范围同 [tags]；完整内容用 [mediaxx_get_tag] 获取
+  Map<String, int> truncatedTags([MediaxxInfoStream? stream]) {
+    final header = this.header;
+    final tagSize = sizeOf<MediaxxInfoTag>();
+    final offset = stream?.tagOffset ?? header.tagOffset;
+    final first = (offset - header.tagOffset) ~/ tagSize;
+    final count = stream?.tagCount ?? header.tagCount;
+    final truncPtr = (_base + header.truncatedTagOffset)
+        .cast<MediaxxInfoTruncatedTag>();
+    final tagPtr = (_base + header.tagOffset).cast<MediaxxInfoTag>();
+    final result = <String, int>{};
+    for (int i = 0; i < header.truncatedTagCount; ++i) {
+      final trunc = (truncPtr + i).ref;
+      if (trunc.tag >= first && trunc.tag < first + count) {
+        result[string((tagPtr + trunc.tag).ref.key)!] = trunc.length;
+      }
+    }
+    return result;
+  }
+
+  /// 规范化的标签，[MEDIAXX_TAG_TITLE] 等 -> 值；单值字段只有一个元素
+  /// - 需要请求 [MEDIAXX_FIELD_NORM_TAGS]
+  Map<int, List<String>> normalizedTags() {
+    final header = this.header;
+    final tagPtr = (_base + header.normTagOffset).cast<MediaxxInfoNormTag>();
+    final result = <int, List<String>>{};
+    for (int i = 0; i < header.normTagCount; ++i) {
+      final tag = (tagPtr + i).ref;
+      (result[tag.key] ??= <String>[]).add(string(tag.value)!);
+    }
+    return result;
+  }
+
+  void dispose() {
+    if (_isDispose) {
+      return;
+    }
+    _isDispose = true;
+    mediaxx_free(_block);
+  }
+}
+
+/// - [cancelToken] 可选，用于取消请求
+/// - [timeoutMs] 可选，整个请求的截止时长，<= 0 时不限制
+/// - [streamDetails] 可选，HLS/DASH 地址是否下载首个分段以获取编码详情
+/// - [fieldMask] 可选，[MEDIAXX_FIELD_FORMAT] 等的组合，只输出需要的部分，0 表示全部
+/// - [logMode] 可选，[MEDIAXX_LOG_MODE_RECORD] 时错误不生成文字日志，通过 [mediaxx_diag_drain] 取出
+/// - [maxTagSize] 可选，单个标签值的长度上限，见 [MediaxxRequestOptions.maxTagSize]；
+///   被截断的标签列在 json 的 `tags_truncated` 中，完整内容用 [mediaxx_get_tag] 获取
 Future<(int? ret, String? result, String? log)> mediaxx_get_media_info_malloc(
   String filepath,
   String headers,
   String pictureOutputPath,
-  String picture96OutputPath,
-) async {
+  String picture96OutputPath, {
+  MediaxxCancelToken? cancelToken,
+  int timeoutMs = 0,
+  bool streamDetails = false,
+  int fieldMask = 0,
+  int logMode = MEDIAXX_LOG_MODE_TEXT,
+  int maxTagSize = 0,
+}) async {
   final SendPort helperIsolateSendPort = await _helperIsolateSendPort;
   final int requestId = _nextAsyncxxRequestId++;
   final request = _AsyncxxRequestMediaInfo(
@@ -54,6 +214,14 @@ Future<(int? ret, String? result, String? log)> mediaxx_get_media_info_malloc(
     headers: headers,
     pictureOutputPath: pictureOutputPath,
     picture96OutputPath: picture96OutputPath,
+    optionsPtr: _createRequestOptions(
+      cancelToken,
+      timeoutMs,
+      streamDetails: streamDetails,
+      fieldMask: fieldMask,
+      logMode: logMode,
+      maxTagSize: maxTagSize,
+    ),
   );
   final completer = Completer<_AsyncxxResponseMediaInfo>();
   _asyncxxRequests[requestId] = completer;
@@ -62,12 +230,56 @@ Future<(int? ret, String? result, String? log)> mediaxx_get_media_info_malloc(
   return (result.ret, result.result, result.log);
 }
 
+/// 与 [mediaxx_get_media_info_malloc] 相同，但返回二进制格式，省去 json 的编码和解析
+/// - 返回的 [MediaxxInfo] 用完后需要调用 [MediaxxInfo.dispose]
+/// - HLS/DASH 播放列表只有格式信息，没有 `manifest` 部分
+Future<(int? ret, MediaxxInfo? info, String? log)> mediaxx_get_media_info_binary(
+  String filepath,
+  String headers,
+  String pictureOutputPath,
+  String picture96OutputPath, {
+  MediaxxCancelToken? cancelToken,
+  int timeoutMs = 0,
+  int fieldMask = 0,
+  int logMode = MEDIAXX_LOG_MODE_TEXT,
+  int maxTagSize = 0,
+}) async {
+  final SendPort helperIsolateSendPort = await _helperIsolateSendPort;
+  final int requestId = _nextAsyncxxRequestId++;
+  final request = _AsyncxxRequestMediaInfo(
+    requestId,
+    filepath: filepath,
+    headers: headers,
+    pictureOutputPath: pictureOutputPath,
+    picture96OutputPath: picture96OutputPath,
+    optionsPtr: _createRequestOptions(
+      cancelToken,
+      timeoutMs,
+      resultFormat: MEDIAXX_RESULT_FORMAT_BINARY,
+      fieldMask: fieldMask,
+      logMode: logMode,
+      maxTagSize: maxTagSize,
+    ),
+    isBinary: true,
+  );
+  final completer = Completer<_AsyncxxResponseMediaInfo>();
+  _asyncxxRequests[requestId] = completer;
+  helperIsolateSendPort.send(request);
+  final result = await completer.future;
+  return (result.ret, result.info, result.log);
+}
+
+/// - [cancelToken] 可选，用于取消请求
+/// - [timeoutMs] 可选，整个请求的截止时长，<= 0 时不限制
+/// - [ret] 同原生接口，-2 表示请求已取消或超时
 Future<(int ret, String? log)> mediaxx_get_media_picture(
   String filepath,
   String headers,
   String pictureOutputPath,
-  String picture96OutputPath,
-) async {
+  String picture96OutputPath, {
+  MediaxxCancelToken? cancelToken,
+  int timeoutMs = 0,
+}) async {
   final SendPort helperIsolateSendPort = await _helperIsolateSendPort;
   final int requestId = _nextAsyncxxRequestId++;
   final request = _AsyncxxRequestMediaPicture(
@@ -76,6 +288,7 @@ Future<(int ret, String? log)> mediaxx_get_media_picture(
     headers: headers,
     pictureOutputPath: pictureOutputPath,
     picture96OutputPath: picture96OutputPath,
+    optionsPtr: _createRequestOptions(cancelToken, timeoutMs),
   );
   final completer = Completer<_AsyncxxResponseDefault>();
   _asyncxxRequests[requestId] = completer;
@@ -96,7 +309,7 @@ Future<(int ret, String? result, String? log)> mediaxx_analyse_picture_color(
     filepath: filepath,
     data: data,
   );
-  final completer = Completer<_AsyncxxResponseMediaInfo>();
+  final completer = Completer<_AsyncxxResponseAnalysePictureColor>();
   _asyncxxRequests[requestId] = completer;
   helperIsolateSendPort.send(request);
   final result = await completer.future;
@@ -135,6 +348,1482 @@ mediaxx_analyse_picture_color_from_decoded_data(Uint8List data) {
   return (ret, resultStr, logstr);
 }
 
+/// 二进制格式的歌词
+/// - 直接在原生内存上读取；布局见 [MediaxxLyricsHeader]
+/// - 用完后需要调用 [dispose] 释放，之后不能再访问取出的结构体
+class MediaxxLyrics {
+  final Pointer<MediaxxLyricsHeader> _ptr;
+
+  bool _isDispose = false;
+
+  MediaxxLyrics._(this._ptr) {
+    assert(_ptr.ref.magic == MEDIAXX_LYRICS_MAGIC);
+  }
+
+  Pointer<Uint8> get _base => _ptr.cast<Uint8>();
+
+  MediaxxLyricsHeader get header {
+    assert(false == _isDispose);
+    return _ptr.ref;
+  }
+
+  /// 不存在时返回 null
+  String? string(MediaxxInfoString str) {
+    assert(false == _isDispose);
+    if (str.offset == 0) {
+      return null;
+    }
+    return (_base + str.offset).cast<Utf8>().toDartString(length: str.length);
+  }
+
+  /// [MEDIAXX_LYRICS_SOURCE_EMBEDDED] 等
+  int get source => header.source;
+
+  /// 歌词没有时间时的全文
+  String? get plainText => string(header.plainText);
+
+  String? get title => string(header.title);
+
+  String? get artist => string(header.artist);
+
+  String? get album => string(header.album);
+
+  int get lineCount => header.lineCount;
+
+  MediaxxLyricsLine line(int index) {
+    assert(index >= 0 && index < lineCount);
+    final header = this.header;
+    return (_base + header.lineOffset + index * header.lineSize)
+        .cast<MediaxxLyricsLine>()
+        .ref;
+  }
+
+  /// 空行返回空字符串
+  String lineText(int index) => string(line(index).text) ?? "";
+
+  /// 播放到 [positionMs] 时的当前行：时间不晚于 [positionMs] 的最后一行
+  /// - 行已按时间排序，二分查找；还没到第一行时返回 -1
+  int lineIndexAt(int positionMs) {
+    int low = 0;
+    int high = lineCount;
+    while (low < high) {
+      final mid = (low + high) >> 1;
+      if (line(mid).timeMs <= positionMs) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+    return low - 1;
+  }
+
+  void dispose() {
+    if (_isDispose) {
+      return;
+    }
+    _isDispose = true;
+    mediaxx_free(_ptr);
+  }
+}
+
+/// 获取歌词，查找顺序见 [MediaxxBindings.mediaxx_get_lyrics_malloc]
+/// - 在临时 isolate 中读取；返回的 [MediaxxLyrics] 用完后需要调用 [MediaxxLyrics.dispose]
+/// - [ret] 1 找到歌词，0 没有歌词，-1 无法打开，-2 已取消或超时
+Future<(int ret, MediaxxLyrics? lyrics, String? log)> mediaxx_get_lyrics(
+  String filepath, {
+  String headers = "",
+  MediaxxCancelToken? cancelToken,
+  int timeoutMs = 0,
+  int logMode = MEDIAXX_LOG_MODE_TEXT,
+}) async {
+  // 指针以地址传入 isolate，原生内存在进程内共享
+  final optionsAddress = _createRequestOptions(
+    cancelToken,
+    timeoutMs,
+    logMode: logMode,
+  ).address;
+  final (ret, resultAddress, log) = await Isolate.run(() {
+    final filepathPtr = filepath.toNativeUtf8().cast<Char>();
+    final headersPtr = headers.toNativeUtf8().cast<Char>();
+    final optionsPtr = Pointer<MediaxxRequestOptions>.fromAddress(
+      optionsAddress,
+    );
+    final Pointer<Pointer<Char>> result = malloc<Pointer<Char>>();
+    result.value = nullptr;
+    final Pointer<Pointer<Char>> log = malloc<Pointer<Char>>();
+    log.value = nullptr;
+
+    final ret = _bindings.mediaxx_get_lyrics_malloc(
+      filepathPtr,
+      headersPtr,
+      optionsPtr,
+      result,
+      log,
+    );
+    final resultPtr = result.value;
+    final logPtr = log.value;
+
+    malloc.free(filepathPtr);
+    malloc.free(headersPtr);
+    malloc.free(optionsPtr);
+    malloc.free(result);
+    malloc.free(log);
+
+    final logStr = logPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(logPtr);
+    return (ret, resultPtr.address, logStr);
+  });
+  final lyrics = (0 != resultAddress)
+      ? MediaxxLyrics._(Pointer<MediaxxLyricsHeader>.fromAddress(resultAddress))
+      : null;
+  return (ret, lyrics, log);
+}
+
+/// 获取一个标签的完整内容，用于信息中被截断的标签，见 [MediaxxBindings.mediaxx_get_tag_malloc]
+/// - [streamIndex] 流的下标，< 0 时为格式级别的标签
+/// - [ret] 1 找到，0 没有该标签，-1 无法打开，-2 已取消或超时
+Future<(int ret, String? value, String? log)> mediaxx_get_tag(
+  String filepath,
+  String key, {
+  String headers = "",
+  int streamIndex = -1,
+  MediaxxCancelToken? cancelToken,
+  int timeoutMs = 0,
+  int logMode = MEDIAXX_LOG_MODE_TEXT,
+}) async {
+  // 指针以地址传入 isolate，原生内存在进程内共享
+  final optionsAddress = _createRequestOptions(
+    cancelToken,
+    timeoutMs,
+    logMode: logMode,
+  ).address;
+  return await Isolate.run(() {
+    final filepathPtr = filepath.toNativeUtf8().cast<Char>();
+    final headersPtr = headers.toNativeUtf8().cast<Char>();
+    final keyPtr = key.toNativeUtf8().cast<Char>();
+    final optionsPtr = Pointer<MediaxxRequestOptions>.fromAddress(
+      optionsAddress,
+    );
+    final Pointer<Pointer<Char>> result = malloc<Pointer<Char>>();
+    result.value = nullptr;
+    final Pointer<Pointer<Char>> log = malloc<Pointer<Char>>();
+    log.value = nullptr;
+
+    final ret = _bindings.mediaxx_get_tag_malloc(
+      filepathPtr,
+      headersPtr,
+      keyPtr,
+      streamIndex,
+      optionsPtr,
+      result,
+      log,
+    );
+    final resultPtr = result.value;
+    final logPtr = log.value;
+
+    malloc.free(filepathPtr);
+    malloc.free(headersPtr);
+    malloc.free(keyPtr);
+    malloc.free(optionsPtr);
+    malloc.free(result);
+    malloc.free(log);
+
+    final value = resultPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(resultPtr);
+    final logStr = logPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(logPtr);
+    return (ret, value, logStr);
+  });
+}
+
+/// 波形文件，格式见 [MediaxxWaveformHeader]
+/// - 在 Dart 的字节数据上直接读取，不需要释放
+class MediaxxWaveform {
+  // [MediaxxWaveformHeader.levels] 的偏移和每项的长度
+  static const _levelsOffset = 32;
+  static const _levelSize = 12;
+
+  final ByteData _data;
+
+  MediaxxWaveform._(this._data);
+
+  /// 不是波形文件时返回 null
+  static MediaxxWaveform? fromBytes(Uint8List bytes) {
+    if (bytes.lengthInBytes < sizeOf<MediaxxWaveformHeader>()) {
+      return null;
+    }
+    final data = ByteData.sublistView(bytes);
+    if (data.getUint32(0, Endian.host) != MEDIAXX_WAVEFORM_MAGIC ||
+        data.getUint32(8, Endian.host) > bytes.lengthInBytes) {
+      return null;
+    }
+    return MediaxxWaveform._(data);
+  }
+
+  int get sampleRate => _data.getUint32(12, Endian.host);
+
+  /// 源的声道数
+  int get channels => _data.getUint32(16, Endian.host);
+
+  int get levelCount => _data.getUint32(20, Endian.host);
+
+  int get totalSamples => _data.getUint64(24, Endian.host);
+
+  Duration get duration => Duration(
+    microseconds: sampleRate > 0 ? totalSamples * 1000000 ~/ sampleRate : 0,
+  );
+
+  int _levelField(int level, int field) {
+    assert(level >= 0 && level < levelCount);
+    return _data.getUint32(
+      _levelsOffset + level * _levelSize + field * 4,
+      Endian.host,
+    );
+  }
+
+  int samplesPerPoint(int level) => _levelField(level, 0);
+
+  int pointCount(int level) => _levelField(level, 1);
+
+  /// 点数不少于 [minPoints] 的最粗一级；都不够时为第 0 级
+  int levelFor(int minPoints) {
+    for (int level = levelCount - 1; level > 0; --level) {
+      if (pointCount(level) >= minPoints) {
+        return level;
+      }
+    }
+    return 0;
+  }
+
+  int _pointOffset(int level, int index) {
+    assert(index >= 0 && index < pointCount(level));
+    return _levelField(level, 2) + index * sizeOf<MediaxxWaveformPoint>();
+  }
+
+  /// -1.0 ~ 1.0
+  double min(int level, int index) =>
+      _data.getInt8(_pointOffset(level, index)) / 127;
+
+  /// -1.0 ~ 1.0
+  double max(int level, int index) =>
+      _data.getInt8(_pointOffset(level, index) + 1) / 127;
+
+  /// 0 ~ 1.0
+  double rms(int level, int index) =>
+      _data.getUint8(_pointOffset(level, index) + 2) / 255;
+}
+
+/// 生成音频的波形文件，见 [MediaxxBindings.mediaxx_get_audio_visualization]
+/// - 在临时 isolate 中解码；生成后用 [MediaxxWaveform.fromBytes] 读取
+/// - [ret] 1 成功，0 没有可解码的音频，-1 无法打开或无法写入，-2 已取消或超时
+Future<(int ret, String? log)> mediaxx_get_audio_visualization(
+  String filepath,
+  String outputPath, {
+  String headers = "",
+  MediaxxCancelToken? cancelToken,
+  int timeoutMs = 0,
+  int logMode = MEDIAXX_LOG_MODE_TEXT,
+}) async {
+  // 指针以地址传入 isolate，原生内存在进程内共享
+  final optionsAddress = _createRequestOptions(
+    cancelToken,
+    timeoutMs,
+    logMode: logMode,
+  ).address;
+  return await Isolate.run(() {
+    final filepathPtr = filepath.toNativeUtf8().cast<Char>();
+    final headersPtr = headers.toNativeUtf8().cast<Char>();
+    final outputPathPtr = outputPath.toNativeUtf8().cast<Char>();
+    final optionsPtr = Pointer<MediaxxRequestOptions>.fromAddress(
+      optionsAddress,
+    );
+    final Pointer<Pointer<Char>> log = malloc<Pointer<Char>>();
+    log.value = nullptr;
+
+    final ret = _bindings.mediaxx_get_audio_visualization(
+      filepathPtr,
+      headersPtr,
+      outputPathPtr,
+      optionsPtr,
+      log,
+    );
+    final logPtr = log.value;
+
+    malloc.free(filepathPtr);
+    malloc.free(headersPtr);
+    malloc.free(outputPathPtr);
+    malloc.free(optionsPtr);
+    malloc.free(log);
+
+    final logStr = logPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(logPtr);
+    return (ret, logStr);
+  });
+}
+
+/// 频谱文件，格式见 [MediaxxSpectrumHeader]
+/// - 在 Dart 的字节数据上直接读取，不需要释放
+class MediaxxSpectrum {
+  final ByteData _data;
+
+  MediaxxSpectrum._(this._data);
+
+  /// 不是频谱文件时返回 null
+  static MediaxxSpectrum? fromBytes(Uint8List bytes) {
+    if (bytes.lengthInBytes < sizeOf<MediaxxSpectrumHeader>()) {
+      return null;
+    }
+    final data = ByteData.sublistView(bytes);
+    if (data.getUint32(0, Endian.host) != MEDIAXX_SPECTRUM_MAGIC ||
+        data.getUint32(8, Endian.host) > bytes.lengthInBytes) {
+      return null;
+    }
+    return MediaxxSpectrum._(data);
+  }
+
+  int get sampleRate => _data.getUint32(12, Endian.host);
+
+  int get fftSize => _data.getUint32(16, Endian.host);
+
+  int get hopSize => _data.getUint32(20, Endian.host);
+
+  int get bandCount => _data.getUint32(24, Endian.host);
+
+  int get frameCount => _data.getUint32(28, Endian.host);
+
+  double get minDb => _data.getFloat32(32, Endian.host);
+
+  double get maxDb => _data.getFloat32(36, Endian.host);
+
+  /// 第 [frame] 帧的中心时间
+  Duration frameTime(int frame) => Duration(
+    microseconds: sampleRate > 0
+        ? (frame * hopSize + fftSize ~/ 2) * 1000000 ~/ sampleRate
+        : 0,
+  );
+
+  /// 第 [band] 个频带的下边界（Hz）；[band] 为 [bandCount] 时为最后一个频带的上边界
+  double bandEdge(int band) {
+    assert(band >= 0 && band <= bandCount);
+    return _data.getFloat32(
+      _data.getUint32(40, Endian.host) + band * 4,
+      Endian.host,
+    );
+  }
+
+  /// 0 ~ 1.0，对应 [minDb] ~ [maxDb]
+  double level(int frame, int band) {
+    assert(frame >= 0 && frame < frameCount);
+    assert(band >= 0 && band < bandCount);
+    return _data.getUint8(
+          _data.getUint32(44, Endian.host) + frame * bandCount + band,
+        ) /
+        255;
+  }
+
+  /// 能量（dBFS）
+  double db(int frame, int band) =>
+      minDb + level(frame, band) * (maxDb - minDb);
+}
+
+/// 生成音频的频谱文件，见 [MediaxxBindings.mediaxx_get_audio_spectrum]
+/// - 参数为 0 时使用默认值，见 [MediaxxSpectrumOptions]
+/// - 在临时 isolate 中解码；生成后用 [MediaxxSpectrum.fromBytes] 读取
+/// - [ret] 同 [mediaxx_get_audio_visualization]
+Future<(int ret, String? log)> mediaxx_get_audio_spectrum(
+  String filepath,
+  String outputPath, {
+  int sampleRate = 0,
+  int fftSize = 0,
+  int hopSize = 0,
+  int bandCount = 0,
+  double minFreq = 0,
+  double maxFreq = 0,
+  String headers = "",
+  MediaxxCancelToken? cancelToken,
+  int timeoutMs = 0,
+  int logMode = MEDIAXX_LOG_MODE_TEXT,
+}) async {
+  final spectrum = malloc<MediaxxSpectrumOptions>();
+  spectrum.ref
+    ..sampleRate = sampleRate
+    ..fftSize = fftSize
+    ..hopSize = hopSize
+    ..bandCount = bandCount
+    ..minFreq = minFreq
+    ..maxFreq = maxFreq;
+  final spectrumAddress = spectrum.address;
+  final optionsAddress = _createRequestOptions(
+    cancelToken,
+    timeoutMs,
+    logMode: logMode,
+  ).address;
+  return await Isolate.run(() {
+    final filepathPtr = filepath.toNativeUtf8().cast<Char>();
+    final headersPtr = headers.toNativeUtf8().cast<Char>();
+    final outputPathPtr = outputPath.toNativeUtf8().cast<Char>();
+    final spectrumPtr = Pointer<MediaxxSpectrumOptions>.fromAddress(
+      spectrumAddress,
+    );
+    final optionsPtr = Pointer<MediaxxRequestOptions>.fromAddress(
+      optionsAddress,
+    );
+    final Pointer<Pointer<Char>> log = malloc<Pointer<Char>>();
+    log.value = nullptr;
+
+    final ret = _bindings.mediaxx_get_audio_spectrum(
+      filepathPtr,
+      headersPtr,
+      outputPathPtr,
+      spectrumPtr,
+      optionsPtr,
+      log,
+    );
+    final logPtr = log.value;
+
+    malloc.free(filepathPtr);
+    malloc.free(headersPtr);
+    malloc.free(outputPathPtr);
+    malloc.free(spectrumPtr);
+    malloc.free(optionsPtr);
+    malloc.free(log);
+
+    final logStr = logPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(logPtr);
+    return (ret, logStr);
+  });
+}
+
+/// 实时可视化，见 [MediaxxBindings.mediaxx_visualizer_create]
+/// - 播放器在音频线程中调用 [push]，UI 每帧调用 [poll] 后读取 [snapshot]
+/// - [push] 和 [poll] 各自只能在一个线程中调用；用完后需要调用 [dispose]
+class MediaxxVisualizer {
+  final Pointer<Void> _handle;
+  final int channels;
+  final Pointer<MediaxxVisualizerSnapshot> _snapshot =
+      calloc<MediaxxVisualizerSnapshot>();
+  // [push] 复用的原生缓冲区，不够时才重新分配
+  Pointer<Float> _buffer = nullptr;
+  int _bufferLength = 0;
+  bool _isDispose = false;
+
+  MediaxxVisualizer._(this._handle, this.channels);
+
+  /// 参数为 0 时使用默认值，见 [MediaxxVisualizerOptions]；参数错误时抛出 [ArgumentError]
+  factory MediaxxVisualizer({
+    required int sampleRate,
+    required int channels,
+    int fftSize = 0,
+    int bandCount = 0,
+    int frameRate = 0,
+    int bufferMs = 0,
+    double minFreq = 0,
+    double maxFreq = 0,
+  }) {
+    final options = malloc<MediaxxVisualizerOptions>();
+    options.ref
+      ..sampleRate = sampleRate
+      ..channels = channels
+      ..fftSize = fftSize
+      ..bandCount = bandCount
+      ..frameRate = frameRate
+      ..bufferMs = bufferMs
+      ..minFreq = minFreq
+      ..maxFreq = maxFreq;
+    final Pointer<Pointer<Char>> log = malloc<Pointer<Char>>();
+    log.value = nullptr;
+
+    final handle = _bindings.mediaxx_visualizer_create(options, log);
+    final logPtr = log.value;
+
+    malloc.free(options);
+    malloc.free(log);
+    final logStr = logPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(logPtr);
+    if (nullptr == handle) {
+      throw ArgumentError(logStr);
+    }
+    return MediaxxVisualizer._(handle, channels);
+  }
+
+  /// 推入交错排列的 PCM，返回实际写入的帧数
+  int push(Float32List samples) {
+    assert(false == _isDispose);
+    if (samples.length > _bufferLength) {
+      if (nullptr != _buffer) {
+        malloc.free(_buffer);
+      }
+      _buffer = malloc<Float>(samples.length);
+      _bufferLength = samples.length;
+    }
+    _buffer.asTypedList(samples.length).setAll(0, samples);
+    return _bindings.mediaxx_visualizer_push(
+      _handle,
+      _buffer,
+      samples.length ~/ channels,
+    );
+  }
+
+  /// 推入原生内存中的 PCM，不经过复制
+  int pushNative(Pointer<Float> samples, int frames) {
+    assert(false == _isDispose);
+    return _bindings.mediaxx_visualizer_push(_handle, samples, frames);
+  }
+
+  /// 丢弃还未分析的采样，如跳转后；需要在调用 [push] 的线程中调用
+  void reset() {
+    assert(false == _isDispose);
+    _bindings.mediaxx_visualizer_reset(_handle);
+  }
+
+  /// 更新 [snapshot]，返回是否有新的结果
+  bool poll() {
+    assert(false == _isDispose);
+    return _bindings.mediaxx_visualizer_poll(_handle, _snapshot) != 0;
+  }
+
+  /// 最近一次 [poll] 的结果，下一次 [poll] 时被覆盖
+  MediaxxVisualizerSnapshot get snapshot => _snapshot.ref;
+
+  /// 第 [band] 个频带的能量（dBFS）
+  double band(int band) {
+    assert(band >= 0 && band < _snapshot.ref.bandCount);
+    return _snapshot.ref.bands[band];
+  }
+
+  void dispose() {
+    if (_isDispose) {
+      return;
+    }
+    _isDispose = true;
+    _bindings.mediaxx_visualizer_free(_handle);
+    calloc.free(_snapshot);
+    if (nullptr != _buffer) {
+      malloc.free(_buffer);
+    }
+  }
+}
+
+/// PCM 解码会话，见 [MediaxxBindings.mediaxx_decoder_open]
+/// - 用 [open] 在临时 isolate 中打开；[read]、[seek] 是同步调用，网络文件可能阻塞，
+///   可以把整个会话放到单独的 isolate 中使用
+/// - [readNative] 直接写入调用方的原生内存，不经过复制
+/// - 用完后需要调用 [dispose] 释放；打开时传入的 [MediaxxCancelToken] 需要保持有效直到释放
+class MediaxxDecoder {
+  final Pointer<Void> _handle;
+  final Pointer<MediaxxDecoderInfo> _info = calloc<MediaxxDecoderInfo>();
+  // [read] 复用的原生缓冲区，不够时才重新分配
+  Pointer<Float> _buffer = nullptr;
+  int _bufferFrames = 0;
+  bool _isDispose = false;
+
+  /// 输出的采样率和声道数
+  late final int sampleRate;
+  late final int channels;
+
+  MediaxxDecoder._(this._handle) {
+    _bindings.mediaxx_decoder_get_info(_handle, _info);
+    sampleRate = _info.ref.sampleRate;
+    channels = _info.ref.channels;
+  }
+
+  /// [sampleRate]、[channels] 为 0 时与源相同；失败时 [decoder] 为空，原因见 [log]
+  static Future<(MediaxxDecoder? decoder, String? log)> open(
+    String filepath, {
+    int sampleRate = 0,
+    int channels = 0,
+    String headers = "",
+    MediaxxCancelToken? cancelToken,
+    int timeoutMs = 0,
+    int logMode = MEDIAXX_LOG_MODE_TEXT,
+  }) async {
+    final optionsAddress = _createRequestOptions(
+      cancelToken,
+      timeoutMs,
+      logMode: logMode,
+    ).address;
+    final (address, logStr) = await Isolate.run(() {
+      final filepathPtr = filepath.toNativeUtf8().cast<Char>();
+      final headersPtr = headers.toNativeUtf8().cast<Char>();
+      final optionsPtr = Pointer<MediaxxRequestOptions>.fromAddress(
+        optionsAddress,
+      );
+      final Pointer<Pointer<Char>> log = malloc<Pointer<Char>>();
+      log.value = nullptr;
+
+      final handle = _bindings.mediaxx_decoder_open(
+        filepathPtr,
+        headersPtr,
+        sampleRate,
+        channels,
+        optionsPtr,
+        log,
+      );
+      final logPtr = log.value;
+
+      malloc.free(filepathPtr);
+      malloc.free(headersPtr);
+      malloc.free(optionsPtr);
+      malloc.free(log);
+
+      final logStr = logPtr.cast<Utf8>().tryToDartString();
+      mediaxx_free(logPtr);
+      return (handle.address, logStr);
+    });
+    if (0 == address) {
+      return (null, logStr);
+    }
+    return (MediaxxDecoder._(Pointer<Void>.fromAddress(address)), logStr);
+  }
+
+  /// 当前的参数和位置
+  MediaxxDecoderInfo get info {
+    assert(false == _isDispose);
+    _bindings.mediaxx_decoder_get_info(_handle, _info);
+    return _info.ref;
+  }
+
+  /// 读取最多 [frames] 帧，返回交错排列的采样；已结束时为空，失败或取消时返回 null
+  Float32List? read(int frames) {
+    assert(false == _isDispose);
+    if (frames > _bufferFrames) {
+      if (nullptr != _buffer) {
+        malloc.free(_buffer);
+      }
+      _buffer = malloc<Float>(frames * channels);
+      _bufferFrames = frames;
+    }
+    final ret = _bindings.mediaxx_decoder_read(_handle, _buffer, frames);
+    if (ret < 0) {
+      return null;
+    }
+    return Float32List.fromList(_buffer.asTypedList(ret * channels));
+  }
+
+  /// 读取到原生内存 [dst]，至少 [frames] * [channels] 个 float
+  /// - 返回值同 [MediaxxBindings.mediaxx_decoder_read]
+  int readNative(Pointer<Float> dst, int frames) {
+    assert(false == _isDispose);
+    return _bindings.mediaxx_decoder_read(_handle, dst, frames);
+  }
+
+  /// 跳转到第 [frame] 帧（输出采样率下的序号），精确到采样；不能跳转或已取消时返回 false
+  bool seek(int frame) {
+    assert(false == _isDispose);
+    return _bindings.mediaxx_decoder_seek(_handle, frame) == 1;
+  }
+
+  /// 用会话已打开的文件提取片段到 [outputPath]，见
+  /// [MediaxxBindings.mediaxx_decoder_extract_clip_malloc]
+  /// - 同步调用，与 [read] 一样可能阻塞；结束后回到原来的位置
+  /// - [result] 同 [mediaxx_extract_clip]
+  (int ret, String? result, String? log) extractClip(
+    String outputPath, {
+    required int startMs,
+    required int durationMs,
+    bool accurate = false,
+  }) {
+    assert(false == _isDispose);
+    final outputPathPtr = outputPath.toNativeUtf8().cast<Char>();
+    final Pointer<Pointer<Char>> result = malloc<Pointer<Char>>();
+    result.value = nullptr;
+    final Pointer<Pointer<Char>> log = malloc<Pointer<Char>>();
+    log.value = nullptr;
+
+    final ret = _bindings.mediaxx_decoder_extract_clip_malloc(
+      _handle,
+      outputPathPtr,
+      startMs,
+      durationMs,
+      accurate ? 1 : 0,
+      result,
+      log,
+    );
+    final resultPtr = result.value;
+    final logPtr = log.value;
+
+    malloc.free(outputPathPtr);
+    malloc.free(result);
+    malloc.free(log);
+
+    final resultStr = resultPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(resultPtr);
+    final logStr = logPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(logPtr);
+    return (ret, resultStr, logStr);
+  }
+
+  void dispose() {
+    if (_isDispose) {
+      return;
+    }
+    _isDispose = true;
+    _bindings.mediaxx_decoder_free(_handle);
+    calloc.free(_info);
+    if (nullptr != _buffer) {
+      malloc.free(_buffer);
+    }
+  }
+}
+
+/// 批量扫描响度，计算 ReplayGain 2.0 增益，见 [MediaxxBindings.mediaxx_scan_loudness_malloc]
+/// - [albums] 可选，与 [paths] 等长，相同的非空字符串为同一专辑
+/// - 在临时 isolate 中调用，原生侧在线程池中并行扫描
+/// - [count] 为成功扫描的数量，参数错误为 -1；[result] 为 json，每项的 `loudness` 可以直接合并到缓存的信息中
+Future<(int count, String? result, String? log)> mediaxx_scan_loudness(
+  List<String> paths, {
+  List<String>? albums,
+  String headers = "",
+  int threadCount = 0,
+  MediaxxCancelToken? cancelToken,
+  int timeoutMs = 0,
+  int logMode = MEDIAXX_LOG_MODE_TEXT,
+}) async {
+  final optionsAddress = _createRequestOptions(
+    cancelToken,
+    timeoutMs,
+    logMode: logMode,
+  ).address;
+  final pathsJson = jsonEncode(paths);
+  final albumsJson = null != albums ? jsonEncode(albums) : null;
+  return await Isolate.run(() {
+    final pathsPtr = pathsJson.toNativeUtf8().cast<Char>();
+    final albumsPtr = albumsJson?.toNativeUtf8().cast<Char>() ?? nullptr;
+    final headersPtr = headers.toNativeUtf8().cast<Char>();
+    final optionsPtr = Pointer<MediaxxRequestOptions>.fromAddress(
+      optionsAddress,
+    );
+    final Pointer<Pointer<Char>> result = malloc<Pointer<Char>>();
+    result.value = nullptr;
+    final Pointer<Pointer<Char>> log = malloc<Pointer<Char>>();
+    log.value = nullptr;
+
+    final count = _bindings.mediaxx_scan_loudness_malloc(
+      pathsPtr,
+      albumsPtr,
+      headersPtr,
+      threadCount,
+      optionsPtr,
+      result,
+      log,
+    );
+    final resultPtr = result.value;
+    final logPtr = log.value;
+
+    malloc.free(pathsPtr);
+    if (nullptr != albumsPtr) {
+      malloc.free(albumsPtr);
+    }
+    malloc.free(headersPtr);
+    malloc.free(optionsPtr);
+    malloc.free(result);
+    malloc.free(log);
+
+    final resultStr = resultPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(resultPtr);
+    final logStr = logPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(logPtr);
+    return (count, resultStr, logStr);
+  });
+}
+
+/// 批量检测节拍（BPM）和调性，见 [MediaxxBindings.mediaxx_scan_rhythm_malloc]
+/// - 每个文件只解码中间的 60s，适合在后台扫描媒体库时使用
+/// - 在临时 isolate 中调用，原生侧在线程池中并行分析
+/// - [count] 为成功分析的数量，参数错误为 -1；[result] 为 json，每项的 `rhythm` 可以直接合并到缓存的信息中
+Future<(int count, String? result, String? log)> mediaxx_scan_rhythm(
+  List<String> paths, {
+  String headers = "",
+  int threadCount = 0,
+  MediaxxCancelToken? cancelToken,
+  int timeoutMs = 0,
+  int logMode = MEDIAXX_LOG_MODE_TEXT,
+}) async {
+  final optionsAddress = _createRequestOptions(
+    cancelToken,
+    timeoutMs,
+    logMode: logMode,
+  ).address;
+  final pathsJson = jsonEncode(paths);
+  return await Isolate.run(() {
+    final pathsPtr = pathsJson.toNativeUtf8().cast<Char>();
+    final headersPtr = headers.toNativeUtf8().cast<Char>();
+    final optionsPtr = Pointer<MediaxxRequestOptions>.fromAddress(
+      optionsAddress,
+    );
+    final Pointer<Pointer<Char>> result = malloc<Pointer<Char>>();
+    result.value = nullptr;
+    final Pointer<Pointer<Char>> log = malloc<Pointer<Char>>();
+    log.value = nullptr;
+
+    final count = _bindings.mediaxx_scan_rhythm_malloc(
+      pathsPtr,
+      headersPtr,
+      threadCount,
+      optionsPtr,
+      result,
+      log,
+    );
+    final resultPtr = result.value;
+    final logPtr = log.value;
+
+    malloc.free(pathsPtr);
+    malloc.free(headersPtr);
+    malloc.free(optionsPtr);
+    malloc.free(result);
+    malloc.free(log);
+
+    final resultStr = resultPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(resultPtr);
+    final logStr = logPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(logPtr);
+    return (count, resultStr, logStr);
+  });
+}
+
+/// 批量检测首尾的静音，见 [MediaxxBindings.mediaxx_scan_silence_malloc]
+/// - 只解码开头和结尾，适合在扫描媒体库时使用
+/// - 在临时 isolate 中调用，原生侧在线程池中并行检测
+/// - [count] 为成功检测的数量，参数错误为 -1；[result] 为 json，每项的 `silence` 为有声部分的精确位置
+Future<(int count, String? result, String? log)> mediaxx_scan_silence(
+  List<String> paths, {
+  double thresholdDb = 0,
+  int windowMs = 0,
+  String headers = "",
+  int threadCount = 0,
+  MediaxxCancelToken? cancelToken,
+  int timeoutMs = 0,
+  int logMode = MEDIAXX_LOG_MODE_TEXT,
+}) async {
+  final optionsAddress = _createRequestOptions(
+    cancelToken,
+    timeoutMs,
+    logMode: logMode,
+  ).address;
+  final pathsJson = jsonEncode(paths);
+  return await Isolate.run(() {
+    final pathsPtr = pathsJson.toNativeUtf8().cast<Char>();
+    final headersPtr = headers.toNativeUtf8().cast<Char>();
+    final optionsPtr = Pointer<MediaxxRequestOptions>.fromAddress(
+      optionsAddress,
+    );
+    final Pointer<Pointer<Char>> result = malloc<Pointer<Char>>();
+    result.value = nullptr;
+    final Pointer<Pointer<Char>> log = malloc<Pointer<Char>>();
+    log.value = nullptr;
+
+    final count = _bindings.mediaxx_scan_silence_malloc(
+      pathsPtr,
+      headersPtr,
+      thresholdDb,
+      windowMs,
+      threadCount,
+      optionsPtr,
+      result,
+      log,
+    );
+    final resultPtr = result.value;
+    final logPtr = log.value;
+
+    malloc.free(pathsPtr);
+    malloc.free(headersPtr);
+    malloc.free(optionsPtr);
+    malloc.free(result);
+    malloc.free(log);
+
+    final resultStr = resultPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(resultPtr);
+    final logStr = logPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(logPtr);
+    return (count, resultStr, logStr);
+  });
+}
+
+/// 批量扫描 MP3/ADTS AAC 的精确时长，见 [MediaxxBindings.mediaxx_scan_exact_duration_malloc]
+/// - 只解析帧头，不解码；只支持本地文件
+/// - 在临时 isolate 中调用，原生侧在线程池中并行扫描
+/// - [count] 为成功扫描的数量，参数错误为 -1；[result] 为 json，每项的 `exact` 为精确的采样数和无缝播放信息
+Future<(int count, String? result, String? log)> mediaxx_scan_exact_duration(
+  List<String> paths, {
+  int threadCount = 0,
+  MediaxxCancelToken? cancelToken,
+  int timeoutMs = 0,
+  int logMode = MEDIAXX_LOG_MODE_TEXT,
+}) async {
+  final optionsAddress = _createRequestOptions(
+    cancelToken,
+    timeoutMs,
+    logMode: logMode,
+  ).address;
+  final pathsJson = jsonEncode(paths);
+  return await Isolate.run(() {
+    final pathsPtr = pathsJson.toNativeUtf8().cast<Char>();
+    final optionsPtr = Pointer<MediaxxRequestOptions>.fromAddress(
+      optionsAddress,
+    );
+    final Pointer<Pointer<Char>> result = malloc<Pointer<Char>>();
+    result.value = nullptr;
+    final Pointer<Pointer<Char>> log = malloc<Pointer<Char>>();
+    log.value = nullptr;
+
+    final count = _bindings.mediaxx_scan_exact_duration_malloc(
+      pathsPtr,
+      threadCount,
+      optionsPtr,
+      result,
+      log,
+    );
+    final resultPtr = result.value;
+    final logPtr = log.value;
+
+    malloc.free(pathsPtr);
+    malloc.free(optionsPtr);
+    malloc.free(result);
+    malloc.free(log);
+
+    final resultStr = resultPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(resultPtr);
+    final logStr = logPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(logPtr);
+    return (count, resultStr, logStr);
+  });
+}
+
+/// 提取片段到 [outputPath]，见 [MediaxxBindings.mediaxx_extract_clip_malloc]
+///
+/// [result] 成功时为 json 对象 `{"start", "duration", "packets", "reencoded"}`
+Future<(int ret, String? result, String? log)> mediaxx_extract_clip(
+  String filepath,
+  String outputPath, {
+  required int startMs,
+  required int durationMs,
+  bool accurate = false,
+  String headers = "",
+  MediaxxCancelToken? cancelToken,
+  int timeoutMs = 0,
+  int logMode = MEDIAXX_LOG_MODE_TEXT,
+}) async {
+  final optionsAddress = _createRequestOptions(
+    cancelToken,
+    timeoutMs,
+    logMode: logMode,
+  ).address;
+  return await Isolate.run(() {
+    final filepathPtr = filepath.toNativeUtf8().cast<Char>();
+    final headersPtr = headers.toNativeUtf8().cast<Char>();
+    final outputPathPtr = outputPath.toNativeUtf8().cast<Char>();
+    final optionsPtr = Pointer<MediaxxRequestOptions>.fromAddress(
+      optionsAddress,
+    );
+    final Pointer<Pointer<Char>> result = malloc<Pointer<Char>>();
+    result.value = nullptr;
+    final Pointer<Pointer<Char>> log = malloc<Pointer<Char>>();
+    log.value = nullptr;
+
+    final ret = _bindings.mediaxx_extract_clip_malloc(
+      filepathPtr,
+      headersPtr,
+      outputPathPtr,
+      startMs,
+      durationMs,
+      accurate ? 1 : 0,
+      optionsPtr,
+      result,
+      log,
+    );
+    final resultPtr = result.value;
+    final logPtr = log.value;
+
+    malloc.free(filepathPtr);
+    malloc.free(headersPtr);
+    malloc.free(outputPathPtr);
+    malloc.free(optionsPtr);
+    malloc.free(result);
+    malloc.free(log);
+
+    final resultStr = resultPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(resultPtr);
+    final logStr = logPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(logPtr);
+    return (ret, resultStr, logStr);
+  });
+}
+
+/// 生成声学指纹，见 [MediaxxBindings.mediaxx_get_fingerprint_malloc]
+/// - 在临时 isolate 中调用；[hashes] 可以保存下来，下次启动时重新插入 [MediaxxFingerprintIndex]
+/// - [ret] 同原生接口：1 成功，0 没有音频或过短，-1 无法打开，-2 已取消或超时
+Future<(int ret, Uint32List? hashes, String? log)> mediaxx_get_fingerprint(
+  String filepath, {
+  int seconds = 0,
+  String headers = "",
+  MediaxxCancelToken? cancelToken,
+  int timeoutMs = 0,
+  int logMode = MEDIAXX_LOG_MODE_TEXT,
+}) async {
+  final optionsAddress = _createRequestOptions(
+    cancelToken,
+    timeoutMs,
+    logMode: logMode,
+  ).address;
+  return await Isolate.run(() {
+    final filepathPtr = filepath.toNativeUtf8().cast<Char>();
+    final headersPtr = headers.toNativeUtf8().cast<Char>();
+    final optionsPtr = Pointer<MediaxxRequestOptions>.fromAddress(
+      optionsAddress,
+    );
+    final Pointer<Pointer<Char>> result = malloc<Pointer<Char>>();
+    result.value = nullptr;
+    final Pointer<Int> count = malloc<Int>();
+    count.value = 0;
+    final Pointer<Pointer<Char>> log = malloc<Pointer<Char>>();
+    log.value = nullptr;
+
+    final ret = _bindings.mediaxx_get_fingerprint_malloc(
+      filepathPtr,
+      headersPtr,
+      seconds,
+      optionsPtr,
+      result,
+      count,
+      log,
+    );
+    final resultPtr = result.value;
+    final hashCount = count.value;
+    final logPtr = log.value;
+
+    malloc.free(filepathPtr);
+    malloc.free(headersPtr);
+    malloc.free(optionsPtr);
+    malloc.free(result);
+    malloc.free(count);
+    malloc.free(log);
+
+    Uint32List? hashes;
+    if (ret == 1 && hashCount > 0 && nullptr != resultPtr) {
+      hashes = Uint32List.fromList(
+        resultPtr.cast<Uint32>().asTypedList(hashCount),
+      );
+    }
+    mediaxx_free(resultPtr);
+    final logStr = logPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(logPtr);
+    return (ret, hashes, logStr);
+  });
+}
+
+/// 复制 [hashes] 到原生内存，需要调用方释放
+Pointer<UnsignedInt> _copyHashes(Uint32List hashes) {
+  final ptr = malloc<Uint32>(hashes.isEmpty ? 1 : hashes.length);
+  ptr.asTypedList(hashes.length).setAll(0, hashes);
+  return ptr.cast<UnsignedInt>();
+}
+
+/// 比较两个指纹，见 [MediaxxBindings.mediaxx_fingerprint_compare]
+/// - [offset] 为 [b] 相对 [a] 的帧偏移
+(double similarity, int offset) mediaxx_fingerprint_compare(
+  Uint32List a,
+  Uint32List b,
+) {
+  final aPtr = _copyHashes(a);
+  final bPtr = _copyHashes(b);
+  final offsetPtr = malloc<Int>();
+  offsetPtr.value = 0;
+  final similarity = _bindings.mediaxx_fingerprint_compare(
+    aPtr,
+    a.length,
+    bPtr,
+    b.length,
+    offsetPtr,
+  );
+  final offset = offsetPtr.value;
+  malloc.free(aPtr);
+  malloc.free(bPtr);
+  malloc.free(offsetPtr);
+  return (similarity, offset);
+}
+
+/// 指纹的倒排索引，用于查找重复的曲目，见 [MediaxxBindings.mediaxx_fingerprint_index_create]
+/// - 各方法直接调用原生接口，查询一般在 1ms 以内，可以在主 isolate 中调用
+class MediaxxFingerprintIndex {
+  final Pointer<Void> _handle;
+  bool _isDispose = false;
+
+  MediaxxFingerprintIndex._(this._handle);
+
+  factory MediaxxFingerprintIndex() {
+    return MediaxxFingerprintIndex._(
+      _bindings.mediaxx_fingerprint_index_create(),
+    );
+  }
+
+  /// 插入或替换 [id] 的指纹，指纹为空时返回 false
+  bool add(int id, Uint32List hashes) {
+    assert(false == _isDispose);
+    final hashesPtr = _copyHashes(hashes);
+    final ret = _bindings.mediaxx_fingerprint_index_add(
+      _handle,
+      id,
+      hashesPtr,
+      hashes.length,
+    );
+    malloc.free(hashesPtr);
+    return 1 == ret;
+  }
+
+  bool remove(int id) {
+    assert(false == _isDispose);
+    return 1 == _bindings.mediaxx_fingerprint_index_remove(_handle, id);
+  }
+
+  int get length {
+    assert(false == _isDispose);
+    return _bindings.mediaxx_fingerprint_index_size(_handle);
+  }
+
+  /// 相似度不低于 [minSimilarity] 的曲目，按相似度降序；[minSimilarity] <= 0 时为 0.75
+  List<({int id, double similarity, int offset})> query(
+    Uint32List hashes, {
+    double minSimilarity = 0,
+    int maxMatches = 16,
+  }) {
+    assert(false == _isDispose);
+    final hashesPtr = _copyHashes(hashes);
+    final matchesPtr = malloc<MediaxxFingerprintMatch>(maxMatches);
+    final count = _bindings.mediaxx_fingerprint_index_query(
+      _handle,
+      hashesPtr,
+      hashes.length,
+      minSimilarity,
+      matchesPtr,
+      maxMatches,
+    );
+    final matches = [
+      for (var i = 0; i < count; ++i)
+        (
+          id: matchesPtr[i].id,
+          similarity: matchesPtr[i].similarity,
+          offset: matchesPtr[i].offset,
+        ),
+    ];
+    malloc.free(hashesPtr);
+    malloc.free(matchesPtr);
+    return matches;
+  }
+
+  void dispose() {
+    if (_isDispose) {
+      return;
+    }
+    _isDispose = true;
+    _bindings.mediaxx_fingerprint_index_free(_handle);
+  }
+}
+
+/// 解析 LRC 歌词文本，如从网络获取的歌词
+/// - 返回的 [MediaxxLyrics] 用完后需要调用 [MediaxxLyrics.dispose]
+MediaxxLyrics mediaxx_parse_lyrics(String text) {
+  final data = utf8.encode(text);
+  final dataPtr = malloc<Uint8>(data.lengthInBytes);
+  dataPtr.asTypedList(data.lengthInBytes).setAll(0, data);
+  final Pointer<Pointer<Char>> result = malloc<Pointer<Char>>();
+  result.value = nullptr;
+
+  _bindings.mediaxx_parse_lyrics_malloc(
+    dataPtr.cast<Char>(),
+    data.lengthInBytes,
+    result,
+  );
+  final resultPtr = result.value;
+
+  malloc.free(dataPtr);
+  malloc.free(result);
+  return MediaxxLyrics._(resultPtr.cast<MediaxxLyricsHeader>());
+}
+
+/// 字典格式的批量结果
+/// - 直接在原生内存上读取；布局见 [MediaxxInfoDictHeader]
+/// - 整批共享一个字典，每个不同的字符串只转换一次，结果缓存在 Dart 侧
+/// - 用完后需要调用 [dispose] 释放，之后不能再访问取出的结构体
+class MediaxxInfoDict {
+  final Pointer<MediaxxInfoDictHeader> _ptr;
+  // 编号 -> 已转换的字符串
+  final List<String?> _strings;
+
+  bool _isDispose = false;
+
+  MediaxxInfoDict._(this._ptr)
+    : _strings = List<String?>.filled(_ptr.ref.stringCount, null) {
+    assert(_ptr.ref.magic == MEDIAXX_INFO_DICT_MAGIC);
+  }
+
+  Pointer<Uint8> get _base => _ptr.cast<Uint8>();
+
+  MediaxxInfoDictHeader get header {
+    assert(false == _isDispose);
+    return _ptr.ref;
+  }
+
+  int get entryCount => header.entryCount;
+
+  MediaxxInfoDictEntry entry(int index) {
+    assert(index >= 0 && index < entryCount);
+    final header = this.header;
+    return (_base + header.entryOffset + index * header.entrySize)
+        .cast<MediaxxInfoDictEntry>()
+        .ref;
+  }
+
+  /// 字典中的字符串，编号 0 返回 null；同一编号总是返回同一个对象
+  String? string(int id) {
+    assert(false == _isDispose);
+    if (id == 0 || id >= _strings.length) {
+      return null;
+    }
+    final cached = _strings[id];
+    if (null != cached) {
+      return cached;
+    }
+    final str = ((_base + header.stringOffset).cast<MediaxxInfoString>() + id).ref;
+    return _strings[id] = (_base + str.offset).cast<Utf8>().toDartString(
+      length: str.length,
+    );
+  }
+
+  /// [entry] 的规范化标签，[MEDIAXX_TAG_TITLE] 等 -> 值；单值字段只有一个元素
+  Map<int, List<String>> normalizedTags(MediaxxInfoDictEntry entry) {
+    final tagPtr = (_base + entry.tagOffset).cast<MediaxxInfoDictTag>();
+    final result = <int, List<String>>{};
+    for (int i = 0; i < entry.tagCount; ++i) {
+      final tag = (tagPtr + i).ref;
+      (result[tag.key] ??= <String>[]).add(string(tag.value)!);
+    }
+    return result;
+  }
+
+  void dispose() {
+    if (_isDispose) {
+      return;
+    }
+    _isDispose = true;
+    mediaxx_free(_ptr);
+  }
+}
+
+/// 批量读取信息，返回字典格式，适合一次加载整个媒体库
+/// - 在临时 isolate 中读取，参数同 [MediaxxBindings.mediaxx_get_media_info_batch_malloc]
+/// - [fieldMask] 不含 [MEDIAXX_FIELD_NORM_TAGS] 时没有标签
+/// - 返回的 [MediaxxInfoDict] 用完后需要调用 [MediaxxInfoDict.dispose]；参数错误时为 null
+Future<(int count, MediaxxInfoDict? dict, String? log)> mediaxx_get_media_info_dict(
+  List<String> paths, {
+  String headers = "",
+  int order = 1,
+  MediaxxCancelToken? cancelToken,
+  int timeoutMs = 0,
+  int fieldMask = 0,
+  int logMode = MEDIAXX_LOG_MODE_TEXT,
+  int maxTagSize = 0,
+}) async {
+  final pathsJson = jsonEncode(paths);
+  // 指针以地址传入 isolate，原生内存在进程内共享
+  final optionsAddress = _createRequestOptions(
+    cancelToken,
+    timeoutMs,
+    resultFormat: MEDIAXX_RESULT_FORMAT_DICT,
+    fieldMask: fieldMask,
+    logMode: logMode,
+    maxTagSize: maxTagSize,
+  ).address;
+  final (count, resultAddress, log) = await Isolate.run(() {
+    final pathsPtr = pathsJson.toNativeUtf8().cast<Char>();
+    final headersPtr = headers.toNativeUtf8().cast<Char>();
+    final optionsPtr = Pointer<MediaxxRequestOptions>.fromAddress(
+      optionsAddress,
+    );
+    final Pointer<Pointer<Char>> result = malloc<Pointer<Char>>();
+    result.value = nullptr;
+    final Pointer<Pointer<Char>> log = malloc<Pointer<Char>>();
+    log.value = nullptr;
+
+    final count = _bindings.mediaxx_get_media_info_batch_malloc(
+      pathsPtr,
+      headersPtr,
+      order,
+      optionsPtr,
+      result,
+      log,
+    );
+    final resultPtr = result.value;
+    final logPtr = log.value;
+
+    malloc.free(pathsPtr);
+    malloc.free(headersPtr);
+    malloc.free(optionsPtr);
+    malloc.free(result);
+    malloc.free(log);
+
+    final logStr = logPtr.cast<Utf8>().tryToDartString();
+    mediaxx_free(logPtr);
+    return (count, resultPtr.address, logStr);
+  });
+  final dict = (0 != resultAddress)
+      ? MediaxxInfoDict._(Pointer<MediaxxInfoDictHeader>.fromAddress(resultAddress))
+      : null;
+  return (count, dict, log);
+}
+
+/// 流式批量任务的一条结果，见 [MediaxxStreamRecord]
+class MediaxxStreamItem {
+  final int kind;
+  final int index;
+  final int ret;
+  final String? path;
+  final String? result;
+  final String? log;
+
+  const MediaxxStreamItem._({
+    required this.kind,
+    required this.index,
+    required this.ret,
+    this.path,
+    this.result,
+    this.log,
+  });
+
+  bool get isDone => kind == MEDIAXX_STREAM_KIND_DONE;
+}
+
+/// 流式批量读取：每完成一项就推送一条结果，最后一条为 [MediaxxStreamItem.isDone]
+/// - [jobs] 为 [MEDIAXX_STREAM_JOB_INFO] 等的组合；包含封面或主色调时 [coverDir] 必要
+/// - 订阅暂停时不再确认，原生侧未确认的记录达到 [maxPending] 后暂停读取
+/// - 取消订阅会停止任务，并等待正在处理的一项完成
+/// - 参数错误时流以 [ArgumentError] 结束
+Stream<MediaxxStreamItem> mediaxx_batch_stream(
+  List<String> paths,
+  String headers, {
+  int order = 1,
+  int jobs = MEDIAXX_STREAM_JOB_INFO,
+  String coverDir = "",
+  MediaxxCancelToken? cancelToken,
+  int timeoutMs = 0,
+  int fieldMask = 0,
+  int logMode = MEDIAXX_LOG_MODE_TEXT,
+  int maxTagSize = 0,
+  int maxPending = 16,
+}) {
+  late final StreamController<MediaxxStreamItem> controller;
+  NativeCallable<MediaxxStreamCallbackFunction>? callback;
+  Pointer<Void> handle = nullptr;
+  // 暂停期间收到的记录数，恢复后再确认
+  int unacked = 0;
+
+  void close() {
+    if (nullptr != handle) {
+      _bindings.mediaxx_batch_stream_free(handle);
+      handle = nullptr;
+    }
+    callback?.close();
+    callback = null;
+  }
+
+  void onRecord(Pointer<Void> userData, Pointer<MediaxxStreamRecord> record) {
+    final ref = record.ref;
+    final item = MediaxxStreamItem._(
+      kind: ref.kind,
+      index: ref.index,
+      ret: ref.ret,
+      path: ref.path.cast<Utf8>().tryToDartString(),
+      result: ref.result.cast<Utf8>().tryToDartString(length: ref.resultSize),
+      log: ref.log.cast<Utf8>().tryToDartString(),
+    );
+    mediaxx_free(record);
+    if (controller.isClosed) {
+      return;
+    }
+    controller.add(item);
+    if (item.isDone) {
+      close();
+      controller.close();
+      return;
+    }
+    if (controller.isPaused) {
+      ++unacked;
+    } else if (nullptr != handle) {
+      _bindings.mediaxx_batch_stream_ack(handle, 1);
+    }
+  }
+
+  controller = StreamController<MediaxxStreamItem>(
+    onListen: () {
+      callback = NativeCallable<MediaxxStreamCallbackFunction>.listener(
+        onRecord,
+      );
+      final pathsPtr = jsonEncode(paths).toNativeUtf8().cast<Char>();
+      final headersPtr = headers.toNativeUtf8().cast<Char>();
+      final coverDirPtr = coverDir.toNativeUtf8().cast<Char>();
+      final optionsPtr = _createRequestOptions(
+        cancelToken,
+        timeoutMs,
+        fieldMask: fieldMask,
+        logMode: logMode,
+        maxTagSize: maxTagSize,
+      );
+      final Pointer<Pointer<Char>> log = malloc<Pointer<Char>>();
+      log.value = nullptr;
+
+      handle = _bindings.mediaxx_batch_stream_start(
+        pathsPtr,
+        headersPtr,
+        order,
+        jobs,
+        coverDirPtr,
+        optionsPtr,
+        maxPending,
+        callback!.nativeFunction,
+        nullptr,
+        log,
+      );
+      final logPtr = log.value;
+
+      malloc.free(pathsPtr);
+      malloc.free(headersPtr);
+      malloc.free(coverDirPtr);
+      malloc.free(optionsPtr);
+      malloc.free(log);
+      final logStr = logPtr.cast<Utf8>().tryToDartString();
+      mediaxx_free(logPtr);
+      if (nullptr == handle) {
+        close();
+        controller.addError(ArgumentError(logStr));
+        controller.close();
+      }
+    },
+    onResume: () {
+      if (unacked > 0 && nullptr != handle) {
+        _bindings.mediaxx_batch_stream_ack(handle, unacked);
+      }
+      unacked = 0;
+    },
+    onCancel: close,
+  );
+  return controller.stream;
+}
+
+/// 取出诊断记录并格式化为文字，每条一行；没有记录时返回空字符串
+/// - 每次最多取出 [capacity] 条
+String mediaxx_diag_drain({int capacity = 256}) {
+  final records = malloc<MediaxxDiagRecord>(capacity);
+  final count = _bindings.mediaxx_diag_drain(records, capacity);
+  final textPtr = _bindings.mediaxx_diag_format_malloc(records, count);
+  malloc.free(records);
+  final text = textPtr.cast<Utf8>().tryToDartString();
+  mediaxx_free(textPtr);
+  return text ?? "";
+}
+
+int mediaxx_diag_dropped_count() {
+  return _bindings.mediaxx_diag_dropped_count();
+}
+
 String mediaxx_get_available_hwcodec_list() {
   final result = _bindings.mediaxx_get_available_hwcodec_list();
   final str = result.cast<Utf8>().tryToDartString();
@@ -168,6 +1857,9 @@ class _AsyncxxRequestMediaInfo {
   late Pointer<Char> headersPtr;
   late Pointer<Char> pictureOutputPathPtr;
   late Pointer<Char> picture96OutputPathPtr;
+  final Pointer<MediaxxRequestOptions> optionsPtr;
+  // 结果为二进制，不转换为字符串
+  final bool isBinary;
 
   bool isDispose = false;
 
@@ -177,6 +1869,8 @@ class _AsyncxxRequestMediaInfo {
     required String headers,
     required String pictureOutputPath,
     required String picture96OutputPath,
+    required this.optionsPtr,
+    this.isBinary = false,
   }) {
     filepathPtr = filepath.toNativeUtf8().cast<Char>();
     headersPtr = headers.toNativeUtf8().cast<Char>();
@@ -187,18 +1881,19 @@ class _AsyncxxRequestMediaInfo {
 
 class _AsyncxxResponseMediaInfo {
   final int id;
-  final int ret;
-  final Pointer<Char>? resultPtr;
-  final Pointer<Char>? logPtr;
+  // 结果和日志在同一块内存中，只需释放一次；内存不足时为 null
+  final Pointer<MediaxxResultBlock>? blockPtr;
+  final bool isBinary;
 
+  int? ret;
   String? result;
+  MediaxxInfo? info;
   String? log;
 
   _AsyncxxResponseMediaInfo(
     this.id, {
-    required this.ret,
-    this.resultPtr,
-    this.logPtr,
+    this.blockPtr,
+    this.isBinary = false,
   });
 }
 
@@ -209,6 +1904,7 @@ class _AsyncxxRequestMediaPicture {
   late Pointer<Char> headersPtr;
   late Pointer<Char> pictureOutputPathPtr;
   late Pointer<Char> picture96OutputPathPtr;
+  final Pointer<MediaxxRequestOptions> optionsPtr;
 
   bool isDispose = false;
 
@@ -218,6 +1914,7 @@ class _AsyncxxRequestMediaPicture {
     required String headers,
     required String pictureOutputPath,
     required String picture96OutputPath,
+    required this.optionsPtr,
   }) {
     filepathPtr = filepath.toNativeUtf8().cast<Char>();
     headersPtr = headers.toNativeUtf8().cast<Char>();
@@ -250,6 +1947,23 @@ class _AsyncxxRequestAnalysePictureColor {
   }
 }
 
+class _AsyncxxResponseAnalysePictureColor {
+  final int id;
+  final int ret;
+  final Pointer<Char>? resultPtr;
+  final Pointer<Char>? logPtr;
+
+  String? result;
+  String? log;
+
+  _AsyncxxResponseAnalysePictureColor(
+    this.id, {
+    required this.ret,
+    this.resultPtr,
+    this.logPtr,
+  });
+}
+
 class _AsyncxxResponseDefault {
   final int id;
   final int result;
@@ -284,6 +1998,35 @@ Future<SendPort> _helperIsolateSendPort = () async {
         final completer = _asyncxxRequests[data.id]!;
         _asyncxxRequests.remove(data.id);
 
+        final blockPtr = data.blockPtr;
+        if (null != blockPtr) {
+          final block = blockPtr.ref;
+          data.ret = block.ret;
+          if (nullptr != block.result) {
+            if (data.isBinary) {
+              data.info = MediaxxInfo._(
+                block.result.cast<MediaxxInfoHeader>(),
+                blockPtr,
+              );
+            } else {
+              data.result = block.result.cast<Utf8>().tryToDartString();
+            }
+          }
+          if (nullptr != block.log) {
+            data.log = block.log.cast<Utf8>().tryToDartString();
+          }
+        }
+        completer.complete(data);
+
+        // 二进制结果由 [MediaxxInfo.dispose] 整块释放
+        if (null != blockPtr && null == data.info) {
+          malloc.free(blockPtr);
+        }
+        return;
+      } else if (data is _AsyncxxResponseAnalysePictureColor) {
+        final Completer<dynamic> completer = _asyncxxRequests[data.id]!;
+        _asyncxxRequests.remove(data.id);
+
         data.result = data.resultPtr?.cast<Utf8>().tryToDartString();
         data.log = data.logPtr?.cast<Utf8>().tryToDartString();
         completer.complete(data);
@@ -291,7 +2034,7 @@ Future<SendPort> _helperIsolateSendPort = () async {
         if (null != data.resultPtr) {
           malloc.free(data.resultPtr!);
         }
-        if (null != data.logPtr && nullptr != data.logPtr) {
+        if (null != data.logPtr) {
           malloc.free(data.logPtr!);
         }
         return;
@@ -323,34 +2066,25 @@ Future<SendPort> _helperIsolateSendPort = () async {
           final headersPtr = data.headersPtr;
           final pictureOutputPathPtr = data.pictureOutputPathPtr;
           final picture96OutputPathPtr = data.picture96OutputPathPtr;
-          final Pointer<Pointer<Char>> result = malloc<Pointer<Char>>();
-          result.value = nullptr;
-          final Pointer<Pointer<Char>> log = malloc<Pointer<Char>>();
-          log.value = nullptr;
 
-          final ret = _bindings.mediaxx_get_media_info_malloc(
+          final blockPtr = _bindings.mediaxx_get_media_info_block_malloc(
             filepathPtr,
             headersPtr,
             pictureOutputPathPtr,
             picture96OutputPathPtr,
-            result,
-            log,
+            data.optionsPtr,
           );
-          final resultPtr = result.value;
-          final logPtr = log.value;
 
           malloc.free(filepathPtr);
           malloc.free(headersPtr);
           malloc.free(pictureOutputPathPtr);
           malloc.free(picture96OutputPathPtr);
-          malloc.free(result);
-          malloc.free(log);
+          malloc.free(data.optionsPtr);
           data.isDispose = true;
           final response = _AsyncxxResponseMediaInfo(
             data.id,
-            ret: ret,
-            resultPtr: (nullptr != resultPtr) ? resultPtr : null,
-            logPtr: (nullptr != logPtr) ? logPtr : null,
+            blockPtr: (nullptr != blockPtr) ? blockPtr : null,
+            isBinary: data.isBinary,
           );
           sendPort.send(response);
           return;
@@ -363,11 +2097,12 @@ Future<SendPort> _helperIsolateSendPort = () async {
           final Pointer<Pointer<Char>> log = malloc<Pointer<Char>>();
           log.value = nullptr;
 
-          final result = _bindings.mediaxx_get_media_picture(
+          final result = _bindings.mediaxx_get_media_picture_ex(
             filepathPtr,
             headersPtr,
             pictureOutputPathPtr,
             picture96OutputPathPtr,
+            data.optionsPtr,
             log,
           );
           final logPtr = log.value;
@@ -376,6 +2111,7 @@ Future<SendPort> _helperIsolateSendPort = () async {
           malloc.free(headersPtr);
           malloc.free(pictureOutputPathPtr);
           malloc.free(picture96OutputPathPtr);
+          malloc.free(data.optionsPtr);
           malloc.free(log);
           final response = _AsyncxxResponseDefault(
             data.id,
@@ -412,7 +2148,7 @@ Future<SendPort> _helperIsolateSendPort = () async {
           }
           malloc.free(result);
           malloc.free(log);
-          final response = _AsyncxxResponseMediaInfo(
+          final response = _AsyncxxResponseAnalysePictureColor(
             data.id,
             ret: ret,
             resultPtr: (nullptr != resultPtr) ? resultPtr : null,
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+# 生成 src/lib/util/charset_tables.h：GB18030、Big5（CP950）、Shift-JIS（CP932）到 Unicode 的解码表
+# 用法：python3 script/gen_charset_tables.py
+
+import os
+
+OUTPUT = os.path.join(os.path.dirname(__file__), "..", "src", "lib", "util", "charset_tables.h")
+
+# 双字节表的范围，与 charset.cpp 中的查表方式一致
+GBK_LEADS = range(0x81, 0xFF)
+BIG5_LEADS = range(0xA1, 0xFA)
+SJIS_LEADS = list(range(0x81, 0xA0)) + list(range(0xE0, 0xFD))
+TRAILS = range(0x40, 0xFF)
+
+# GB18030 四字节中 BMP 部分的数量
+GB18030_BMP_COUNT = 39420
+VALUES_PER_LINE = 11
+RANGES_PER_LINE = 5
+
+
+def decode_pair(codec, lead, trail):
+    try:
+        text = bytes([lead, trail]).decode(codec)
+    except UnicodeDecodeError:
+        return 0
+    if len(text) != 1 or ord(text) > 0xFFFF:
+        return 0
+    return ord(text)
+
+
+def double_byte_table(codec, leads):
+    return [decode_pair(codec, lead, trail) for lead in leads for trail in TRAILS]
+
+
+def gb18030_ranges():
+    """四字节的线性序号 -> 码点，按连续段压缩为 (起始序号, 起始码点)"""
+    ranges = []
+    prev = None
+    for linear in range(GB18030_BMP_COUNT):
+        b4 = 0x30 + linear % 10
+        b3 = 0x81 + linear // 10 % 126
+        b2 = 0x30 + linear // 1260 % 10
+        b1 = 0x81 + linear // 12600
+        try:
+            cp = ord(bytes([b1, b2, b3, b4]).decode("gb18030"))
+        except UnicodeDecodeError:
+            cp = None
+        if cp is not None and (prev is None or cp != prev + 1):
+            ranges.append((linear, cp))
+        prev = cp
+    return ranges
+
+
+def format_array(values, fmt, per_line=VALUES_PER_LINE):
+    lines = []
+    for i in range(0, len(values), per_line):
+        chunk = values[i : i + per_line]
+        lines.append("        " + ", ".join(fmt(v) for v in chunk) + ",")
+    return "\n".join(lines)
+
+
+def main():
+    hex16 = lambda v: f"0x{v:04X}"
+    gbk = double_byte_table("gb18030", GBK_LEADS)
+    big5 = double_byte_table("cp950", BIG5_LEADS)
+    sjis = double_byte_table("cp932", SJIS_LEADS)
+    ranges = gb18030_ranges()
+
+    out = []
+    out.append("#pragma once")
+    out.append("")
+    out.append("// 由 script/gen_charset_tables.py 生成，不要手动修改")
+    out.append("// clang-format off")
+    out.append("")
+    out.append("#include <cstdint>")
+    out.append("")
+    out.append("namespace charsetxx::tables {")
+    out.append("")
+    out.append("    /// 双字节表的尾字节范围 0x40~0xFE，每个首字节一行；0 表示未定义")
+    out.append(f"    inline constexpr uint32_t cTrailFirst = 0x{TRAILS.start:02X};")
+    out.append(f"    inline constexpr uint32_t cTrailCount = {len(TRAILS)};")
+    out.append("")
+    out.append(f"    /// GB18030 双字节部分（即 GBK），首字节 0x{GBK_LEADS.start:02X}~0x{GBK_LEADS.stop - 1:02X}")
+    out.append(f"    inline constexpr uint16_t cGbk[{len(gbk)}] = {{")
+    out.append(format_array(gbk, hex16))
+    out.append("    };")
+    out.append("")
+    out.append("    /// GB18030 四字节中 BMP 部分：{起始线性序号, 起始码点}，段内连续")
+    out.append(f"    inline constexpr uint32_t cGb18030BmpCount = {GB18030_BMP_COUNT};")
+    out.append(f"    inline constexpr uint32_t cGb18030Ranges[{len(ranges)}][2] = {{")
+    out.append(format_array([f"{{{a}, 0x{b:04X}}}" for a, b in ranges], str, RANGES_PER_LINE))
+    out.append("    };")
+    out.append("")
+    out.append(f"    /// Big5（CP950），首字节 0x{BIG5_LEADS.start:02X}~0x{BIG5_LEADS.stop - 1:02X}")
+    out.append(f"    inline constexpr uint16_t cBig5[{len(big5)}] = {{")
+    out.append(format_array(big5, hex16))
+    out.append("    };")
+    out.append("")
+    out.append("    /// Shift-JIS（CP932），首字节 0x81~0x9F、0xE0~0xFC 依次排列")
+    out.append(f"    inline constexpr uint16_t cShiftJis[{len(sjis)}] = {{")
+    out.append(format_array(sjis, hex16))
+    out.append("    };")
+    out.append("} // namespace charsetxx::tables")
+    out.append("")
+
+    # 与其他源码一致使用 CRLF
+    with open(OUTPUT, "w", encoding="utf-8", newline="\r\n") as f:
+        f.write("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
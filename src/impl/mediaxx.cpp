@@ -1,17 +1,215 @@
 
 #include "mediaxx.h"
 #include "analyse/audio_visualization.h"
+#include "analyse/batch_stream.h"
+#include "analyse/clip_extractor.h"
 #include "analyse/codec_info.h"
+#include "analyse/decode_session.h"
+#include "analyse/fingerprint.h"
+#include "analyse/frame_scanner.h"
+#include "analyse/library_watcher.h"
+#include "analyse/loudness_scanner.h"
+#include "analyse/lyrics_reader.h"
+#include "analyse/manifest_probe.h"
+#include "analyse/media_info_binary.h"
 #include "analyse/media_info_reader.h"
+#include "analyse/realtime_visualizer.h"
+#include "analyse/remote_probe.h"
+#include "analyse/rhythm_analyzer.h"
+#include "analyse/scan_order.h"
+#include "analyse/silence_detector.h"
 #include "analyse/tool.h"
 #include "simdjson.h"
+#include "util/arena.h"
+#include "util/cancel_token.h"
+#include "util/diag.h"
+#include "util/json_helper.h"
 #include "util/log.h"
 #include "util/string_util.h"
+#include "util/thread_pool.h"
 #include "util/utilxx.h"
+#include <cmath>
+#include <condition_variable>
 #include <cstdlib>
 #include <iostream>
+#include <memory_resource>
+#include <mutex>
+#include <new>
 #include <string>
 #include <string_view>
+#include <unordered_map>
+
+static void _applyRequestOptions(MediaInfoItem_c& item, const MediaxxRequestOptions* options) {
+    if (nullptr == options) {
+        return;
+    }
+    item.interrupt.token = static_cast<const CancelToken_c*>(options->cancelToken);
+    item.interrupt.setTimeout(options->timeoutMs);
+    item.setFieldMask(options->fieldMask);
+    item.setMaxTagSize(options->maxTagSize);
+    item.textLog = (options->logMode != MEDIAXX_LOG_MODE_RECORD);
+}
+
+// 字典格式只用于批量读取，各项先按二进制格式读取再转换
+static bool _isBinaryResult(const MediaxxRequestOptions* options) {
+    return nullptr != options
+        && (options->resultFormat == MEDIAXX_RESULT_FORMAT_BINARY
+            || options->resultFormat == MEDIAXX_RESULT_FORMAT_DICT);
+}
+
+// 按 [options] 指定的格式读取信息到 [out]；返回 0 成功，-1 失败，-2 取消或超时
+// - HLS/DASH 播放列表由 [ManifestProbe_c] 直接解析，避免 ffmpeg 下载分段
+// - 普通文件成功后保持打开，调用方可以继续读取封面
+static int _readMediaInfo(
+    MediaInfoItem_c&             item,
+    const char*                  headers,
+    const MediaxxRequestOptions* options,
+    std::string&                 out
+) {
+    const bool binary = _isBinaryResult(options);
+    if (ManifestProbe_c::isManifestUrl(item.filepath)) {
+        if (binary) {
+            // 二进制格式没有 `manifest` 部分，只输出格式信息
+            ManifestInfo info{};
+            if (ManifestProbe_c::instance.load(item, headers, info)) {
+                out = MediaInfoBinaryWriter_c::buildFormatOnly(
+                    item.filepath,
+                    info.type,
+                    info.duration,
+                    info.bitRate(),
+                    item.fieldMask
+                );
+                return 0;
+            }
+        } else {
+            const bool streamDetails = (nullptr != options) && (0 != options->streamDetails);
+            simdjson::builder::string_builder jsonsb{};
+            if (ManifestProbe_c::instance.probe(item, headers, streamDetails, jsonsb)) {
+                out = jsonsb.view().value_unsafe();
+                return 0;
+            }
+        }
+    } else if (MediaInfoReader_c::instance.openFile(item, headers)) {
+        if (binary) {
+            out = MediaInfoBinaryWriter_c::build(
+                item.filepath,
+                item.fmtCtx,
+                item.fieldMask,
+                item.maxTagSize
+            );
+        } else {
+            auto jsonsb = MediaInfoReader_c::instance.toInfoMap(item);
+            out         = jsonsb.view().value_unsafe();
+        }
+        return 0;
+    }
+    return item.isInterrupted() ? -2 : -1;
+}
+
+// 读取单个文件的信息，[outLog] 为空表示没有日志
+// - 日志使用 [outLog] 的内存资源，读取完直接转移给 [outLog]，不会复制
+static int _readMediaInfo(
+    const std::string_view       filepath,
+    const char*                  headers,
+    const MediaxxRequestOptions* options,
+    std::string&                 out,
+    std::pmr::string&            outLog
+) {
+    auto item = MediaInfoItem_c{filepath, nullptr, outLog.get_allocator().resource()};
+    _applyRequestOptions(item, options);
+    const int ret = _readMediaInfo(item, headers, options, out);
+    item.dispose();
+    outLog = std::move(item.logText);
+    return ret;
+}
+
+// 读取单个文件的信息，附加 `"ret"`、`"info"`、`"log"` 字段到当前 json 对象内
+static int _appendMediaInfo(
+    simdjson::builder::string_builder& sb,
+    const std::string_view             filepath,
+    const char*                        headers,
+    const MediaxxRequestOptions*       options = nullptr
+) {
+    RequestArena_c   arena{};
+    std::string      info{};
+    std::pmr::string log{arena.get()};
+    const int        ret = _readMediaInfo(filepath, headers, options, info, log);
+    sb.append_key_value<"ret">(ret);
+    if (0 == ret) {
+        sb.append_comma();
+        sb.escape_and_append_with_quotes("info");
+        sb.append_colon();
+        sb.append_raw(info);
+    }
+    if (false == log.empty()) {
+        sb.append_comma();
+        sb.append_key_value<"log">(std::string_view{log});
+    }
+    return ret;
+}
+
+// 读取信息并按需提取封面；返回值同 [mediaxx_get_media_info_ex_malloc]，[out] 为空表示没有结果
+static int _getMediaInfo(
+    MediaInfoItem_c&             item,
+    const char*                  headers,
+    const char*                  pictureOutputPath,
+    const char*                  picture96OutputPath,
+    const MediaxxRequestOptions* options,
+    std::string&                 out
+) {
+    assert(nullptr != headers);
+    assert(nullptr != pictureOutputPath);
+    assert(nullptr != picture96OutputPath);
+    _applyRequestOptions(item, options);
+    if ('\0' != pictureOutputPath[0]) {
+        // 提取封面需要完整的流信息
+        item.probeStreams = true;
+    }
+    int ret = _readMediaInfo(item, headers, options, out);
+    if (0 == ret) {
+        auto pOutput   = std::string_view{pictureOutputPath};
+        auto p96Output = std::string_view{picture96OutputPath};
+        // 播放列表没有打开 [fmtCtx]，也没有封面
+        if (false == pOutput.empty() && nullptr != item.fmtCtx) {
+            // 读取图片
+            ret = MediaInfoReader_c::instance.savePicture(item, pOutput, p96Output);
+        }
+    }
+    item.dispose();
+    return ret;
+}
+
+// 把结果和日志复制到一块 mediaxx_malloc 的内存中，调用方只需释放一次
+// - 布局：[MediaxxResultBlock] | 结果（8 字节对齐，二进制结果可直接按结构体读取）| 日志
+static const MediaxxResultBlock*
+    _makeResultBlock(int ret, const std::string_view result, const std::string_view log) {
+    const auto align8       = [](size_t value) { return (value + 7) & ~size_t(7); };
+    const auto resultOffset = align8(sizeof(MediaxxResultBlock));
+    const auto logOffset    = resultOffset + (result.empty() ? 0 : align8(result.size() + 1));
+    const auto totalSize    = logOffset + (log.empty() ? 0 : log.size() + 1);
+
+    auto base = static_cast<char*>(mediaxx_malloc(totalSize));
+    if (nullptr == base) {
+        LXX_ERR("mediaxx_malloc failed: {}", totalSize);
+        return nullptr;
+    }
+    auto block       = new (base) MediaxxResultBlock{};
+    block->ret       = ret;
+    block->totalSize = (unsigned int)totalSize;
+    if (false == result.empty()) {
+        memcpy(base + resultOffset, result.data(), result.size());
+        base[resultOffset + result.size()] = '\0';
+        block->result                      = base + resultOffset;
+        block->resultSize                  = (unsigned int)result.size();
+    }
+    if (false == log.empty()) {
+        memcpy(base + logOffset, log.data(), log.size());
+        base[logOffset + log.size()] = '\0';
+        block->log                   = base + logOffset;
+        block->logSize               = (unsigned int)log.size();
+    }
+    return block;
+}
 
 FFI_PLUGIN_EXPORT void* mediaxx_malloc(unsigned long long size) {
     return malloc(size);
@@ -39,6 +237,24 @@ FFI_PLUGIN_EXPORT const char* mediaxx_get_label_malloc() {
     return str;
 }
 
+FFI_PLUGIN_EXPORT void* mediaxx_cancel_token_create() {
+    return new CancelToken_c{};
+}
+
+FFI_PLUGIN_EXPORT void mediaxx_cancel_token_cancel(void* token) {
+    assert(nullptr != token);
+    static_cast<CancelToken_c*>(token)->cancel();
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_cancel_token_is_cancelled(void* token) {
+    assert(nullptr != token);
+    return static_cast<CancelToken_c*>(token)->isCancelled() ? 1 : 0;
+}
+
+FFI_PLUGIN_EXPORT void mediaxx_cancel_token_free(void* token) {
+    delete static_cast<CancelToken_c*>(token);
+}
+
 FFI_PLUGIN_EXPORT int mediaxx_get_media_info_malloc(
     const char*  filepath,
     const char*  headers,
@@ -46,38 +262,447 @@ FFI_PLUGIN_EXPORT int mediaxx_get_media_info_malloc(
     const char*  picture96OutputPath,
     const char** outResult,
     const char** outLog
+) {
+    return mediaxx_get_media_info_ex_malloc(
+        filepath,
+        headers,
+        pictureOutputPath,
+        picture96OutputPath,
+        nullptr,
+        outResult,
+        outLog
+    );
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_get_media_info_ex_malloc(
+    const char*                  filepath,
+    const char*                  headers,
+    const char*                  pictureOutputPath,
+    const char*                  picture96OutputPath,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    const char**                 outLog
 ) {
     assert(nullptr != filepath);
-    assert(nullptr != headers);
-    assert(nullptr != pictureOutputPath);
-    assert(nullptr != picture96OutputPath);
     assert(nullptr != outResult);
     assert(nullptr != outLog);
     LXX_DEBEG("mediaxx_get_media_info_malloc : {} ......", filepath);
 
-    auto item  = MediaInfoItem_c{std::string_view{filepath}, outLog};
-    int  ret   = 0;
-    *outResult = nullptr;
-    if (MediaInfoReader_c::instance.openFile(item, headers)) {
-        // 读取信息
-        auto jsonsb    = MediaInfoReader_c::instance.toInfoMap(item);
-        auto pOutput   = std::string_view{pictureOutputPath};
-        auto p96Output = std::string_view{picture96OutputPath};
-        *outResult     = stringxx::stringCopyMalloc(jsonsb.view().value_unsafe()).data();
+    auto        item = MediaInfoItem_c{std::string_view{filepath}, outLog};
+    std::string info{};
+    const int   ret = _getMediaInfo(
+        item,
+        headers,
+        pictureOutputPath,
+        picture96OutputPath,
+        options,
+        info
+    );
+    // 二进制结果中含有 '\0'，长度以 [MediaxxInfoHeader.totalSize] 为准
+    *outResult = info.empty() ? nullptr : stringxx::stringCopyMalloc(info).data();
+    LXX_DEBEG("mediaxx_get_media_info_malloc done: {}", (void*)(*outResult));
+    return ret;
+}
 
-        if (false == pOutput.empty()) {
-            // 读取图片
-            ret = MediaInfoReader_c::instance.savePicture(item, pOutput, p96Output);
-        } else {
-            ret = 0;
+FFI_PLUGIN_EXPORT const MediaxxResultBlock* mediaxx_get_media_info_block_malloc(
+    const char*                  filepath,
+    const char*                  headers,
+    const char*                  pictureOutputPath,
+    const char*                  picture96OutputPath,
+    const MediaxxRequestOptions* options
+) {
+    assert(nullptr != filepath);
+    LXX_DEBEG("mediaxx_get_media_info_block_malloc : {} ......", filepath);
+    // 日志写入栈上的 arena，最后与结果一起复制到同一块内存
+    RequestArena_c arena{};
+    auto           item = MediaInfoItem_c{std::string_view{filepath}, nullptr, arena.get()};
+    std::string    info{};
+    const int      ret = _getMediaInfo(
+        item,
+        headers,
+        pictureOutputPath,
+        picture96OutputPath,
+        options,
+        info
+    );
+    return _makeResultBlock(ret, info, item.logView());
+}
+
+// 批量读取信息；返回值同 [mediaxx_get_media_info_batch_malloc]，[out] 为空表示没有结果
+static int _getMediaInfoBatch(
+    const char*                     pathsJson,
+    const char*                     headers,
+    int                             order,
+    const MediaxxRequestOptions*    options,
+    analyse_tool::AnalyseLogItem_c& logItem,
+    std::string&                    out
+) {
+    assert(nullptr != pathsJson);
+    assert(nullptr != headers);
+
+    std::vector<std::string> paths{};
+    if (false == jsonParseStringArray(pathsJson, paths)) {
+        logItem.setLog("路径列表不是字符串数组");
+        return -1;
+    }
+    const auto token = (nullptr != options) ? static_cast<const CancelToken_c*>(options->cancelToken)
+                                            : nullptr;
+    const auto timeoutMs = (nullptr != options) ? options->timeoutMs : 0;
+    const auto fieldMask = (nullptr != options) ? options->fieldMask : 0u;
+    const auto maxTagSize = (nullptr != options) ? options->maxTagSize : 0;
+    const bool binary    = _isBinaryResult(options);
+    const bool dict      = binary && options->resultFormat == MEDIAXX_RESULT_FORMAT_DICT;
+
+    // 远程地址交给事件循环并发读取，本地文件在当前线程按磁盘顺序读取
+    std::vector<std::string>       localPaths{};
+    std::vector<size_t>            localIndexes{};
+    std::mutex                     remoteMutex{};
+    std::condition_variable        remoteCond{};
+    std::vector<RemoteProbeResult> remoteResults{};
+    size_t                         remoteCount = 0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        const auto& path = paths[i];
+        // 播放列表由 [ManifestProbe_c] 解析，不走远程探测
+        if (ManifestProbe_c::isManifestUrl(path) || false == RemoteProbe_c::isSupported(path)) {
+            localPaths.push_back(path);
+            localIndexes.push_back(i);
+            continue;
+        }
+        ++remoteCount;
+        // 在事件循环和工作线程中排队的时间不计入超时，从开始连接时计时
+        RequestInterrupt interrupt{};
+        interrupt.token = token;
+        interrupt.deferTimeout(timeoutMs);
+        RemoteProbe_c::instance.probe(
+            i,
+            path,
+            headers,
+            interrupt,
+            binary,
+            fieldMask,
+            maxTagSize,
+            [&remoteMutex, &remoteCond, &remoteResults](RemoteProbeResult&& result) {
+                std::lock_guard lock{remoteMutex};
+                remoteResults.push_back(std::move(result));
+                remoteCond.notify_one();
+            }
+        );
+    }
+
+    const auto sorted = ScanOrder_c::sortByDiskLocality(localPaths, ScanOrderMode(order));
+    // 其他协议的网络地址不经过页缓存，不需要预读
+    const auto prefetch = [&localPaths, &sorted](size_t i) {
+        if (i < sorted.size()) {
+            const auto& path = localPaths[sorted[i]];
+            if (path.find("://") == std::string::npos) {
+                ScanOrder_c::prefetchHeadTail(path);
+            }
+        }
+    };
+    // 预读窗口：读取当前文件时，后续几个文件的头尾已经在排队
+    constexpr size_t cPrefetchAhead = 4;
+    for (size_t i = 0; i < cPrefetchAhead; ++i) {
+        prefetch(i);
+    }
+
+    int  count   = 0;
+    bool isFirst = true;
+
+    simdjson::builder::string_builder sb{};
+    MediaInfoBinaryBatch_c            binaryResult{};
+    MediaInfoBinaryDict_c             dictResult{};
+    // 各文件的结果依次复制到 [binaryResult]，复用同一个缓冲区
+    std::string                       info{};
+    sb.start_array();
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        if (nullptr != token && token->isCancelled()) {
+            logItem.setLog("批量读取已取消，已完成 {}/{}", i, sorted.size());
+            break;
+        }
+        prefetch(i + cPrefetchAhead);
+        if (binary) {
+            const auto index = localIndexes[sorted[i]];
+            // 每个文件的日志使用独立的 arena，读取下一个文件前整体释放
+            RequestArena_c   arena{};
+            std::pmr::string log{arena.get()};
+            info.clear();
+            // [timeoutMs] 对每个文件单独计时
+            const int ret = _readMediaInfo(paths[index], headers, options, info, log);
+            if (0 == ret) {
+                ++count;
+            }
+            if (dict) {
+                dictResult.add(index, ret, paths[index], info, log);
+            } else {
+                binaryResult.add(index, ret, paths[index], info, log);
+            }
+            continue;
+        }
+        if (false == isFirst) {
+            sb.append_comma();
+        }
+        isFirst          = false;
+        const auto index = localIndexes[sorted[i]];
+        sb.start_object();
+        sb.append_key_value<"index">(int64_t(index));
+        sb.append_comma();
+        sb.append_key_value<"path">(std::string_view{paths[index]});
+        sb.append_comma();
+        // [timeoutMs] 对每个文件单独计时
+        if (0 == _appendMediaInfo(sb, paths[index], headers, options)) {
+            ++count;
+        }
+        sb.end_object();
+    }
+
+    // 取消后远程请求也会很快结束，这里总是等待全部回调完成
+    std::unique_lock lock{remoteMutex};
+    remoteCond.wait(lock, [&remoteResults, remoteCount] { return remoteResults.size() == remoteCount; });
+    for (const auto& result : remoteResults) {
+        if (binary) {
+            if (result.ret == 0) {
+                ++count;
+            }
+            const auto& path = paths[result.index];
+            if (dict) {
+                dictResult.add(result.index, result.ret, path, result.info, result.log);
+            } else {
+                binaryResult.add(result.index, result.ret, path, result.info, result.log);
+            }
+            continue;
+        }
+        if (false == isFirst) {
+            sb.append_comma();
         }
+        isFirst = false;
+        sb.start_object();
+        sb.append_key_value<"index">(int64_t(result.index));
+        sb.append_comma();
+        sb.append_key_value<"path">(std::string_view{paths[result.index]});
+        sb.append_comma();
+        sb.append_key_value<"ret">(result.ret);
+        if (result.ret == 0) {
+            ++count;
+            sb.append_comma();
+            sb.escape_and_append_with_quotes("info");
+            sb.append_colon();
+            sb.append_raw(result.info);
+        }
+        if (false == result.log.empty()) {
+            sb.append_comma();
+            sb.append_key_value<"log">(std::string_view{result.log});
+        }
+        sb.end_object();
+    }
+    sb.end_array();
+    if (dict) {
+        out = dictResult.finish();
+    } else if (binary) {
+        out = binaryResult.finish();
     } else {
-        *outResult = nullptr;
-        ret        = -1;
+        out = sb.view().value_unsafe();
     }
-    item.dispose();
-    LXX_DEBEG("mediaxx_get_media_info_malloc done: {}", (void*)(*outResult));
-    return ret;
+    return count;
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_get_media_info_batch_malloc(
+    const char*                  pathsJson,
+    const char*                  headers,
+    int                          order,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    const char**                 outLog
+) {
+    assert(nullptr != outResult);
+    assert(nullptr != outLog);
+    auto        logItem = analyse_tool::AnalyseLogItem_c{outLog};
+    std::string result{};
+    const int   count = _getMediaInfoBatch(pathsJson, headers, order, options, logItem, result);
+    *outResult        = result.empty() ? nullptr : stringxx::stringCopyMalloc(result).data();
+    return count;
+}
+
+FFI_PLUGIN_EXPORT const MediaxxResultBlock* mediaxx_get_media_info_batch_block_malloc(
+    const char*                  pathsJson,
+    const char*                  headers,
+    int                          order,
+    const MediaxxRequestOptions* options
+) {
+    RequestArena_c arena{};
+    auto           logItem = analyse_tool::AnalyseLogItem_c{nullptr, arena.get()};
+    std::string    result{};
+    const int      count = _getMediaInfoBatch(pathsJson, headers, order, options, logItem, result);
+    return _makeResultBlock(count, result, logItem.logView());
+}
+
+// 流式批量任务的执行体，在 [BatchStream_c] 的线程中运行；返回成功读取信息的数量
+static int _runBatchStream(
+    BatchStream_c&                  stream,
+    const std::vector<std::string>& paths,
+    const std::string&              headers,
+    int                             order,
+    int                             jobs,
+    const std::string&              coverDir,
+    const MediaxxRequestOptions&    options
+) {
+    const auto token       = static_cast<const CancelToken_c*>(options.cancelToken);
+    const bool needPicture = (jobs & (MEDIAXX_STREAM_JOB_COVER | MEDIAXX_STREAM_JOB_PALETTE)) != 0;
+    const auto sorted      = ScanOrder_c::sortByDiskLocality(paths, ScanOrderMode(order));
+    const auto prefetch    = [&paths, &sorted](size_t i) {
+        if (i < sorted.size() && paths[sorted[i]].find("://") == std::string::npos) {
+            ScanOrder_c::prefetchHeadTail(paths[sorted[i]]);
+        }
+    };
+    constexpr size_t cPrefetchAhead = 4;
+    for (size_t i = 0; i < cPrefetchAhead; ++i) {
+        prefetch(i);
+    }
+
+    int         count = 0;
+    std::string info{};
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        if ((nullptr != token && token->isCancelled()) || stream.isClosing()) {
+            break;
+        }
+        prefetch(i + cPrefetchAhead);
+        const auto  index = int(sorted[i]);
+        const auto& path  = paths[sorted[i]];
+
+        RequestArena_c arena{};
+        auto           item = MediaInfoItem_c{path, nullptr, arena.get()};
+        _applyRequestOptions(item, &options);
+        if (needPicture) {
+            item.probeStreams = true;
+        }
+        // 每条记录只带上一条之后新增的日志
+        size_t     logStart = 0;
+        const auto takeLog  = [&item, &logStart]() {
+            const auto log = item.logView().substr(logStart);
+            logStart       = item.logView().size();
+            return log;
+        };
+
+        int ret = -1;
+        info.clear();
+        if (jobs & MEDIAXX_STREAM_JOB_INFO) {
+            ret = _readMediaInfo(item, headers.c_str(), &options, info);
+            if (0 == ret) {
+                ++count;
+            }
+            if (false == stream.post(MEDIAXX_STREAM_KIND_INFO, index, ret, path, info, takeLog())) {
+                item.dispose();
+                break;
+            }
+        } else if (MediaInfoReader_c::instance.openFile(item, headers)) {
+            ret = 0;
+        }
+
+        if (needPicture) {
+            std::string cover{};
+            int         coverRet = 0;
+            if (0 == ret && nullptr != item.fmtCtx) {
+                cover        = std::format("{}/{}.jpg", coverDir, index);
+                auto cover96 = std::format("{}/{}_96.jpg", coverDir, index);
+                coverRet     = MediaInfoReader_c::instance.savePicture(item, cover, cover96);
+            } else if (item.isInterrupted()) {
+                coverRet = -2;
+            }
+            if (jobs & MEDIAXX_STREAM_JOB_COVER) {
+                const auto result = (coverRet > 0) ? std::string_view{cover} : std::string_view{};
+                stream.post(MEDIAXX_STREAM_KIND_COVER, index, coverRet, path, result, takeLog());
+            }
+            if (jobs & MEDIAXX_STREAM_JOB_PALETTE) {
+                std::string palette{};
+                if (coverRet > 0) {
+                    auto color = analyse_tool::analysePictureColorFromPath(cover.c_str(), item);
+                    if (nullptr != color) {
+                        palette = color->toJson().view().value_unsafe();
+                    }
+                }
+                const int  paletteRet = palette.empty() ? 0 : 1;
+                const auto log        = takeLog();
+                stream.post(MEDIAXX_STREAM_KIND_PALETTE, index, paletteRet, path, palette, log);
+            }
+        }
+        item.dispose();
+    }
+    return count;
+}
+
+FFI_PLUGIN_EXPORT void* mediaxx_batch_stream_start(
+    const char*                  pathsJson,
+    const char*                  headers,
+    int                          order,
+    int                          jobs,
+    const char*                  coverDir,
+    const MediaxxRequestOptions* options,
+    int                          maxPending,
+    MediaxxStreamCallback        callback,
+    void*                        userData,
+    const char**                 outLog
+) {
+    assert(nullptr != pathsJson);
+    assert(nullptr != headers);
+    assert(nullptr != callback);
+    assert(nullptr != outLog);
+    auto logItem = analyse_tool::AnalyseLogItem_c{outLog};
+
+    std::vector<std::string> paths{};
+    if (false == jsonParseStringArray(pathsJson, paths)) {
+        logItem.setLog("路径列表不是字符串数组");
+        return nullptr;
+    }
+    constexpr int cAllJobs
+        = MEDIAXX_STREAM_JOB_INFO | MEDIAXX_STREAM_JOB_COVER | MEDIAXX_STREAM_JOB_PALETTE;
+    if (0 == (jobs & cAllJobs)) {
+        logItem.setLog("未指定任务: {}", jobs);
+        return nullptr;
+    }
+    const bool needPicture = (jobs & (MEDIAXX_STREAM_JOB_COVER | MEDIAXX_STREAM_JOB_PALETTE)) != 0;
+    if (needPicture && (nullptr == coverDir || '\0' == coverDir[0])) {
+        logItem.setLog("封面和主色调任务需要指定封面目录");
+        return nullptr;
+    }
+
+    // 参数在任务线程中使用，全部复制
+    const auto optionsCopy = (nullptr != options) ? *options : MediaxxRequestOptions{};
+    const auto coverDirStr = std::string{needPicture ? coverDir : ""};
+    const auto headerStr   = std::string{headers};
+    auto       stream      = new BatchStream_c{callback, userData, maxPending};
+    stream->start([=, paths = std::move(paths)](BatchStream_c& self) {
+        const int count
+            = _runBatchStream(self, paths, headerStr, order, jobs, coverDirStr, optionsCopy);
+        self.post(MEDIAXX_STREAM_KIND_DONE, -1, count, {}, {}, {});
+    });
+    return stream;
+}
+
+FFI_PLUGIN_EXPORT void mediaxx_batch_stream_ack(void* stream, int count) {
+    assert(nullptr != stream);
+    static_cast<BatchStream_c*>(stream)->ack(count);
+}
+
+FFI_PLUGIN_EXPORT void mediaxx_batch_stream_free(void* stream) {
+    delete static_cast<BatchStream_c*>(stream);
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_diag_drain(MediaxxDiagRecord* outRecords, int capacity) {
+    if (nullptr == outRecords || capacity <= 0) {
+        return 0;
+    }
+    return int(Diagnostics_c::instance.drain(outRecords, size_t(capacity)));
+}
+
+FFI_PLUGIN_EXPORT const char*
+    mediaxx_diag_format_malloc(const MediaxxDiagRecord* records, int count) {
+    if (nullptr == records || count <= 0) {
+        return stringxx::stringCopyMalloc("").data();
+    }
+    return stringxx::stringCopyMalloc(Diagnostics_c::format(records, size_t(count))).data();
+}
+
+FFI_PLUGIN_EXPORT unsigned long long mediaxx_diag_dropped_count() {
+    return Diagnostics_c::instance.droppedCount();
 }
 
 FFI_PLUGIN_EXPORT int mediaxx_get_media_picture(
@@ -86,20 +711,39 @@ FFI_PLUGIN_EXPORT int mediaxx_get_media_picture(
     const char*  pictureOutputPath,
     const char*  picture96OutputPath,
     const char** outLog
+) {
+    return mediaxx_get_media_picture_ex(
+        filepath,
+        headers,
+        pictureOutputPath,
+        picture96OutputPath,
+        nullptr,
+        outLog
+    );
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_get_media_picture_ex(
+    const char*                  filepath,
+    const char*                  headers,
+    const char*                  pictureOutputPath,
+    const char*                  picture96OutputPath,
+    const MediaxxRequestOptions* options,
+    const char**                 outLog
 ) {
     assert(nullptr != filepath);
     assert(nullptr != headers);
     assert(nullptr != pictureOutputPath);
     assert(nullptr != picture96OutputPath);
-    auto item   = MediaInfoItem_c{std::string_view{filepath}, outLog};
-    int  result = 0;
+    auto item = MediaInfoItem_c{std::string_view{filepath}, outLog};
+    _applyRequestOptions(item, options);
+    int result = 0;
     // 完整封面路径必须非空
     auto pOutput   = std::string_view{pictureOutputPath};
     auto p96Output = std::string_view{picture96OutputPath};
     if (false == pOutput.empty() && MediaInfoReader_c::instance.openFile(item, headers)) {
         result = MediaInfoReader_c::instance.savePicture(item, pOutput, p96Output);
     } else {
-        result = 0;
+        result = item.isInterrupted() ? -2 : 0;
     }
     item.dispose();
     return result;
@@ -168,12 +812,857 @@ FFI_PLUGIN_EXPORT const char* mediaxx_get_available_hwcodec_list() {
     return stringxx::stringCopyMalloc(jsonsb.view().value_unsafe()).data();
 }
 
-FFI_PLUGIN_EXPORT int mediaxx_get_audio_visualization(const char* filepath, const char* output) {
+FFI_PLUGIN_EXPORT int mediaxx_get_audio_visualization(
+    const char*                  filepath,
+    const char*                  headers,
+    const char*                  outputPath,
+    const MediaxxRequestOptions* options,
+    const char**                 outLog
+) {
+    assert(nullptr != filepath);
+    assert(nullptr != headers);
+    assert(nullptr != outputPath);
+    auto item = MediaInfoItem_c{std::string_view{filepath}, outLog};
+    _applyRequestOptions(item, options);
+    const int ret = AudioVisualization_c::instance.analyse(item, headers, outputPath);
+    item.dispose();
+    return ret;
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_get_audio_spectrum(
+    const char*                   filepath,
+    const char*                   headers,
+    const char*                   outputPath,
+    const MediaxxSpectrumOptions* spectrum,
+    const MediaxxRequestOptions*  options,
+    const char**                  outLog
+) {
     assert(nullptr != filepath);
-    assert(nullptr != output);
-    auto ret = AudioVisualization_c::instance.analyse(filepath, output);
-    if (ret) {
-        return 1;
+    assert(nullptr != headers);
+    assert(nullptr != outputPath);
+    auto item = MediaInfoItem_c{std::string_view{filepath}, outLog};
+    _applyRequestOptions(item, options);
+    const int ret
+        = AudioVisualization_c::instance.analyseSpectrum(item, headers, outputPath, spectrum);
+    item.dispose();
+    return ret;
+}
+
+FFI_PLUGIN_EXPORT void* mediaxx_visualizer_create(
+    const MediaxxVisualizerOptions* options,
+    const char**                    outLog
+) {
+    assert(nullptr != outLog);
+    auto logItem = analyse_tool::AnalyseLogItem_c{outLog};
+    if (nullptr == options || options->sampleRate <= 0) {
+        logItem.setLog("采样率无效");
+        return nullptr;
     }
-    return 0;
-}
\ No newline at end of file
+    if (options->channels <= 0 || options->channels > 8) {
+        logItem.setLog("声道数无效: {}", options->channels);
+        return nullptr;
+    }
+    auto visualizer = new RealtimeVisualizer_c{*options};
+    if (false == visualizer->start()) {
+        delete visualizer;
+        logItem.setLog("无法初始化 FFT");
+        return nullptr;
+    }
+    return visualizer;
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_visualizer_push(void* visualizer, const float* samples, int frames) {
+    assert(nullptr != visualizer);
+    if (nullptr == samples || frames <= 0) {
+        return 0;
+    }
+    return int(static_cast<RealtimeVisualizer_c*>(visualizer)->push(samples, size_t(frames)));
+}
+
+FFI_PLUGIN_EXPORT void mediaxx_visualizer_reset(void* visualizer) {
+    assert(nullptr != visualizer);
+    static_cast<RealtimeVisualizer_c*>(visualizer)->reset();
+}
+
+FFI_PLUGIN_EXPORT int
+    mediaxx_visualizer_poll(void* visualizer, MediaxxVisualizerSnapshot* outSnapshot) {
+    assert(nullptr != visualizer);
+    assert(nullptr != outSnapshot);
+    return static_cast<RealtimeVisualizer_c*>(visualizer)->poll(*outSnapshot) ? 1 : 0;
+}
+
+FFI_PLUGIN_EXPORT void mediaxx_visualizer_free(void* visualizer) {
+    delete static_cast<RealtimeVisualizer_c*>(visualizer);
+}
+
+FFI_PLUGIN_EXPORT void* mediaxx_decoder_open(
+    const char*                  filepath,
+    const char*                  headers,
+    int                          sampleRate,
+    int                          channels,
+    const MediaxxRequestOptions* options,
+    const char**                 outLog
+) {
+    assert(nullptr != filepath);
+    assert(nullptr != headers);
+    assert(nullptr != outLog);
+    auto logItem = analyse_tool::AnalyseLogItem_c{outLog};
+    auto session = new DecodeSession_c{std::string_view{filepath}};
+    _applyRequestOptions(session->item, options);
+    const int ret = session->open(headers, sampleRate, channels);
+    // 会话的日志不直接写入 [outLog]：调用方在返回后就会释放它，而会话还要继续使用
+    if (false == session->item.logView().empty()) {
+        logItem.setLog(session->item.logView());
+    }
+    if (1 != ret) {
+        delete session;
+        return nullptr;
+    }
+    return session;
+}
+
+FFI_PLUGIN_EXPORT void mediaxx_decoder_get_info(void* decoder, MediaxxDecoderInfo* outInfo) {
+    assert(nullptr != decoder);
+    assert(nullptr != outInfo);
+    const auto& audio         = static_cast<DecodeSession_c*>(decoder)->decoder;
+    outInfo->sampleRate       = audio.sampleRate();
+    outInfo->channels         = audio.channels();
+    outInfo->sourceSampleRate = audio.sourceSampleRate();
+    outInfo->sourceChannels   = audio.sourceChannels();
+    outInfo->estimatedFrames  = audio.estimatedFrames();
+    outInfo->position         = audio.position();
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_decoder_read(void* decoder, float* dst, int frames) {
+    assert(nullptr != decoder);
+    if (nullptr == dst || frames <= 0) {
+        return 0;
+    }
+    return static_cast<DecodeSession_c*>(decoder)->read(dst, frames);
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_decoder_seek(void* decoder, long long frame) {
+    assert(nullptr != decoder);
+    return static_cast<DecodeSession_c*>(decoder)->seek(frame);
+}
+
+FFI_PLUGIN_EXPORT void mediaxx_decoder_free(void* decoder) {
+    delete static_cast<DecodeSession_c*>(decoder);
+}
+
+// 在线程池中逐个分析 [paths]，[fn](item, i) 的返回值同 [mediaxx_get_audio_visualization]
+// - [timeoutMs] 对每个文件单独计时；取消后的文件在打开前就会返回 -2
+template<typename Fn>
+static void _scanFiles(
+    const std::vector<std::string>& paths,
+    size_t                          threadCount,
+    const MediaxxRequestOptions*    options,
+    std::vector<int>&               rets,
+    std::vector<std::string>&       logs,
+    Fn&&                            fn
+) {
+    rets.assign(paths.size(), -2);
+    logs.assign(paths.size(), std::string{});
+    ThreadPool_c pool{std::min(threadCount, std::max<size_t>(paths.size(), 1))};
+    for (size_t i = 0; i < paths.size(); ++i) {
+        pool.post([&, i] {
+            auto item = MediaInfoItem_c{paths[i], nullptr};
+            _applyRequestOptions(item, options);
+            rets[i] = fn(item, i);
+            item.dispose();
+            logs[i] = item.logText;
+        });
+    }
+    // 析构时等待所有文件完成
+}
+
+// 写入 [_scanFiles] 的结果数组，每项为 `{"index", "path", "ret", [key], "log"}`
+// - [key] 对象只在成功时存在，由 [fn](i) 写入其中的字段；返回成功的数量
+template<typename Fn>
+static int _appendScanResults(
+    simdjson::builder::string_builder& sb,
+    const std::vector<std::string>&    paths,
+    const std::vector<int>&            rets,
+    const std::vector<std::string>&    logs,
+    std::string_view                   key,
+    Fn&&                               fn
+) {
+    int count = 0;
+    sb.start_array();
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (i > 0) {
+            sb.append_comma();
+        }
+        sb.start_object();
+        sb.append_key_value<"index">(int64_t(i));
+        sb.append_comma();
+        sb.append_key_value<"path">(std::string_view{paths[i]});
+        sb.append_comma();
+        sb.append_key_value<"ret">(rets[i]);
+        if (1 == rets[i]) {
+            ++count;
+            sb.append_comma();
+            sb.escape_and_append_with_quotes(key);
+            sb.append_colon();
+            sb.start_object();
+            fn(i);
+            sb.end_object();
+        }
+        if (false == logs[i].empty()) {
+            sb.append_comma();
+            sb.append_key_value<"log">(std::string_view{logs[i]});
+        }
+        sb.end_object();
+    }
+    sb.end_array();
+    return count;
+}
+
+// 保留两位小数，用于响度、增益和置信度
+static double _roundHundredths(double value) {
+    return std::round(value * 100.0) / 100.0;
+}
+
+// 写入 `"integrated"` 等响度字段；返回综合响度，静音或过短时为 -inf 且不写入综合响度和增益
+static double _appendLoudness(
+    simdjson::builder::string_builder&      sb,
+    std::span<const LoudnessMeter_c* const> meters,
+    std::string_view                        gainKey
+) {
+    const auto integrated = LoudnessMeter_c::integratedOf(meters);
+    if (std::isfinite(integrated)) {
+        sb.append_key_value<"integrated">(_roundHundredths(integrated));
+        sb.append_comma();
+        const auto gain = LoudnessMeter_c::cReferenceLufs - integrated;
+        sb.append_key_value(gainKey, _roundHundredths(gain));
+        sb.append_comma();
+    }
+    sb.append_key_value<"range">(_roundHundredths(LoudnessMeter_c::rangeOf(meters)));
+    return integrated;
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_scan_loudness_malloc(
+    const char*                  pathsJson,
+    const char*                  albumsJson,
+    const char*                  headers,
+    int                          threadCount,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    const char**                 outLog
+) {
+    assert(nullptr != pathsJson);
+    assert(nullptr != headers);
+    assert(nullptr != outResult);
+    assert(nullptr != outLog);
+    auto logItem = analyse_tool::AnalyseLogItem_c{outLog};
+
+    std::vector<std::string> paths{};
+    if (false == jsonParseStringArray(pathsJson, paths)) {
+        logItem.setLog("路径列表不是字符串数组");
+        return -1;
+    }
+    std::vector<std::string> albumKeys{};
+    if (nullptr != albumsJson
+        && (false == jsonParseStringArray(albumsJson, albumKeys)
+            || albumKeys.size() != paths.size())) {
+        logItem.setLog("专辑列表不是与路径列表等长的字符串数组");
+        return -1;
+    }
+
+    const auto totalThreads
+        = (threadCount > 0) ? size_t(threadCount) : ThreadPool_c::defaultThreadCount();
+    const auto fileCount     = std::max<size_t>(paths.size(), 1);
+    // 文件数少于线程数时，多余的线程分给解码器
+    const auto decodeThreads = int(std::max<size_t>(totalThreads / fileCount, 1));
+
+    std::vector<LoudnessMeter_c> meters(paths.size());
+    std::vector<int>             rets{};
+    std::vector<std::string>     logs{};
+    _scanFiles(paths, totalThreads, options, rets, logs, [&](MediaInfoItem_c& item, size_t i) {
+        return LoudnessScanner_c::instance.scan(item, headers, decodeThreads, meters[i]);
+    });
+
+    // 按首次出现的顺序分组，只包含扫描成功的曲目
+    struct Album {
+        std::string_view                    key{};
+        std::vector<const LoudnessMeter_c*> members{};
+        double                              peak       = 0;
+        double                              integrated = 0;
+    };
+    std::vector<Album>                           albums{};
+    std::unordered_map<std::string_view, size_t> albumIndexes{};
+    for (size_t i = 0; i < albumKeys.size(); ++i) {
+        if (albumKeys[i].empty() || 1 != rets[i]) {
+            continue;
+        }
+        const auto [it, inserted] = albumIndexes.try_emplace(albumKeys[i], albums.size());
+        if (inserted) {
+            albums.push_back(Album{albumKeys[i]});
+        }
+        auto& album = albums[it->second];
+        album.members.push_back(&meters[i]);
+        album.peak = std::max(album.peak, meters[i].truePeak());
+    }
+
+    simdjson::builder::string_builder sb{};
+    sb.start_object();
+    sb.append_key_value<"reference">(LoudnessMeter_c::cReferenceLufs);
+    sb.append_comma();
+    sb.escape_and_append_with_quotes("albums");
+    sb.append_colon();
+    sb.start_array();
+    for (auto& album : albums) {
+        if (&album != &albums.front()) {
+            sb.append_comma();
+        }
+        sb.start_object();
+        sb.append_key_value<"key">(album.key);
+        sb.append_comma();
+        sb.append_key_value<"count">(int64_t(album.members.size()));
+        sb.append_comma();
+        sb.append_key_value<"true_peak">(album.peak);
+        sb.append_comma();
+        album.integrated = _appendLoudness(sb, album.members, "replaygain_album_gain");
+        sb.end_object();
+    }
+    sb.end_array();
+    sb.append_comma();
+    sb.escape_and_append_with_quotes("tracks");
+    sb.append_colon();
+    const int count = _appendScanResults(sb, paths, rets, logs, "loudness", [&](size_t i) {
+        const auto& meter = meters[i];
+        sb.append_key_value<"sample_peak">(meter.samplePeak());
+        sb.append_comma();
+        sb.append_key_value<"true_peak">(meter.truePeak());
+        sb.append_comma();
+        sb.append_key_value<"replaygain_track_peak">(meter.truePeak());
+        sb.append_comma();
+        const LoudnessMeter_c* self = &meter;
+        _appendLoudness(sb, {&self, 1}, "replaygain_track_gain");
+        const auto it = albumKeys.empty() ? albumIndexes.end() : albumIndexes.find(albumKeys[i]);
+        if (it != albumIndexes.end() && std::isfinite(albums[it->second].integrated)) {
+            const auto& album = albums[it->second];
+            const auto  gain  = LoudnessMeter_c::cReferenceLufs - album.integrated;
+            sb.append_comma();
+            sb.append_key_value<"album">(album.key);
+            sb.append_comma();
+            sb.append_key_value<"replaygain_album_gain">(_roundHundredths(gain));
+            sb.append_comma();
+            sb.append_key_value<"replaygain_album_peak">(album.peak);
+        }
+    });
+    sb.end_object();
+    *outResult = stringxx::stringCopyMalloc(sb.view().value_unsafe()).data();
+    return count;
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_scan_rhythm_malloc(
+    const char*                  pathsJson,
+    const char*                  headers,
+    int                          threadCount,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    const char**                 outLog
+) {
+    assert(nullptr != pathsJson);
+    assert(nullptr != headers);
+    assert(nullptr != outResult);
+    assert(nullptr != outLog);
+    auto logItem = analyse_tool::AnalyseLogItem_c{outLog};
+
+    std::vector<std::string> paths{};
+    if (false == jsonParseStringArray(pathsJson, paths)) {
+        logItem.setLog("路径列表不是字符串数组");
+        return -1;
+    }
+
+    const auto totalThreads
+        = (threadCount > 0) ? size_t(threadCount) : ThreadPool_c::defaultThreadCount();
+
+    std::vector<RhythmInfo>  infos(paths.size());
+    std::vector<int>         rets{};
+    std::vector<std::string> logs{};
+    _scanFiles(paths, totalThreads, options, rets, logs, [&](MediaInfoItem_c& item, size_t i) {
+        return RhythmAnalyzer_c::instance.analyse(item, headers, infos[i]);
+    });
+
+    simdjson::builder::string_builder sb{};
+    const int count = _appendScanResults(sb, paths, rets, logs, "rhythm", [&](size_t i) {
+        const auto& info     = infos[i];
+        bool        hasField = false;
+        if (info.bpm > 0) {
+            sb.append_key_value<"bpm">(std::round(info.bpm * 10.0) / 10.0);
+            sb.append_comma();
+            sb.append_key_value<"bpm_confidence">(_roundHundredths(info.bpmConfidence));
+            hasField = true;
+        }
+        if (info.key >= 0) {
+            if (hasField) {
+                sb.append_comma();
+            }
+            sb.append_key_value<"key">(RhythmAnalyzer_c::keyName(info.key));
+            sb.append_comma();
+            sb.append_key_value<"key_index">(info.key);
+            sb.append_comma();
+            sb.append_key_value<"camelot">(RhythmAnalyzer_c::camelot(info.key));
+            sb.append_comma();
+            sb.append_key_value<"key_confidence">(_roundHundredths(info.keyConfidence));
+        }
+    });
+    *outResult = stringxx::stringCopyMalloc(sb.view().value_unsafe()).data();
+    return count;
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_scan_silence_malloc(
+    const char*                  pathsJson,
+    const char*                  headers,
+    float                        thresholdDb,
+    int                          windowMs,
+    int                          threadCount,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    const char**                 outLog
+) {
+    assert(nullptr != pathsJson);
+    assert(nullptr != headers);
+    assert(nullptr != outResult);
+    assert(nullptr != outLog);
+    auto logItem = analyse_tool::AnalyseLogItem_c{outLog};
+
+    std::vector<std::string> paths{};
+    if (false == jsonParseStringArray(pathsJson, paths)) {
+        logItem.setLog("路径列表不是字符串数组");
+        return -1;
+    }
+
+    const auto totalThreads
+        = (threadCount > 0) ? size_t(threadCount) : ThreadPool_c::defaultThreadCount();
+
+    std::vector<SilenceInfo> infos(paths.size());
+    std::vector<int>         rets{};
+    std::vector<std::string> logs{};
+    _scanFiles(paths, totalThreads, options, rets, logs, [&](MediaInfoItem_c& item, size_t i) {
+        return SilenceDetector_c::instance.detect(item, headers, thresholdDb, windowMs, infos[i]);
+    });
+
+    simdjson::builder::string_builder sb{};
+    const int count = _appendScanResults(sb, paths, rets, logs, "silence", [&](size_t i) {
+        const auto& info    = infos[i];
+        // 秒数保留到毫秒
+        const auto  seconds = [&info](int64_t frames) {
+            return double(std::llround(double(frames) * 1000.0 / info.sampleRate)) / 1000.0;
+        };
+        sb.append_key_value<"sample_rate">(info.sampleRate);
+        sb.append_comma();
+        sb.append_key_value<"total_frames">(info.totalFrames);
+        sb.append_comma();
+        if (info.audioStart < 0) {
+            sb.append_key_value<"silent">(true);
+            return;
+        }
+        sb.append_key_value<"audio_start">(info.audioStart);
+        sb.append_comma();
+        sb.append_key_value<"audio_end">(info.audioEnd);
+        sb.append_comma();
+        sb.append_key_value<"leading_silence">(seconds(info.audioStart));
+        sb.append_comma();
+        sb.append_key_value<"trailing_silence">(seconds(info.totalFrames - info.audioEnd));
+    });
+    *outResult = stringxx::stringCopyMalloc(sb.view().value_unsafe()).data();
+    return count;
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_scan_exact_duration_malloc(
+    const char*                  pathsJson,
+    int                          threadCount,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    const char**                 outLog
+) {
+    assert(nullptr != pathsJson);
+    assert(nullptr != outResult);
+    assert(nullptr != outLog);
+    auto logItem = analyse_tool::AnalyseLogItem_c{outLog};
+
+    std::vector<std::string> paths{};
+    if (false == jsonParseStringArray(pathsJson, paths)) {
+        logItem.setLog("路径列表不是字符串数组");
+        return -1;
+    }
+
+    const auto totalThreads
+        = (threadCount > 0) ? size_t(threadCount) : ThreadPool_c::defaultThreadCount();
+
+    std::vector<FrameScanInfo> infos(paths.size());
+    std::vector<int>           rets{};
+    std::vector<std::string>   logs{};
+    _scanFiles(paths, totalThreads, options, rets, logs, [&](MediaInfoItem_c& item, size_t i) {
+        return FrameScanner_c::instance.scan(item, infos[i]);
+    });
+
+    simdjson::builder::string_builder sb{};
+    const int count = _appendScanResults(sb, paths, rets, logs, "exact", [&](size_t i) {
+        const auto& info  = infos[i];
+        const auto  valid = info.validSamples();
+        sb.append_key_value<"format">(info.format);
+        sb.append_comma();
+        sb.append_key_value<"sample_rate">(info.sampleRate);
+        sb.append_comma();
+        sb.append_key_value<"channels">(info.channels);
+        sb.append_comma();
+        sb.append_key_value<"frames">(info.frameCount);
+        sb.append_comma();
+        sb.append_key_value<"samples">(info.totalSamples);
+        sb.append_comma();
+        sb.append_key_value<"valid_samples">(valid);
+        sb.append_comma();
+        // 秒数保留到微秒
+        sb.append_key_value<"duration">(
+            double(std::llround(double(valid) * 1e6 / info.sampleRate)) / 1e6
+        );
+        if (false == info.gaplessSource.empty()) {
+            sb.append_comma();
+            sb.append_key_value<"encoder_delay">(info.encoderDelay);
+            sb.append_comma();
+            sb.append_key_value<"encoder_padding">(info.encoderPadding);
+            sb.append_comma();
+            sb.append_key_value<"gapless_source">(info.gaplessSource);
+        }
+        if (info.headerFrames >= 0) {
+            sb.append_comma();
+            sb.append_key_value<"header_frames">(info.headerFrames);
+        }
+        if (info.skippedBytes > 0) {
+            sb.append_comma();
+            sb.append_key_value<"skipped_bytes">(info.skippedBytes);
+        }
+    });
+    *outResult = stringxx::stringCopyMalloc(sb.view().value_unsafe()).data();
+    return count;
+}
+
+// 片段提取的结果，见 [mediaxx_extract_clip_malloc]
+static const char* _clipInfoJson(const ClipInfo& info) {
+    simdjson::builder::string_builder sb{};
+    sb.start_object();
+    sb.append_key_value<"start">(double(info.startUs) / 1e6);
+    sb.append_comma();
+    sb.append_key_value<"duration">(double(info.durationUs) / 1e6);
+    sb.append_comma();
+    sb.append_key_value<"packets">(info.packets);
+    sb.append_comma();
+    sb.append_key_value<"reencoded">(info.reencoded);
+    sb.end_object();
+    return stringxx::stringCopyMalloc(sb.view().value_unsafe()).data();
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_extract_clip_malloc(
+    const char*                  filepath,
+    const char*                  headers,
+    const char*                  outputPath,
+    long long                    startMs,
+    long long                    durationMs,
+    int                          accurate,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    const char**                 outLog
+) {
+    assert(nullptr != filepath);
+    assert(nullptr != headers);
+    assert(nullptr != outputPath);
+    assert(nullptr != outResult);
+    *outResult = nullptr;
+    auto item  = MediaInfoItem_c{std::string_view{filepath}, outLog};
+    _applyRequestOptions(item, options);
+    ClipInfo   info{};
+    const bool exact = (0 != accurate);
+    auto&      clip  = ClipExtractor_c::instance;
+    const int  ret   = clip.extract(item, headers, outputPath, startMs, durationMs, exact, info);
+    if (1 == ret) {
+        *outResult = _clipInfoJson(info);
+    }
+    item.dispose();
+    return ret;
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_decoder_extract_clip_malloc(
+    void*        decoder,
+    const char*  outputPath,
+    long long    startMs,
+    long long    durationMs,
+    int          accurate,
+    const char** outResult,
+    const char** outLog
+) {
+    assert(nullptr != decoder);
+    assert(nullptr != outputPath);
+    assert(nullptr != outResult);
+    assert(nullptr != outLog);
+    *outResult   = nullptr;
+    auto session = static_cast<DecodeSession_c*>(decoder);
+    ClipInfo  info{};
+    const int ret = session->extractClip(outputPath, startMs, durationMs, 0 != accurate, info);
+    if (1 == ret) {
+        *outResult = _clipInfoJson(info);
+    }
+    if (false == session->item.logView().empty()) {
+        auto logItem = analyse_tool::AnalyseLogItem_c{outLog};
+        logItem.setLog(session->item.logView());
+    }
+    return ret;
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_get_fingerprint_malloc(
+    const char*                  filepath,
+    const char*                  headers,
+    int                          seconds,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    int*                         outCount,
+    const char**                 outLog
+) {
+    assert(nullptr != filepath);
+    assert(nullptr != headers);
+    assert(nullptr != outResult);
+    assert(nullptr != outCount);
+    *outResult = nullptr;
+    *outCount  = 0;
+    auto item  = MediaInfoItem_c{std::string_view{filepath}, outLog};
+    _applyRequestOptions(item, options);
+    std::vector<uint32_t> hashes{};
+    const int ret = AudioFingerprint_c::instance.generate(item, headers, seconds, hashes);
+    if (1 == ret) {
+        const auto bytes = std::string_view{
+            reinterpret_cast<const char*>(hashes.data()),
+            hashes.size() * sizeof(uint32_t)
+        };
+        *outResult = stringxx::stringCopyMalloc(bytes).data();
+        *outCount  = int(hashes.size());
+    }
+    item.dispose();
+    return ret;
+}
+
+FFI_PLUGIN_EXPORT float mediaxx_fingerprint_compare(
+    const unsigned int* a,
+    int                 aCount,
+    const unsigned int* b,
+    int                 bCount,
+    int*                outOffset
+) {
+    int        offset     = 0;
+    const auto similarity = (nullptr == a || nullptr == b || aCount <= 0 || bCount <= 0)
+                                ? 0.0f
+                                : AudioFingerprint_c::compare(
+                                      {a, size_t(aCount)}, {b, size_t(bCount)}, offset
+                                  );
+    if (nullptr != outOffset) {
+        *outOffset = offset;
+    }
+    return similarity;
+}
+
+FFI_PLUGIN_EXPORT void* mediaxx_fingerprint_index_create() {
+    return new FingerprintIndex_c{};
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_fingerprint_index_add(
+    void*               index,
+    long long           id,
+    const unsigned int* hashes,
+    int                 count
+) {
+    assert(nullptr != index);
+    if (nullptr == hashes || count <= 0) {
+        return 0;
+    }
+    return static_cast<FingerprintIndex_c*>(index)->add(id, {hashes, size_t(count)}) ? 1 : 0;
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_fingerprint_index_remove(void* index, long long id) {
+    assert(nullptr != index);
+    return static_cast<FingerprintIndex_c*>(index)->remove(id) ? 1 : 0;
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_fingerprint_index_size(void* index) {
+    assert(nullptr != index);
+    return int(static_cast<FingerprintIndex_c*>(index)->size());
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_fingerprint_index_query(
+    void*                    index,
+    const unsigned int*      hashes,
+    int                      count,
+    float                    minSimilarity,
+    MediaxxFingerprintMatch* outMatches,
+    int                      maxMatches
+) {
+    assert(nullptr != index);
+    if (nullptr == hashes || count <= 0 || nullptr == outMatches || maxMatches <= 0) {
+        return 0;
+    }
+    const auto matches = static_cast<const FingerprintIndex_c*>(index)->query(
+        {hashes, size_t(count)},
+        (minSimilarity > 0) ? minSimilarity : FingerprintIndex_c::cDefMinSimilarity,
+        {outMatches, size_t(maxMatches)}
+    );
+    return int(matches);
+}
+
+FFI_PLUGIN_EXPORT void mediaxx_fingerprint_index_free(void* index) {
+    delete static_cast<FingerprintIndex_c*>(index);
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_get_lyrics_malloc(
+    const char*                  filepath,
+    const char*                  headers,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    const char**                 outLog
+) {
+    assert(nullptr != filepath);
+    assert(nullptr != headers);
+    assert(nullptr != outResult);
+    *outResult = nullptr;
+    auto item  = MediaInfoItem_c{std::string_view{filepath}, outLog};
+    _applyRequestOptions(item, options);
+    LyricsDocument doc{};
+    const int      ret = LyricsReader_c::instance.read(item, headers, doc);
+    if (1 == ret) {
+        *outResult = stringxx::stringCopyMalloc(LyricsReader_c::build(doc)).data();
+    }
+    item.dispose();
+    return ret;
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_parse_lyrics_malloc(
+    const char*  text,
+    const size_t textSize,
+    const char** outResult
+) {
+    assert(nullptr != text || 0 == textSize);
+    assert(nullptr != outResult);
+    LyricsDocument doc{};
+    doc.source = MEDIAXX_LYRICS_SOURCE_TEXT;
+    if (nullptr != text) {
+        const auto view = std::string_view{text, textSize};
+        if (false == LyricsReader_c::parseLrc(view, doc)) {
+            doc.plainText = doc.addString(stringxx::strTrim(view));
+        }
+    }
+    *outResult = stringxx::stringCopyMalloc(LyricsReader_c::build(doc)).data();
+    return int(doc.lines.size());
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_get_tag_malloc(
+    const char*                  filepath,
+    const char*                  headers,
+    const char*                  key,
+    int                          streamIndex,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    const char**                 outLog
+) {
+    assert(nullptr != filepath);
+    assert(nullptr != headers);
+    assert(nullptr != key);
+    assert(nullptr != outResult);
+    *outResult = nullptr;
+    auto item  = MediaInfoItem_c{std::string_view{filepath}, outLog};
+    _applyRequestOptions(item, options);
+    // 只需要标签，不探测流
+    item.setFieldMask(MEDIAXX_FIELD_FORMAT_TAGS | MEDIAXX_FIELD_STREAM_TAGS);
+    if (false == MediaInfoReader_c::instance.openFile(item, headers)) {
+        const int ret = item.isInterrupted() ? -2 : -1;
+        item.dispose();
+        return ret;
+    }
+
+    AVDictionary* metadata = nullptr;
+    if (streamIndex < 0) {
+        metadata = item.fmtCtx->metadata;
+    } else if (unsigned(streamIndex) < item.fmtCtx->nb_streams) {
+        metadata = item.fmtCtx->streams[streamIndex]->metadata;
+    }
+    int ret = 0;
+    if (const auto tag = av_dict_get(metadata, key, nullptr, 0); nullptr != tag) {
+        *outResult = stringxx::stringCopyMalloc(tag->value).data();
+        ret        = 1;
+    }
+    item.dispose();
+    return ret;
+}
+
+FFI_PLUGIN_EXPORT void* mediaxx_library_watcher_create(const char** outLog) {
+    assert(nullptr != outLog);
+    auto logItem = analyse_tool::AnalyseLogItem_c{outLog};
+    auto watcher = new LibraryWatcher_c{};
+    if (false == watcher->init(logItem)) {
+        delete watcher;
+        return nullptr;
+    }
+    return watcher;
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_library_watcher_add_root(
+    void*        watcher,
+    const char*  rootPath,
+    const char** outLog
+) {
+    assert(nullptr != watcher);
+    assert(nullptr != rootPath);
+    assert(nullptr != outLog);
+    auto logItem = analyse_tool::AnalyseLogItem_c{outLog};
+    return static_cast<LibraryWatcher_c*>(watcher)->addRoot(rootPath, logItem) ? 1 : 0;
+}
+
+FFI_PLUGIN_EXPORT int mediaxx_library_watcher_poll_malloc(
+    void*        watcher,
+    int          timeoutMs,
+    int          debounceMs,
+    int          probe,
+    const char** outResult,
+    const char** outLog
+) {
+    assert(nullptr != watcher);
+    assert(nullptr != outResult);
+    assert(nullptr != outLog);
+    *outResult   = nullptr;
+    auto logItem = analyse_tool::AnalyseLogItem_c{outLog};
+    auto self    = static_cast<LibraryWatcher_c*>(watcher);
+    if (false == self->isAvail()) {
+        logItem.setLog("监听未初始化");
+        return -1;
+    }
+    auto deltas = self->poll(timeoutMs, debounceMs, logItem);
+
+    simdjson::builder::string_builder sb{};
+    sb.start_array();
+    bool isFirst = true;
+    for (const auto& delta : deltas) {
+        if (false == isFirst) {
+            sb.append_comma();
+        }
+        isFirst = false;
+        sb.start_object();
+        sb.append_key_value<"type">(int(delta.type));
+        sb.append_comma();
+        sb.append_key_value<"path">(std::string_view{delta.path});
+        sb.append_comma();
+        sb.append_key_value<"is_dir">(delta.isDir);
+        // 只重新读取新增/修改的文件
+        if (0 != probe && false == delta.isDir
+            && (delta.type == LibraryDeltaType::Add || delta.type == LibraryDeltaType::Update)) {
+            sb.append_comma();
+            _appendMediaInfo(sb, delta.path, "");
+        }
+        sb.end_object();
+    }
+    sb.end_array();
+    *outResult = stringxx::stringCopyMalloc(sb.view().value_unsafe()).data();
+    return int(deltas.size());
+}
+
+FFI_PLUGIN_EXPORT void mediaxx_library_watcher_free(void* watcher) {
+    delete static_cast<LibraryWatcher_c*>(watcher);
+}
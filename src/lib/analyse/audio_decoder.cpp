@@ -0,0 +1,305 @@
+#include "audio_decoder.h"
+#include "util/log.h"
+#include <algorithm>
+#include <cstring>
+
+bool AudioDecoder_c::open(MediaInfoItem_c& in_item, int sampleRate, int channels, int threads) {
+    close();
+    item = &in_item;
+
+    const AVCodec* decoder = nullptr;
+    audioIndex = av_find_best_stream(item->fmtCtx, AVMEDIA_TYPE_AUDIO, -1, -1, &decoder, 0);
+    if (AVERROR_STREAM_NOT_FOUND == audioIndex) {
+        setError(MEDIAXX_DIAG_ERR_NO_AUDIO);
+        close();
+        return false;
+    }
+    if (audioIndex < 0 || nullptr == decoder) {
+        setError(MEDIAXX_DIAG_ERR_NO_DECODER, std::min(audioIndex, 0));
+        close();
+        return false;
+    }
+
+    const auto stream = item->fmtCtx->streams[audioIndex];
+    codecCtx          = avcodec_alloc_context3(decoder);
+    frame             = av_frame_alloc();
+    packet            = av_packet_alloc();
+    if (nullptr == codecCtx || nullptr == frame || nullptr == packet) {
+        setError(MEDIAXX_DIAG_ERR_NO_MEMORY);
+        close();
+        return false;
+    }
+    int ret = avcodec_parameters_to_context(codecCtx, stream->codecpar);
+    if (ret >= 0) {
+        codecCtx->pkt_timebase = stream->time_base;
+        if (threads > 1) {
+            codecCtx->thread_count = threads;
+            codecCtx->thread_type  = FF_THREAD_FRAME | FF_THREAD_SLICE;
+        }
+        ret = avcodec_open2(codecCtx, decoder, nullptr);
+    }
+    if (ret < 0) {
+        setError(MEDIAXX_DIAG_ERR_DECODER_OPEN, ret);
+        close();
+        return false;
+    }
+
+    outSampleRate = sampleRate > 0 ? sampleRate : codecCtx->sample_rate;
+    outChannels   = channels > 0 ? channels : codecCtx->ch_layout.nb_channels;
+    if (outSampleRate <= 0 || outChannels <= 0) {
+        setError(MEDIAXX_DIAG_ERR_DECODER_OPEN);
+        close();
+        return false;
+    }
+
+    // 其他流的包在解复用时直接丢弃
+    for (unsigned int i = 0; i < item->fmtCtx->nb_streams; ++i) {
+        if (int(i) != audioIndex) {
+            item->fmtCtx->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+    return true;
+}
+
+void AudioDecoder_c::setError(unsigned short code, int avError) {
+    item->setError(MEDIAXX_DIAG_STAGE_AUDIO, code, avError, {}, std::max(audioIndex, -1));
+}
+
+void AudioDecoder_c::close() {
+    swr_free(&swrCtx);
+    avcodec_free_context(&codecCtx);
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    av_channel_layout_uninit(&swrInLayout);
+    swrInRate   = 0;
+    swrInFormat = -1;
+    pending.clear();
+    pendingPos    = 0;
+    nextFrame     = 0;
+    discardFrames = 0;
+    seekTarget    = 0;
+    decoderEof    = false;
+    error         = 0;
+    audioIndex    = -1;
+    outSampleRate = 0;
+    outChannels   = 0;
+    item          = nullptr;
+}
+
+int64_t AudioDecoder_c::estimatedFrames() const {
+    if (nullptr == codecCtx) {
+        return 0;
+    }
+    const auto stream = item->fmtCtx->streams[audioIndex];
+    if (stream->duration > 0) {
+        return av_rescale_q(stream->duration, stream->time_base, AVRational{1, outSampleRate});
+    }
+    if (item->fmtCtx->duration > 0) {
+        return av_rescale(item->fmtCtx->duration, outSampleRate, AV_TIME_BASE);
+    }
+    return 0;
+}
+
+bool AudioDecoder_c::setupResampler(const AVFrame* in) {
+    if (nullptr != swrCtx && in->sample_rate == swrInRate && in->format == swrInFormat
+        && 0 == av_channel_layout_compare(&in->ch_layout, &swrInLayout)) {
+        return true;
+    }
+    // 参数在流中途变化（如电台切换节目）时重建，旧的重采样器中缓存的少量采样丢弃
+    swr_free(&swrCtx);
+    AVChannelLayout inLayout{};
+    if (AV_CHANNEL_ORDER_UNSPEC == in->ch_layout.order) {
+        av_channel_layout_default(&inLayout, in->ch_layout.nb_channels);
+    } else {
+        av_channel_layout_copy(&inLayout, &in->ch_layout);
+    }
+    AVChannelLayout outLayout{};
+    av_channel_layout_default(&outLayout, outChannels);
+    int ret = swr_alloc_set_opts2(
+        &swrCtx,
+        &outLayout,
+        AV_SAMPLE_FMT_FLT,
+        outSampleRate,
+        &inLayout,
+        AVSampleFormat(in->format),
+        in->sample_rate,
+        0,
+        nullptr
+    );
+    av_channel_layout_uninit(&inLayout);
+    av_channel_layout_uninit(&outLayout);
+    if (ret >= 0) {
+        ret = swr_init(swrCtx);
+    }
+    if (ret < 0) {
+        setError(MEDIAXX_DIAG_ERR_DECODER_OPEN, ret);
+        swr_free(&swrCtx);
+        return false;
+    }
+    swrInRate   = in->sample_rate;
+    swrInFormat = in->format;
+    av_channel_layout_uninit(&swrInLayout);
+    av_channel_layout_copy(&swrInLayout, &in->ch_layout);
+    return true;
+}
+
+int AudioDecoder_c::decodeFrame() {
+    while (true) {
+        int ret = avcodec_receive_frame(codecCtx, frame);
+        if (0 == ret || AVERROR_EOF == ret) {
+            return ret;
+        }
+        if (AVERROR_INVALIDDATA == ret) {
+            // 帧线程解码时损坏的数据在这里报告，跳过这一帧
+            LXX_DEBEG("AudioDecoder | skip frame: {}", utilxx::av_err2str(ret));
+            continue;
+        }
+        if (AVERROR(EAGAIN) != ret) {
+            setError(MEDIAXX_DIAG_ERR_DECODE, ret);
+            return ret;
+        }
+        if (item->isInterrupted()) {
+            return AVERROR_EXIT;
+        }
+
+        ret = av_read_frame(item->fmtCtx, packet);
+        if (ret < 0) {
+            if (item->isInterrupted()) {
+                return AVERROR_EXIT;
+            }
+            // 读取出错时已解码的部分仍然有效，当作结束处理
+            if (AVERROR_EOF != ret) {
+                setError(MEDIAXX_DIAG_ERR_READ, ret);
+            }
+            avcodec_send_packet(codecCtx, nullptr);
+            continue;
+        }
+        if (packet->stream_index == audioIndex) {
+            // 损坏的包只跳过这一个，不影响后面的
+            ret = avcodec_send_packet(codecCtx, packet);
+            if (ret < 0) {
+                LXX_DEBEG("AudioDecoder | skip packet: {}", utilxx::av_err2str(ret));
+            }
+        }
+        av_packet_unref(packet);
+    }
+}
+
+int AudioDecoder_c::takePending(float* dst, int frames) {
+    if (pendingPos >= pending.size()) {
+        return 0;
+    }
+    const auto count = std::min<size_t>(frames, (pending.size() - pendingPos) / outChannels);
+    std::memcpy(dst, pending.data() + pendingPos, count * outChannels * sizeof(float));
+    pendingPos += count * outChannels;
+    return int(count);
+}
+
+int AudioDecoder_c::convert(const AVFrame* in, float* dst, int frames) {
+    const int  inCount = (nullptr != in) ? in->nb_samples : 0;
+    const auto inData  = (nullptr != in) ? const_cast<const uint8_t**>(in->extended_data) : nullptr;
+    // 本次最多输出的帧数，包括重采样器中缓存的
+    const int  maxOut  = swr_get_out_samples(swrCtx, inCount);
+    if (maxOut <= 0) {
+        return maxOut;
+    }
+    if (maxOut <= frames && 0 == discardFrames) {
+        auto out = reinterpret_cast<uint8_t*>(dst);
+        return swr_convert(swrCtx, &out, frames, inData, inCount);
+    }
+
+    // 放不下、或者需要丢弃开头时才经过 [pending]
+    pending.resize(size_t(maxOut) * outChannels);
+    pendingPos = 0;
+    auto      out   = reinterpret_cast<uint8_t*>(pending.data());
+    const int count = swr_convert(swrCtx, &out, maxOut, inData, inCount);
+    if (count < 0) {
+        pending.clear();
+        return count;
+    }
+    pending.resize(size_t(count) * outChannels);
+    if (discardFrames > 0) {
+        const auto drop = std::min<int64_t>(discardFrames, count);
+        pendingPos      = size_t(drop) * outChannels;
+        discardFrames -= drop;
+    }
+    return takePending(dst, frames);
+}
+
+int AudioDecoder_c::read(float* dst, int frames) {
+    if (nullptr == codecCtx) {
+        return AVERROR(EINVAL);
+    }
+    int done = 0;
+    while (true) {
+        done += takePending(dst + size_t(done) * outChannels, frames - done);
+        if (done >= frames || decoderEof || 0 != error) {
+            break;
+        }
+
+        int ret = decodeFrame();
+        if (AVERROR_EOF == ret) {
+            // 取出重采样器中剩余的数据
+            decoderEof = true;
+            ret        = (nullptr != swrCtx)
+                           ? convert(nullptr, dst + size_t(done) * outChannels, frames - done)
+                           : 0;
+        } else if (0 == ret) {
+            if (discardFrames < 0) {
+                // 跳转后的第一帧：按时间戳算出目标之前需要丢弃的部分
+                const auto stream = item->fmtCtx->streams[audioIndex];
+                auto       pts    = frame->best_effort_timestamp;
+                discardFrames     = 0;
+                if (AV_NOPTS_VALUE != pts) {
+                    if (AV_NOPTS_VALUE != stream->start_time) {
+                        pts -= stream->start_time;
+                    }
+                    const auto start
+                        = av_rescale_q(pts, stream->time_base, AVRational{1, outSampleRate});
+                    discardFrames = std::max<int64_t>(0, seekTarget - start);
+                }
+            }
+            ret = setupResampler(frame)
+                    ? convert(frame, dst + size_t(done) * outChannels, frames - done)
+                    : AVERROR(EINVAL);
+            av_frame_unref(frame);
+        }
+        if (ret < 0) {
+            error = ret;
+            break;
+        }
+        done += ret;
+    }
+
+    nextFrame += done;
+    return (0 == done && 0 != error) ? error : done;
+}
+
+bool AudioDecoder_c::seek(int64_t target) {
+    if (nullptr == codecCtx) {
+        return false;
+    }
+    target            = std::max<int64_t>(target, 0);
+    const auto stream = item->fmtCtx->streams[audioIndex];
+    auto       ts     = av_rescale_q(target, AVRational{1, outSampleRate}, stream->time_base);
+    if (AV_NOPTS_VALUE != stream->start_time) {
+        ts += stream->start_time;
+    }
+    const int ret = avformat_seek_file(item->fmtCtx, audioIndex, INT64_MIN, ts, ts, 0);
+    if (ret < 0) {
+        setError(MEDIAXX_DIAG_ERR_READ, ret);
+        return false;
+    }
+
+    avcodec_flush_buffers(codecCtx);
+    // 重采样器在下一帧时重建，丢弃跳转前缓存的数据
+    swr_free(&swrCtx);
+    pending.clear();
+    pendingPos    = 0;
+    decoderEof    = false;
+    error         = 0;
+    seekTarget    = target;
+    discardFrames = -1;
+    nextFrame     = target;
+    return true;
+}
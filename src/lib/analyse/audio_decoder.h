@@ -0,0 +1,117 @@
+#pragma once
+
+extern "C" {
+#include "libavcodec/avcodec.h"
+#include "libavformat/avformat.h"
+#include "libswresample/swresample.h"
+}
+
+#include "analyse/media_info_reader.h"
+#include <cstdint>
+#include <vector>
+
+/// # 音频解码
+/// - 解码 [MediaInfoItem_c] 中已打开的文件的最佳音频流，经 libswresample 转为交错的 float
+/// - 拉取式：[read] 尽量直接写入调用方的缓冲区，一帧放不下时才经过内部缓冲
+/// - 每个实例有独立的解码器状态，不同实例可以在不同线程中同时使用；[item] 需要比实例活得久
+class AudioDecoder_c {
+public:
+
+    AudioDecoder_c() = default;
+
+    ~AudioDecoder_c() {
+        close();
+    }
+
+    AudioDecoder_c(const AudioDecoder_c&)            = delete;
+    AudioDecoder_c& operator=(const AudioDecoder_c&) = delete;
+
+    /// [sampleRate]、[channels] 为 0 时与源相同；声道数不同时由 libswresample 混音
+    /// - [threads] > 1 时启用解码器的帧/切片多线程（解码器支持时）
+    /// - 失败时错误已记录到 [item]
+    bool open(MediaInfoItem_c& item, int sampleRate = 0, int channels = 0, int threads = 1);
+
+    /// 读取最多 [frames] 帧到 [dst]（交错排列，共 frames * [channels] 个 float）
+    /// - 返回实际读取的帧数，只有结束时才少于 [frames]；0 表示已结束
+    /// - < 0 为请求已取消（AVERROR_EXIT）或读取失败
+    int read(float* dst, int frames);
+
+    /// 跳转到第 [frame] 帧（输出采样率下的序号），精确到采样
+    bool seek(int64_t frame);
+
+    void close();
+
+    int sampleRate() const {
+        return outSampleRate;
+    }
+
+    int channels() const {
+        return outChannels;
+    }
+
+    /// 源的声道数
+    int sourceChannels() const {
+        return nullptr == codecCtx ? 0 : codecCtx->ch_layout.nb_channels;
+    }
+
+    /// 源的采样率
+    int sourceSampleRate() const {
+        return nullptr == codecCtx ? 0 : codecCtx->sample_rate;
+    }
+
+    int streamIndex() const {
+        return audioIndex;
+    }
+
+    /// 按容器时长估计的总帧数（输出采样率），未知时为 0
+    int64_t estimatedFrames() const;
+
+    /// 下一次 [read] 的第一帧的序号
+    int64_t position() const {
+        return nextFrame;
+    }
+
+protected:
+
+    MediaInfoItem_c* item       = nullptr;
+    AVCodecContext*  codecCtx   = nullptr;
+    SwrContext*      swrCtx     = nullptr;
+    AVFrame*         frame      = nullptr;
+    AVPacket*        packet     = nullptr;
+    int              audioIndex = -1;
+
+    int outSampleRate = 0;
+    int outChannels   = 0;
+
+    // [swrCtx] 当前的输入参数，流中途变化时重建
+    int             swrInRate   = 0;
+    int             swrInFormat = -1;
+    AVChannelLayout swrInLayout{};
+
+    // 一帧放不下时的剩余部分，交错排列
+    std::vector<float> pending{};
+    size_t             pendingPos = 0;
+
+    int64_t nextFrame = 0;
+    // 跳转后需要丢弃的帧数；< 0 表示等待跳转后的第一帧确定
+    int64_t discardFrames = 0;
+    int64_t seekTarget    = 0;
+
+    bool decoderEof = false;
+    // 读取中途出错时先返回已读取的部分，下一次 [read] 再返回错误
+    int  error      = 0;
+
+    /// 记录 [MEDIAXX_DIAG_STAGE_AUDIO] 阶段的错误
+    void setError(unsigned short code, int avError = 0);
+
+    bool setupResampler(const AVFrame* in);
+
+    /// 解码下一帧到 [frame]；返回 0 成功，AVERROR_EOF 结束，其他为错误
+    int decodeFrame();
+
+    /// 把 [frame]（为空时为重采样器的剩余数据）转换到 [dst]，放不下的部分写入 [pending]
+    int convert(const AVFrame* in, float* dst, int frames);
+
+    /// 从 [pending] 复制到 [dst]，返回帧数
+    int takePending(float* dst, int frames);
+};
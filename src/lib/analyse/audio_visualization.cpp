@@ -1,25 +1,396 @@
-extern "C" {
-#include "libavcodec/avcodec.h"
-#include "libavfilter/avfilter.h"
-#include "libavfilter/buffersink.h"
-#include "libavfilter/buffersrc.h"
-#include "libavformat/avformat.h"
-#include "libavutil/avutil.h"
-#include "libavutil/opt.h"
-#include "libswresample/swresample.h"
-}
-
 #include "audio_visualization.h"
+#include "analyse/audio_decoder.h"
+#include "analyse/spectrum.h"
+#include "util/log.h"
+#include <algorithm>
+#include <bit>
 #include <cmath>
 #include <cstring>
 #include <fstream>
-#include <iostream>
-#include <stdint.h>
-#include <util/utilxx.h>
+#include <limits>
 #include <vector>
 
 AudioVisualization_c AudioVisualization_c::instance = AudioVisualization_c();
 
-bool AudioVisualization_c::analyse(const char* input_filename, const char* output_filename) {
-    return true;
+namespace {
+    // 每次解码的帧数
+    constexpr int    cReadFrames = 16384;
+    // 每次写入/合并的点数
+    constexpr size_t cPointBatch = 4096;
+
+    // 频谱图的默认参数
+    constexpr int   cSpectrumSampleRate = 22050;
+    constexpr int   cSpectrumFftSize    = 2048;
+    constexpr int   cSpectrumBandCount  = 64;
+    constexpr float cSpectrumMinFreq    = 20;
+    // 量化范围（dBFS）
+    constexpr float cSpectrumMinDb      = -90;
+    constexpr float cSpectrumMaxDb      = 0;
+    // 每次写入的字节数
+    constexpr size_t cSpectrumBatch     = 65536;
+
+    signed char quantizeSample(float value) {
+        return static_cast<signed char>(std::lrint(std::clamp(value, -1.0f, 1.0f) * 127.0f));
+    }
+
+    unsigned char quantizeRms(double rms) {
+        return static_cast<unsigned char>(std::lrint(std::clamp(rms, 0.0, 1.0) * 255.0));
+    }
+
+    /// 一个点的统计
+    struct PointStat {
+        float        min        = std::numeric_limits<float>::max();
+        float        max        = std::numeric_limits<float>::lowest();
+        double       sumSquares = 0;
+        unsigned int count      = 0;
+
+        void add(const float* samples, unsigned int size) {
+            auto  lo = min;
+            auto  hi = max;
+            float sq = 0;
+            for (unsigned int i = 0; i < size; ++i) {
+                const auto v = samples[i];
+                lo           = v < lo ? v : lo;
+                hi           = v > hi ? v : hi;
+                sq += v * v;
+            }
+            min = lo;
+            max = hi;
+            sumSquares += sq;
+            count += size;
+        }
+
+        MediaxxWaveformPoint toPoint() const {
+            return MediaxxWaveformPoint{
+                quantizeSample(min),
+                quantizeSample(max),
+                quantizeRms(std::sqrt(sumSquares / count)),
+                0
+            };
+        }
+    };
+
+    /// 相邻两个点合并为上一级的一个点；RMS 按能量平均
+    MediaxxWaveformPoint mergePoints(const MediaxxWaveformPoint& a, const MediaxxWaveformPoint& b) {
+        const auto energy = (double(a.rms) * a.rms + double(b.rms) * b.rms) / 2;
+        return MediaxxWaveformPoint{
+            std::min(a.min, b.min),
+            std::max(a.max, b.max),
+            static_cast<unsigned char>(std::lrint(std::sqrt(energy))),
+            0
+        };
+    }
+
+    /// 读回 [source] 级合并出 [target] 级，写在文件末尾
+    bool buildLevel(
+        std::fstream&               file,
+        const MediaxxWaveformLevel& source,
+        const MediaxxWaveformLevel& target
+    ) {
+        std::vector<MediaxxWaveformPoint> input(cPointBatch * 2);
+        std::vector<MediaxxWaveformPoint> output(cPointBatch);
+        for (unsigned int done = 0; done < source.pointCount;) {
+            const auto count = std::min<size_t>(input.size(), source.pointCount - done);
+            file.seekg(source.pointOffset + std::streamoff(done) * sizeof(MediaxxWaveformPoint));
+            file.read(
+                reinterpret_cast<char*>(input.data()),
+                std::streamsize(count * sizeof(MediaxxWaveformPoint))
+            );
+            // 点数为奇数时最后一个点单独成为上一级的点
+            const auto outCount = (count + 1) / 2;
+            for (size_t i = 0; i < outCount; ++i) {
+                const auto& a = input[i * 2];
+                output[i]     = (i * 2 + 1 < count) ? mergePoints(a, input[i * 2 + 1]) : a;
+            }
+            const auto outPos = std::streamoff(done / 2) * sizeof(MediaxxWaveformPoint);
+            file.seekp(target.pointOffset + outPos);
+            file.write(
+                reinterpret_cast<const char*>(output.data()),
+                std::streamsize(outCount * sizeof(MediaxxWaveformPoint))
+            );
+            if (false == bool(file)) {
+                return false;
+            }
+            done += unsigned(count);
+        }
+        return true;
+    }
+
+    /// 打开文件和音频流，返回值同 [AudioVisualization_c::analyse]，1 表示成功
+    int openAudio(
+        MediaInfoItem_c& item,
+        std::string_view headers,
+        AudioDecoder_c&  decoder,
+        int              sampleRate
+    ) {
+        // 解码需要完整的流参数
+        item.probeStreams = true;
+        if (false == MediaInfoReader_c::instance.openFile(item, headers)) {
+            return item.isInterrupted() ? -2 : -1;
+        }
+        return decoder.open(item, sampleRate, 1) ? 1 : 0;
+    }
+
+    bool openOutput(MediaInfoItem_c& item, std::string_view outputPath, std::fstream& file) {
+        constexpr auto cMode = std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary;
+        file.open(std::filesystem::path(outputPath), cMode);
+        if (false == file.is_open()) {
+            item.setError(MEDIAXX_DIAG_STAGE_AUDIO, MEDIAXX_DIAG_ERR_WRITE, 0, outputPath);
+            return false;
+        }
+        return true;
+    }
+
+    /// 为 0 的参数替换为默认值，并限制范围
+    MediaxxSpectrumOptions normalizeSpectrum(const MediaxxSpectrumOptions* spectrum) {
+        auto params = (nullptr != spectrum) ? *spectrum : MediaxxSpectrumOptions{};
+        if (0 == params.sampleRate) {
+            params.sampleRate = cSpectrumSampleRate;
+        }
+        if (params.fftSize <= 0) {
+            params.fftSize = cSpectrumFftSize;
+        }
+        params.fftSize = int(std::bit_ceil(unsigned(std::clamp(params.fftSize, 64, 32768))));
+        if (params.hopSize <= 0) {
+            params.hopSize = params.fftSize / 2;
+        }
+        if (params.bandCount <= 0) {
+            params.bandCount = cSpectrumBandCount;
+        }
+        params.hopSize   = std::min(params.hopSize, params.fftSize);
+        params.bandCount = std::min(params.bandCount, params.fftSize / 2);
+        return params;
+    }
+
+    /// 失败时不保留不完整的输出文件
+    void removeOutput(std::fstream& file, std::string_view outputPath) {
+        file.close();
+        std::error_code ec{};
+        std::filesystem::remove(std::filesystem::path(outputPath), ec);
+    }
+} // namespace
+
+int AudioVisualization_c::analyse(
+    MediaInfoItem_c& item,
+    std::string_view headers,
+    std::string_view outputPath
+) {
+    AudioDecoder_c decoder{};
+    if (const int ret = openAudio(item, headers, decoder, 0); 1 != ret) {
+        return ret;
+    }
+    std::fstream file{};
+    if (false == openOutput(item, outputPath, file)) {
+        return -1;
+    }
+    const auto fail = [&](int ret) {
+        removeOutput(file, outputPath);
+        return ret;
+    };
+
+    MediaxxWaveformHeader header{};
+    header.magic      = MEDIAXX_WAVEFORM_MAGIC;
+    header.version    = MEDIAXX_WAVEFORM_VERSION;
+    header.headerSize = uint16_t(sizeof(MediaxxWaveformHeader));
+    header.sampleRate = unsigned(decoder.sampleRate());
+    header.channels   = unsigned(decoder.sourceChannels());
+    // 占位，最后再写入
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // 第 0 级：边解码边写入
+    std::vector<float>                samples(cReadFrames);
+    std::vector<MediaxxWaveformPoint> points{};
+    points.reserve(cPointBatch);
+    PointStat    stat{};
+    unsigned int pointCount = 0;
+    const auto   flush      = [&] {
+        file.write(
+            reinterpret_cast<const char*>(points.data()),
+            std::streamsize(points.size() * sizeof(MediaxxWaveformPoint))
+        );
+        pointCount += unsigned(points.size());
+        points.clear();
+    };
+    while (true) {
+        const int frames = decoder.read(samples.data(), cReadFrames);
+        if (frames <= 0) {
+            if (item.isInterrupted()) {
+                return fail(-2);
+            }
+            // 中途解码失败时保留已解码的部分，错误已记录
+            break;
+        }
+        header.totalSamples += unsigned(frames);
+        for (int pos = 0; pos < frames;) {
+            const auto size = std::min<unsigned>(cBasePointSamples - stat.count, frames - pos);
+            stat.add(samples.data() + pos, size);
+            pos += int(size);
+            if (stat.count == cBasePointSamples) {
+                points.push_back(stat.toPoint());
+                stat = PointStat{};
+                if (points.size() == cPointBatch) {
+                    flush();
+                }
+            }
+        }
+    }
+    if (stat.count > 0) {
+        points.push_back(stat.toPoint());
+    }
+    flush();
+    if (0 == header.totalSamples) {
+        item.setError(MEDIAXX_DIAG_STAGE_AUDIO, MEDIAXX_DIAG_ERR_DECODE);
+        return fail(0);
+    }
+
+    // 逐级合并
+    header.levels[0] = MediaxxWaveformLevel{
+        cBasePointSamples,
+        pointCount,
+        unsigned(sizeof(MediaxxWaveformHeader))
+    };
+    header.levelCount = 1;
+    while (header.levelCount < MEDIAXX_WAVEFORM_MAX_LEVELS) {
+        const auto& source = header.levels[header.levelCount - 1];
+        if (source.pointCount <= cMaxTopPoints) {
+            break;
+        }
+        const auto target = MediaxxWaveformLevel{
+            source.samplesPerPoint * 2,
+            (source.pointCount + 1) / 2,
+            unsigned(source.pointOffset + source.pointCount * sizeof(MediaxxWaveformPoint))
+        };
+        if (false == buildLevel(file, source, target)) {
+            break;
+        }
+        header.levels[header.levelCount++] = target;
+    }
+    const auto& last = header.levels[header.levelCount - 1];
+    header.totalSize = unsigned(last.pointOffset + last.pointCount * sizeof(MediaxxWaveformPoint));
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.flush();
+    if (false == bool(file)) {
+        item.setError(MEDIAXX_DIAG_STAGE_AUDIO, MEDIAXX_DIAG_ERR_WRITE, 0, outputPath);
+        return fail(-1);
+    }
+    LXX_DEBEG(
+        "AudioVisualization | {} samples, {} levels: {}",
+        header.totalSamples,
+        header.levelCount,
+        item.filepath
+    );
+    return 1;
+}
+
+int AudioVisualization_c::analyseSpectrum(
+    MediaInfoItem_c&              item,
+    std::string_view              headers,
+    std::string_view              outputPath,
+    const MediaxxSpectrumOptions* spectrum
+) {
+    const auto params = normalizeSpectrum(spectrum);
+
+    AudioDecoder_c decoder{};
+    // < 0 时使用源的采样率
+    const int openRet = openAudio(item, headers, decoder, std::max(params.sampleRate, 0));
+    if (1 != openRet) {
+        return openRet;
+    }
+    const auto sampleRate = decoder.sampleRate();
+    const auto minFreq    = (params.minFreq > 0) ? params.minFreq : cSpectrumMinFreq;
+    const auto maxFreq    = (params.maxFreq > 0) ? params.maxFreq : sampleRate / 2.0f;
+
+    SpectrumAnalyzer_c analyzer{};
+    if (false == analyzer.init(sampleRate, params.fftSize, params.bandCount, minFreq, maxFreq)) {
+        item.setError(MEDIAXX_DIAG_STAGE_AUDIO, MEDIAXX_DIAG_ERR_NO_MEMORY, analyzer.initError());
+        return 0;
+    }
+    std::fstream file{};
+    if (false == openOutput(item, outputPath, file)) {
+        return -1;
+    }
+    const auto fail = [&](int ret) {
+        removeOutput(file, outputPath);
+        return ret;
+    };
+
+    const auto& edges = analyzer.bandEdges();
+
+    MediaxxSpectrumHeader header{};
+    header.magic          = MEDIAXX_SPECTRUM_MAGIC;
+    header.version        = MEDIAXX_SPECTRUM_VERSION;
+    header.headerSize     = uint16_t(sizeof(MediaxxSpectrumHeader));
+    header.sampleRate     = unsigned(sampleRate);
+    header.fftSize        = unsigned(params.fftSize);
+    header.hopSize        = unsigned(params.hopSize);
+    header.bandCount      = unsigned(params.bandCount);
+    header.minDb          = cSpectrumMinDb;
+    header.maxDb          = cSpectrumMaxDb;
+    header.bandEdgeOffset = unsigned(sizeof(MediaxxSpectrumHeader));
+    header.dataOffset     = unsigned(header.bandEdgeOffset + edges.size() * sizeof(float));
+    // 占位，最后再写入
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(
+        reinterpret_cast<const char*>(edges.data()),
+        std::streamsize(edges.size() * sizeof(float))
+    );
+
+    const auto fftSize = size_t(params.fftSize);
+    const auto hopSize = size_t(params.hopSize);
+    // 当前窗口，每帧左移 [hopSize] 后在末尾补充新的采样
+    std::vector<float>         window(fftSize);
+    std::vector<float>         bandDb(params.bandCount);
+    std::vector<unsigned char> data{};
+    data.reserve(cSpectrumBatch + params.bandCount);
+    const auto flush = [&] {
+        file.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+        data.clear();
+    };
+    const auto dbScale = 255.0f / (cSpectrumMaxDb - cSpectrumMinDb);
+
+    // 新读取的采样数，为 0 时已没有新数据
+    auto filled = size_t(std::max(decoder.read(window.data(), int(fftSize)), 0));
+    while (filled > 0) {
+        analyzer.process(window.data(), bandDb.data());
+        for (const auto db : bandDb) {
+            const auto level = std::clamp((db - cSpectrumMinDb) * dbScale, 0.0f, 255.0f);
+            data.push_back(static_cast<unsigned char>(std::lrint(level)));
+        }
+        ++header.frameCount;
+        if (data.size() >= cSpectrumBatch) {
+            flush();
+        }
+
+        std::memmove(window.data(), window.data() + hopSize, (fftSize - hopSize) * sizeof(float));
+        const auto tail = window.data() + (fftSize - hopSize);
+        filled          = size_t(std::max(decoder.read(tail, int(hopSize)), 0));
+        // 结束时最后一帧不足的部分补 0
+        std::fill(tail + filled, tail + hopSize, 0.0f);
+    }
+    if (item.isInterrupted()) {
+        return fail(-2);
+    }
+    flush();
+    if (0 == header.frameCount) {
+        item.setError(MEDIAXX_DIAG_STAGE_AUDIO, MEDIAXX_DIAG_ERR_DECODE);
+        return fail(0);
+    }
+
+    header.totalSize = unsigned(header.dataOffset + header.frameCount * header.bandCount);
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.flush();
+    if (false == bool(file)) {
+        item.setError(MEDIAXX_DIAG_STAGE_AUDIO, MEDIAXX_DIAG_ERR_WRITE, 0, outputPath);
+        return fail(-1);
+    }
+    LXX_DEBEG(
+        "AudioVisualization | spectrum {} frames x {} bands: {}",
+        header.frameCount,
+        header.bandCount,
+        item.filepath
+    );
+    return 1;
 }
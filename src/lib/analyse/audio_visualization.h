@@ -1,13 +1,35 @@
 #pragma once
 
+#include "analyse/media_info_reader.h"
+#include <string_view>
+
+/// # 音频波形和频谱图
+/// - 解码为单声道后边解码边写入文件，内存占用与时长无关
+/// - 波形：每 [cBasePointSamples] 个采样统计一个点的最小值、最大值和 RMS 写入第 0 级，
+///   结束后从文件中读回逐级合并
+/// - 频谱图：重叠的窗口经 [SpectrumAnalyzer_c] 得到各频带的能量，量化为 1 字节
 class AudioVisualization_c {
 public:
 
     static AudioVisualization_c instance;
 
+    /// 第 0 级每个点的采样数
+    static constexpr unsigned int cBasePointSamples = 512;
+    /// 最粗的一级不超过的点数
+    static constexpr unsigned int cMaxTopPoints     = 1024;
+
     AudioVisualization_c() {}
 
     ~AudioVisualization_c() {}
 
-    bool analyse(const char* input_filename, const char* output_filename);
+    /// 返回值同 [mediaxx_get_audio_visualization]；失败时不保留输出文件
+    int analyse(MediaInfoItem_c& item, std::string_view headers, std::string_view outputPath);
+
+    /// 返回值同 [analyse]；[spectrum] 为空或其中为 0 的参数使用默认值
+    int analyseSpectrum(
+        MediaInfoItem_c&              item,
+        std::string_view              headers,
+        std::string_view              outputPath,
+        const MediaxxSpectrumOptions* spectrum
+    );
 };
@@ -0,0 +1,107 @@
+#include "batch_stream.h"
+#include "util/log.h"
+#include <cassert>
+#include <cstring>
+#include <new>
+
+namespace {
+    constexpr size_t align8(size_t value) {
+        return (value + 7) & ~size_t(7);
+    }
+
+    /// 复制到 [base + offset]，返回块内的字符串；空串返回 nullptr
+    const char* copyString(char* base, size_t offset, std::string_view str) {
+        if (str.empty()) {
+            return nullptr;
+        }
+        memcpy(base + offset, str.data(), str.size());
+        base[offset + str.size()] = '\0';
+        return base + offset;
+    }
+
+    size_t stringSpace(std::string_view str) {
+        return str.empty() ? 0 : str.size() + 1;
+    }
+} // namespace
+
+BatchStream_c::~BatchStream_c() {
+    {
+        std::lock_guard lock{mutex};
+        closing = true;
+    }
+    cond.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void BatchStream_c::start(std::function<void(BatchStream_c&)> job) {
+    assert(false == worker.joinable());
+    worker = std::thread{[this, job = std::move(job)] { job(*this); }};
+}
+
+MediaxxStreamRecord* BatchStream_c::makeRecord(
+    int              kind,
+    int              index,
+    int              ret,
+    std::string_view path,
+    std::string_view result,
+    std::string_view log
+) {
+    const auto resultOffset = align8(sizeof(MediaxxStreamRecord));
+    const auto pathOffset   = resultOffset + align8(stringSpace(result));
+    const auto logOffset    = pathOffset + stringSpace(path);
+    const auto totalSize    = logOffset + stringSpace(log);
+
+    auto base = static_cast<char*>(mediaxx_malloc(totalSize));
+    if (nullptr == base) {
+        LXX_ERR("mediaxx_malloc failed: {}", totalSize);
+        return nullptr;
+    }
+    auto record        = new (base) MediaxxStreamRecord{};
+    record->kind       = kind;
+    record->index      = index;
+    record->ret        = ret;
+    record->resultSize = (unsigned int)result.size();
+    record->result     = copyString(base, resultOffset, result);
+    record->path       = copyString(base, pathOffset, path);
+    record->log        = copyString(base, logOffset, log);
+    return record;
+}
+
+bool BatchStream_c::post(
+    int              kind,
+    int              index,
+    int              ret,
+    std::string_view path,
+    std::string_view result,
+    std::string_view log
+) {
+    {
+        std::unique_lock lock{mutex};
+        cond.wait(lock, [this] { return closing || pending < maxPending; });
+        if (closing) {
+            return false;
+        }
+        ++pending;
+    }
+    // 在锁外复制和回调，回调中可以直接 [ack]
+    auto record = makeRecord(kind, index, ret, path, result, log);
+    if (nullptr == record) {
+        ack(1);
+        return false;
+    }
+    callback(userData, record);
+    return true;
+}
+
+void BatchStream_c::ack(int count) {
+    if (count <= 0) {
+        return;
+    }
+    {
+        std::lock_guard lock{mutex};
+        pending = (size_t(count) >= pending) ? 0 : pending - size_t(count);
+    }
+    cond.notify_all();
+}
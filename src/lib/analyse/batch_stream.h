@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mediaxx.h>
+#include <mutex>
+#include <string_view>
+#include <thread>
+
+/// # 流式批量任务
+/// - 任务在独立线程中执行，每完成一项就通过回调投递一条 [MediaxxStreamRecord]，不必等整批结束
+/// - 已投递但未 [ack] 的记录达到 [maxPending] 时暂停投递，消费方跟不上时不会无限堆积
+/// - 记录是单独的一块 mediaxx_malloc 内存，由消费方释放，可以晚于本对象释放
+class BatchStream_c {
+public:
+
+    inline static constexpr size_t cDefMaxPending = 16;
+
+    BatchStream_c(MediaxxStreamCallback in_callback, void* in_userData, int in_maxPending) :
+        callback(in_callback),
+        userData(in_userData),
+        maxPending(in_maxPending > 0 ? size_t(in_maxPending) : cDefMaxPending) {}
+
+    /// 停止投递并等待任务线程结束
+    ~BatchStream_c();
+
+    BatchStream_c(const BatchStream_c&)            = delete;
+    BatchStream_c& operator=(const BatchStream_c&) = delete;
+
+    /// 在任务线程中执行 [job]，只能调用一次
+    void start(std::function<void(BatchStream_c&)> job);
+
+    /// 投递一条记录；未确认的记录过多时等待，已关闭时返回 false
+    bool post(
+        int              kind,
+        int              index,
+        int              ret,
+        std::string_view path,
+        std::string_view result,
+        std::string_view log
+    );
+
+    /// 消费方处理完 [count] 条记录
+    void ack(int count);
+
+    bool isClosing() {
+        std::lock_guard lock{mutex};
+        return closing;
+    }
+
+protected:
+
+    MediaxxStreamCallback   callback;
+    void*                   userData;
+    const size_t            maxPending;
+    size_t                  pending = 0;
+    bool                    closing = false;
+    std::mutex              mutex{};
+    std::condition_variable cond{};
+    std::thread             worker{};
+
+    /// 复制到一块连续内存：[MediaxxStreamRecord] | 结果（8 字节对齐）| 路径 | 日志
+    static MediaxxStreamRecord* makeRecord(
+        int              kind,
+        int              index,
+        int              ret,
+        std::string_view path,
+        std::string_view result,
+        std::string_view log
+    );
+};
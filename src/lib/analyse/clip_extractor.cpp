@@ -0,0 +1,565 @@
+#include "clip_extractor.h"
+#include "analyse/audio_decoder.h"
+#include "util/log.h"
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+
+ClipExtractor_c ClipExtractor_c::instance = ClipExtractor_c();
+
+namespace {
+    // 源没有码率时，重新编码使用的码率
+    constexpr int64_t cDefBitrate   = 192000;
+    // 编码器不限制帧长时，每次送入的帧数
+    constexpr int     cDefFrameSize = 1024;
+
+    /// 输出的容器，析构时关闭文件
+    struct Output {
+        AVFormatContext* ctx = nullptr;
+
+        ~Output() {
+            if (nullptr == ctx) {
+                return;
+            }
+            if (false == bool(ctx->oformat->flags & AVFMT_NOFILE)) {
+                avio_closep(&ctx->pb);
+            }
+            avformat_free_context(ctx);
+        }
+    };
+
+    /// 重新编码的编码器和格式转换
+    struct Encoder {
+        AVCodecContext* ctx    = nullptr;
+        SwrContext*     swr    = nullptr;
+        AVFrame*        frame  = nullptr;
+        AVPacket*       packet = nullptr;
+
+        ~Encoder() {
+            avcodec_free_context(&ctx);
+            swr_free(&swr);
+            av_frame_free(&frame);
+            av_packet_free(&packet);
+        }
+    };
+
+    /// 附加图片（封面）在视频流中只有一个包，不是真正的视频
+    bool isAttachedPic(const AVStream* stream) {
+        return 0 != (stream->disposition & AV_DISPOSITION_ATTACHED_PIC);
+    }
+
+    /// 输出容器可以直接复制的音频或视频流
+    bool isCopyable(const AVOutputFormat* format, const AVStream* stream) {
+        const auto type = stream->codecpar->codec_type;
+        if ((type != AVMEDIA_TYPE_AUDIO && type != AVMEDIA_TYPE_VIDEO) || isAttachedPic(stream)) {
+            return false;
+        }
+        // < 0 表示容器没有声明支持的编码，交给写入时检查
+        return 0 != avformat_query_codec(format, stream->codecpar->codec_id, FF_COMPLIANCE_NORMAL);
+    }
+
+    /// 编码器支持的最接近 [sampleRate] 的采样率：优先不低于它的最小值
+    int pickSampleRate(const AVCodecContext* ctx, const AVCodec* codec, int sampleRate) {
+        const int* rates = nullptr;
+        int        count = 0;
+        if (avcodec_get_supported_config(
+                ctx, codec, AV_CODEC_CONFIG_SAMPLE_RATE, 0, (const void**)&rates, &count
+            ) < 0
+            || nullptr == rates || count <= 0) {
+            return sampleRate;
+        }
+        int above = 0;
+        int below = 0;
+        for (int i = 0; i < count; ++i) {
+            if (rates[i] == sampleRate) {
+                return sampleRate;
+            }
+            if (rates[i] > sampleRate) {
+                above = (0 == above) ? rates[i] : std::min(above, rates[i]);
+            } else {
+                below = std::max(below, rates[i]);
+            }
+        }
+        return (above > 0) ? above : below;
+    }
+
+    /// 编码器支持的采样格式，优先 float
+    AVSampleFormat pickSampleFormat(const AVCodecContext* ctx, const AVCodec* codec) {
+        const AVSampleFormat* formats = nullptr;
+        int                   count   = 0;
+        if (avcodec_get_supported_config(
+                ctx, codec, AV_CODEC_CONFIG_SAMPLE_FORMAT, 0, (const void**)&formats, &count
+            ) < 0
+            || nullptr == formats || count <= 0) {
+            return AV_SAMPLE_FMT_FLTP;
+        }
+        for (int i = 0; i < count; ++i) {
+            if (formats[i] == AV_SAMPLE_FMT_FLT || formats[i] == AV_SAMPLE_FMT_FLTP) {
+                return formats[i];
+            }
+        }
+        return formats[0];
+    }
+
+    /// 源的编码，容器不支持或没有编码器时为容器默认的音频编码
+    const AVCodec* findAudioEncoder(const AVOutputFormat* format, const AVCodecParameters* par) {
+        if (avformat_query_codec(format, par->codec_id, FF_COMPLIANCE_NORMAL) != 0) {
+            if (const auto codec = avcodec_find_encoder(par->codec_id); nullptr != codec) {
+                return codec;
+            }
+        }
+        const auto id = av_guess_codec(format, nullptr, nullptr, nullptr, AVMEDIA_TYPE_AUDIO);
+        return (AV_CODEC_ID_NONE == id) ? nullptr : avcodec_find_encoder(id);
+    }
+
+    /// 把编码器中的包全部写入；[frame] 为空时冲刷编码器
+    int encodeFrame(Encoder& enc, AVFrame* frame, AVFormatContext* oc, int64_t& packets) {
+        int ret = avcodec_send_frame(enc.ctx, frame);
+        while (ret >= 0) {
+            ret = avcodec_receive_packet(enc.ctx, enc.packet);
+            if (AVERROR(EAGAIN) == ret || AVERROR_EOF == ret) {
+                return 0;
+            }
+            if (ret < 0) {
+                break;
+            }
+            av_packet_rescale_ts(enc.packet, enc.ctx->time_base, oc->streams[0]->time_base);
+            enc.packet->stream_index = 0;
+            ret                      = av_interleaved_write_frame(oc, enc.packet);
+            ++packets;
+        }
+        return ret;
+    }
+
+    class ClipWriter {
+    public:
+
+        ClipWriter(MediaInfoItem_c& in_item, std::string_view in_outputPath, ClipInfo& in_out)
+            : item(in_item),
+              outputPath(in_outputPath),
+              out(in_out) {}
+
+        /// 返回值同 [ClipExtractor_c::extract]
+        int run(int64_t startMs, int64_t durationMs, bool accurate);
+
+        bool hasCreatedFile() const {
+            return created;
+        }
+
+    protected:
+
+        MediaInfoItem_c&  item;
+        const std::string outputPath;
+        ClipInfo&         out;
+        Output            output{};
+        // 源的流在输出中的序号，-1 为不复制
+        std::vector<int>  streamMap{};
+        // 复制时确定起点的流：有视频时为视频，否则为音频
+        int               refIndex = -1;
+        // 已创建输出文件，失败时需要删除
+        bool              created  = false;
+
+        /// 按输出容器支持的编码选择要复制的流，返回选中的数量
+        int mapStreams();
+
+        /// 打开输出文件并写入容器头
+        bool writeHeader();
+
+        int copyPackets(int64_t startUs, int64_t endUs);
+
+        int encodeAudio(int audioIndex, int64_t startMs, int64_t durationMs);
+
+        int fail(unsigned short code, int avError = 0) {
+            item.setError(MEDIAXX_DIAG_STAGE_CLIP, code, avError, outputPath);
+            return item.isInterrupted() ? -2 : -1;
+        }
+    };
+
+    int ClipWriter::mapStreams() {
+        const auto ic = item.fmtCtx;
+        const auto oc = output.ctx;
+        streamMap.assign(ic->nb_streams, -1);
+        int videoIndex = -1;
+        int audioIndex = -1;
+        for (unsigned int i = 0; i < ic->nb_streams; ++i) {
+            const auto is   = ic->streams[i];
+            const auto type = is->codecpar->codec_type;
+            if (false == isCopyable(oc->oformat, is)) {
+                continue;
+            }
+            const auto os = avformat_new_stream(oc, nullptr);
+            if (nullptr == os || avcodec_parameters_copy(os->codecpar, is->codecpar) < 0) {
+                return -1;
+            }
+            // 编码标签由输出容器重新选择
+            os->codecpar->codec_tag = 0;
+            os->time_base           = is->time_base;
+            os->disposition         = is->disposition;
+            av_dict_copy(&os->metadata, is->metadata, 0);
+            streamMap[i] = os->index;
+            if (type == AVMEDIA_TYPE_VIDEO && videoIndex < 0) {
+                videoIndex = int(i);
+            } else if (type == AVMEDIA_TYPE_AUDIO && audioIndex < 0) {
+                audioIndex = int(i);
+            }
+        }
+        refIndex = (videoIndex >= 0) ? videoIndex : audioIndex;
+        return int(oc->nb_streams);
+    }
+
+    bool ClipWriter::writeHeader() {
+        const auto oc = output.ctx;
+        av_dict_copy(&oc->metadata, item.fmtCtx->metadata, 0);
+        if (false == bool(oc->oformat->flags & AVFMT_NOFILE)) {
+            const AVIOInterruptCB cb{&RequestInterrupt::avCallback, &item.interrupt};
+            const int ret = avio_open2(&oc->pb, outputPath.c_str(), AVIO_FLAG_WRITE, &cb, nullptr);
+            if (ret < 0) {
+                fail(MEDIAXX_DIAG_ERR_WRITE, ret);
+                return false;
+            }
+            created = true;
+        }
+        // 复制的第一个包的解码时间戳可能为负（B 帧），整体平移到 0
+        oc->avoid_negative_ts = AVFMT_AVOID_NEG_TS_MAKE_ZERO;
+        if (const int ret = avformat_write_header(oc, nullptr); ret < 0) {
+            fail(MEDIAXX_DIAG_ERR_WRITE, ret);
+            return false;
+        }
+        return true;
+    }
+
+    int ClipWriter::copyPackets(int64_t startUs, int64_t endUs) {
+        const auto ic       = item.fmtCtx;
+        const auto oc       = output.ctx;
+        const auto base     = (AV_NOPTS_VALUE != ic->start_time) ? ic->start_time : 0;
+        const bool videoRef = ic->streams[refIndex]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO;
+        // 跳转到不超过 [startUs] 的最近的关键帧；不能跳转时从头读取，以起点之后的第一个关键帧为起点
+        const bool seeked
+            = (startUs <= base) || avformat_seek_file(ic, -1, INT64_MIN, startUs, startUs, 0) >= 0;
+
+        AVPacket* pkt = av_packet_alloc();
+        if (nullptr == pkt) {
+            return fail(MEDIAXX_DIAG_ERR_NO_MEMORY);
+        }
+        auto              clipStart = int64_t(AV_NOPTS_VALUE);
+        auto              clipEnd   = int64_t(AV_NOPTS_VALUE);
+        std::vector<bool> finished(ic->nb_streams, false);
+        auto              remaining = int(oc->nb_streams);
+        int               ret       = 0;
+        while (remaining > 0 && (ret = av_read_frame(ic, pkt)) >= 0) {
+            const auto index = pkt->stream_index;
+            const auto is    = ic->streams[index];
+            auto       ts    = (AV_NOPTS_VALUE != pkt->pts) ? pkt->pts : pkt->dts;
+            if (streamMap[index] < 0 || finished[index] || AV_NOPTS_VALUE == ts) {
+                av_packet_unref(pkt);
+                continue;
+            }
+            const auto tsUs  = av_rescale_q(ts, is->time_base, AV_TIME_BASE_Q);
+            const auto endOf = tsUs + av_rescale_q(pkt->duration, is->time_base, AV_TIME_BASE_Q);
+            if (AV_NOPTS_VALUE == clipStart) {
+                // 起点由参考流确定：视频为关键帧，音频为包含起点的帧
+                bool isStart = false;
+                if (index == refIndex && videoRef) {
+                    isStart = (pkt->flags & AV_PKT_FLAG_KEY) && (seeked || tsUs >= startUs);
+                } else if (index == refIndex) {
+                    isStart = (pkt->duration > 0) ? (endOf > startUs) : (tsUs >= startUs);
+                }
+                if (false == isStart) {
+                    av_packet_unref(pkt);
+                    continue;
+                }
+                clipStart = tsUs;
+            }
+            // 按解码顺序判断结尾，B 帧引用的后一帧之前的帧不会被截掉
+            const auto orderTs = (AV_NOPTS_VALUE != pkt->dts) ? pkt->dts : ts;
+            if (av_rescale_q(orderTs, is->time_base, AV_TIME_BASE_Q) >= endUs) {
+                finished[index] = true;
+                --remaining;
+                av_packet_unref(pkt);
+                continue;
+            }
+            if (index != refIndex && endOf <= clipStart) {
+                // 其他流在起点之前结束的包；参考流关键帧之后显示时间更早的 B 帧仍需保留
+                av_packet_unref(pkt);
+                continue;
+            }
+            clipEnd = std::max(clipEnd, endOf);
+
+            const auto offset = av_rescale_q(clipStart, AV_TIME_BASE_Q, is->time_base);
+            if (AV_NOPTS_VALUE != pkt->pts) {
+                pkt->pts -= offset;
+            }
+            if (AV_NOPTS_VALUE != pkt->dts) {
+                pkt->dts -= offset;
+            }
+            const auto os = oc->streams[streamMap[index]];
+            av_packet_rescale_ts(pkt, is->time_base, os->time_base);
+            pkt->stream_index = os->index;
+            pkt->pos          = -1;
+            // 写入后 [pkt] 被清空
+            if ((ret = av_interleaved_write_frame(oc, pkt)) < 0) {
+                break;
+            }
+            ++out.packets;
+        }
+        av_packet_free(&pkt);
+        if (item.isInterrupted()) {
+            item.setError(MEDIAXX_DIAG_STAGE_CLIP, MEDIAXX_DIAG_ERR_CANCELLED);
+            return -2;
+        }
+        if (ret < 0 && AVERROR_EOF != ret) {
+            return fail(MEDIAXX_DIAG_ERR_WRITE, ret);
+        }
+        if (0 == out.packets) {
+            item.setLog("起点超出时长: {}ms", (startUs - base) / 1000);
+            return 0;
+        }
+        out.startUs    = clipStart - base;
+        out.durationUs = clipEnd - clipStart;
+        return 1;
+    }
+
+    int ClipWriter::encodeAudio(int audioIndex, int64_t startMs, int64_t durationMs) {
+        const auto ic    = item.fmtCtx;
+        const auto oc    = output.ctx;
+        const auto par   = ic->streams[audioIndex]->codecpar;
+        const auto codec = findAudioEncoder(oc->oformat, par);
+        if (nullptr == codec) {
+            item.setError(MEDIAXX_DIAG_STAGE_CLIP, MEDIAXX_DIAG_ERR_NO_ENCODER);
+            return 0;
+        }
+        Encoder enc{};
+        enc.ctx    = avcodec_alloc_context3(codec);
+        enc.frame  = av_frame_alloc();
+        enc.packet = av_packet_alloc();
+        if (nullptr == enc.ctx || nullptr == enc.frame || nullptr == enc.packet) {
+            return fail(MEDIAXX_DIAG_ERR_NO_MEMORY);
+        }
+        const int channels   = par->ch_layout.nb_channels;
+        const int sampleRate = pickSampleRate(enc.ctx, codec, par->sample_rate);
+        av_channel_layout_default(&enc.ctx->ch_layout, channels);
+        enc.ctx->sample_rate = sampleRate;
+        enc.ctx->sample_fmt  = pickSampleFormat(enc.ctx, codec);
+        enc.ctx->time_base   = AVRational{1, sampleRate};
+        enc.ctx->bit_rate    = (par->bit_rate > 0) ? par->bit_rate
+                             : (ic->bit_rate > 0 ? ic->bit_rate : cDefBitrate);
+        if (oc->oformat->flags & AVFMT_GLOBALHEADER) {
+            enc.ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+        }
+        if (const int ret = avcodec_open2(enc.ctx, codec, nullptr); ret < 0) {
+            // 编码器存在但参数不被接受，与找不到编码器区分开
+            return fail(MEDIAXX_DIAG_ERR_ENCODE, ret);
+        }
+        const auto os = avformat_new_stream(oc, nullptr);
+        if (nullptr == os || avcodec_parameters_from_context(os->codecpar, enc.ctx) < 0) {
+            return fail(MEDIAXX_DIAG_ERR_NO_MEMORY);
+        }
+        os->time_base = enc.ctx->time_base;
+        av_dict_copy(&os->metadata, ic->streams[audioIndex]->metadata, 0);
+
+        // 解码为编码器的采样率和声道数的交错 float，再转换为编码器的采样格式
+        AudioDecoder_c decoder{};
+        if (false == decoder.open(item, sampleRate, channels)) {
+            return 0;
+        }
+        if (swr_alloc_set_opts2(
+                &enc.swr,
+                &enc.ctx->ch_layout,
+                enc.ctx->sample_fmt,
+                sampleRate,
+                &enc.ctx->ch_layout,
+                AV_SAMPLE_FMT_FLT,
+                sampleRate,
+                0,
+                nullptr
+            ) < 0
+            || swr_init(enc.swr) < 0) {
+            return fail(MEDIAXX_DIAG_ERR_NO_MEMORY);
+        }
+        const auto startFrame = startMs * sampleRate / 1000;
+        const auto total      = durationMs * sampleRate / 1000;
+        if (startFrame > 0 && false == decoder.seek(startFrame)) {
+            return item.isInterrupted() ? -2 : -1;
+        }
+        if (false == writeHeader()) {
+            return item.isInterrupted() ? -2 : -1;
+        }
+
+        const bool variable  = codec->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE;
+        const int  frameSize = (enc.ctx->frame_size > 0 && false == variable) ? enc.ctx->frame_size
+                                                                               : cDefFrameSize;
+        std::vector<float> pcm(size_t(frameSize) * channels);
+        int64_t            done        = 0;
+        int                ret         = 0;
+        bool               decodeError = false;
+        while (done < total) {
+            // 固定帧长的编码器，除最后一帧外每帧都必须是 [frameSize]；解码器只在结束时读不满
+            const auto want   = int(std::min<int64_t>(frameSize, total - done));
+            const auto frames = decoder.read(pcm.data(), want);
+            if (frames <= 0) {
+                ret         = frames;
+                decodeError = (frames < 0);
+                break;
+            }
+            av_frame_unref(enc.frame);
+            enc.frame->format      = enc.ctx->sample_fmt;
+            enc.frame->sample_rate = sampleRate;
+            enc.frame->nb_samples  = frames;
+            av_channel_layout_copy(&enc.frame->ch_layout, &enc.ctx->ch_layout);
+            if ((ret = av_frame_get_buffer(enc.frame, 0)) < 0) {
+                break;
+            }
+            const auto src = reinterpret_cast<const uint8_t*>(pcm.data());
+            if ((ret = swr_convert(enc.swr, enc.frame->data, frames, &src, frames)) < 0) {
+                break;
+            }
+            enc.frame->pts  = done;
+            done           += frames;
+            if ((ret = encodeFrame(enc, enc.frame, oc, out.packets)) < 0) {
+                break;
+            }
+        }
+        if (item.isInterrupted()) {
+            item.setError(MEDIAXX_DIAG_STAGE_CLIP, MEDIAXX_DIAG_ERR_CANCELLED);
+            return -2;
+        }
+        if (decodeError) {
+            return fail(MEDIAXX_DIAG_ERR_DECODE, ret);
+        }
+        if (ret < 0 || (ret = encodeFrame(enc, nullptr, oc, out.packets)) < 0) {
+            return fail(MEDIAXX_DIAG_ERR_ENCODE, ret);
+        }
+        if (0 == done) {
+            item.setLog("起点超出时长: {}ms", startMs);
+            return 0;
+        }
+        out.startUs    = startFrame * 1000000 / sampleRate;
+        out.durationUs = done * 1000000 / sampleRate;
+        out.reencoded  = true;
+        return 1;
+    }
+
+    int ClipWriter::run(int64_t startMs, int64_t durationMs, bool accurate) {
+        const auto ic = item.fmtCtx;
+        int        ret
+            = avformat_alloc_output_context2(&output.ctx, nullptr, nullptr, outputPath.c_str());
+        if (ret < 0 || nullptr == output.ctx) {
+            item.setLog("无法识别输出容器: {}", outputPath);
+            return fail(MEDIAXX_DIAG_ERR_WRITE, ret);
+        }
+
+        // 输出中有视频时不重新编码，视频只能从关键帧开始
+        bool hasVideo = false;
+        for (unsigned int i = 0; i < ic->nb_streams; ++i) {
+            const auto is = ic->streams[i];
+            const auto of = output.ctx->oformat;
+            if (is->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && isCopyable(of, is)) {
+                hasVideo = true;
+            }
+        }
+        if (accurate && false == hasVideo) {
+            const int audioIndex
+                = av_find_best_stream(ic, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+            if (audioIndex < 0) {
+                item.setError(MEDIAXX_DIAG_STAGE_CLIP, MEDIAXX_DIAG_ERR_NO_AUDIO);
+                return 0;
+            }
+            ret = encodeAudio(audioIndex, startMs, durationMs);
+        } else {
+            if (accurate) {
+                item.setLog("有视频时不重新编码，从关键帧开始复制: {}", item.filepath);
+            }
+            if (const int count = mapStreams(); count <= 0) {
+                if (0 == count) {
+                    item.setLog("输出容器不支持源的音视频编码: {}", outputPath);
+                    return 0;
+                }
+                return fail(MEDIAXX_DIAG_ERR_NO_MEMORY);
+            }
+            if (false == writeHeader()) {
+                return item.isInterrupted() ? -2 : -1;
+            }
+            const auto base = (AV_NOPTS_VALUE != ic->start_time) ? ic->start_time : 0;
+            const auto from = base + startMs * 1000;
+            ret             = copyPackets(from, from + durationMs * 1000);
+        }
+        if (1 == ret) {
+            if ((ret = av_write_trailer(output.ctx)) < 0) {
+                return fail(MEDIAXX_DIAG_ERR_WRITE, ret);
+            }
+            return 1;
+        }
+        return ret;
+    }
+} // namespace
+
+int ClipExtractor_c::extract(
+    MediaInfoItem_c& item,
+    std::string_view headers,
+    std::string_view outputPath,
+    int64_t          startMs,
+    int64_t          durationMs,
+    bool             accurate,
+    ClipInfo&        out
+) {
+    if (false == checkArgs(item, outputPath, startMs, durationMs)) {
+        return -1;
+    }
+    // 复用读取信息时的打开方式，复制需要完整的流参数
+    item.probeStreams = true;
+    if (false == MediaInfoReader_c::instance.openFile(item, headers)) {
+        return item.isInterrupted() ? -2 : -1;
+    }
+    return extractOpened(item, outputPath, startMs, durationMs, accurate, out);
+}
+
+int ClipExtractor_c::extractOpened(
+    MediaInfoItem_c& item,
+    std::string_view outputPath,
+    int64_t          startMs,
+    int64_t          durationMs,
+    bool             accurate,
+    ClipInfo&        out
+) {
+    if (nullptr == item.fmtCtx || false == checkArgs(item, outputPath, startMs, durationMs)) {
+        return -1;
+    }
+    int  ret     = 0;
+    bool created = false;
+    {
+        // 先关闭输出文件，失败时才能删除
+        ClipWriter writer{item, outputPath, out};
+        ret     = writer.run(startMs, durationMs, accurate);
+        created = writer.hasCreatedFile();
+    }
+    if (1 != ret) {
+        // 只删除本次创建的文件，打开之前失败时不影响已存在的同名文件
+        if (created) {
+            std::error_code ec{};
+            std::filesystem::remove(std::filesystem::path(outputPath), ec);
+        }
+        return ret;
+    }
+    LXX_DEBEG(
+        "ClipExtractor | {}us + {}us, {} packets{}: {}",
+        out.startUs,
+        out.durationUs,
+        out.packets,
+        out.reencoded ? " (reencoded)" : "",
+        item.filepath
+    );
+    return 1;
+}
+
+bool ClipExtractor_c::checkArgs(
+    MediaInfoItem_c& item,
+    std::string_view outputPath,
+    int64_t          startMs,
+    int64_t          durationMs
+) {
+    if (outputPath.empty() || startMs < 0 || durationMs <= 0) {
+        item.setLog("参数无效: start {}ms, duration {}ms", startMs, durationMs);
+        return false;
+    }
+    return true;
+}
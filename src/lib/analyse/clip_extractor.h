@@ -0,0 +1,68 @@
+#pragma once
+
+#include "analyse/media_info_reader.h"
+#include <cstdint>
+#include <string_view>
+
+/// 片段的提取结果，时间相对源的开头（微秒）
+struct ClipInfo {
+    /// 实际的起点：复制时为起点之前最近的关键帧或帧边界
+    int64_t startUs    = 0;
+    int64_t durationUs = 0;
+    /// 写入的数据包数
+    int64_t packets    = 0;
+    /// 音频是否重新编码
+    bool    reencoded  = false;
+};
+
+/// # 片段提取
+/// - [extract] 以读取信息相同的方式（[MediaInfoReader_c::openFile]）打开文件；[extractOpened]
+///   直接使用已打开的解复用器（如 [DecodeSession_c] 持有的），不再重复打开和探测
+/// - 跳转到起点之前最近的关键帧，直接复制数据包到新的容器（按输出路径的扩展名选择），
+///   不解码也不编码，开销与片段的字节数相当
+/// - 有视频时以视频的关键帧为起点，其他流从同一时间开始；只有音频时以包含起点的音频帧为起点
+///   （如 MP3 每帧约 26ms）
+/// - 只复制输出容器支持的音频和视频流；封面（附加图片）、字幕和数据流跳过
+/// - [accurate] 且只有音频时，改为经 [AudioDecoder_c] 精确到采样地解码后重新编码：
+///   优先使用源的编码，没有该编码器或容器不支持时使用容器默认的音频编码
+class ClipExtractor_c {
+public:
+
+    static ClipExtractor_c instance;
+
+    ClipExtractor_c() {}
+
+    ~ClipExtractor_c() {}
+
+    /// 返回值同 [mediaxx_get_audio_visualization]；失败时不保留输出文件
+    /// - 起点超出时长时返回 0
+    int extract(
+        MediaInfoItem_c& item,
+        std::string_view headers,
+        std::string_view outputPath,
+        int64_t          startMs,
+        int64_t          durationMs,
+        bool             accurate,
+        ClipInfo&        out
+    );
+
+    /// 同 [extract]，从 [item] 已打开的 [MediaInfoItem_c::fmtCtx] 读取
+    /// - 会移动解复用的读取位置；调用方需要保证期间不丢弃（`AVDISCARD_ALL`）要复制的流
+    int extractOpened(
+        MediaInfoItem_c& item,
+        std::string_view outputPath,
+        int64_t          startMs,
+        int64_t          durationMs,
+        bool             accurate,
+        ClipInfo&        out
+    );
+
+protected:
+
+    static bool checkArgs(
+        MediaInfoItem_c& item,
+        std::string_view outputPath,
+        int64_t          startMs,
+        int64_t          durationMs
+    );
+};
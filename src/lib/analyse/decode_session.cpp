@@ -0,0 +1,74 @@
+#include "decode_session.h"
+#include "util/log.h"
+#include <algorithm>
+#include <vector>
+
+int DecodeSession_c::open(std::string_view headers, int sampleRate, int channels) {
+    // 解码需要完整的流参数
+    item.probeStreams = true;
+    if (false == MediaInfoReader_c::instance.openFile(item, headers)) {
+        return item.isInterrupted() ? -2 : -1;
+    }
+    if (false == decoder.open(item, std::max(sampleRate, 0), std::max(channels, 0))) {
+        return 0;
+    }
+    // 会话可能持续很久（如边解码边播放），之后只响应取消
+    item.interrupt.deadlineUs = 0;
+    // 之后没有 [outLog]，读取和跳转的错误写入诊断记录
+    item.textLog              = false;
+    LXX_DEBEG(
+        "DecodeSession | {}Hz {}ch -> {}Hz {}ch: {}",
+        decoder.sourceSampleRate(),
+        decoder.sourceChannels(),
+        decoder.sampleRate(),
+        decoder.channels(),
+        item.filepath
+    );
+    return 1;
+}
+
+int DecodeSession_c::read(float* dst, int frames) {
+    const int ret = decoder.read(dst, frames);
+    if (ret >= 0) {
+        return ret;
+    }
+    return (AVERROR_EXIT == ret || item.isInterrupted()) ? -2 : -1;
+}
+
+int DecodeSession_c::seek(int64_t frame) {
+    if (decoder.seek(frame)) {
+        return 1;
+    }
+    return item.isInterrupted() ? -2 : 0;
+}
+
+int DecodeSession_c::extractClip(
+    std::string_view outputPath,
+    int64_t          startMs,
+    int64_t          durationMs,
+    bool             accurate,
+    ClipInfo&        out
+) {
+    const auto fmtCtx   = item.fmtCtx;
+    const auto position = decoder.position();
+    // 只保留本次的日志，会话的日志不会一直增长
+    item.logText.clear();
+    item.textLog = true;
+    // 解码器让解复用丢弃了其他流的包，复制期间恢复
+    std::vector<AVDiscard> discards(fmtCtx->nb_streams);
+    for (unsigned int i = 0; i < fmtCtx->nb_streams; ++i) {
+        discards[i]                 = fmtCtx->streams[i]->discard;
+        fmtCtx->streams[i]->discard = AVDISCARD_DEFAULT;
+    }
+    auto&     clip = ClipExtractor_c::instance;
+    const int ret  = clip.extractOpened(item, outputPath, startMs, durationMs, accurate, out);
+    for (unsigned int i = 0; i < fmtCtx->nb_streams; ++i) {
+        fmtCtx->streams[i]->discard = discards[i];
+    }
+    // 复制移动了读取位置，回到原来的位置继续解码；失败的原因写入日志
+    if (false == decoder.seek(position)) {
+        item.setLog("片段提取后无法跳转回 {} 帧: {}", position, item.filepath);
+    }
+    item.textLog = false;
+    return ret;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "analyse/audio_decoder.h"
+#include "analyse/clip_extractor.h"
+#include "analyse/media_info_reader.h"
+#include <string_view>
+
+/// # PCM 解码会话
+/// - 持有打开的文件和 [AudioDecoder_c]，调用方按需拉取 PCM，读取直接写入调用方的缓冲区
+/// - 每个会话有独立的解复用和解码状态，不同会话可以在不同线程中同时使用；同一个会话不能同时使用
+class DecodeSession_c {
+public:
+
+    MediaInfoItem_c item;
+    AudioDecoder_c  decoder{};
+
+    explicit DecodeSession_c(std::string_view filepath) : item(filepath, nullptr) {}
+
+    ~DecodeSession_c() {
+        decoder.close();
+        item.dispose();
+    }
+
+    DecodeSession_c(const DecodeSession_c&)            = delete;
+    DecodeSession_c& operator=(const DecodeSession_c&) = delete;
+
+    /// 返回值同 [mediaxx_get_audio_visualization]
+    /// - [sampleRate]、[channels] <= 0 时与源相同
+    /// - 截止时间只限制打开；取消句柄对之后的读取和跳转仍然有效
+    int open(std::string_view headers, int sampleRate, int channels);
+
+    /// 返回读取的帧数，0 表示已结束，-1 失败，-2 已取消
+    int read(float* dst, int frames);
+
+    /// 返回 1 成功，0 不能跳转，-2 已取消
+    int seek(int64_t frame);
+
+    /// 用会话已打开的解复用器提取片段，返回值同 [ClipExtractor_c::extract]
+    /// - 期间恢复解码器丢弃的其他流，结束后跳转回原来的位置，之后的 [read] 不受影响
+    /// - 本次的日志和错误只写入 [MediaInfoItem_c::logView]，不写入诊断记录
+    int extractClip(
+        std::string_view outputPath,
+        int64_t          startMs,
+        int64_t          durationMs,
+        bool             accurate,
+        ClipInfo&        out
+    );
+};
@@ -0,0 +1,476 @@
+#include "fingerprint.h"
+#include "analyse/audio_decoder.h"
+#include "analyse/spectrum.h"
+#include "util/log.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+
+AudioFingerprint_c AudioFingerprint_c::instance = AudioFingerprint_c();
+
+namespace {
+    constexpr int   cSampleRate = 11025;
+    constexpr int   cFftSize    = 4096;
+    constexpr int   cHopSize    = cFftSize / 3;
+    constexpr float cMinFreq    = 28;
+    constexpr float cMaxFreq    = 3520;
+    // 色度在时间上的平滑系数
+    constexpr std::array<float, 5> cSmoothing = {0.25f, 0.75f, 1.0f, 0.75f, 0.25f};
+    // 归一化前模长低于该值的帧视为静音，置为 0
+    constexpr float cSilenceNorm = 0.01f;
+    // 滤波器对比度的量化阈值
+    constexpr float cThreshold   = 0.1f;
+    // 4 级对应的格雷码
+    constexpr std::array<uint32_t, 4> cGrayCode = {0, 1, 3, 2};
+
+    // 对齐后重叠部分少于该帧数（约 2s）时相似度为 0
+    constexpr size_t cMinOverlap = 16;
+
+    // 索引：初始桶数和平均每桶的条目数上限
+    constexpr int      cInitBucketBits    = 12;
+    constexpr size_t   cPostingsPerBucket = 32;
+    // 精确比较的候选数和最少票数
+    constexpr size_t   cMaxCandidates     = 16;
+    constexpr uint16_t cMinVotes          = 2;
+
+    enum class FilterType : uint8_t {
+        // 高半部分的音高类 / 低半部分
+        FreqHalves,
+        // 后半段时间 / 前半段
+        TimeHalves,
+        // 对角的两个象限 / 另外两个
+        Checker,
+        // 中间三分之一的音高类 / 两侧
+        FreqThirds,
+        // 中间三分之一的时间 / 两侧
+        TimeThirds,
+    };
+
+    /// 从当前帧开始 [width] 帧、音高类 [y, y + height) 的矩形
+    struct Filter {
+        FilterType type;
+        int        y;
+        int        height;
+        int        width;
+    };
+
+    constexpr std::array<Filter, 16> cFilters = {{
+        {FilterType::TimeHalves, 0, 12, 2},
+        {FilterType::TimeHalves, 0, 12, 8},
+        {FilterType::TimeHalves, 0, 6, 4},
+        {FilterType::TimeHalves, 6, 6, 4},
+        {FilterType::FreqHalves, 0, 12, 1},
+        {FilterType::FreqHalves, 0, 12, 6},
+        {FilterType::FreqHalves, 3, 6, 3},
+        {FilterType::FreqHalves, 6, 6, 12},
+        {FilterType::Checker, 0, 12, 4},
+        {FilterType::Checker, 2, 8, 8},
+        {FilterType::Checker, 6, 6, 16},
+        {FilterType::FreqThirds, 0, 12, 2},
+        {FilterType::FreqThirds, 3, 9, 6},
+        {FilterType::FreqThirds, 0, 6, 16},
+        {FilterType::TimeThirds, 0, 12, 6},
+        {FilterType::TimeThirds, 4, 6, 12},
+    }};
+
+    constexpr int cMaxFilterWidth = 16;
+
+    /// 色度图在时间上的前缀和，[area] 为矩形内的总和
+    class ChromaImage {
+    public:
+
+        explicit ChromaImage(const std::vector<std::array<float, 12>>& chroma)
+            : prefix((chroma.size() + 1) * 12, 0.0f) {
+            for (size_t t = 0; t < chroma.size(); ++t) {
+                for (size_t b = 0; b < 12; ++b) {
+                    prefix[(t + 1) * 12 + b] = prefix[t * 12 + b] + chroma[t][b];
+                }
+            }
+        }
+
+        float area(size_t t, int width, int y, int height) const {
+            const auto begin = prefix.data() + t * 12;
+            const auto end   = prefix.data() + (t + width) * 12;
+            float      sum   = 0;
+            for (int b = y; b < y + height; ++b) {
+                sum += end[b] - begin[b];
+            }
+            return sum;
+        }
+
+    protected:
+
+        std::vector<float> prefix;
+    };
+
+    /// [a] 相对 [b] 的对比度，-1~1
+    float contrast(float a, float b) {
+        return (a - b) / (a + b + 1e-6f);
+    }
+
+    float applyFilter(const ChromaImage& image, size_t t, const Filter& f) {
+        const auto halfH  = f.height / 2;
+        const auto halfW  = f.width / 2;
+        const auto thirdH = f.height / 3;
+        const auto thirdW = f.width / 3;
+        switch (f.type) {
+        case FilterType::FreqHalves:
+            return contrast(
+                image.area(t, f.width, f.y + halfH, halfH),
+                image.area(t, f.width, f.y, halfH)
+            );
+        case FilterType::TimeHalves:
+            return contrast(
+                image.area(t + halfW, halfW, f.y, f.height),
+                image.area(t, halfW, f.y, f.height)
+            );
+        case FilterType::Checker:
+            return contrast(
+                image.area(t, halfW, f.y, halfH) + image.area(t + halfW, halfW, f.y + halfH, halfH),
+                image.area(t, halfW, f.y + halfH, halfH) + image.area(t + halfW, halfW, f.y, halfH)
+            );
+        case FilterType::FreqThirds: {
+            // 两侧的面积是中间的两倍
+            const auto total  = image.area(t, f.width, f.y, f.height);
+            const auto middle = image.area(t, f.width, f.y + thirdH, thirdH);
+            return contrast(middle * 2, total - middle);
+        }
+        case FilterType::TimeThirds: {
+            const auto total  = image.area(t, f.width, f.y, f.height);
+            const auto middle = image.area(t + thirdW, thirdW, f.y, f.height);
+            return contrast(middle * 2, total - middle);
+        }
+        }
+        return 0;
+    }
+
+    uint32_t quantize(float value) {
+        if (value < 0) {
+            return cGrayCode[value < -cThreshold ? 0 : 1];
+        }
+        return cGrayCode[value < cThreshold ? 2 : 3];
+    }
+
+    /// 时间上平滑后逐帧归一化（L2）
+    void normalizeChroma(std::vector<std::array<float, 12>>& chroma) {
+        const auto                         n      = chroma.size();
+        const auto                         radius = cSmoothing.size() / 2;
+        std::vector<std::array<float, 12>> smoothed(n);
+        for (size_t t = 0; t < n; ++t) {
+            auto& out = smoothed[t];
+            out.fill(0.0f);
+            for (size_t k = 0; k < cSmoothing.size(); ++k) {
+                // 两端按最近的帧延伸
+                const auto src = std::clamp<long>(long(t + k) - long(radius), 0, long(n) - 1);
+                for (size_t b = 0; b < 12; ++b) {
+                    out[b] += cSmoothing[k] * chroma[src][b];
+                }
+            }
+            float norm = 0;
+            for (const auto value : out) {
+                norm += value * value;
+            }
+            norm = std::sqrt(norm);
+            for (auto& value : out) {
+                value = norm < cSilenceNorm ? 0.0f : value / norm;
+            }
+        }
+        chroma.swap(smoothed);
+    }
+} // namespace
+
+int AudioFingerprint_c::generate(
+    MediaInfoItem_c&       item,
+    std::string_view       headers,
+    int                    seconds,
+    std::vector<uint32_t>& out
+) {
+    seconds = (seconds > 0) ? std::min(seconds, cMaxSeconds) : cDefSeconds;
+
+    // 解码需要完整的流参数
+    item.probeStreams = true;
+    if (false == MediaInfoReader_c::instance.openFile(item, headers)) {
+        return item.isInterrupted() ? -2 : -1;
+    }
+    AudioDecoder_c decoder{};
+    if (false == decoder.open(item, cSampleRate, 1)) {
+        return 0;
+    }
+    SpectrumAnalyzer_c analyzer{};
+    // 只用 [SpectrumAnalyzer_c::power]，频带不使用
+    if (false == analyzer.init(cSampleRate, cFftSize, 1, cMinFreq, cMaxFreq)) {
+        item.setError(MEDIAXX_DIAG_STAGE_AUDIO, MEDIAXX_DIAG_ERR_NO_MEMORY, analyzer.initError());
+        return 0;
+    }
+
+    const auto          binCount = size_t(cFftSize / 2 + 1);
+    std::vector<int8_t> pitchClass(binCount, -1);
+    for (size_t k = 1; k < binCount; ++k) {
+        const auto freq = float(k) * cSampleRate / cFftSize;
+        if (freq >= cMinFreq && freq <= cMaxFreq) {
+            pitchClass[k] = int8_t(SpectrumAnalyzer_c::pitchClass(freq));
+        }
+    }
+
+    const auto                         maxSamples = int64_t(cSampleRate) * seconds;
+    std::vector<float>                 window(cFftSize);
+    std::vector<std::array<float, 12>> chroma{};
+    chroma.reserve(size_t(maxSamples / cHopSize) + 1);
+
+    auto decoded = int64_t(std::max(decoder.read(window.data(), cFftSize), 0));
+    auto filled  = decoded;
+    std::fill(window.begin() + filled, window.end(), 0.0f);
+    while (filled > 0) {
+        const auto power = analyzer.power(window.data());
+        auto&      frame = chroma.emplace_back();
+        frame.fill(0.0f);
+        for (size_t k = 1; k < binCount; ++k) {
+            if (pitchClass[k] >= 0) {
+                frame[pitchClass[k]] += power[k];
+            }
+        }
+        if (decoded >= maxSamples) {
+            break;
+        }
+
+        std::memmove(
+            window.data(),
+            window.data() + cHopSize,
+            (cFftSize - cHopSize) * sizeof(float)
+        );
+        const auto tail = window.data() + (cFftSize - cHopSize);
+        filled          = std::max(decoder.read(tail, cHopSize), 0);
+        std::fill(tail + filled, tail + cHopSize, 0.0f);
+        decoded += filled;
+    }
+    if (item.isInterrupted()) {
+        return -2;
+    }
+    if (0 == decoded) {
+        item.setError(MEDIAXX_DIAG_STAGE_AUDIO, MEDIAXX_DIAG_ERR_DECODE);
+        return 0;
+    }
+    if (chroma.size() < cMinOverlap + cMaxFilterWidth - 1) {
+        item.setLog("音频过短，无法生成指纹: {}", item.filepath);
+        return 0;
+    }
+
+    normalizeChroma(chroma);
+    const ChromaImage image{chroma};
+    const auto        count = chroma.size() - cMaxFilterWidth + 1;
+    out.resize(count);
+    for (size_t t = 0; t < count; ++t) {
+        uint32_t hash = 0;
+        for (size_t i = 0; i < cFilters.size(); ++i) {
+            hash |= quantize(applyFilter(image, t, cFilters[i])) << (i * 2);
+        }
+        out[t] = hash;
+    }
+    LXX_DEBEG("AudioFingerprint | {} hashes: {}", out.size(), item.filepath);
+    return 1;
+}
+
+float AudioFingerprint_c::compare(
+    std::span<const uint32_t> a,
+    std::span<const uint32_t> b,
+    int&                      outOffset
+) {
+    outOffset = 0;
+    if (a.size() < cMinOverlap || b.size() < cMinOverlap) {
+        return 0;
+    }
+    // 相同哈希的位置差（[b] 的位置 - [a] 的位置）投票，取票数最多的偏移
+    thread_local std::vector<std::pair<uint32_t, uint32_t>> positions{};
+    thread_local std::vector<uint16_t>                      votes{};
+    positions.resize(b.size());
+    for (size_t j = 0; j < b.size(); ++j) {
+        positions[j] = {b[j], uint32_t(j)};
+    }
+    std::sort(positions.begin(), positions.end());
+    votes.assign(a.size() + b.size(), 0);
+    for (size_t i = 0; i < a.size(); ++i) {
+        auto it = std::lower_bound(positions.begin(), positions.end(), std::pair{a[i], 0u});
+        for (; it != positions.end() && it->first == a[i]; ++it) {
+            auto& vote = votes[it->second + a.size() - i];
+            vote       = uint16_t(std::min(vote + 1, 0xFFFF));
+        }
+    }
+    const auto best   = std::max_element(votes.begin(), votes.end());
+    // 没有相同的哈希时按开头对齐
+    const auto offset = (0 == *best) ? 0L : long(best - votes.begin()) - long(a.size());
+
+    const auto begin = size_t(std::max(0L, -offset));
+    const auto end   = size_t(std::min(long(a.size()), long(b.size()) - offset));
+    if (end <= begin || end - begin < cMinOverlap) {
+        return 0;
+    }
+    size_t errors = 0;
+    for (size_t i = begin; i < end; ++i) {
+        errors += size_t(std::popcount(a[i] ^ b[size_t(long(i) + offset)]));
+    }
+    outOffset = int(offset);
+    return 1.0f - float(errors) / float((end - begin) * 32);
+}
+
+FingerprintIndex_c::FingerprintIndex_c() {
+    rebuild(cInitBucketBits);
+}
+
+void FingerprintIndex_c::rebuild(int bits) {
+    // 去掉已移除的曲目，重新编号
+    std::vector<uint32_t> remap(tracks.size(), UINT32_MAX);
+    std::vector<Track>    live{};
+    live.reserve(slots.size());
+    for (size_t slot = 0; slot < tracks.size(); ++slot) {
+        if (false == tracks[slot].hashes.empty()) {
+            remap[slot] = uint32_t(live.size());
+            slots[tracks[slot].id] = remap[slot];
+            live.push_back(std::move(tracks[slot]));
+        }
+    }
+    tracks.swap(live);
+
+    std::vector<std::vector<Posting>> old{};
+    old.swap(buckets);
+    bucketBits = bits;
+    buckets.resize(size_t(1) << bits);
+    postingCount    = 0;
+    removedPostings = 0;
+    for (auto& bucket : old) {
+        for (const auto posting : bucket) {
+            if (UINT32_MAX != remap[posting.slot]) {
+                const auto slot = remap[posting.slot];
+                buckets[bucketOf(posting.hash)].push_back(Posting{posting.hash, slot});
+                ++postingCount;
+            }
+        }
+        // 逐个释放，峰值内存不超过新旧各一份
+        std::vector<Posting>{}.swap(bucket);
+    }
+}
+
+bool FingerprintIndex_c::add(int64_t id, std::span<const uint32_t> hashes) {
+    if (hashes.empty()) {
+        return false;
+    }
+    std::vector<uint32_t> distinct{hashes.begin(), hashes.end()};
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+
+    std::unique_lock lock{mutex};
+    removeLocked(id);
+    const auto slot = uint32_t(tracks.size());
+    tracks.push_back(Track{id, {hashes.begin(), hashes.end()}});
+    slots[id] = slot;
+    for (const auto hash : distinct) {
+        buckets[bucketOf(hash)].push_back(Posting{hash, slot});
+    }
+    postingCount += distinct.size();
+    if (postingCount > buckets.size() * cPostingsPerBucket) {
+        rebuild(bucketBits + 1);
+    }
+    return true;
+}
+
+void FingerprintIndex_c::removeLocked(int64_t id) {
+    const auto it = slots.find(id);
+    if (it == slots.end()) {
+        return;
+    }
+    auto& track = tracks[it->second];
+    slots.erase(it);
+    std::vector<uint32_t> distinct(std::move(track.hashes));
+    track.hashes.clear();
+    std::sort(distinct.begin(), distinct.end());
+    removedPostings += size_t(std::unique(distinct.begin(), distinct.end()) - distinct.begin());
+    // 条目不立即删除，查询时跳过；超过一半时重新分配
+    if (removedPostings * 2 > postingCount) {
+        rebuild(bucketBits);
+    }
+}
+
+bool FingerprintIndex_c::remove(int64_t id) {
+    std::unique_lock lock{mutex};
+    if (false == slots.contains(id)) {
+        return false;
+    }
+    removeLocked(id);
+    return true;
+}
+
+size_t FingerprintIndex_c::size() const {
+    std::shared_lock lock{mutex};
+    return slots.size();
+}
+
+size_t FingerprintIndex_c::query(
+    std::span<const uint32_t>          hashes,
+    float                              minSimilarity,
+    std::span<MediaxxFingerprintMatch> out
+) const {
+    if (hashes.empty() || out.empty()) {
+        return 0;
+    }
+    thread_local std::vector<uint32_t> distinct{};
+    thread_local std::vector<uint16_t> votes{};
+    thread_local std::vector<uint32_t> touched{};
+    distinct.assign(hashes.begin(), hashes.end());
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    touched.clear();
+
+    std::shared_lock lock{mutex};
+    // 只增不减，曲目数变化时补齐；用完后把投过票的位置清零
+    if (votes.size() < tracks.size()) {
+        votes.resize(tracks.size(), 0);
+    }
+    for (const auto hash : distinct) {
+        for (const auto posting : buckets[bucketOf(hash)]) {
+            if (posting.hash == hash && votes[posting.slot] < 0xFFFF) {
+                if (0 == votes[posting.slot]++) {
+                    touched.push_back(posting.slot);
+                }
+            }
+        }
+    }
+
+    // 去掉已移除的曲目后取票数最多的若干首
+    std::erase_if(touched, [this](uint32_t slot) {
+        const bool drop = votes[slot] < cMinVotes || tracks[slot].hashes.empty();
+        if (drop) {
+            votes[slot] = 0;
+        }
+        return drop;
+    });
+    const auto candidates = std::min(touched.size(), cMaxCandidates);
+    std::partial_sort(
+        touched.begin(),
+        touched.begin() + long(candidates),
+        touched.end(),
+        [](uint32_t a, uint32_t b) { return votes[a] > votes[b]; }
+    );
+    for (const auto slot : touched) {
+        votes[slot] = 0;
+    }
+
+    std::vector<MediaxxFingerprintMatch> matches{};
+    for (size_t i = 0; i < candidates; ++i) {
+        const auto& track = tracks[touched[i]];
+        int        offset     = 0;
+        const auto similarity = AudioFingerprint_c::compare(hashes, track.hashes, offset);
+        if (similarity >= minSimilarity) {
+            matches.push_back(MediaxxFingerprintMatch{track.id, similarity, offset});
+        }
+    }
+    lock.unlock();
+
+    std::sort(matches.begin(), matches.end(), [](const auto& a, const auto& b) {
+        return a.similarity > b.similarity;
+    });
+    const auto count = std::min(matches.size(), out.size());
+    std::copy_n(matches.begin(), count, out.begin());
+    return count;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "analyse/media_info_reader.h"
+#include <cstdint>
+#include <mediaxx.h>
+#include <shared_mutex>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// # 声学指纹（与 Chromaprint 同类的算法，结果不兼容）
+/// - 从开头解码 [seconds] 秒，重采样为 11025Hz 单声道；4096 点的窗、1/3 重叠做 FFT，
+///   功率按音高类累计为色度，时间上平滑后逐帧归一化
+/// - 在色度图上滑动 16 个 Haar 型滤波器，每个的对比度按 ±[cThreshold] 量化为 4 级（格雷码，
+///   相邻级只差 1 位），拼成每帧（约 124ms）一个 32 位哈希
+/// - 不同编码、码率、音量的同一录音，对齐后大部分位相同；不相关的音频约一半的位相同
+class AudioFingerprint_c {
+public:
+
+    static constexpr int cDefSeconds = 30;
+    static constexpr int cMaxSeconds = 300;
+
+    static AudioFingerprint_c instance;
+
+    AudioFingerprint_c() {}
+
+    ~AudioFingerprint_c() {}
+
+    /// 返回值同 [mediaxx_get_audio_visualization]；音频过短（约 2s 以内）时返回 0
+    /// - [seconds] <= 0 时为 [cDefSeconds]，超过 [cMaxSeconds] 时截断
+    int generate(
+        MediaInfoItem_c&       item,
+        std::string_view       headers,
+        int                    seconds,
+        std::vector<uint32_t>& out
+    );
+
+    /// 相似度，0~1，为对齐后重叠部分相同的位的比例；重叠太短时为 0
+    /// - 对齐由相同哈希的位置差投票决定；[outOffset] 为 [b] 相对 [a] 的帧偏移
+    static float compare(std::span<const uint32_t> a, std::span<const uint32_t> b, int& outOffset);
+};
+
+/// # 指纹的倒排索引
+/// - 每个哈希对应包含它的曲目（每首去重），按哈希混合后的高位分桶，桶数随条目数翻倍
+/// - 查询时按查询指纹的各个哈希给曲目投票，票数最多的若干首再用 [AudioFingerprint_c::compare]
+///   精确比较；查询的开销只与指纹长度和命中的条目数有关，与曲目总数基本无关
+/// - 可以增量插入；查询之间、查询与插入之间可以在不同线程中同时调用
+class FingerprintIndex_c {
+public:
+
+    static constexpr float cDefMinSimilarity = 0.75f;
+
+    FingerprintIndex_c();
+
+    /// 已存在的 [id] 先移除再插入；指纹为空时返回 false
+    bool add(int64_t id, std::span<const uint32_t> hashes);
+
+    bool remove(int64_t id);
+
+    size_t size() const;
+
+    /// 相似度不低于 [minSimilarity] 的曲目按相似度降序写入 [out]，返回写入的数量
+    size_t query(
+        std::span<const uint32_t>          hashes,
+        float                              minSimilarity,
+        std::span<MediaxxFingerprintMatch> out
+    ) const;
+
+protected:
+
+    struct Track {
+        int64_t               id = 0;
+        // 为空表示已移除
+        std::vector<uint32_t> hashes{};
+    };
+
+    struct Posting {
+        uint32_t hash;
+        uint32_t slot;
+    };
+
+    std::vector<Track>                    tracks{};
+    std::unordered_map<int64_t, uint32_t> slots{};
+    std::vector<std::vector<Posting>>     buckets{};
+    int                                   bucketBits      = 0;
+    size_t                                postingCount    = 0;
+    // 指向已移除曲目的条目数，超过一半时重新分配
+    size_t                                removedPostings = 0;
+
+    mutable std::shared_mutex mutex{};
+
+    size_t bucketOf(uint32_t hash) const {
+        // 哈希的各位分布不均匀，先乘以黄金比例常数混合
+        return size_t((hash * 0x9E3779B1u) >> (32 - bucketBits));
+    }
+
+    /// 调整桶数，去掉已移除的曲目并重新分配所有有效的条目
+    void rebuild(int bits);
+
+    void removeLocked(int64_t id);
+};
@@ -0,0 +1,470 @@
+#include "frame_scanner.h"
+#include "util/log.h"
+#include "util/mapped_file.h"
+#include <charconv>
+#include <cstring>
+
+FrameScanner_c FrameScanner_c::instance = FrameScanner_c();
+
+namespace {
+    // 开头确认同步需要连续有效的帧数，帧之间重新同步时为 2
+    constexpr int     cSyncFrames     = 4;
+    // 开头最多跳过的无效数据，超过时认为不是 MP3/ADTS 流
+    constexpr size_t  cMaxLeadingJunk = 1 << 20;
+    // 每扫描这么多帧检查一次是否取消
+    constexpr int64_t cCheckInterval  = 8192;
+    // iTunSMPB 的延迟和填充的上限，超过时认为无效
+    constexpr int64_t cMaxGapless     = 1 << 20;
+    constexpr size_t  cNotFound       = SIZE_MAX;
+
+    // 码率（kbps）：[MPEG-1, MPEG-2/2.5][Layer I, II, III][索引]，索引 0 为自由格式
+    constexpr int cMpegBitrates[2][3][15] = {
+        {
+         {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448},
+         {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384},
+         {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320},
+         },
+        {
+         {0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256},
+         {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},
+         {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},
+         },
+    };
+    // MPEG-1 的采样率，MPEG-2 减半，MPEG-2.5 为四分之一
+    constexpr int cMpegSampleRates[3]  = {44100, 48000, 32000};
+    constexpr int cAdtsSampleRates[13] = {
+        96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050, 16000, 12000, 11025, 8000, 7350,
+    };
+
+    enum class StreamKind {
+        Mpeg,
+        Adts,
+    };
+
+    struct FrameHeader {
+        int      length     = 0;
+        int      samples    = 0;
+        int      sampleRate = 0;
+        int      channels   = 0;
+        // 同一个流中不变的字段，用于确认同步；不会为 0
+        uint32_t key        = 0;
+    };
+
+    uint32_t readBe32(const uint8_t* p) {
+        return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+    }
+
+    uint32_t readLe32(const uint8_t* p) {
+        return uint32_t(p[3]) << 24 | uint32_t(p[2]) << 16 | uint32_t(p[1]) << 8 | p[0];
+    }
+
+    /// ID3v2 的同步安全整数，每字节只用低 7 位
+    uint32_t readSyncsafe(const uint8_t* p) {
+        return uint32_t(p[0] & 0x7F) << 21 | uint32_t(p[1] & 0x7F) << 14
+             | uint32_t(p[2] & 0x7F) << 7 | (p[3] & 0x7F);
+    }
+
+    /// MPEG 音频帧头，4 字节；不支持自由格式
+    bool parseMpeg(const uint8_t* p, FrameHeader& h) {
+        if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0) {
+            return false;
+        }
+        // 0 为 MPEG-2.5，1 保留，2 为 MPEG-2，3 为 MPEG-1；层的编码 3~1 对应 Layer I~III
+        const int version      = (p[1] >> 3) & 3;
+        const int layer        = 4 - ((p[1] >> 1) & 3);
+        const int bitrateIndex = p[2] >> 4;
+        const int rateIndex    = (p[2] >> 2) & 3;
+        if (version == 1 || layer == 4 || bitrateIndex == 0 || bitrateIndex == 15 || rateIndex == 3
+            || (p[3] & 3) == 2) {
+            return false;
+        }
+        const bool mpeg1   = (version == 3);
+        const int  bitrate = cMpegBitrates[mpeg1 ? 0 : 1][layer - 1][bitrateIndex] * 1000;
+        const int  padding = (p[2] >> 1) & 1;
+        h.sampleRate       = cMpegSampleRates[rateIndex] >> (mpeg1 ? 0 : (version == 2 ? 1 : 2));
+        if (layer == 1) {
+            h.samples = 384;
+            h.length  = (12 * bitrate / h.sampleRate + padding) * 4;
+        } else {
+            h.samples = (layer == 3 && false == mpeg1) ? 576 : 1152;
+            h.length  = h.samples / 8 * bitrate / h.sampleRate + padding;
+        }
+        h.channels = ((p[3] >> 6) == 3) ? 1 : 2;
+        h.key      = uint32_t(p[1] & 0xFE) << 8 | (p[2] & 0x0C);
+        return true;
+    }
+
+    /// ADTS 帧头，7 字节（有 CRC 时之后还有 2 字节）
+    bool parseAdts(const uint8_t* p, FrameHeader& h) {
+        if (p[0] != 0xFF || (p[1] & 0xF6) != 0xF0) {
+            return false;
+        }
+        const int rateIndex = (p[2] >> 2) & 0x0F;
+        if (rateIndex >= 13) {
+            return false;
+        }
+        const int headerSize = (p[1] & 1) ? 7 : 9;
+        h.length             = (p[3] & 3) << 11 | p[4] << 3 | p[5] >> 5;
+        if (h.length <= headerSize) {
+            return false;
+        }
+        h.sampleRate = cAdtsSampleRates[rateIndex];
+        h.samples    = 1024 * ((p[6] & 3) + 1);
+        // 0 表示声道由 PCE 定义
+        h.channels   = (p[2] & 1) << 2 | p[3] >> 6;
+        h.key        = uint32_t(p[1]) << 16 | uint32_t(p[2] & 0xFD) << 8 | (p[3] & 0xC0);
+        return true;
+    }
+
+    /// [pos] 处完整的一帧；[key] 不为 0 时还要属于同一个流
+    bool parseAt(
+        const uint8_t* data,
+        size_t         pos,
+        size_t         end,
+        StreamKind     kind,
+        uint32_t       key,
+        FrameHeader&   h
+    ) {
+        if (pos + 7 > end) {
+            // 最短的 MPEG 帧也超过 7 字节
+            return false;
+        }
+        const auto ok = (kind == StreamKind::Mpeg) ? parseMpeg(data + pos, h)
+                                                   : parseAdts(data + pos, h);
+        return ok && (0 == key || h.key == key) && pos + size_t(h.length) <= end;
+    }
+
+    /// 从 [from] 开始查找同步位置：连续 [frames] 帧有效且属于同一个流（或恰好到结尾）
+    /// - [key] 不为 0 时只接受 [kind] 的同一个流，否则两种都尝试并写入找到的流
+    /// - 同步字的第一个字节总是 0xFF，用 memchr 跳过其他数据
+    size_t findSync(
+        const uint8_t* data,
+        size_t         from,
+        size_t         limit,
+        size_t         end,
+        int            frames,
+        StreamKind&    kind,
+        uint32_t&      key
+    ) {
+        const auto confirm = [&](size_t pos, StreamKind candidate) {
+            FrameHeader h{};
+            auto        streamKey = key;
+            for (int i = 0; i < frames && pos < end; ++i) {
+                if (false == parseAt(data, pos, end, candidate, streamKey, h)) {
+                    return false;
+                }
+                streamKey  = h.key;
+                pos       += size_t(h.length);
+            }
+            kind = candidate;
+            key  = streamKey;
+            return true;
+        };
+        limit = std::min(limit, end);
+        for (auto pos = from; pos < limit; ++pos) {
+            const auto hit = static_cast<const uint8_t*>(memchr(data + pos, 0xFF, limit - pos));
+            if (nullptr == hit) {
+                break;
+            }
+            pos = size_t(hit - data);
+            if (0 != key) {
+                if (confirm(pos, kind)) {
+                    return pos;
+                }
+            } else if (confirm(pos, StreamKind::Mpeg) || confirm(pos, StreamKind::Adts)) {
+                return pos;
+            }
+        }
+        return cNotFound;
+    }
+
+    /// ID3v2 文本的 ASCII 部分；iTunSMPB 的描述和值都是 ASCII
+    std::string asciiText(const uint8_t* p, size_t size, bool wide, bool bigEndian) {
+        std::string text{};
+        if (false == wide) {
+            for (size_t i = 0; i < size; ++i) {
+                if (p[i] > 0 && p[i] < 0x80) {
+                    text.push_back(char(p[i]));
+                }
+            }
+            return text;
+        }
+        if (size >= 2 && (p[0] == 0xFF || p[0] == 0xFE) && (p[0] ^ p[1]) == 0x01) {
+            bigEndian  = (p[0] == 0xFE);
+            p         += 2;
+            size      -= 2;
+        }
+        for (size_t i = 0; i + 1 < size; i += 2) {
+            const auto unit = bigEndian ? (p[i] << 8 | p[i + 1]) : (p[i + 1] << 8 | p[i]);
+            if (unit > 0 && unit < 0x80) {
+                text.push_back(char(unit));
+            }
+        }
+        return text;
+    }
+
+    /// COMM/TXXX 帧（v2.2 为 COM/TXX）为 iTunSMPB 时，写入值
+    void readSmpbFrame(const uint8_t* body, size_t size, bool comment, std::string& smpb) {
+        // 编码（1 字节）、语言（COMM，3 字节）、以 0 结尾的描述、值
+        const size_t start = comment ? 4 : 1;
+        if (size <= start) {
+            return;
+        }
+        const bool wide      = (body[0] == 1 || body[0] == 2);
+        const bool bigEndian = (body[0] == 2);
+        const auto unit      = size_t(wide ? 2 : 1);
+        auto       pos       = start;
+        while (pos + unit <= size && (body[pos] != 0 || (wide && body[pos + 1] != 0))) {
+            pos += unit;
+        }
+        if (pos + unit > size
+            || asciiText(body + start, pos - start, wide, bigEndian) != "iTunSMPB") {
+            return;
+        }
+        pos  += unit;
+        smpb  = asciiText(body + pos, size - pos, wide, bigEndian);
+    }
+
+    /// 在一个 ID3v2 标签的帧中查找 iTunSMPB；[tag] 为标签头之后的数据
+    void findSmpb(const uint8_t* tag, size_t size, int major, int flags, std::string& smpb) {
+        if (major < 2 || major > 4 || (major < 4 && (flags & 0x80))) {
+            // 全局反同步也作用于帧头，iTunSMPB 不会出现在这样的标签中
+            return;
+        }
+        const size_t headerSize = (major == 2) ? 6 : 10;
+        size_t       pos        = 0;
+        if (major > 2 && (flags & 0x40) && size >= 4) {
+            // 扩展头：v2.3 的长度不含自身的 4 字节，v2.4 的包含
+            pos = (major == 3) ? 4 + readBe32(tag) : readSyncsafe(tag);
+        }
+        while (pos + headerSize <= size && tag[pos] != 0) {
+            const auto frame = tag + pos;
+            size_t     frameSize{};
+            if (major == 2) {
+                frameSize = size_t(frame[3]) << 16 | size_t(frame[4]) << 8 | frame[5];
+            } else {
+                frameSize = (major == 4) ? readSyncsafe(frame + 4) : readBe32(frame + 4);
+            }
+            const auto bodyPos = pos + headerSize;
+            if (frameSize > size - bodyPos) {
+                return;
+            }
+            pos = bodyPos + frameSize;
+            // 压缩、加密或单独反同步的帧跳过
+            if (major > 2 && (frame[9] & ((major == 3) ? 0xC0 : 0x0E))) {
+                continue;
+            }
+            const auto idSize = size_t((major == 2) ? 3 : 4);
+            const auto id     = std::string_view{reinterpret_cast<const char*>(frame), idSize};
+            if (id == "COMM" || id == "COM") {
+                readSmpbFrame(tag + bodyPos, frameSize, true, smpb);
+            } else if (id == "TXXX" || id == "TXX") {
+                readSmpbFrame(tag + bodyPos, frameSize, false, smpb);
+            }
+            if (false == smpb.empty()) {
+                return;
+            }
+        }
+    }
+
+    /// 跳过开头的 ID3v2 标签（可能有多个），返回之后的位置
+    size_t skipId3v2(const uint8_t* data, size_t size, std::string& smpb) {
+        size_t pos = 0;
+        while (pos + 10 <= size && 0 == memcmp(data + pos, "ID3", 3)) {
+            const int  major   = data[pos + 3];
+            const int  flags   = data[pos + 5];
+            const auto tagSize = size_t(readSyncsafe(data + pos + 6));
+            const auto body    = pos + 10;
+            if (smpb.empty()) {
+                findSmpb(data + body, std::min(tagSize, size - body), major, flags, smpb);
+            }
+            // 有标签尾时多 10 字节
+            pos = std::min(size, body + tagSize + ((flags & 0x10) ? 10 : 0));
+        }
+        return pos;
+    }
+
+    /// 去掉结尾的 ID3v1 和 APEv2 标签，返回音频数据的结尾
+    size_t trimTrailingTags(const uint8_t* data, size_t begin, size_t end) {
+        if (end - begin >= 128 && 0 == memcmp(data + end - 128, "TAG", 3)) {
+            end -= 128;
+        }
+        if (end - begin >= 32 && 0 == memcmp(data + end - 32, "APETAGEX", 8)) {
+            // 长度包含标签尾，不包含标签头；标志的最高位表示有标签头
+            const auto footer = data + end - 32;
+            const auto total  = size_t(readLe32(footer + 12))
+                             + ((readLe32(footer + 20) & 0x80000000u) ? 32 : 0);
+            if (total <= end - begin) {
+                end -= total;
+            }
+        }
+        return end;
+    }
+
+    /// 其他容器格式的文件签名，其中可能恰好有类似帧头的数据
+    bool isOtherContainer(const uint8_t* p, size_t size) {
+        if (size < 12) {
+            return false;
+        }
+        for (const auto magic : {"RIFF", "fLaC", "OggS", "FORM", "\x1A\x45\xDF\xA3", "wvpk"}) {
+            if (0 == memcmp(p, magic, 4)) {
+                return true;
+            }
+        }
+        return 0 == memcmp(p + 4, "ftyp", 4);
+    }
+
+    /// 第一帧为 Xing/Info/VBRI 信息帧时，读取其中的帧数和 LAME 标签，返回 true
+    bool readInfoFrame(const uint8_t* frame, const FrameHeader& h, FrameScanInfo& out) {
+        if (((frame[1] >> 1) & 3) != 1) {
+            // 只有 Layer III
+            return false;
+        }
+        const auto length = size_t(h.length);
+        const bool mpeg1  = (frame[1] & 0x18) == 0x18;
+        const bool mono   = (h.channels == 1);
+        // Xing 头在边信息之后
+        const auto xing   = size_t(4 + (mpeg1 ? (mono ? 17 : 32) : (mono ? 9 : 17)));
+        if (xing + 8 <= length
+            && (0 == memcmp(frame + xing, "Xing", 4) || 0 == memcmp(frame + xing, "Info", 4))) {
+            const auto flags = readBe32(frame + xing + 4);
+            auto       pos   = xing + 8;
+            if ((flags & 0x01) && pos + 4 <= length) {
+                out.headerFrames = readBe32(frame + pos);
+            }
+            // 帧数、字节数、TOC、质量，各自存在时占用的字节数
+            pos += ((flags & 0x01) ? 4 : 0) + ((flags & 0x02) ? 4 : 0);
+            pos += ((flags & 0x04) ? 100 : 0) + ((flags & 0x08) ? 4 : 0);
+            // LAME 标签：编码器名 9 字节，第 21 字节起的 3 字节为各 12 位的延迟和填充；
+            // FFmpeg 写入的标签格式相同
+            if (pos + 24 <= length
+                && (0 == memcmp(frame + pos, "LAME", 4) || 0 == memcmp(frame + pos, "Lavf", 4)
+                    || 0 == memcmp(frame + pos, "Lavc", 4))) {
+                const auto p       = frame + pos + 21;
+                out.encoderDelay   = p[0] << 4 | p[1] >> 4;
+                out.encoderPadding = (p[1] & 0x0F) << 8 | p[2];
+                out.gaplessSource  = "lame";
+            }
+            return true;
+        }
+        // VBRI 头固定在帧头之后 32 字节
+        const size_t vbri = 4 + 32;
+        if (vbri + 18 <= length && 0 == memcmp(frame + vbri, "VBRI", 4)) {
+            out.headerFrames = readBe32(frame + vbri + 14);
+            return true;
+        }
+        return false;
+    }
+
+    /// iTunSMPB：空格分隔的十六进制数，第 2、3 个为延迟和填充
+    bool parseSmpb(std::string_view text, FrameScanInfo& out) {
+        uint64_t    fields[3]{};
+        size_t      count = 0;
+        const char* p     = text.data();
+        const char* end   = p + text.size();
+        while (count < 3 && p < end) {
+            if (*p == ' ') {
+                ++p;
+                continue;
+            }
+            const auto [next, ec] = std::from_chars(p, end, fields[count], 16);
+            if (ec != std::errc{}) {
+                return false;
+            }
+            p = next;
+            ++count;
+        }
+        if (count < 3 || fields[1] > cMaxGapless || fields[2] > cMaxGapless) {
+            return false;
+        }
+        out.encoderDelay   = int(fields[1]);
+        out.encoderPadding = int(fields[2]);
+        out.gaplessSource  = "itunsmpb";
+        return true;
+    }
+} // namespace
+
+int FrameScanner_c::scan(MediaInfoItem_c& item, FrameScanInfo& out) {
+    if (item.filepath.empty()) {
+        item.setError(MEDIAXX_DIAG_STAGE_OPEN, MEDIAXX_DIAG_ERR_NO_PATH);
+        return -1;
+    }
+    if (item.filepath.find("://") != std::string::npos) {
+        item.setLog("只支持本地文件: {}", item.filepath);
+        return -1;
+    }
+    if (item.isInterrupted()) {
+        item.setError(MEDIAXX_DIAG_STAGE_OPEN, MEDIAXX_DIAG_ERR_CANCELLED);
+        return -2;
+    }
+    MappedFile_c file{};
+    if (false == file.open(item.filepath)) {
+        item.setError(MEDIAXX_DIAG_STAGE_OPEN, MEDIAXX_DIAG_ERR_OPEN);
+        return -1;
+    }
+    const auto  data = file.data();
+    std::string smpb{};
+    const auto  head = skipId3v2(data, file.size(), smpb);
+    const auto  end  = trimTrailingTags(data, head, file.size());
+
+    auto       kind  = StreamKind::Mpeg;
+    uint32_t   key   = 0;
+    auto       first = cNotFound;
+    if (false == isOtherContainer(data + head, end - head)) {
+        first = findSync(data, head, head + cMaxLeadingJunk, end, cSyncFrames, kind, key);
+    }
+    if (first == cNotFound) {
+        item.setLog("没有找到 MP3/ADTS 帧: {}", item.filepath);
+        return 0;
+    }
+    out.format       = (kind == StreamKind::Mpeg) ? "mp3" : "aac";
+    out.skippedBytes = int64_t(first - head);
+
+    FrameHeader h{};
+    auto        pos = first;
+    while (pos < end) {
+        if (false == parseAt(data, pos, end, kind, key, h)) {
+            // 无效的数据或不完整的最后一帧，找下一个同步位置
+            const auto next = findSync(data, pos + 1, end, end, 2, kind, key);
+            out.skippedBytes += int64_t(((next == cNotFound) ? end : next) - pos);
+            if (next == cNotFound) {
+                break;
+            }
+            pos = next;
+            continue;
+        }
+        if (pos == first && kind == StreamKind::Mpeg && readInfoFrame(data + pos, h, out)) {
+            // 信息帧解码为静音，解码器会丢弃，不计入
+            pos += size_t(h.length);
+            continue;
+        }
+        if (0 == out.frameCount) {
+            out.sampleRate = h.sampleRate;
+            out.channels   = h.channels;
+        }
+        ++out.frameCount;
+        out.totalSamples += h.samples;
+        pos              += size_t(h.length);
+        if (0 == out.frameCount % cCheckInterval && item.isInterrupted()) {
+            item.setError(MEDIAXX_DIAG_STAGE_STREAM_INFO, MEDIAXX_DIAG_ERR_CANCELLED);
+            return -2;
+        }
+    }
+    if (0 == out.frameCount) {
+        item.setLog("没有音频帧: {}", item.filepath);
+        return 0;
+    }
+    if (out.gaplessSource.empty() && false == smpb.empty() && false == parseSmpb(smpb, out)) {
+        item.setLog("无效的 iTunSMPB: {}", smpb);
+    }
+    LXX_DEBEG(
+        "FrameScanner | {} {} frames, {} samples, delay {}, padding {}: {}",
+        out.format,
+        out.frameCount,
+        out.totalSamples,
+        out.encoderDelay,
+        out.encoderPadding,
+        item.filepath
+    );
+    return 1;
+}
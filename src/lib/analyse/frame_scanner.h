@@ -0,0 +1,52 @@
+#pragma once
+
+#include "analyse/media_info_reader.h"
+#include <cstdint>
+#include <string_view>
+
+/// 逐帧扫描得到的精确时长和无缝播放信息，采样数为每声道的采样数
+struct FrameScanInfo {
+    /// `mp3`（MPEG-1/2/2.5 Layer I/II/III）或 `aac`（ADTS）
+    std::string_view format{};
+    int              sampleRate     = 0;
+    int              channels       = 0;
+    /// 音频帧数，不含 Xing/Info/VBRI 信息帧
+    int64_t          frameCount     = 0;
+    /// 所有音频帧解码得到的采样数
+    int64_t          totalSamples   = 0;
+    /// 编码器在开头和结尾加入的采样数，-1 表示文件中没有记录
+    int              encoderDelay   = -1;
+    int              encoderPadding = -1;
+    /// Xing/VBRI 头记录的帧数，-1 表示没有；与 [frameCount] 不同说明文件被截断或拼接过
+    int64_t          headerFrames   = -1;
+    /// 延迟和填充的来源：`lame`（LAME 标签）、`itunsmpb`（ID3 的 iTunSMPB 注释）或空
+    std::string_view gaplessSource{};
+    /// 帧之间跳过的无法识别的字节数
+    int64_t          skippedBytes   = 0;
+
+    /// 去掉延迟和填充后的有效采样数
+    int64_t validSamples() const {
+        return totalSamples - std::max(encoderDelay, 0) - std::max(encoderPadding, 0);
+    }
+};
+
+/// # 按帧头扫描 MP3 和 ADTS AAC 的精确时长
+/// - 没有 Xing/VBRI 头的 VBR MP3、裸 ADTS 流中，FFmpeg 按码率估算时长，误差可达数秒；
+///   这里映射整个文件，逐个解析帧头累计采样数，不解码，开销只有顺序读一遍文件
+/// - 帧同步字用 memchr 查找 0xFF（libc 的向量化实现），候选位置的下一帧也有效才确认；
+///   帧之间的无效数据跳过后重新同步
+/// - 跳过开头的 ID3v2、结尾的 ID3v1 和 APEv2 标签；第一帧为 Xing/Info/VBRI 信息帧时不计入，
+///   其中的 LAME 标签记录编码器的延迟和填充，没有时读取 ID3v2 的 iTunSMPB 注释
+class FrameScanner_c {
+public:
+
+    static FrameScanner_c instance;
+
+    FrameScanner_c() {}
+
+    ~FrameScanner_c() {}
+
+    /// 只支持本地文件
+    /// - 返回 1 成功，0 不是 MP3/ADTS 流，-1 无法打开，-2 已取消
+    int scan(MediaInfoItem_c& item, FrameScanInfo& out);
+};
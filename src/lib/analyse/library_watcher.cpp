@@ -0,0 +1,328 @@
+#include "library_watcher.h"
+#include "util/log.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <format>
+
+#if _ISLINUX || _ISANDROID
+#include <cerrno>
+#include <dirent.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 只关心会影响媒体库内容的事件；IN_MODIFY 在写入过程中会频繁触发，改用 IN_CLOSE_WRITE
+static constexpr uint32_t cWatchMask = IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM
+                                     | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR
+                                     | IN_EXCL_UNLINK;
+
+// 单次合并的最长等待时间，避免持续写入时一直不返回
+static constexpr int cMaxDebounceRounds = 10;
+
+LibraryWatcher_c::LibraryWatcher_c() {}
+
+LibraryWatcher_c::~LibraryWatcher_c() {
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+bool LibraryWatcher_c::init(analyse_tool::AnalyseLogItem_c& logItem) {
+    if (fd >= 0) {
+        return true;
+    }
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        logItem.setLog("inotify_init1 失败: {}", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool LibraryWatcher_c::addRoot(const std::string_view root, analyse_tool::AnalyseLogItem_c& logItem) {
+    if (fd < 0) {
+        logItem.setLog("监听未初始化");
+        return false;
+    }
+    auto dir = std::string{root};
+    while (dir.size() > 1 && dir.back() == '/') {
+        dir.pop_back();
+    }
+    std::lock_guard lock{mutex};
+    if (std::find(roots.begin(), roots.end(), dir) == roots.end()) {
+        roots.push_back(dir);
+    }
+    // 首次添加时不上报已有文件，由调用方的全量扫描负责
+    return addWatchRecursive(dir, false, logItem);
+}
+
+bool LibraryWatcher_c::addWatchRecursive(
+    const std::string&              dir,
+    bool                            reportFiles,
+    analyse_tool::AnalyseLogItem_c& logItem
+) {
+    const int wd = inotify_add_watch(fd, dir.c_str(), cWatchMask);
+    if (wd < 0) {
+        // ENOSPC: 超过 /proc/sys/fs/inotify/max_user_watches
+        logItem.setLog("inotify_add_watch 失败: {} | {}", dir, strerror(errno));
+        return false;
+    }
+    {
+        // 同一 inode 重复注册时会返回相同的 wd
+        auto it = wdToDir.find(wd);
+        if (it != wdToDir.end()) {
+            dirToWd.erase(it->second);
+        }
+        wdToDir[wd]  = dir;
+        dirToWd[dir] = wd;
+    }
+
+    DIR* dp = opendir(dir.c_str());
+    if (nullptr == dp) {
+        return true;
+    }
+    bool result = true;
+    while (auto entry = readdir(dp)) {
+        if (0 == strcmp(entry->d_name, ".") || 0 == strcmp(entry->d_name, "..")) {
+            continue;
+        }
+        auto path  = std::string{dir}.append("/").append(entry->d_name);
+        auto isDir = (entry->d_type == DT_DIR);
+        if (entry->d_type == DT_UNKNOWN) {
+            // 部分文件系统不返回类型；不跟随符号链接，避免目录环
+            struct stat st{};
+            if (0 == lstat(path.c_str(), &st)) {
+                isDir = S_ISDIR(st.st_mode);
+            }
+        }
+        if (isDir) {
+            if (false == addWatchRecursive(path, reportFiles, logItem)) {
+                result = false;
+            }
+        } else if (reportFiles && entry->d_type != DT_LNK) {
+            markPending(path, LibraryDeltaType::Add, false);
+        }
+    }
+    closedir(dp);
+    return result;
+}
+
+void LibraryWatcher_c::removeWatchByPrefix(const std::string& dir) {
+    const auto prefix = dir + "/";
+    for (auto it = dirToWd.begin(); it != dirToWd.end();) {
+        if (it->first == dir || it->first.starts_with(prefix)) {
+            inotify_rm_watch(fd, it->second);
+            wdToDir.erase(it->second);
+            it = dirToWd.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void LibraryWatcher_c::markPending(const std::string& path, LibraryDeltaType type, bool isDir) {
+    if (type == LibraryDeltaType::Remove && isDir) {
+        // 目录被移除，调用方会按前缀移除其下所有条目，丢弃本轮内其下的文件变更
+        const auto prefix = path + "/";
+        std::erase_if(pending, [&prefix](const auto& item) {
+            return item.first.starts_with(prefix);
+        });
+    }
+    auto it = pending.find(path);
+    if (it == pending.end()) {
+        pending.emplace(path, PendingState{type, isDir, pendingOrder++});
+        return;
+    }
+    auto& state = it->second;
+    switch (type) {
+    case LibraryDeltaType::Add:
+        // 删除后重新出现，视为内容变更
+        state.type = (state.type == LibraryDeltaType::Remove || state.type == LibraryDeltaType::Update)
+                       ? LibraryDeltaType::Update
+                       : LibraryDeltaType::Add;
+        break;
+    case LibraryDeltaType::Update:
+        if (state.type != LibraryDeltaType::Add) {
+            state.type = LibraryDeltaType::Update;
+        }
+        break;
+    case LibraryDeltaType::Remove:
+        if (state.type == LibraryDeltaType::Add) {
+            // 本轮内新建又删除的临时文件，不需要上报
+            pending.erase(it);
+            return;
+        }
+        state.type = LibraryDeltaType::Remove;
+        break;
+    case LibraryDeltaType::Rescan:
+        state.type = LibraryDeltaType::Rescan;
+        break;
+    }
+    state.isDir = isDir;
+}
+
+bool LibraryWatcher_c::readEvents(analyse_tool::AnalyseLogItem_c& logItem) {
+    alignas(struct inotify_event) char buffer[64 * 1024];
+    bool                               hasEvent = false;
+    while (true) {
+        const auto len = read(fd, buffer, sizeof(buffer));
+        if (len <= 0) {
+            if (len < 0 && errno != EAGAIN && errno != EINTR) {
+                logItem.setLog("读取 inotify 事件失败: {}", strerror(errno));
+            }
+            break;
+        }
+        hasEvent = true;
+        for (ssize_t offset = 0; offset < len;) {
+            const auto event = reinterpret_cast<const struct inotify_event*>(buffer + offset);
+            offset += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+                continue;
+            }
+            auto wdIt = wdToDir.find(event->wd);
+            if (wdIt == wdToDir.end()) {
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                dirToWd.erase(wdIt->second);
+                wdToDir.erase(wdIt);
+                continue;
+            }
+            const auto dir = wdIt->second;
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+                // 被监听的目录自身被删除/移走，子目录的事件会由上级目录的监听单独上报
+                if (std::find(roots.begin(), roots.end(), dir) != roots.end()) {
+                    removeWatchByPrefix(dir);
+                    markPending(dir, LibraryDeltaType::Remove, true);
+                }
+                continue;
+            }
+            if (event->len == 0) {
+                continue;
+            }
+            const auto path  = std::string{dir}.append("/").append(event->name);
+            const bool isDir = (event->mask & IN_ISDIR);
+            LXX_DEBEG("LibraryWatcher event: {} | {}", event->mask, path);
+
+            if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                if (isDir) {
+                    // 新目录在注册监听前可能已写入文件，补充上报
+                    addWatchRecursive(path, true, logItem);
+                } else {
+                    markPending(path, LibraryDeltaType::Add, false);
+                }
+            } else if (event->mask & IN_CLOSE_WRITE) {
+                markPending(path, LibraryDeltaType::Update, false);
+            } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                if (isDir) {
+                    removeWatchByPrefix(path);
+                }
+                markPending(path, LibraryDeltaType::Remove, isDir);
+            }
+        }
+    }
+    return hasEvent;
+}
+
+std::vector<LibraryDelta> LibraryWatcher_c::takePending() {
+    std::vector<LibraryDelta> result{};
+    if (overflow) {
+        // 溢出后单个事件已不可信，直接要求全量扫描
+        overflow = false;
+        pending.clear();
+        for (const auto& root : roots) {
+            result.push_back(LibraryDelta{LibraryDeltaType::Rescan, root, true});
+        }
+        return result;
+    }
+    std::vector<std::pair<size_t, LibraryDelta>> ordered{};
+    ordered.reserve(pending.size());
+    for (auto& [path, state] : pending) {
+        ordered.emplace_back(state.order, LibraryDelta{state.type, path, state.isDir});
+    }
+    pending.clear();
+    pendingOrder = 0;
+    std::sort(ordered.begin(), ordered.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+    result.reserve(ordered.size());
+    for (auto& item : ordered) {
+        result.push_back(std::move(item.second));
+    }
+    return result;
+}
+
+std::vector<LibraryDelta>
+    LibraryWatcher_c::poll(int timeoutMs, int debounceMs, analyse_tool::AnalyseLogItem_c& logItem) {
+    if (fd < 0) {
+        logItem.setLog("监听未初始化");
+        return {};
+    }
+    if (debounceMs < 0) {
+        debounceMs = 0;
+    }
+    struct pollfd pfd{fd, POLLIN, 0};
+    // 不持有锁等待，允许其他线程同时 [addRoot]
+    if (::poll(&pfd, 1, timeoutMs) <= 0) {
+        std::lock_guard lock{mutex};
+        return takePending();
+    }
+    std::lock_guard lock{mutex};
+    readEvents(logItem);
+    for (int round = 0; round < cMaxDebounceRounds && debounceMs > 0; ++round) {
+        pfd.revents = 0;
+        if (::poll(&pfd, 1, debounceMs) <= 0) {
+            break;
+        }
+        readEvents(logItem);
+    }
+    return takePending();
+}
+
+#else
+
+LibraryWatcher_c::LibraryWatcher_c() {}
+
+LibraryWatcher_c::~LibraryWatcher_c() {}
+
+bool LibraryWatcher_c::init(analyse_tool::AnalyseLogItem_c& logItem) {
+    logItem.setLog("当前平台不支持目录监听");
+    return false;
+}
+
+bool LibraryWatcher_c::addRoot(const std::string_view root, analyse_tool::AnalyseLogItem_c& logItem) {
+    logItem.setLog("当前平台不支持目录监听");
+    return false;
+}
+
+bool LibraryWatcher_c::addWatchRecursive(
+    const std::string&              dir,
+    bool                            reportFiles,
+    analyse_tool::AnalyseLogItem_c& logItem
+) {
+    return false;
+}
+
+void LibraryWatcher_c::removeWatchByPrefix(const std::string& dir) {}
+
+void LibraryWatcher_c::markPending(const std::string& path, LibraryDeltaType type, bool isDir) {}
+
+bool LibraryWatcher_c::readEvents(analyse_tool::AnalyseLogItem_c& logItem) {
+    return false;
+}
+
+std::vector<LibraryDelta> LibraryWatcher_c::takePending() {
+    return {};
+}
+
+std::vector<LibraryDelta>
+    LibraryWatcher_c::poll(int timeoutMs, int debounceMs, analyse_tool::AnalyseLogItem_c& logItem) {
+    return {};
+}
+
+#endif
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "analyse/tool.h"
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// 媒体库变更类型
+enum class LibraryDeltaType : int {
+    // 事件队列溢出，期间的变更已丢失，调用方需要对 [path] 做一次完整扫描
+    Rescan = 0,
+    Add    = 1,
+    Update = 2,
+    Remove = 3,
+};
+
+struct LibraryDelta {
+    LibraryDeltaType type;
+    std::string      path;
+    // [Remove] 时如果是目录，调用方需要移除该目录下的所有条目
+    bool             isDir = false;
+};
+
+/// # 媒体库目录监听
+/// - 仅 Linux/Android 可用，基于 inotify
+/// - inotify 不支持递归监听，这里会为根目录下的每个子目录单独注册，并在新建/移入目录时补充注册
+/// - [poll] 会合并 [debounceMs] 内的突发事件，同一路径多次变更只会输出一次
+class LibraryWatcher_c {
+public:
+
+    LibraryWatcher_c();
+
+    ~LibraryWatcher_c();
+
+    /// 创建 inotify 实例，失败时记录原因
+    bool init(analyse_tool::AnalyseLogItem_c& logItem);
+
+    bool isAvail() const {
+        return fd >= 0;
+    }
+
+    /// 递归监听 [root] 及其所有子目录
+    bool addRoot(const std::string_view root, analyse_tool::AnalyseLogItem_c& logItem);
+
+    /// 等待最多 [timeoutMs] 毫秒，有事件后继续收集直到 [debounceMs] 内没有新事件
+    std::vector<LibraryDelta>
+        poll(int timeoutMs, int debounceMs, analyse_tool::AnalyseLogItem_c& logItem);
+
+protected:
+
+    // 记录同一路径在本轮合并中的最终状态
+    struct PendingState {
+        LibraryDeltaType type;
+        bool             isDir;
+        // 保持事件首次出现的顺序输出
+        size_t           order;
+    };
+
+    int                                  fd = -1;
+    std::mutex                           mutex{};
+    std::unordered_map<int, std::string> wdToDir{};
+    std::unordered_map<std::string, int> dirToWd{};
+    std::vector<std::string>             roots{};
+
+    std::unordered_map<std::string, PendingState> pending{};
+    size_t                                        pendingOrder = 0;
+    bool                                          overflow     = false;
+
+    bool addWatchRecursive(
+        const std::string&              dir,
+        bool                            reportFiles,
+        analyse_tool::AnalyseLogItem_c& logItem
+    );
+
+    void removeWatchByPrefix(const std::string& dir);
+
+    void markPending(const std::string& path, LibraryDeltaType type, bool isDir);
+
+    /// 读取并处理当前所有可读事件，返回是否读到事件
+    bool readEvents(analyse_tool::AnalyseLogItem_c& logItem);
+
+    std::vector<LibraryDelta> takePending();
+};
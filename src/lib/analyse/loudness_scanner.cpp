@@ -0,0 +1,298 @@
+#include "loudness_scanner.h"
+#include "analyse/audio_decoder.h"
+#include "util/log.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+extern "C" {
+#include "libavutil/channel_layout.h"
+}
+
+LoudnessScanner_c LoudnessScanner_c::instance = LoudnessScanner_c();
+
+namespace {
+    // 每次解码的帧数
+    constexpr int    cReadFrames    = 8192;
+    // 多相滤波器每相的抽头数
+    constexpr size_t cFirTaps       = 12;
+    // BS.1770 的绝对门限，及综合响度和响度范围的相对门限
+    constexpr double cAbsoluteGate  = -70.0;
+    constexpr double cIntegratedGap = -10.0;
+    constexpr double cRangeGap      = -20.0;
+
+    double energyToLufs(double energy) {
+        return -0.691 + 10.0 * std::log10(energy);
+    }
+
+    double lufsToEnergy(double lufs) {
+        return std::pow(10.0, (lufs + 0.691) / 10.0);
+    }
+
+    double sinc(double x) {
+        return (0.0 == x) ? 1.0 : std::sin(std::numbers::pi * x) / (std::numbers::pi * x);
+    }
+
+    /// 超过绝对门限的块的平均能量，及其数量
+    template<typename Fn>
+    double gatedMean(
+        std::span<const LoudnessMeter_c* const> meters,
+        Fn&&                                    energiesOf,
+        double                                  threshold,
+        size_t&                                 outCount
+    ) {
+        double sum = 0;
+        outCount   = 0;
+        for (const auto meter : meters) {
+            for (const auto energy : energiesOf(*meter)) {
+                if (energy > threshold) {
+                    sum += energy;
+                    ++outCount;
+                }
+            }
+        }
+        return outCount > 0 ? sum / double(outCount) : 0;
+    }
+} // namespace
+
+bool LoudnessMeter_c::init(int sampleRate, int in_channels) {
+    if (sampleRate <= 0 || in_channels <= 0) {
+        return false;
+    }
+    channels = in_channels;
+
+    // BS.1770 的 K 加权系数按采样率换算（双线性变换），同 libebur128
+    const double fs = sampleRate;
+    {
+        const double f0 = 1681.974450955533;
+        const double g  = 3.999843853973347;
+        const double q  = 0.7071752369554196;
+        const double k  = std::tan(std::numbers::pi * f0 / fs);
+        const double vh = std::pow(10.0, g / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+        shelf.b0        = (vh + vb * k / q + k * k) / a0;
+        shelf.b1        = 2.0 * (k * k - vh) / a0;
+        shelf.b2        = (vh - vb * k / q + k * k) / a0;
+        shelf.a1        = 2.0 * (k * k - 1.0) / a0;
+        shelf.a2        = (1.0 - k / q + k * k) / a0;
+    }
+    {
+        const double f0 = 38.13547087602444;
+        const double q  = 0.5003270373238773;
+        const double k  = std::tan(std::numbers::pi * f0 / fs);
+        const double a0 = 1.0 + k / q + k * k;
+        highPass.b0     = 1.0;
+        highPass.b1     = -2.0;
+        highPass.b2     = 1.0;
+        highPass.a1     = 2.0 * (k * k - 1.0) / a0;
+        highPass.a2     = (1.0 - k / q + k * k) / a0;
+    }
+    filterState.assign(size_t(channels) * 4, 0.0);
+
+    AVChannelLayout layout{};
+    av_channel_layout_default(&layout, channels);
+    weights.assign(channels, 1.0);
+    for (int i = 0; i < channels; ++i) {
+        switch (av_channel_layout_channel_from_index(&layout, unsigned(i))) {
+        case AV_CHAN_LOW_FREQUENCY:
+        case AV_CHAN_LOW_FREQUENCY_2:
+            weights[i] = 0.0;
+            break;
+        case AV_CHAN_SIDE_LEFT:
+        case AV_CHAN_SIDE_RIGHT:
+        case AV_CHAN_BACK_LEFT:
+        case AV_CHAN_BACK_RIGHT:
+            weights[i] = 1.41;
+            break;
+        default:
+            break;
+        }
+    }
+    av_channel_layout_uninit(&layout);
+
+    subBlockFrames = size_t(std::max(sampleRate / 10, 1));
+    subBlockPos    = 0;
+    subBlockSum    = 0;
+    subBlockCount  = 0;
+    blockEnergies.clear();
+    shortTermEnergies.clear();
+
+    // 加窗 sinc 低通，截止频率为原采样率的一半；每相的系数之和约为 1
+    oversample = sampleRate < 96000 ? 4 : (sampleRate < 192000 ? 2 : 1);
+    firCoeffs.assign(size_t(oversample) * cFirTaps, 0.0f);
+    const auto length = size_t(oversample) * cFirTaps;
+    const auto center = (double(length) - 1.0) / 2.0;
+    for (size_t m = 0; m < length; ++m) {
+        const auto x      = (double(m) - center) / oversample;
+        const auto window = 0.5 - 0.5 * std::cos(2.0 * std::numbers::pi * (m + 0.5) / length);
+        // 第 phase 相的第 k 个抽头为 h[k * oversample + phase]，与历史采样对齐时倒序
+        const auto phase  = m % oversample;
+        const auto tap    = m / oversample;
+        firCoeffs[phase * cFirTaps + (cFirTaps - 1 - tap)] = float(sinc(x) * window);
+    }
+    firHistory.assign(size_t(channels) * cFirTaps * 2, 0.0f);
+    firPos        = 0;
+    peak          = 0;
+    truePeakValue = 0;
+    return true;
+}
+
+float LoudnessMeter_c::interpolatePeak(const float* window) const {
+    float result = 0;
+    for (int phase = 0; phase < oversample; ++phase) {
+        const auto coeffs = firCoeffs.data() + size_t(phase) * cFirTaps;
+        float      sum    = 0;
+        for (size_t k = 0; k < cFirTaps; ++k) {
+            sum += coeffs[k] * window[k];
+        }
+        result = std::max(result, std::abs(sum));
+    }
+    return result;
+}
+
+void LoudnessMeter_c::add(const float* samples, size_t frames) {
+    const auto channelCount = size_t(channels);
+    for (size_t f = 0; f < frames; ++f, samples += channelCount) {
+        double weighted = 0;
+        for (size_t c = 0; c < channelCount; ++c) {
+            const auto x = samples[c];
+            peak         = std::max(peak, double(std::abs(x)));
+
+            if (oversample > 1) {
+                auto history               = firHistory.data() + c * cFirTaps * 2;
+                history[firPos]            = x;
+                history[firPos + cFirTaps] = x;
+                // [firPos + 1, firPos + cFirTaps] 为从旧到新的 [cFirTaps] 个采样
+                const auto interpolated    = interpolatePeak(history + firPos + 1);
+                truePeakValue              = std::max(truePeakValue, double(interpolated));
+            }
+
+            auto       state = filterState.data() + c * 4;
+            const auto y1    = shelf.b0 * x + state[0];
+            state[0]         = shelf.b1 * x - shelf.a1 * y1 + state[1];
+            state[1]         = shelf.b2 * x - shelf.a2 * y1;
+            const auto y2    = highPass.b0 * y1 + state[2];
+            state[2]         = highPass.b1 * y1 - highPass.a1 * y2 + state[3];
+            state[3]         = highPass.b2 * y1 - highPass.a2 * y2;
+            weighted += weights[c] * y2 * y2;
+        }
+        if (oversample > 1) {
+            firPos = (firPos + 1) % cFirTaps;
+        }
+        subBlockSum += weighted;
+        if (++subBlockPos == subBlockFrames) {
+            finishSubBlock();
+        }
+    }
+}
+
+void LoudnessMeter_c::finishSubBlock() {
+    recentSubBlocks[subBlockCount % cShortTermSubBlocks] = subBlockSum / double(subBlockFrames);
+    ++subBlockCount;
+    subBlockSum = 0;
+    subBlockPos = 0;
+
+    // 块的能量为所含子块的平均
+    const auto average = [this](size_t count) {
+        double sum = 0;
+        for (size_t i = 1; i <= count; ++i) {
+            sum += recentSubBlocks[(subBlockCount - i) % cShortTermSubBlocks];
+        }
+        return sum / double(count);
+    };
+    if (subBlockCount >= cBlockSubBlocks) {
+        blockEnergies.push_back(average(cBlockSubBlocks));
+    }
+    if (subBlockCount >= cShortTermSubBlocks) {
+        shortTermEnergies.push_back(average(cShortTermSubBlocks));
+    }
+}
+
+double LoudnessMeter_c::integratedOf(std::span<const LoudnessMeter_c* const> meters) {
+    const auto blocks = [](const LoudnessMeter_c& meter) -> const std::vector<double>& {
+        return meter.blockEnergies;
+    };
+    size_t     count    = 0;
+    const auto absolute = lufsToEnergy(cAbsoluteGate);
+    const auto mean     = gatedMean(meters, blocks, absolute, count);
+    if (0 == count) {
+        return -std::numeric_limits<double>::infinity();
+    }
+    const auto relative = std::max(absolute, mean * std::pow(10.0, cIntegratedGap / 10.0));
+    const auto gated    = gatedMean(meters, blocks, relative, count);
+    return 0 == count ? -std::numeric_limits<double>::infinity() : energyToLufs(gated);
+}
+
+double LoudnessMeter_c::rangeOf(std::span<const LoudnessMeter_c* const> meters) {
+    const auto shortTerms = [](const LoudnessMeter_c& meter) -> const std::vector<double>& {
+        return meter.shortTermEnergies;
+    };
+    size_t     count    = 0;
+    const auto absolute = lufsToEnergy(cAbsoluteGate);
+    const auto mean     = gatedMean(meters, shortTerms, absolute, count);
+    if (0 == count) {
+        return 0;
+    }
+    const auto relative = std::max(absolute, mean * std::pow(10.0, cRangeGap / 10.0));
+
+    std::vector<double> values{};
+    values.reserve(count);
+    for (const auto meter : meters) {
+        for (const auto energy : meter->shortTermEnergies) {
+            if (energy > relative) {
+                values.push_back(energy);
+            }
+        }
+    }
+    if (values.empty()) {
+        return 0;
+    }
+    // 能量和响度单调对应，直接按能量取分位数
+    const auto at = [&values](double percentile) {
+        const auto index = size_t(std::lround(double(values.size() - 1) * percentile));
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return energyToLufs(values[index]);
+    };
+    const auto low  = at(0.10);
+    const auto high = at(0.95);
+    return high - low;
+}
+
+int LoudnessScanner_c::scan(
+    MediaInfoItem_c& item,
+    std::string_view headers,
+    int              decodeThreads,
+    LoudnessMeter_c& meter
+) {
+    // 解码需要完整的流参数
+    item.probeStreams = true;
+    if (false == MediaInfoReader_c::instance.openFile(item, headers)) {
+        return item.isInterrupted() ? -2 : -1;
+    }
+    AudioDecoder_c decoder{};
+    if (false == decoder.open(item, 0, 0, decodeThreads)) {
+        return 0;
+    }
+    if (false == meter.init(decoder.sampleRate(), decoder.channels())) {
+        item.setError(MEDIAXX_DIAG_STAGE_AUDIO, MEDIAXX_DIAG_ERR_DECODER_OPEN);
+        return 0;
+    }
+
+    std::vector<float> buffer(size_t(cReadFrames) * decoder.channels());
+    int                frames = 0;
+    while ((frames = decoder.read(buffer.data(), cReadFrames)) > 0) {
+        meter.add(buffer.data(), size_t(frames));
+    }
+    if (item.isInterrupted()) {
+        return -2;
+    }
+    LXX_DEBEG(
+        "LoudnessScanner | {:.2f} LUFS, peak {:.4f}: {}",
+        meter.integrated(),
+        meter.truePeak(),
+        item.filepath
+    );
+    return 1;
+}
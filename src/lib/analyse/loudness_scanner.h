@@ -0,0 +1,118 @@
+#pragma once
+
+#include "analyse/media_info_reader.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <vector>
+
+/// # 响度测量（EBU R128 / ITU-R BS.1770-4）
+/// - K 加权后按 100ms 子块累计各声道加权的均方值，每 4 个子块为一个 400ms 门限块（75% 重叠），
+///   每 30 个为一个 3s 短时块
+/// - 综合响度：-70 LUFS 绝对门限和 -10 LU 相对门限；响度范围：短时块经 -70 LUFS 和 -20 LU
+///   门限后 10%~95% 分位数之差
+/// - 真峰值：采样率低于 96kHz 时 4 倍、低于 192kHz 时 2 倍过采样后的峰值
+/// - 只保存块的能量，多个实例可以合并计算专辑的结果
+class LoudnessMeter_c {
+public:
+
+    /// ReplayGain 2.0 的参考响度
+    static constexpr double cReferenceLufs = -18.0;
+
+    /// [samples] 的声道顺序为 av_channel_layout_default 的默认布局
+    bool init(int sampleRate, int channels);
+
+    /// 交错排列的 [frames] 帧
+    void add(const float* samples, size_t frames);
+
+    /// LUFS；没有超过门限的块（如静音或短于 400ms）时为 -inf
+    double integrated() const {
+        const LoudnessMeter_c* self = this;
+        return integratedOf({&self, 1});
+    }
+
+    /// LU
+    double range() const {
+        const LoudnessMeter_c* self = this;
+        return rangeOf({&self, 1});
+    }
+
+    /// 线性，满幅为 1.0
+    double samplePeak() const {
+        return peak;
+    }
+
+    /// 线性，可能超过 1.0
+    double truePeak() const {
+        return std::max(truePeakValue, peak);
+    }
+
+    /// 合并 [meters] 的所有门限块计算综合响度，即专辑的响度
+    static double integratedOf(std::span<const LoudnessMeter_c* const> meters);
+
+    static double rangeOf(std::span<const LoudnessMeter_c* const> meters);
+
+protected:
+
+    // 直接 II 型转置的二阶节
+    struct Biquad {
+        double b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+    };
+
+    static constexpr size_t cShortTermSubBlocks = 30;
+    static constexpr size_t cBlockSubBlocks     = 4;
+
+    int                 channels = 0;
+    Biquad              shelf{};
+    Biquad              highPass{};
+    // 每声道 4 个：两级滤波器各 2 个状态
+    std::vector<double> filterState{};
+    // 各声道的权重，LFE 为 0，环绕声道为 1.41
+    std::vector<double> weights{};
+
+    size_t subBlockFrames = 0;
+    size_t subBlockPos    = 0;
+    double subBlockSum    = 0;
+    size_t subBlockCount  = 0;
+    // 最近 [cShortTermSubBlocks] 个子块的能量
+    std::array<double, cShortTermSubBlocks> recentSubBlocks{};
+
+    std::vector<double> blockEnergies{};
+    std::vector<double> shortTermEnergies{};
+
+    // 真峰值的多相插值滤波器：[phase][tap]，系数已倒序
+    int                oversample = 1;
+    std::vector<float> firCoeffs{};
+    // 每声道 2 * [cFirTaps] 个，同一个采样写两次，窗口总是连续的
+    std::vector<float> firHistory{};
+    size_t             firPos = 0;
+
+    double peak          = 0;
+    double truePeakValue = 0;
+
+    void finishSubBlock();
+
+    float interpolatePeak(const float* window) const;
+};
+
+/// # 响度扫描
+/// - 以源的采样率和声道数解码，不重采样也不混音，结果写入 [LoudnessMeter_c]
+class LoudnessScanner_c {
+public:
+
+    static LoudnessScanner_c instance;
+
+    LoudnessScanner_c() {}
+
+    ~LoudnessScanner_c() {}
+
+    /// 返回值同 [mediaxx_get_audio_visualization]；[decodeThreads] 见 [AudioDecoder_c::open]
+    int scan(
+        MediaInfoItem_c& item,
+        std::string_view headers,
+        int              decodeThreads,
+        LoudnessMeter_c& meter
+    );
+};
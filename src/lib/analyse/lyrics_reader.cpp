@@ -0,0 +1,605 @@
+#include "lyrics_reader.h"
+#include "util/charset.h"
+#include "util/log.h"
+#include "util/string_util.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+LyricsReader_c LyricsReader_c::instance;
+
+namespace {
+    constexpr size_t align8(size_t value) {
+        return (value + 7) & ~size_t(7);
+    }
+
+    /// 字符串偏移从字符串区开头换算为结果开头；0 表示不存在，保持不变
+    void rebase(MediaxxInfoString& str, uint32_t base) {
+        if (str.offset != 0) {
+            str.offset += base;
+        }
+    }
+
+    bool isDigit(char ch) {
+        return ch >= '0' && ch <= '9';
+    }
+
+    /// 只去掉 ASCII 空白，歌词中的全角空格保留
+    std::string_view trim(std::string_view str) {
+        constexpr std::string_view cSpaces = " \t\r\n";
+        const auto                 begin   = str.find_first_not_of(cSpaces);
+        if (begin == std::string_view::npos) {
+            return {};
+        }
+        return str.substr(begin, str.find_last_not_of(cSpaces) - begin + 1);
+    }
+
+    bool startsWithIgnoreCase(std::string_view str, std::string_view prefix) {
+        return str.size() >= prefix.size()
+            && std::equal(prefix.begin(), prefix.end(), str.begin(), [](char a, char b) {
+                   return std::tolower(static_cast<unsigned char>(a))
+                       == std::tolower(static_cast<unsigned char>(b));
+               });
+    }
+
+    bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+        return a.size() == b.size() && startsWithIgnoreCase(a, b);
+    }
+
+    /// ID3 USLT 为 `lyrics-{描述-}{语言}`，Vorbis/APE 为 `LYRICS`、`UNSYNCEDLYRICS`，MP4 `©lyr` 为 `lyrics`；
+    /// 注意不能按前缀匹配 `lyrics`，会匹配到 `LYRICIST`
+    bool isLyricsKey(std::string_view key) {
+        return equalsIgnoreCase(key, "lyrics") || startsWithIgnoreCase(key, "lyrics-")
+            || equalsIgnoreCase(key, "unsyncedlyrics") || equalsIgnoreCase(key, "unsynced lyrics");
+    }
+
+    /// 读取十进制整数，过长的部分忽略；没有数字时返回 false
+    bool readInt(std::string_view str, size_t& pos, int64_t& value) {
+        const auto begin = pos;
+        value            = 0;
+        for (; pos < str.size() && isDigit(str[pos]); ++pos) {
+            if (pos - begin < 9) {
+                value = value * 10 + (str[pos] - '0');
+            }
+        }
+        return pos > begin;
+    }
+
+    /// 小数部分换算为毫秒，只取前 3 位；没有数字时返回 -1
+    int64_t readFractionMs(std::string_view str, size_t& pos) {
+        int64_t ms     = 0;
+        size_t  digits = 0;
+        for (; pos < str.size() && isDigit(str[pos]); ++pos, ++digits) {
+            if (digits < 3) {
+                ms = ms * 10 + (str[pos] - '0');
+            }
+        }
+        for (auto i = digits; i < 3; ++i) {
+            ms *= 10;
+        }
+        return digits > 0 ? ms : -1;
+    }
+
+    /// 解析 `mm:ss`、`mm:ss.xx`、`mm:ss:xx`、`hh:mm:ss.xx`，不是时间戳时返回 -1
+    int64_t parseLrcTime(std::string_view tag) {
+        tag            = trim(tag);
+        size_t  pos    = 0;
+        int64_t first  = 0;
+        int64_t second = 0;
+        if (false == readInt(tag, pos, first) || pos >= tag.size() || tag[pos] != ':') {
+            return -1;
+        }
+        ++pos;
+        if (false == readInt(tag, pos, second)) {
+            return -1;
+        }
+
+        int64_t result = (first * 60 + second) * 1000;
+        if (pos < tag.size() && tag[pos] == ':') {
+            ++pos;
+            const auto start = pos;
+            int64_t    third = 0;
+            if (false == readInt(tag, pos, third)) {
+                return -1;
+            }
+            if (pos < tag.size() && tag[pos] == '.') {
+                // hh:mm:ss.xx
+                ++pos;
+                const auto ms = readFractionMs(tag, pos);
+                if (ms < 0) {
+                    return -1;
+                }
+                result = ((first * 60 + second) * 60 + third) * 1000 + ms;
+            } else {
+                // mm:ss:xx，部分软件用冒号分隔小数
+                pos = start;
+                result += readFractionMs(tag, pos);
+            }
+        } else if (pos < tag.size() && tag[pos] == '.') {
+            ++pos;
+            const auto ms = readFractionMs(tag, pos);
+            if (ms < 0) {
+                return -1;
+            }
+            result += ms;
+        }
+        return pos == tag.size() ? result : -1;
+    }
+
+    /// `[ti:]`、`[ar:]`、`[al:]`、`[by:]`、`[offset:]`，其他标签忽略
+    void parseIdTag(std::string_view tag, LyricsDocument& out) {
+        const auto colon = tag.find(':');
+        if (colon == std::string_view::npos) {
+            return;
+        }
+        const auto key   = trim(tag.substr(0, colon));
+        auto       value = trim(tag.substr(colon + 1));
+        if (equalsIgnoreCase(key, "offset")) {
+            if (value.starts_with('+')) {
+                value.remove_prefix(1);
+            }
+            int offset = 0;
+            if (std::from_chars(value.data(), value.data() + value.size(), offset).ec
+                == std::errc{}) {
+                out.offsetMs = offset;
+            }
+        } else if (equalsIgnoreCase(key, "ti")) {
+            out.title = out.addString(value);
+        } else if (equalsIgnoreCase(key, "ar")) {
+            out.artist = out.addString(value);
+        } else if (equalsIgnoreCase(key, "al")) {
+            out.album = out.addString(value);
+        } else if (equalsIgnoreCase(key, "by")) {
+            out.by = out.addString(value);
+        }
+    }
+
+    uint32_t readBe32(const char* data) {
+        const auto p = reinterpret_cast<const unsigned char*>(data);
+        return uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+    }
+
+    /// ID3v2 的同步安全整数，每字节只用低 7 位
+    uint32_t readSyncsafe(const char* data) {
+        const auto p = reinterpret_cast<const unsigned char*>(data);
+        return uint32_t(p[0] & 0x7F) << 21 | uint32_t(p[1] & 0x7F) << 14
+             | uint32_t(p[2] & 0x7F) << 7 | (p[3] & 0x7F);
+    }
+
+    /// 还原 ID3v2 的反同步：0xFF 0x00 -> 0xFF
+    void undoUnsync(std::string& data) {
+        size_t write = 0;
+        for (size_t read = 0; read < data.size(); ++read) {
+            data[write++] = data[read];
+            if (static_cast<unsigned char>(data[read]) == 0xFF && read + 1 < data.size()
+                && data[read + 1] == '\0') {
+                ++read;
+            }
+        }
+        data.resize(write);
+    }
+
+    /// 读取以 0 结尾的字符串（UTF-16 为两个字节的 0），返回不含结尾的原始字节
+    std::string_view readTerminated(std::string_view data, size_t& pos, bool wide) {
+        const auto begin = pos;
+        auto       end   = data.size();
+        if (wide) {
+            for (auto i = begin; i + 1 < data.size(); i += 2) {
+                if (data[i] == '\0' && data[i + 1] == '\0') {
+                    end = i;
+                    break;
+                }
+            }
+            pos = std::min(data.size(), end + 2);
+        } else {
+            end = std::min(data.find('\0', begin), data.size());
+            pos = std::min(data.size(), end + 1);
+        }
+        return data.substr(begin, end - begin);
+    }
+
+    /// 按 ID3 的文字编码转为 UTF-8 追加到 [out]
+    void appendId3Text(std::string& out, std::string_view raw, unsigned char encoding) {
+        switch (encoding) {
+        case 0:
+            stringxx::latin1AppendToUtf8(out, raw);
+            break;
+        case 1:
+            // 带 BOM 的 UTF-16，每个字符串各自带 BOM
+            if (raw.starts_with("\xFE\xFF")) {
+                stringxx::utf16AppendToUtf8(out, raw.substr(2), true);
+            } else if (raw.starts_with("\xFF\xFE")) {
+                stringxx::utf16AppendToUtf8(out, raw.substr(2), false);
+            } else {
+                stringxx::utf16AppendToUtf8(out, raw, false);
+            }
+            break;
+        case 2:
+            stringxx::utf16AppendToUtf8(out, raw, true);
+            break;
+        default:
+            out.append(raw);
+            break;
+        }
+    }
+} // namespace
+
+MediaxxInfoString LyricsDocument::addString(std::string_view str) {
+    if (str.empty()) {
+        return MediaxxInfoString{};
+    }
+    MediaxxInfoString result{uint32_t(pool.size()), uint32_t(str.size())};
+    pool.append(str);
+    pool.push_back('\0');
+    return result;
+}
+
+bool LyricsReader_c::parseLrc(std::string_view text, LyricsDocument& out) {
+    if (text.starts_with("\xEF\xBB\xBF")) {
+        text.remove_prefix(3);
+    }
+    std::vector<int64_t> times{};
+    while (false == text.empty()) {
+        const auto end  = text.find('\n');
+        auto       line = trim(text.substr(0, end));
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+
+        // `[00:12.00][01:30.50]歌词`：开头连续的时间戳共用后面的文字
+        times.clear();
+        while (line.starts_with('[')) {
+            const auto close = line.find(']');
+            if (close == std::string_view::npos) {
+                break;
+            }
+            const auto tag  = line.substr(1, close - 1);
+            const auto time = parseLrcTime(tag);
+            if (time >= 0) {
+                times.push_back(time);
+                line.remove_prefix(close + 1);
+                continue;
+            }
+            if (times.empty()) {
+                parseIdTag(tag, out);
+            }
+            break;
+        }
+        if (times.empty()) {
+            continue;
+        }
+        const auto lineText = out.addString(trim(line));
+        for (const auto time : times) {
+            out.lines.push_back(LyricsDocument::Line{time, lineText});
+        }
+    }
+    return false == out.lines.empty();
+}
+
+std::string LyricsReader_c::build(const LyricsDocument& doc) {
+    std::vector<MediaxxLyricsLine> lines{};
+    lines.reserve(doc.lines.size());
+    for (const auto& line : doc.lines) {
+        const auto time = std::clamp<int64_t>(line.timeMs - doc.offsetMs, 0, UINT32_MAX);
+        lines.push_back(MediaxxLyricsLine{uint32_t(time), line.text});
+    }
+    // 同一时间的多行（如翻译）保持原文顺序
+    std::stable_sort(lines.begin(), lines.end(), [](const auto& a, const auto& b) {
+        return a.timeMs < b.timeMs;
+    });
+
+    const auto lineOffset = uint32_t(align8(sizeof(MediaxxLyricsHeader)));
+    const auto poolOffset = uint32_t(lineOffset + lines.size() * sizeof(MediaxxLyricsLine));
+    const auto totalSize  = uint32_t(align8(poolOffset + doc.pool.size()));
+
+    MediaxxLyricsHeader header{};
+    header.magic      = MEDIAXX_LYRICS_MAGIC;
+    header.version    = MEDIAXX_LYRICS_VERSION;
+    header.headerSize = uint16_t(sizeof(MediaxxLyricsHeader));
+    header.totalSize  = totalSize;
+    header.source     = doc.source;
+    header.offsetMs   = doc.offsetMs;
+    header.lineSize   = uint32_t(sizeof(MediaxxLyricsLine));
+    header.lineOffset = lineOffset;
+    header.lineCount  = uint32_t(lines.size());
+    header.plainText  = doc.plainText;
+    header.title      = doc.title;
+    header.artist     = doc.artist;
+    header.album      = doc.album;
+    header.by         = doc.by;
+    for (auto str : {&header.plainText, &header.title, &header.artist, &header.album, &header.by}) {
+        rebase(*str, poolOffset);
+    }
+    for (auto& line : lines) {
+        rebase(line.text, poolOffset);
+    }
+
+    std::string result{};
+    result.reserve(totalSize);
+    result.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    result.resize(lineOffset, '\0');
+    result.append(
+        reinterpret_cast<const char*>(lines.data()),
+        lines.size() * sizeof(MediaxxLyricsLine)
+    );
+    result.append(doc.pool);
+    result.resize(totalSize, '\0');
+    return result;
+}
+
+bool LyricsReader_c::readEmbedded(
+    MediaInfoItem_c&  item,
+    LyricsDocument&   out,
+    std::string_view& outPlain
+) {
+    const auto fmtCtx  = item.fmtCtx;
+    auto       tryTags = [&](AVDictionary* metadata) {
+        AVDictionaryEntry* tag = nullptr;
+        while ((tag = av_dict_get(metadata, "", tag, AV_DICT_IGNORE_SUFFIX))) {
+            if (nullptr == tag->key || nullptr == tag->value || false == isLyricsKey(tag->key)) {
+                continue;
+            }
+            const auto value = std::string_view{tag->value};
+            out.clear();
+            if (parseLrc(value, out)) {
+                out.source = MEDIAXX_LYRICS_SOURCE_EMBEDDED;
+                return true;
+            }
+            if (outPlain.empty()) {
+                outPlain = trim(value);
+            }
+        }
+        return false;
+    };
+
+    // Ogg 等容器的标签在流上
+    auto found = tryTags(fmtCtx->metadata);
+    for (unsigned int i = 0; false == found && i < fmtCtx->nb_streams; ++i) {
+        found = tryTags(fmtCtx->streams[i]->metadata);
+    }
+    if (false == found) {
+        out.clear();
+    }
+    return found;
+}
+
+bool LyricsReader_c::parseSylt(
+    MediaInfoItem_c& item,
+    std::string_view body,
+    LyricsDocument&  out
+) {
+    // 编码(1) | 语言(3) | 时间单位(1) | 内容类型(1) | 描述 | {文字 | 时间(4)}...
+    if (body.size() < 6) {
+        return false;
+    }
+    const auto encoding   = static_cast<unsigned char>(body[0]);
+    const auto timeFormat = static_cast<unsigned char>(body[4]);
+    // 1 为 MPEG 帧序号，换算需要解码帧长，不支持
+    if (timeFormat != 2) {
+        item.setLog("SYLT 的时间单位不是毫秒，跳过: {}", int(timeFormat));
+        return false;
+    }
+    const bool wide = (encoding == 1 || encoding == 2);
+    size_t     pos  = 6;
+    readTerminated(body, pos, wide);
+
+    struct Entry {
+        uint32_t    timeMs;
+        std::string text;
+    };
+    std::vector<Entry> entries{};
+    bool               perSyllable = false;
+    while (pos < body.size()) {
+        const auto raw = readTerminated(body, pos, wide);
+        if (pos + 4 > body.size()) {
+            break;
+        }
+        Entry entry{readBe32(body.data() + pos), {}};
+        pos += 4;
+        appendId3Text(entry.text, raw, encoding);
+        perSyllable = perSyllable || entry.text.starts_with('\n') || entry.text.starts_with('\r');
+        entries.push_back(std::move(entry));
+    }
+
+    if (false == perSyllable) {
+        for (const auto& entry : entries) {
+            const auto text = out.addString(trim(entry.text));
+            out.lines.push_back(LyricsDocument::Line{entry.timeMs, text});
+        }
+        return false == out.lines.empty();
+    }
+
+    // 逐字的 SYLT 以换行开头标记新的一行：合并为整行，时间取行首的字
+    std::string lineText{};
+    int64_t     lineTime = -1;
+    const auto  flush    = [&] {
+        if (lineTime >= 0) {
+            out.lines.push_back(LyricsDocument::Line{lineTime, out.addString(trim(lineText))});
+        }
+        lineText.clear();
+    };
+    for (const auto& entry : entries) {
+        if (lineTime < 0 || entry.text.starts_with('\n') || entry.text.starts_with('\r')) {
+            flush();
+            lineTime = entry.timeMs;
+        }
+        lineText.append(entry.text);
+    }
+    flush();
+    return false == out.lines.empty();
+}
+
+bool LyricsReader_c::readSylt(MediaInfoItem_c& item, LyricsDocument& out) {
+    if (item.filepath.find("://") != std::string::npos) {
+        return false;
+    }
+    std::ifstream file{std::filesystem::path(item.filepath), std::ios::binary};
+    char          header[10];
+    if (false == file.is_open() || false == bool(file.read(header, sizeof(header)))
+        || 0 != memcmp(header, "ID3", 3)) {
+        return false;
+    }
+    // ID3v2.2 的帧 ID 只有 3 个字符，没有 SYLT
+    const auto major = static_cast<unsigned char>(header[3]);
+    if (major != 3 && major != 4) {
+        return false;
+    }
+    const auto flags   = static_cast<unsigned char>(header[5]);
+    const auto tagSize = size_t(readSyncsafe(header + 6));
+
+    // v2.3 的全局反同步也作用于帧头，只能整体读取还原后再遍历；其他情况跳过不需要的帧（如封面）
+    std::string whole{};
+    const bool  unsyncTag = (major == 3) && (flags & 0x80);
+    if (unsyncTag) {
+        if (tagSize > cMaxId3Size) {
+            item.setLog("ID3 标签过大，跳过 SYLT: {}", tagSize);
+            return false;
+        }
+        whole.resize(tagSize);
+        if (false == bool(file.read(whole.data(), std::streamsize(tagSize)))) {
+            return false;
+        }
+        undoUnsync(whole);
+    }
+    const auto limit  = unsyncTag ? whole.size() : tagSize;
+    const auto readAt = [&](size_t pos, size_t size, std::string& buffer) {
+        if (pos + size > limit) {
+            return false;
+        }
+        if (unsyncTag) {
+            buffer.assign(whole, pos, size);
+            return true;
+        }
+        buffer.resize(size);
+        file.seekg(std::streamoff(sizeof(header) + pos));
+        return bool(file.read(buffer.data(), std::streamsize(size)));
+    };
+
+    std::string frame{};
+    size_t      pos = 0;
+    if (flags & 0x40) {
+        // 扩展头：v2.3 的长度不含自身的 4 字节，v2.4 的包含
+        if (false == readAt(0, 4, frame)) {
+            return false;
+        }
+        pos = (major == 3) ? 4 + readBe32(frame.data()) : readSyncsafe(frame.data());
+    }
+
+    std::string body{};
+    while (pos + 10 <= limit) {
+        if (false == readAt(pos, 10, frame) || frame[0] == '\0') {
+            // 之后是填充
+            break;
+        }
+        const auto size        = size_t(major == 4 ? readSyncsafe(&frame[4]) : readBe32(&frame[4]));
+        const auto formatFlags = static_cast<unsigned char>(frame[9]);
+        const auto bodyPos     = pos + 10;
+        pos                    = bodyPos + size;
+        if (0 != frame.compare(0, 4, "SYLT")) {
+            continue;
+        }
+        if ((major == 3) ? (formatFlags & 0xC0) : (formatFlags & 0x0C)) {
+            item.setLog("SYLT 帧已压缩或加密，跳过");
+            continue;
+        }
+        if (false == readAt(bodyPos, size, body)) {
+            break;
+        }
+        if (major == 4) {
+            // 数据长度指示（同步安全整数，不受反同步影响）
+            if (formatFlags & 0x01) {
+                body.erase(0, std::min<size_t>(4, body.size()));
+            }
+            if (formatFlags & 0x02) {
+                undoUnsync(body);
+            }
+        }
+        if (parseSylt(item, body, out)) {
+            out.source = MEDIAXX_LYRICS_SOURCE_SYLT;
+            return true;
+        }
+        out.clear();
+    }
+    return false;
+}
+
+bool LyricsReader_c::readSidecar(MediaInfoItem_c& item, LyricsDocument& out) {
+    if (item.filepath.find("://") != std::string::npos) {
+        return false;
+    }
+    auto            path = std::filesystem::path(item.filepath);
+    std::error_code ec{};
+    for (const auto extension : {".lrc", ".LRC"}) {
+        path.replace_extension(extension);
+        const auto size = std::filesystem::file_size(path, ec);
+        if (ec) {
+            continue;
+        }
+        if (size > cMaxLrcSize) {
+            item.setLog("歌词文件过大，跳过: {}", size);
+            return false;
+        }
+        std::ifstream file{path, std::ios::binary};
+        std::string   raw(size, '\0');
+        if (false == file.is_open()
+            || false == bool(file.read(raw.data(), std::streamsize(size)))) {
+            item.setLog("无法读取歌词文件: {}", path.string());
+            return false;
+        }
+
+        std::string text{};
+        if (raw.starts_with("\xFF\xFE")) {
+            stringxx::utf16AppendToUtf8(text, std::string_view{raw}.substr(2), false);
+        } else if (raw.starts_with("\xFE\xFF")) {
+            stringxx::utf16AppendToUtf8(text, std::string_view{raw}.substr(2), true);
+        } else if (charsetxx::isUtf8(raw)) {
+            text = std::move(raw);
+        } else {
+            // 常见的 GBK、Big5 等编码的歌词文件
+            const auto charset = charsetxx::detect(raw);
+            charsetxx::decode(raw, charset, text);
+            LXX_DEBEG("lrc charset: {} -> {}", path.string(), int(charset));
+        }
+
+        out.clear();
+        if (parseLrc(text, out)) {
+            out.source = MEDIAXX_LYRICS_SOURCE_SIDECAR;
+            return true;
+        }
+        out.clear();
+        return false;
+    }
+    return false;
+}
+
+int LyricsReader_c::read(
+    MediaInfoItem_c&       item,
+    const std::string_view headers,
+    LyricsDocument&        out
+) {
+    // 只需要标签，不探测流
+    item.setFieldMask(MEDIAXX_FIELD_FORMAT_TAGS | MEDIAXX_FIELD_STREAM_TAGS);
+    const bool opened = MediaInfoReader_c::instance.openFile(item, headers);
+    if (item.isInterrupted()) {
+        return -2;
+    }
+
+    std::string_view plain{};
+    if (opened && readEmbedded(item, out, plain)) {
+        return 1;
+    }
+    if (opened && readSylt(item, out)) {
+        return 1;
+    }
+    if (readSidecar(item, out)) {
+        return 1;
+    }
+    if (false == plain.empty()) {
+        out.clear();
+        out.source    = MEDIAXX_LYRICS_SOURCE_EMBEDDED;
+        out.plainText = out.addString(plain);
+        return 1;
+    }
+    return opened ? 0 : -1;
+}
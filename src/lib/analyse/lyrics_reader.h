@@ -0,0 +1,75 @@
+#pragma once
+
+#include "analyse/media_info_reader.h"
+#include <cstdint>
+#include <mediaxx.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// # 解析后的歌词
+/// - 文字都在 [pool] 中，一行有多个时间戳时共用一份
+/// - 时间保持原文的值，[LyricsReader_c::build] 时才应用 [offsetMs] 并排序
+struct LyricsDocument {
+    struct Line {
+        int64_t           timeMs;
+        MediaxxInfoString text;
+    };
+
+    int               source   = MEDIAXX_LYRICS_SOURCE_NONE;
+    int               offsetMs = 0;
+    std::vector<Line> lines{};
+    MediaxxInfoString plainText{};
+    MediaxxInfoString title{};
+    MediaxxInfoString artist{};
+    MediaxxInfoString album{};
+    MediaxxInfoString by{};
+    // 以 '\0' 开头，使偏移 0 表示不存在
+    std::string       pool{'\0'};
+
+    /// 空串返回不存在
+    MediaxxInfoString addString(std::string_view str);
+
+    void clear() {
+        *this = LyricsDocument{};
+    }
+};
+
+/// # 歌词读取
+/// - 内嵌标签由 ffmpeg 读取；ffmpeg 不解析的 ID3 SYLT 帧直接从文件头读取
+/// - LRC 的时间戳、`[offset:]` 和一行多个时间戳都在这里解析，结果为按时间排序的二进制数组
+class LyricsReader_c {
+public:
+
+    // `.lrc` 文件的大小上限
+    inline static constexpr size_t cMaxLrcSize = 4 * 1024 * 1024;
+    // ID3v2 标签需要整体读取（全局反同步）时的大小上限
+    inline static constexpr size_t cMaxId3Size = 16 * 1024 * 1024;
+
+    static LyricsReader_c instance;
+
+    /// 返回值同 [mediaxx_get_lyrics_malloc]；[item] 由调用方释放，[out] 在释放前构建
+    int read(MediaInfoItem_c& item, const std::string_view headers, LyricsDocument& out);
+
+    /// 解析 LRC 文本，返回是否有带时间的行；不改变 [out.source]
+    static bool parseLrc(std::string_view text, LyricsDocument& out);
+
+    /// 布局见 [MediaxxLyricsHeader]
+    static std::string build(const LyricsDocument& doc);
+
+protected:
+
+    /// 标签值由 [item.fmtCtx] 持有，在其释放前有效
+    static bool readEmbedded(
+        MediaInfoItem_c&  item,
+        LyricsDocument&   out,
+        std::string_view& outPlain
+    );
+
+    static bool readSylt(MediaInfoItem_c& item, LyricsDocument& out);
+
+    /// 解析一个 SYLT 帧的内容（已还原反同步）
+    static bool parseSylt(MediaInfoItem_c& item, std::string_view body, LyricsDocument& out);
+
+    static bool readSidecar(MediaInfoItem_c& item, LyricsDocument& out);
+};
@@ -0,0 +1,971 @@
+#include "manifest_probe.h"
+#include "util/log.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <unordered_map>
+
+ManifestProbe_c ManifestProbe_c::instance;
+
+namespace {
+    bool startsWithIgnoreCase(std::string_view str, std::string_view prefix) {
+        return str.size() >= prefix.size()
+            && std::equal(prefix.begin(), prefix.end(), str.begin(), [](char a, char b) {
+                   return std::tolower(static_cast<unsigned char>(a))
+                       == std::tolower(static_cast<unsigned char>(b));
+               });
+    }
+
+    bool endsWithIgnoreCase(std::string_view str, std::string_view suffix) {
+        return str.size() >= suffix.size()
+            && startsWithIgnoreCase(str.substr(str.size() - suffix.size()), suffix);
+    }
+
+    std::string_view trim(std::string_view str) {
+        while (false == str.empty() && std::isspace(static_cast<unsigned char>(str.front()))) {
+            str.remove_prefix(1);
+        }
+        while (false == str.empty() && std::isspace(static_cast<unsigned char>(str.back()))) {
+            str.remove_suffix(1);
+        }
+        return str;
+    }
+
+    int64_t toInt64(std::string_view str) {
+        int64_t value = 0;
+        for (char c : str) {
+            if (c < '0' || c > '9') {
+                break;
+            }
+            value = value * 10 + (c - '0');
+        }
+        return value;
+    }
+
+    double toDouble(std::string_view str) {
+        // 不使用 strtod，避免受 locale 小数点影响
+        double value = 0;
+        double scale = 0;
+        for (char c : str) {
+            if (c == '.' && scale == 0) {
+                scale = 1;
+            } else if (c >= '0' && c <= '9') {
+                if (scale == 0) {
+                    value = value * 10 + (c - '0');
+                } else {
+                    scale *= 10;
+                    value += (c - '0') / scale;
+                }
+            } else {
+                break;
+            }
+        }
+        return value;
+    }
+
+    /// `30000/1001` 或 `29.97`
+    double toFrameRate(std::string_view str) {
+        const auto slash = str.find('/');
+        if (slash == std::string_view::npos) {
+            return toDouble(str);
+        }
+        const auto den = toDouble(str.substr(slash + 1));
+        return den > 0 ? toDouble(str.substr(0, slash)) / den : 0;
+    }
+
+    /// ISO 8601 时长，如 `PT1H2M3.5S`、`P1DT2H`；忽略年、月
+    double parseIsoDuration(std::string_view str) {
+        if (false == str.starts_with('P')) {
+            return 0;
+        }
+        str.remove_prefix(1);
+        double result = 0;
+        bool   inTime = false;
+        while (false == str.empty()) {
+            if (str.front() == 'T') {
+                inTime = true;
+                str.remove_prefix(1);
+                continue;
+            }
+            size_t len = 0;
+            while (len < str.size() && (std::isdigit(static_cast<unsigned char>(str[len])) || str[len] == '.')) {
+                ++len;
+            }
+            if (len == 0 || len >= str.size()) {
+                break;
+            }
+            const auto value = toDouble(str.substr(0, len));
+            switch (str[len]) {
+            case 'W':
+                result += value * 7 * 86400;
+                break;
+            case 'D':
+                result += value * 86400;
+                break;
+            case 'H':
+                result += value * 3600;
+                break;
+            case 'M':
+                if (inTime) {
+                    result += value * 60;
+                }
+                break;
+            case 'S':
+                result += value;
+                break;
+            default:
+                break;
+            }
+            str.remove_prefix(len + 1);
+        }
+        return result;
+    }
+
+    /// HLS 属性列表：`KEY=VALUE,KEY="VALUE,WITH,COMMA"`
+    std::unordered_map<std::string, std::string> parseHlsAttributes(std::string_view str) {
+        std::unordered_map<std::string, std::string> result{};
+        while (false == str.empty()) {
+            const auto eq = str.find('=');
+            if (eq == std::string_view::npos) {
+                break;
+            }
+            auto key = std::string{trim(str.substr(0, eq))};
+            str.remove_prefix(eq + 1);
+            std::string value{};
+            if (false == str.empty() && str.front() == '"') {
+                const auto close = str.find('"', 1);
+                value            = std::string{str.substr(1, close == std::string_view::npos ? str.size() - 1 : close - 1)};
+                str.remove_prefix(close == std::string_view::npos ? str.size() : close + 1);
+                const auto comma = str.find(',');
+                str.remove_prefix(comma == std::string_view::npos ? str.size() : comma + 1);
+            } else {
+                const auto comma = str.find(',');
+                value            = std::string{trim(str.substr(0, comma))};
+                str.remove_prefix(comma == std::string_view::npos ? str.size() : comma + 1);
+            }
+            result[std::move(key)] = std::move(value);
+        }
+        return result;
+    }
+
+    /// `n[@o]`；未指定偏移时接着上一个分段
+    void parseByteRange(std::string_view str, int64_t nextOffset, ManifestSegment& segment) {
+        const auto at  = str.find('@');
+        segment.length = toInt64(str.substr(0, at));
+        segment.offset = (at == std::string_view::npos) ? nextOffset : toInt64(str.substr(at + 1));
+    }
+
+    std::string xmlUnescape(std::string_view str) {
+        std::string result{};
+        result.reserve(str.size());
+        while (false == str.empty()) {
+            if (str.front() == '&') {
+                static constexpr std::pair<std::string_view, char> cEntities[] = {
+                    {"&amp;",  '&' },
+                    {"&lt;",   '<' },
+                    {"&gt;",   '>' },
+                    {"&quot;", '"' },
+                    {"&apos;", '\''},
+                };
+                bool matched = false;
+                for (const auto& [entity, c] : cEntities) {
+                    if (str.starts_with(entity)) {
+                        result.push_back(c);
+                        str.remove_prefix(entity.size());
+                        matched = true;
+                        break;
+                    }
+                }
+                if (matched) {
+                    continue;
+                }
+            }
+            result.push_back(str.front());
+            str.remove_prefix(1);
+        }
+        return result;
+    }
+
+    /// 简单的 XML 标签，只保留 DASH 需要的信息
+    struct XmlTag {
+        std::string_view                             name{};
+        std::unordered_map<std::string, std::string> attrs{};
+        bool                                         isClose     = false;
+        bool                                         isSelfClose = false;
+
+        std::string_view attr(const std::string& key) const {
+            auto it = attrs.find(key);
+            return it == attrs.end() ? std::string_view{} : std::string_view{it->second};
+        }
+    };
+
+    /// 读取 [pos] 处开始的下一个标签，跳过注释和声明；返回 false 表示结束
+    bool nextXmlTag(std::string_view text, size_t& pos, XmlTag& tag, std::string_view& textBefore) {
+        while (true) {
+            const auto start = text.find('<', pos);
+            if (start == std::string_view::npos) {
+                return false;
+            }
+            textBefore = text.substr(pos, start - pos);
+            if (text.substr(start).starts_with("<!--")) {
+                const auto end = text.find("-->", start);
+                pos            = (end == std::string_view::npos) ? text.size() : end + 3;
+                continue;
+            }
+            const auto end = text.find('>', start);
+            if (end == std::string_view::npos) {
+                return false;
+            }
+            pos       = end + 1;
+            auto body = text.substr(start + 1, end - start - 1);
+            if (body.starts_with('?') || body.starts_with('!')) {
+                continue;
+            }
+            tag             = XmlTag{};
+            tag.isClose     = body.starts_with('/');
+            tag.isSelfClose = body.ends_with('/');
+            if (tag.isClose) {
+                body.remove_prefix(1);
+            }
+            if (tag.isSelfClose) {
+                body.remove_suffix(1);
+            }
+            const auto nameEnd = body.find_first_of(" \t\r\n");
+            tag.name           = body.substr(0, nameEnd);
+            // 去掉命名空间前缀
+            if (const auto colon = tag.name.find(':'); colon != std::string_view::npos) {
+                tag.name.remove_prefix(colon + 1);
+            }
+            body.remove_prefix(nameEnd == std::string_view::npos ? body.size() : nameEnd);
+            while (true) {
+                const auto eq = body.find('=');
+                if (eq == std::string_view::npos) {
+                    break;
+                }
+                auto key   = trim(body.substr(0, eq));
+                body.remove_prefix(eq + 1);
+                body       = trim(body);
+                if (body.empty() || (body.front() != '"' && body.front() != '\'')) {
+                    break;
+                }
+                const auto quote = body.front();
+                const auto close = body.find(quote, 1);
+                if (close == std::string_view::npos) {
+                    break;
+                }
+                if (const auto colon = key.find(':'); colon != std::string_view::npos) {
+                    key.remove_prefix(colon + 1);
+                }
+                tag.attrs[std::string{key}] = xmlUnescape(body.substr(1, close - 1));
+                body.remove_prefix(close + 1);
+            }
+            return true;
+        }
+    }
+
+    struct DashTemplate {
+        std::string initialization{};
+        std::string media{};
+        int64_t     startNumber = 1;
+        int64_t     timescale   = 1;
+        int64_t     duration    = 0;
+        // SegmentTimeline
+        bool        hasTimeline = false;
+        int64_t     firstTime   = 0;
+        int64_t     timelineCount = 0;
+
+        void merge(const XmlTag& tag) {
+            if (auto v = tag.attr("initialization"); false == v.empty()) {
+                initialization = std::string{v};
+            }
+            if (auto v = tag.attr("media"); false == v.empty()) {
+                media = std::string{v};
+            }
+            if (auto v = tag.attr("startNumber"); false == v.empty()) {
+                startNumber = toInt64(v);
+            }
+            if (auto v = tag.attr("timescale"); false == v.empty()) {
+                timescale = std::max<int64_t>(1, toInt64(v));
+            }
+            if (auto v = tag.attr("duration"); false == v.empty()) {
+                duration = toInt64(v);
+            }
+        }
+    };
+
+    /// 替换 `$RepresentationID$`、`$Number%05d$` 等模板标识符
+    std::string fillDashTemplate(
+        std::string_view   tpl,
+        const std::string& repId,
+        int64_t            bandwidth,
+        int64_t            number,
+        int64_t            time
+    ) {
+        std::string result{};
+        while (false == tpl.empty()) {
+            const auto start = tpl.find('$');
+            if (start == std::string_view::npos) {
+                result.append(tpl);
+                break;
+            }
+            result.append(tpl.substr(0, start));
+            const auto end = tpl.find('$', start + 1);
+            if (end == std::string_view::npos) {
+                result.append(tpl.substr(start));
+                break;
+            }
+            auto ident = tpl.substr(start + 1, end - start - 1);
+            tpl.remove_prefix(end + 1);
+            if (ident.empty()) {
+                result.push_back('$');
+                continue;
+            }
+            int width = 0;
+            if (const auto percent = ident.find('%'); percent != std::string_view::npos) {
+                // 只支持 %0[width]d
+                width = int(toInt64(ident.substr(percent + 1).substr(ident[percent + 1] == '0' ? 1 : 0)));
+                ident = ident.substr(0, percent);
+            }
+            auto number2str = [width](int64_t value) {
+                auto str = std::to_string(value);
+                if (int(str.size()) < width) {
+                    str.insert(0, size_t(width) - str.size(), '0');
+                }
+                return str;
+            };
+            if (ident == "RepresentationID") {
+                result.append(repId);
+            } else if (ident == "Bandwidth") {
+                result.append(number2str(bandwidth));
+            } else if (ident == "Number") {
+                result.append(number2str(number));
+            } else if (ident == "Time") {
+                result.append(number2str(time));
+            }
+        }
+        return result;
+    }
+
+    /// 内存中的分段数据，供 AVIOContext 读取
+    struct MemorySource {
+        std::string data{};
+        int64_t     pos = 0;
+
+        static int avRead(void* opaque, uint8_t* buf, int size) {
+            auto self = static_cast<MemorySource*>(opaque);
+            if (self->pos >= int64_t(self->data.size())) {
+                return AVERROR_EOF;
+            }
+            const auto count = std::min<int64_t>(size, int64_t(self->data.size()) - self->pos);
+            memcpy(buf, self->data.data() + self->pos, size_t(count));
+            self->pos += count;
+            return int(count);
+        }
+
+        static int64_t avSeek(void* opaque, int64_t offset, int whence) {
+            auto       self = static_cast<MemorySource*>(opaque);
+            const auto size = int64_t(self->data.size());
+            switch (whence & ~AVSEEK_FORCE) {
+            case AVSEEK_SIZE:
+                return size;
+            case SEEK_SET:
+                break;
+            case SEEK_CUR:
+                offset += self->pos;
+                break;
+            case SEEK_END:
+                offset += size;
+                break;
+            default:
+                return AVERROR(EINVAL);
+            }
+            if (offset < 0) {
+                return AVERROR(EINVAL);
+            }
+            self->pos = offset;
+            return offset;
+        }
+    };
+} // namespace
+
+bool ManifestProbe_c::isManifestUrl(std::string_view url) {
+    // 本地的 `.m3u` 等是普通的播放列表文件，仍由 ffmpeg 打开
+    if (false == startsWithIgnoreCase(url, "http://")
+        && false == startsWithIgnoreCase(url, "https://")) {
+        return false;
+    }
+    const auto end  = url.find_first_of("?#");
+    const auto path = url.substr(0, end);
+    return endsWithIgnoreCase(path, ".m3u8") || endsWithIgnoreCase(path, ".m3u")
+        || endsWithIgnoreCase(path, ".mpd");
+}
+
+std::string ManifestProbe_c::resolveUrl(std::string_view base, std::string_view uri) {
+    uri = trim(uri);
+    if (uri.empty()) {
+        return std::string{base};
+    }
+    if (uri.find("://") != std::string_view::npos) {
+        return std::string{uri};
+    }
+    const auto schemeEnd = base.find("://");
+    if (uri.starts_with("//")) {
+        return std::string{base.substr(0, schemeEnd == std::string_view::npos ? 0 : schemeEnd + 1)}
+            .append(uri);
+    }
+    if (uri.starts_with('/')) {
+        // 协议 + 主机
+        const auto hostStart = (schemeEnd == std::string_view::npos) ? 0 : schemeEnd + 3;
+        const auto hostEnd   = base.find('/', hostStart);
+        return std::string{base.substr(0, hostEnd)}.append(uri);
+    }
+    // 相对当前目录，去掉查询参数和文件名
+    auto dir = base.substr(0, base.find_first_of("?#"));
+    dir      = dir.substr(0, dir.rfind('/') + 1);
+    return std::string{dir}.append(uri);
+}
+
+bool ManifestProbe_c::parseHls(
+    std::string_view text,
+    std::string_view baseUrl,
+    ManifestInfo&    info,
+    bool&            isMaster
+) {
+    if (text.starts_with("\xEF\xBB\xBF")) {
+        text.remove_prefix(3);
+    }
+    if (false == trim(text).starts_with("#EXTM3U")) {
+        return false;
+    }
+    info.type = "hls";
+    isMaster  = false;
+
+    bool            ended          = false;
+    bool            pendingVariant = false;
+    ManifestVariant variant{};
+    double          pendingDuration = -1;
+    ManifestSegment pendingRange{};
+    bool            hasPendingRange = false;
+    int64_t         nextOffset      = 0;
+
+    while (false == text.empty()) {
+        const auto eol  = text.find('\n');
+        const auto line = trim(text.substr(0, eol));
+        text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+        if (line.empty()) {
+            continue;
+        }
+        if (line.starts_with("#EXT-X-STREAM-INF:")) {
+            isMaster       = true;
+            pendingVariant = true;
+            variant        = ManifestVariant{};
+            auto attrs     = parseHlsAttributes(line.substr(18));
+            variant.bandwidth        = toInt64(attrs["BANDWIDTH"]);
+            variant.averageBandwidth = toInt64(attrs["AVERAGE-BANDWIDTH"]);
+            variant.codecs           = attrs["CODECS"];
+            variant.frameRate        = toDouble(attrs["FRAME-RATE"]);
+            const auto& resolution   = attrs["RESOLUTION"];
+            if (const auto x = resolution.find('x'); x != std::string::npos) {
+                variant.width  = int(toInt64(std::string_view{resolution}.substr(0, x)));
+                variant.height = int(toInt64(std::string_view{resolution}.substr(x + 1)));
+            }
+        } else if (line.starts_with("#EXT-X-MEDIA:")) {
+            auto          attrs = parseHlsAttributes(line.substr(13));
+            ManifestMedia media{};
+            media.type     = attrs["TYPE"];
+            media.groupId  = attrs["GROUP-ID"];
+            media.name     = attrs["NAME"];
+            media.language = attrs["LANGUAGE"];
+            if (false == attrs["URI"].empty()) {
+                media.uri = resolveUrl(baseUrl, attrs["URI"]);
+            }
+            info.media.push_back(std::move(media));
+        } else if (line.starts_with("#EXTINF:")) {
+            pendingDuration = toDouble(line.substr(8));
+        } else if (line.starts_with("#EXT-X-BYTERANGE:")) {
+            parseByteRange(line.substr(17), nextOffset, pendingRange);
+            hasPendingRange = true;
+        } else if (line.starts_with("#EXT-X-MAP:")) {
+            auto attrs = parseHlsAttributes(line.substr(11));
+            if (info.initSegment.uri.empty() && false == attrs["URI"].empty()) {
+                info.initSegment.uri = resolveUrl(baseUrl, attrs["URI"]);
+                if (false == attrs["BYTERANGE"].empty()) {
+                    parseByteRange(attrs["BYTERANGE"], 0, info.initSegment);
+                }
+            }
+        } else if (line.starts_with("#EXT-X-TARGETDURATION:")) {
+            info.targetDuration = toDouble(line.substr(22));
+        } else if (line.starts_with("#EXT-X-ENDLIST")) {
+            ended = true;
+        } else if (line.starts_with("#EXT-X-PLAYLIST-TYPE:")) {
+            ended = ended || (trim(line.substr(21)) == "VOD");
+        } else if (line.starts_with('#')) {
+            continue;
+        } else if (pendingVariant) {
+            // #EXT-X-STREAM-INF 的下一行是媒体播放列表地址
+            variant.uri    = resolveUrl(baseUrl, line);
+            pendingVariant = false;
+            info.variants.push_back(std::move(variant));
+        } else if (pendingDuration >= 0) {
+            info.duration += pendingDuration;
+            ++info.segmentCount;
+            if (info.firstSegment.uri.empty()) {
+                info.firstSegment.uri = resolveUrl(baseUrl, line);
+                if (hasPendingRange) {
+                    info.firstSegment.offset = pendingRange.offset;
+                    info.firstSegment.length = pendingRange.length;
+                }
+            }
+            if (hasPendingRange) {
+                nextOffset = pendingRange.offset + pendingRange.length;
+            }
+            pendingDuration = -1;
+            hasPendingRange = false;
+        }
+    }
+    info.isLive = (false == isMaster) && (false == ended);
+    return true;
+}
+
+bool ManifestProbe_c::parseDash(std::string_view text, std::string_view baseUrl, ManifestInfo& info) {
+    info.type = "dash";
+
+    enum class Level { Mpd, Period, Adaptation, Representation };
+
+    XmlTag           tag{};
+    std::string_view textBefore{};
+    size_t           pos        = 0;
+    bool             hasMpd     = false;
+    int              periodNum  = 0;
+    double           periodSum  = 0;
+    double           mpdDuration = 0;
+    Level            level      = Level::Mpd;
+    // 各层级的 BaseURL 和 SegmentTemplate，下层继承上层
+    std::string      baseUrls[4]{std::string{baseUrl}, {}, {}, {}};
+    DashTemplate     templates[4]{};
+    XmlTag           adaptation{};
+    XmlTag           representation{};
+    DashTemplate*    currentTemplate = nullptr;
+    bool             inBaseUrl       = false;
+    bool             hasSelected     = false;
+    bool             selectedIsVideo = false;
+
+    auto finishRepresentation = [&]() {
+        const auto& rep = representation;
+        ManifestVariant variant{};
+        variant.id        = std::string{rep.attr("id")};
+        variant.bandwidth = toInt64(rep.attr("bandwidth"));
+        auto inherit      = [&rep, &adaptation](const char* key) {
+            const auto value = rep.attr(key);
+            return std::string{value.empty() ? adaptation.attr(key) : value};
+        };
+        variant.codecs     = inherit("codecs");
+        variant.mimeType   = inherit("mimeType");
+        variant.width      = int(toInt64(inherit("width")));
+        variant.height     = int(toInt64(inherit("height")));
+        variant.frameRate  = toFrameRate(inherit("frameRate"));
+        variant.sampleRate = int(toInt64(inherit("audioSamplingRate")));
+        if (variant.mimeType.empty()) {
+            const auto contentType = adaptation.attr("contentType");
+            if (false == contentType.empty()) {
+                variant.mimeType = std::string{contentType}.append("/");
+            }
+        }
+        const auto& tpl = templates[int(Level::Representation)];
+        const auto& url = baseUrls[int(Level::Representation)];
+        variant.uri     = url;
+
+        // 优先选择视频，其次第一个
+        const bool isVideo = variant.mimeType.starts_with("video/") || variant.height > 0;
+        if (false == hasSelected || (isVideo && false == selectedIsVideo)) {
+            hasSelected     = true;
+            selectedIsVideo = isVideo;
+            info.initSegment  = ManifestSegment{};
+            info.firstSegment = ManifestSegment{};
+            if (false == tpl.media.empty()) {
+                const auto time = tpl.hasTimeline ? tpl.firstTime : 0;
+                if (false == tpl.initialization.empty()) {
+                    info.initSegment.uri = resolveUrl(
+                        url,
+                        fillDashTemplate(tpl.initialization, variant.id, variant.bandwidth, tpl.startNumber, time)
+                    );
+                }
+                info.firstSegment.uri = resolveUrl(
+                    url,
+                    fillDashTemplate(tpl.media, variant.id, variant.bandwidth, tpl.startNumber, time)
+                );
+                if (tpl.hasTimeline) {
+                    info.segmentCount = tpl.timelineCount;
+                } else if (tpl.duration > 0 && mpdDuration > 0) {
+                    info.segmentCount = int64_t(std::ceil(mpdDuration * tpl.timescale / tpl.duration));
+                }
+            } else {
+                // SegmentBase：整个表示是一个文件，只取开头
+                info.firstSegment.uri = url;
+            }
+        }
+        info.variants.push_back(std::move(variant));
+    };
+
+    while (nextXmlTag(text, pos, tag, textBefore)) {
+        if (inBaseUrl) {
+            if (tag.isClose && tag.name == "BaseURL") {
+                auto& target = baseUrls[int(level)];
+                target       = resolveUrl(target, xmlUnescape(trim(textBefore)));
+                inBaseUrl    = false;
+            }
+            continue;
+        }
+        if (tag.name == "MPD" && false == tag.isClose) {
+            hasMpd      = true;
+            info.isLive = (tag.attr("type") == "dynamic");
+            mpdDuration = parseIsoDuration(tag.attr("mediaPresentationDuration"));
+            if (auto v = tag.attr("maxSegmentDuration"); false == v.empty()) {
+                info.targetDuration = parseIsoDuration(v);
+            }
+        } else if (tag.name == "Period") {
+            if (tag.isClose) {
+                level = Level::Mpd;
+                continue;
+            }
+            ++periodNum;
+            periodSum += parseIsoDuration(tag.attr("duration"));
+            level                          = Level::Period;
+            baseUrls[int(Level::Period)]   = baseUrls[int(Level::Mpd)];
+            templates[int(Level::Period)]  = templates[int(Level::Mpd)];
+        } else if (periodNum > 1) {
+            // 只列出第一个 Period 的码率
+            continue;
+        } else if (tag.name == "AdaptationSet") {
+            if (tag.isClose) {
+                level = Level::Period;
+                continue;
+            }
+            level                             = Level::Adaptation;
+            adaptation                        = tag;
+            baseUrls[int(Level::Adaptation)]  = baseUrls[int(Level::Period)];
+            templates[int(Level::Adaptation)] = templates[int(Level::Period)];
+        } else if (tag.name == "Representation") {
+            if (tag.isClose) {
+                finishRepresentation();
+                level = Level::Adaptation;
+                continue;
+            }
+            level                                 = Level::Representation;
+            representation                        = tag;
+            baseUrls[int(Level::Representation)]  = baseUrls[int(Level::Adaptation)];
+            templates[int(Level::Representation)] = templates[int(Level::Adaptation)];
+            if (tag.isSelfClose) {
+                finishRepresentation();
+                level = Level::Adaptation;
+            }
+        } else if (tag.name == "BaseURL" && false == tag.isClose && false == tag.isSelfClose) {
+            inBaseUrl = true;
+        } else if (tag.name == "SegmentTemplate") {
+            if (tag.isClose) {
+                currentTemplate = nullptr;
+                continue;
+            }
+            auto& target = templates[int(level)];
+            target.merge(tag);
+            currentTemplate = tag.isSelfClose ? nullptr : &target;
+        } else if (tag.name == "SegmentTimeline" && false == tag.isClose && nullptr != currentTemplate) {
+            // 下层重新声明时间线时覆盖继承的
+            currentTemplate->hasTimeline   = true;
+            currentTemplate->timelineCount = 0;
+            currentTemplate->firstTime     = -1;
+        } else if (tag.name == "S" && nullptr != currentTemplate && currentTemplate->hasTimeline) {
+            if (currentTemplate->firstTime < 0) {
+                currentTemplate->firstTime = toInt64(tag.attr("t"));
+            }
+            // r = -1 表示重复到 Period 结束，这里按 1 个计算
+            const auto repeat               = tag.attr("r");
+            currentTemplate->timelineCount += 1 + (repeat.starts_with('-') ? 0 : toInt64(repeat));
+        }
+    }
+    if (false == hasMpd) {
+        return false;
+    }
+    info.duration = mpdDuration > 0 ? mpdDuration : periodSum;
+    return true;
+}
+
+bool ManifestProbe_c::fetch(
+    MediaInfoItem_c&   item,
+    const std::string& url,
+    int64_t            offset,
+    int64_t            length,
+    int64_t            maxSize,
+    std::string&       out
+) {
+    if (item.isInterrupted()) {
+        item.setError(MEDIAXX_DIAG_STAGE_MANIFEST, MEDIAXX_DIAG_ERR_CANCELLED, 0, url);
+        return false;
+    }
+    AVDictionary* opts = nullptr;
+    av_dict_copy(&opts, item.options, 0);
+    if (offset > 0) {
+        av_dict_set_int(&opts, "offset", offset, 0);
+    }
+    if (length > 0) {
+        // ffmpeg http 协议：请求 [offset, end_offset)
+        av_dict_set_int(&opts, "end_offset", offset + length, 0);
+        maxSize = std::min(maxSize, length);
+    }
+    const AVIOInterruptCB cb{&RequestInterrupt::avCallback, &item.interrupt};
+    AVIOContext*          io  = nullptr;
+    int                   ret = avio_open2(&io, url.c_str(), AVIO_FLAG_READ, &cb, &opts);
+    av_dict_free(&opts);
+    if (ret < 0) {
+        item.setError(MEDIAXX_DIAG_STAGE_MANIFEST, MEDIAXX_DIAG_ERR_OPEN, ret, url);
+        return false;
+    }
+    out.clear();
+    unsigned char buffer[16 * 1024];
+    while (int64_t(out.size()) < maxSize) {
+        const auto want = int(std::min<int64_t>(sizeof(buffer), maxSize - int64_t(out.size())));
+        const auto n    = avio_read(io, buffer, want);
+        if (n == AVERROR_EOF || n == 0) {
+            break;
+        }
+        if (n < 0) {
+            ret = n;
+            break;
+        }
+        out.append(reinterpret_cast<const char*>(buffer), size_t(n));
+    }
+    avio_closep(&io);
+    if (ret < 0) {
+        item.setError(MEDIAXX_DIAG_STAGE_MANIFEST, MEDIAXX_DIAG_ERR_READ, ret, url);
+        return false;
+    }
+    return true;
+}
+
+void ManifestProbe_c::appendSegmentStreams(
+    MediaInfoItem_c&                   item,
+    std::string_view                   headers,
+    const ManifestInfo&                info,
+    simdjson::builder::string_builder& out
+) {
+    MemorySource source{};
+    if (false == info.initSegment.uri.empty()) {
+        const auto& init = info.initSegment;
+        if (false == fetch(item, init.uri, init.offset, init.length, cMaxSegmentSize, source.data)) {
+            out.start_array();
+            out.end_array();
+            return;
+        }
+    }
+    std::string segment{};
+    const auto& first = info.firstSegment;
+    if (first.uri.empty()
+        || false == fetch(item, first.uri, first.offset, first.length, cMaxSegmentSize, segment)) {
+        out.start_array();
+        out.end_array();
+        return;
+    }
+    // fMP4：初始化分段 + 媒体分段拼接后就是一个可解析的文件
+    source.data.append(segment);
+    LXX_DEBEG("ManifestProbe_c segment probe: {} bytes | {}", source.data.size(), first.uri);
+
+    auto buffer = static_cast<unsigned char*>(av_malloc(32 * 1024));
+    auto io     = avio_alloc_context(
+        buffer,
+        32 * 1024,
+        0,
+        &source,
+        &MemorySource::avRead,
+        nullptr,
+        &MemorySource::avSeek
+    );
+    auto segItem      = MediaInfoItem_c{first.uri, nullptr};
+    segItem.interrupt = item.interrupt;
+    segItem.customIo  = io;
+    segItem.textLog   = item.textLog;
+    if (nullptr != io && MediaInfoReader_c::instance.openFile(segItem, headers)) {
+        MediaInfoReader_c::instance.appendStreams(
+            out,
+            segItem.fmtCtx,
+            item.fieldMask,
+            item.maxTagSize
+        );
+    } else {
+        out.start_array();
+        out.end_array();
+    }
+    segItem.dispose();
+    if (nullptr != io) {
+        av_freep(&io->buffer);
+        avio_context_free(&io);
+    } else {
+        av_free(buffer);
+    }
+    if (false == segItem.logView().empty()) {
+        item.setLog(segItem.logView());
+    }
+}
+
+bool ManifestProbe_c::load(MediaInfoItem_c& item, std::string_view headers, ManifestInfo& info) {
+    if (item.isInterrupted()) {
+        item.setError(MEDIAXX_DIAG_STAGE_MANIFEST, MEDIAXX_DIAG_ERR_CANCELLED);
+        return false;
+    }
+    item.setOptions(headers);
+
+    std::string text{};
+    if (false == fetch(item, item.filepath, 0, -1, cMaxManifestSize, text)) {
+        return false;
+    }
+    bool isMaster = false;
+    if (parseHls(text, item.filepath, info, isMaster)) {
+        if (isMaster && false == info.variants.empty()) {
+            // 主播放列表没有分段，读取第一个码率的媒体播放列表
+            ManifestInfo media{};
+            bool         mediaIsMaster = false;
+            const auto&  uri           = info.variants.front().uri;
+            if (fetch(item, uri, 0, -1, cMaxManifestSize, text)
+                && parseHls(text, uri, media, mediaIsMaster) && false == mediaIsMaster) {
+                info.isLive         = media.isLive;
+                info.duration       = media.duration;
+                info.targetDuration = media.targetDuration;
+                info.segmentCount   = media.segmentCount;
+                info.initSegment    = media.initSegment;
+                info.firstSegment   = media.firstSegment;
+            }
+        }
+    } else if (false == parseDash(text, item.filepath, info)) {
+        item.setError(MEDIAXX_DIAG_STAGE_MANIFEST, MEDIAXX_DIAG_ERR_UNKNOWN_MANIFEST);
+        return false;
+    }
+    return true;
+}
+
+bool ManifestProbe_c::probe(
+    MediaInfoItem_c&                   item,
+    std::string_view                   headers,
+    bool                               streamDetails,
+    simdjson::builder::string_builder& out
+) {
+    ManifestInfo info{};
+    if (false == load(item, headers, info)) {
+        return false;
+    }
+    const auto bitRate = info.bitRate();
+
+    out.start_object();
+    out.escape_and_append_with_quotes("format");
+    out.append_colon();
+    {
+        out.start_object();
+        if (item.hasField(MEDIAXX_FIELD_FORMAT)) {
+            out.append_key_value<"format_name">(std::string_view{info.type});
+            out.append_comma();
+            out.append_key_value<"duration">(info.duration);
+            out.append_comma();
+            out.append_key_value<"bit_rate">(bitRate);
+            out.append_comma();
+        }
+        if (item.hasField(MEDIAXX_FIELD_FORMAT_TAGS)) {
+            // 播放列表没有标签
+            out.escape_and_append_with_quotes("tags");
+            out.append_colon();
+            out.start_object();
+            out.end_object();
+            out.append_comma();
+        }
+        // 总是输出，放在最后以免多余的逗号
+        out.append_key_value<"filename">(item.filepath);
+        out.end_object();
+    }
+
+    if (item.hasField(MEDIAXX_FIELD_STREAMS)) {
+        out.append_comma();
+        out.escape_and_append_with_quotes("streams");
+        out.append_colon();
+        if (streamDetails) {
+            appendSegmentStreams(item, headers, info, out);
+        } else {
+            out.start_array();
+            out.end_array();
+        }
+    }
+
+    // 码率、分段等属于格式信息，与 [MEDIAXX_FIELD_FORMAT] 一起输出
+    if (item.hasField(MEDIAXX_FIELD_FORMAT)) {
+        out.append_comma();
+        out.escape_and_append_with_quotes("manifest");
+        out.append_colon();
+        out.start_object();
+        out.append_key_value<"type">(std::string_view{info.type});
+        out.append_comma();
+        out.append_key_value<"is_live">(info.isLive);
+        out.append_comma();
+        out.append_key_value<"duration">(info.duration);
+        out.append_comma();
+        out.append_key_value<"target_duration">(info.targetDuration);
+        out.append_comma();
+        out.append_key_value<"segment_count">(info.segmentCount);
+        out.append_comma();
+
+        out.escape_and_append_with_quotes("variants");
+        out.append_colon();
+        out.start_array();
+        for (size_t i = 0; i < info.variants.size(); ++i) {
+            const auto& variant = info.variants[i];
+            if (i > 0) {
+                out.append_comma();
+            }
+            out.start_object();
+            out.append_key_value<"uri">(std::string_view{variant.uri});
+            out.append_comma();
+            out.append_key_value<"id">(std::string_view{variant.id});
+            out.append_comma();
+            out.append_key_value<"bandwidth">(variant.bandwidth);
+            out.append_comma();
+            out.append_key_value<"average_bandwidth">(variant.averageBandwidth);
+            out.append_comma();
+            out.append_key_value<"codecs">(std::string_view{variant.codecs});
+            out.append_comma();
+            out.append_key_value<"mime_type">(std::string_view{variant.mimeType});
+            out.append_comma();
+            out.append_key_value<"width">(variant.width);
+            out.append_comma();
+            out.append_key_value<"height">(variant.height);
+            out.append_comma();
+            out.append_key_value<"frame_rate">(variant.frameRate);
+            out.append_comma();
+            out.append_key_value<"sample_rate">(variant.sampleRate);
+            out.end_object();
+        }
+        out.end_array();
+        out.append_comma();
+
+        out.escape_and_append_with_quotes("media");
+        out.append_colon();
+        out.start_array();
+        for (size_t i = 0; i < info.media.size(); ++i) {
+            const auto& media = info.media[i];
+            if (i > 0) {
+                out.append_comma();
+            }
+            out.start_object();
+            out.append_key_value<"type">(std::string_view{media.type});
+            out.append_comma();
+            out.append_key_value<"group_id">(std::string_view{media.groupId});
+            out.append_comma();
+            out.append_key_value<"name">(std::string_view{media.name});
+            out.append_comma();
+            out.append_key_value<"language">(std::string_view{media.language});
+            out.append_comma();
+            out.append_key_value<"uri">(std::string_view{media.uri});
+            out.end_object();
+        }
+        out.end_array();
+        out.end_object();
+    }
+    out.end_object();
+    return true;
+}
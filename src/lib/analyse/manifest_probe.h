@@ -0,0 +1,118 @@
+#pragma once
+
+#include "analyse/media_info_reader.h"
+#include "simdjson.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// 播放列表中的一个码率/清晰度
+struct ManifestVariant {
+    std::string uri{};
+    std::string id{};
+    std::string codecs{};
+    std::string mimeType{};
+    int64_t     bandwidth        = 0;
+    int64_t     averageBandwidth = 0;
+    int         width            = 0;
+    int         height           = 0;
+    double      frameRate        = 0;
+    int         sampleRate       = 0;
+};
+
+/// HLS `#EXT-X-MEDIA` 声明的独立音轨/字幕
+struct ManifestMedia {
+    std::string type{};
+    std::string groupId{};
+    std::string name{};
+    std::string language{};
+    std::string uri{};
+};
+
+/// 需要下载的分段；[length] < 0 表示整个文件
+struct ManifestSegment {
+    std::string uri{};
+    int64_t     offset = 0;
+    int64_t     length = -1;
+};
+
+struct ManifestInfo {
+    // "hls" 或 "dash"
+    std::string                  type{};
+    bool                         isLive         = false;
+    // 秒，所有分段时长之和；直播时为当前窗口的时长
+    double                       duration       = 0;
+    double                       targetDuration = 0;
+    int64_t                      segmentCount   = 0;
+    std::vector<ManifestVariant> variants{};
+    std::vector<ManifestMedia>   media{};
+    ManifestSegment              initSegment{};
+    ManifestSegment              firstSegment{};
+
+    /// 第一个码率的带宽，作为整体码率
+    int64_t bitRate() const {
+        return variants.empty() ? 0 : variants.front().bandwidth;
+    }
+};
+
+/// # HLS/DASH 播放列表探测
+/// - 直接解析播放列表获取时长、码率、编码等信息，不交给 ffmpeg 下载分段
+/// - 只有在需要编码详情时，才下载初始化分段和第一个媒体分段，在内存中探测
+/// - HLS 主播放列表只会额外下载第一个码率的媒体播放列表，用于累加分段时长
+class ManifestProbe_c {
+public:
+
+    // 播放列表的最大长度
+    inline static constexpr int64_t cMaxManifestSize = 4 * 1024 * 1024;
+    // 探测编码详情时，单个分段最多下载的长度；截断的分段仍足够识别编码
+    inline static constexpr int64_t cMaxSegmentSize  = 1024 * 1024;
+
+    static ManifestProbe_c instance;
+
+    /// 只有 `http://`、`https://` 地址，根据扩展名判断，忽略查询参数
+    static bool isManifestUrl(std::string_view url);
+
+    /// 下载并解析播放列表
+    bool load(MediaInfoItem_c& item, std::string_view headers, ManifestInfo& info);
+
+    /// 输出与 [MediaInfoReader_c::toInfoMap] 相同结构的 json，并附加 `manifest` 字段
+    /// - 按 [MediaInfoItem_c.fieldMask] 输出；`manifest` 随 [MEDIAXX_FIELD_FORMAT] 输出，
+    ///   [streamDetails] 只在请求了 [MEDIAXX_FIELD_STREAMS] 时有效；播放列表没有标签
+    bool probe(
+        MediaInfoItem_c&                   item,
+        std::string_view                   headers,
+        bool                               streamDetails,
+        simdjson::builder::string_builder& out
+    );
+
+    static bool parseHls(
+        std::string_view text,
+        std::string_view baseUrl,
+        ManifestInfo&    info,
+        bool&            isMaster
+    );
+
+    static bool parseDash(std::string_view text, std::string_view baseUrl, ManifestInfo& info);
+
+    static std::string resolveUrl(std::string_view base, std::string_view uri);
+
+protected:
+
+    /// 下载 [url] 的 [offset, offset + length)，最多 [maxSize] 字节
+    bool fetch(
+        MediaInfoItem_c&   item,
+        const std::string& url,
+        int64_t            offset,
+        int64_t            length,
+        int64_t            maxSize,
+        std::string&       out
+    );
+
+    /// 下载初始化分段和第一个媒体分段并探测，输出 `streams` 数组
+    void appendSegmentStreams(
+        MediaInfoItem_c&                   item,
+        std::string_view                   headers,
+        const ManifestInfo&                info,
+        simdjson::builder::string_builder& out
+    );
+};
@@ -0,0 +1,475 @@
+#include "media_info_binary.h"
+#include "analyse/tag_normalizer.h"
+#include "util/charset.h"
+#include "util/log.h"
+#include "util/string_util.h"
+#include <cstring>
+
+extern "C" {
+#include "libavcodec/avcodec.h"
+#include "libavutil/channel_layout.h"
+#include "libavutil/pixdesc.h"
+}
+
+namespace {
+    constexpr size_t align8(size_t value) {
+        return (value + 7) & ~size_t(7);
+    }
+
+    MediaxxInfoRational toRational(AVRational value) {
+        return MediaxxInfoRational{value.num, value.den};
+    }
+
+    /// 字符串偏移从字符串区开头换算为结果开头；0 表示不存在，保持不变
+    void rebase(MediaxxInfoString& str, uint32_t base) {
+        if (str.offset != 0) {
+            str.offset += base;
+        }
+    }
+
+    template <typename T>
+    void appendRecords(std::string& out, const std::vector<T>& records) {
+        out.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T));
+    }
+
+    /// 从 [data] 的 [offset] 处复制一个记录，越界时返回 false；结果不一定 8 字节对齐，不直接转换指针
+    template <typename T>
+    bool readRecord(std::string_view data, size_t offset, T& out) {
+        if (offset > data.size() || data.size() - offset < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&out, data.data() + offset, sizeof(T));
+        return true;
+    }
+
+    /// [MediaInfoBinaryWriter_c] 结果中的字符串，越界时返回空串
+    std::string_view readString(std::string_view data, MediaxxInfoString str) {
+        if (0 == str.offset || str.offset > data.size() || data.size() - str.offset < str.length) {
+            return {};
+        }
+        return data.substr(str.offset, str.length);
+    }
+} // namespace
+
+MediaxxInfoString MediaInfoBinaryWriter_c::addString(const char* str) {
+    if (nullptr == str) {
+        return MediaxxInfoString{};
+    }
+    return addString(std::string_view{str});
+}
+
+MediaxxInfoString MediaInfoBinaryWriter_c::addString(std::string_view str) {
+    MediaxxInfoString result{uint32_t(pool.size()), uint32_t(str.size())};
+    pool.append(str);
+    pool.push_back('\0');
+    return result;
+}
+
+MediaxxInfoString MediaInfoBinaryWriter_c::addInternedString(std::string_view str) {
+    const auto [it, inserted] = interned.try_emplace(str);
+    if (inserted) {
+        it->second = addString(str);
+    }
+    return it->second;
+}
+
+uint32_t MediaInfoBinaryWriter_c::addTags(AVDictionary* metadata) {
+    const auto         start = uint32_t(tags.size());
+    AVDictionaryEntry* tag   = nullptr;
+    while ((tag = av_dict_get(metadata, "", tag, AV_DICT_IGNORE_SUFFIX))) {
+        if (nullptr == tag->key || nullptr == tag->value) {
+            continue;
+        }
+        // 与 json 一致，跳过乱码
+        auto key   = std::string_view{tag->key};
+        auto value = std::string_view{tag->value};
+        if (false == charsetxx::isCleanText(key) || false == charsetxx::isCleanText(value)) {
+            LXX_WARN("tags pair contain '�': '{}': '{}'", key, value);
+            continue;
+        }
+        if (value.size() > maxTagSize) {
+            const auto index = uint32_t(tags.size());
+            truncatedTags.push_back(MediaxxInfoTruncatedTag{index, uint32_t(value.size())});
+            value = stringxx::utf8Truncate(value, maxTagSize);
+        }
+        tags.push_back(MediaxxInfoTag{addInternedString(key), addInternedString(value)});
+    }
+    return uint32_t(tags.size()) - start;
+}
+
+void MediaInfoBinaryWriter_c::addStream(
+    unsigned int index,
+    AVStream*    stream,
+    unsigned int fieldMask
+) {
+    const auto codecPar = stream->codecpar;
+
+    MediaxxInfoStream record{};
+    record.index         = int(index);
+    record.codecId       = int(codecPar->codec_id);
+    record.codecType     = int(codecPar->codec_type);
+    record.codecTag      = codecPar->codec_tag;
+    record.bitRate       = codecPar->bit_rate;
+    record.startTime     = stream->start_time;
+    record.bitsPerSample = codecPar->bits_per_raw_sample;
+    record.rFrameRate    = toRational(stream->r_frame_rate);
+    record.avgFrameRate  = toRational(stream->avg_frame_rate);
+    record.timeBase      = toRational(stream->time_base);
+    if (stream->time_base.den && stream->time_base.num) {
+        record.duration = stream->duration * av_q2d(stream->time_base);
+    }
+    record.codecName = addString(avcodec_get_name(codecPar->codec_id));
+    if (auto avdesc = avcodec_descriptor_get(codecPar->codec_id); nullptr != avdesc) {
+        record.codecLongName = addString(avdesc->long_name);
+    }
+    record.codecTypeName = addString(av_get_media_type_string(codecPar->codec_type));
+
+    // 标签下标在 [finish] 中换算为偏移
+    record.tagOffset = uint32_t(tags.size());
+    if (fieldMask & MEDIAXX_FIELD_STREAM_TAGS) {
+        record.tagCount = addTags(stream->metadata);
+    }
+
+    const bool withVideo = (fieldMask & MEDIAXX_FIELD_VIDEO) != 0;
+    const bool withAudio = (fieldMask & MEDIAXX_FIELD_AUDIO) != 0;
+    switch (codecPar->codec_type) {
+    case AVMEDIA_TYPE_VIDEO:
+        if (withVideo) {
+            record.width             = codecPar->width;
+            record.height            = codecPar->height;
+            record.framerate         = toRational(codecPar->framerate);
+            record.sampleAspectRatio = toRational(stream->sample_aspect_ratio);
+            if (stream->avg_frame_rate.den && stream->avg_frame_rate.num) {
+                record.fps = av_q2d(stream->avg_frame_rate);
+            }
+            record.level          = codecPar->level;
+            record.colorRange     = addString(av_color_range_name(codecPar->color_range));
+            record.colorSpace     = addString(av_color_space_name(codecPar->color_space));
+            record.chromaLocation = addString(av_chroma_location_name(codecPar->chroma_location));
+            record.pixFmt         = addString(av_get_pix_fmt_name((AVPixelFormat)codecPar->format));
+        }
+        break;
+    case AVMEDIA_TYPE_AUDIO:
+        if (withAudio) {
+            record.sampleRate      = codecPar->sample_rate;
+            record.channels        = codecPar->ch_layout.nb_channels;
+            record.initialPadding  = codecPar->initial_padding;
+            record.trailingPadding = codecPar->trailing_padding;
+            // 布局名称很短，用栈上缓冲区
+            char layout[128];
+            if (av_channel_layout_describe(&codecPar->ch_layout, layout, sizeof(layout)) > 0) {
+                record.channelLayout = addString(layout);
+            }
+            record.sampleFmt = addString(av_get_sample_fmt_name((AVSampleFormat)codecPar->format));
+        }
+        break;
+    default:
+        break;
+    }
+    streams.push_back(record);
+}
+
+void MediaInfoBinaryWriter_c::addNormalizedTags(AVFormatContext* fmtCtx) {
+    std::vector<NormalizedTag> normalized{};
+    TagNormalizer_c::normalize(fmtCtx, normalized);
+    normTags.reserve(normalized.size());
+    for (const auto& tag : normalized) {
+        // 规范化的值大多与原始标签相同，共用同一个字符串；截断方式也相同
+        const auto value = stringxx::utf8Truncate(tag.value, maxTagSize);
+        normTags.push_back(MediaxxInfoNormTag{tag.key, addInternedString(value)});
+    }
+}
+
+std::string MediaInfoBinaryWriter_c::finish() {
+    const auto streamOffset  = uint32_t(align8(sizeof(MediaxxInfoHeader)));
+    const auto tagOffset     = uint32_t(streamOffset + streams.size() * sizeof(MediaxxInfoStream));
+    const auto normTagOffset = uint32_t(tagOffset + tags.size() * sizeof(MediaxxInfoTag));
+    const auto normTagsSize  = normTags.size() * sizeof(MediaxxInfoNormTag);
+    const auto truncOffset   = uint32_t(normTagOffset + normTagsSize);
+    const auto truncSize     = truncatedTags.size() * sizeof(MediaxxInfoTruncatedTag);
+    const auto poolOffset    = uint32_t(truncOffset + truncSize);
+    const auto totalSize     = uint32_t(align8(poolOffset + pool.size()));
+
+    header.magic              = MEDIAXX_INFO_MAGIC;
+    header.version            = MEDIAXX_INFO_VERSION;
+    header.headerSize         = uint16_t(sizeof(MediaxxInfoHeader));
+    header.totalSize          = totalSize;
+    header.streamSize         = uint32_t(sizeof(MediaxxInfoStream));
+    header.streamOffset       = streamOffset;
+    header.streamCount        = uint32_t(streams.size());
+    header.tagOffset          = tagOffset + header.tagOffset * uint32_t(sizeof(MediaxxInfoTag));
+    header.normTagOffset      = normTagOffset;
+    header.normTagCount       = uint32_t(normTags.size());
+    header.truncatedTagOffset = truncOffset;
+    header.truncatedTagCount  = uint32_t(truncatedTags.size());
+    rebase(header.filename, poolOffset);
+    rebase(header.formatName, poolOffset);
+    for (auto& stream : streams) {
+        stream.tagOffset = tagOffset + stream.tagOffset * uint32_t(sizeof(MediaxxInfoTag));
+        for (auto str : {
+                 &stream.codecName,
+                 &stream.codecLongName,
+                 &stream.codecTypeName,
+                 &stream.colorRange,
+                 &stream.colorSpace,
+                 &stream.chromaLocation,
+                 &stream.pixFmt,
+                 &stream.channelLayout,
+                 &stream.sampleFmt,
+             }) {
+            rebase(*str, poolOffset);
+        }
+    }
+    for (auto& tag : tags) {
+        rebase(tag.key, poolOffset);
+        rebase(tag.value, poolOffset);
+    }
+    for (auto& tag : normTags) {
+        rebase(tag.value, poolOffset);
+    }
+
+    std::string result{};
+    result.reserve(totalSize);
+    result.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    result.resize(streamOffset, '\0');
+    appendRecords(result, streams);
+    appendRecords(result, tags);
+    appendRecords(result, normTags);
+    appendRecords(result, truncatedTags);
+    result.append(pool);
+    result.resize(totalSize, '\0');
+    return result;
+}
+
+std::string MediaInfoBinaryWriter_c::build(
+    std::string_view filepath,
+    AVFormatContext* fmtCtx,
+    unsigned int     fieldMask,
+    size_t           maxTagSize
+) {
+    MediaInfoBinaryWriter_c writer{};
+    writer.maxTagSize = maxTagSize;
+
+    auto& header    = writer.header;
+    header.filename = writer.addString(filepath);
+    header.size     = -1;
+    if (fieldMask & MEDIAXX_FIELD_FORMAT) {
+        header.formatName     = writer.addString(fmtCtx->iformat->name);
+        header.nbPrograms     = fmtCtx->nb_programs;
+        header.nbStreamGroups = fmtCtx->nb_stream_groups;
+        header.startTime      = fmtCtx->start_time;
+        header.bitRate        = fmtCtx->bit_rate;
+        header.probeScore     = fmtCtx->probe_score;
+        if (nullptr != fmtCtx->pb) {
+            header.size = avio_size(fmtCtx->pb);
+        }
+        if (fmtCtx->duration != AV_NOPTS_VALUE) {
+            header.duration = double(fmtCtx->duration) / AV_TIME_BASE;
+        }
+    }
+
+    if (fieldMask & MEDIAXX_FIELD_FORMAT_TAGS) {
+        // 格式级别的标签总是在最前面，[header.tagOffset] 保持为下标 0
+        header.tagCount = writer.addTags(fmtCtx->metadata);
+    }
+
+    if (fieldMask & MEDIAXX_FIELD_NORM_TAGS) {
+        writer.addNormalizedTags(fmtCtx);
+    }
+
+    if (fieldMask & MEDIAXX_FIELD_STREAMS) {
+        writer.streams.reserve(fmtCtx->nb_streams);
+        for (unsigned int i = 0; i < fmtCtx->nb_streams; ++i) {
+            writer.addStream(i, fmtCtx->streams[i], fieldMask);
+        }
+    }
+    return writer.finish();
+}
+
+std::string MediaInfoBinaryWriter_c::buildFormatOnly(
+    std::string_view filepath,
+    std::string_view formatName,
+    double           duration,
+    int64_t          bitRate,
+    unsigned int     fieldMask
+) {
+    MediaInfoBinaryWriter_c writer{};
+    writer.header.filename = writer.addString(filepath);
+    writer.header.size     = -1;
+    if (fieldMask & MEDIAXX_FIELD_FORMAT) {
+        writer.header.formatName = writer.addString(formatName);
+        writer.header.duration   = duration;
+        writer.header.bitRate    = bitRate;
+    }
+    return writer.finish();
+}
+
+MediaxxInfoString MediaInfoBinaryBatch_c::addString(std::string_view str) {
+    MediaxxInfoString result{uint32_t(pool.size()), uint32_t(str.size())};
+    pool.append(str);
+    pool.push_back('\0');
+    return result;
+}
+
+void MediaInfoBinaryBatch_c::add(
+    size_t           index,
+    int              ret,
+    std::string_view path,
+    std::string_view info,
+    std::string_view log
+) {
+    MediaxxInfoBatchEntry entry{};
+    entry.index = uint32_t(index);
+    entry.ret   = ret;
+    entry.path  = addString(path);
+    if (false == log.empty()) {
+        entry.log = addString(log);
+    }
+    if (false == info.empty()) {
+        // 先记录在 [infos] 中的偏移；[build] 的结果长度已经 8 字节对齐
+        entry.infoOffset = uint32_t(infos.size());
+        entry.infoSize   = uint32_t(info.size());
+        infos.append(info);
+    }
+    entries.push_back(entry);
+}
+
+std::string MediaInfoBinaryBatch_c::finish() {
+    const auto entryOffset = uint32_t(align8(sizeof(MediaxxInfoBatchHeader)));
+    const auto infoOffset  = uint32_t(entryOffset + entries.size() * sizeof(MediaxxInfoBatchEntry));
+    const auto poolOffset  = uint32_t(infoOffset + infos.size());
+    const auto totalSize   = uint32_t(align8(poolOffset + pool.size()));
+
+    MediaxxInfoBatchHeader header{};
+    header.magic       = MEDIAXX_INFO_BATCH_MAGIC;
+    header.version     = MEDIAXX_INFO_VERSION;
+    header.headerSize  = uint16_t(sizeof(MediaxxInfoBatchHeader));
+    header.totalSize   = totalSize;
+    header.entrySize   = uint32_t(sizeof(MediaxxInfoBatchEntry));
+    header.entryOffset = entryOffset;
+    header.entryCount  = uint32_t(entries.size());
+    for (auto& entry : entries) {
+        if (entry.infoSize > 0) {
+            entry.infoOffset += infoOffset;
+        }
+        rebase(entry.path, poolOffset);
+        rebase(entry.log, poolOffset);
+    }
+
+    std::string result{};
+    result.reserve(totalSize);
+    result.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    result.resize(entryOffset, '\0');
+    appendRecords(result, entries);
+    result.append(infos);
+    result.append(pool);
+    result.resize(totalSize, '\0');
+    return result;
+}
+
+uint32_t MediaInfoBinaryDict_c::addString(std::string_view str) {
+    if (str.empty()) {
+        return 0;
+    }
+    if (auto it = ids.find(str); it != ids.end()) {
+        return it->second;
+    }
+    const auto id = uint32_t(strings.size());
+    strings.push_back(MediaxxInfoString{uint32_t(pool.size()), uint32_t(str.size())});
+    pool.append(str);
+    pool.push_back('\0');
+    ids.emplace(str, id);
+    return id;
+}
+
+void MediaInfoBinaryDict_c::add(
+    size_t           index,
+    int              ret,
+    std::string_view path,
+    std::string_view info,
+    std::string_view log
+) {
+    MediaxxInfoDictEntry entry{};
+    entry.index     = uint32_t(index);
+    entry.ret       = ret;
+    entry.path      = addString(path);
+    entry.log       = addString(log);
+    entry.size      = -1;
+    entry.tagOffset = uint32_t(tags.size());
+
+    MediaxxInfoHeader header{};
+    if (false == readRecord(info, 0, header) || header.magic != MEDIAXX_INFO_MAGIC) {
+        entries.push_back(entry);
+        return;
+    }
+    entry.formatName = addString(readString(info, header.formatName));
+    entry.size       = header.size;
+    entry.bitRate    = header.bitRate;
+    entry.duration   = header.duration;
+
+    for (uint32_t i = 0; i < header.streamCount; ++i) {
+        MediaxxInfoStream stream{};
+        const auto        offset = header.streamOffset + size_t(i) * header.streamSize;
+        if (false == readRecord(info, offset, stream)) {
+            break;
+        }
+        if (AVMEDIA_TYPE_AUDIO == stream.codecType && 0 == entry.audioCodec) {
+            entry.audioCodec    = addString(readString(info, stream.codecName));
+            entry.sampleRate    = stream.sampleRate;
+            entry.channels      = stream.channels;
+            entry.bitsPerSample = stream.bitsPerSample;
+        } else if (AVMEDIA_TYPE_VIDEO == stream.codecType && 0 == entry.videoCodec) {
+            entry.videoCodec = addString(readString(info, stream.codecName));
+            entry.width      = stream.width;
+            entry.height     = stream.height;
+        }
+    }
+
+    for (uint32_t i = 0; i < header.normTagCount; ++i) {
+        MediaxxInfoNormTag tag{};
+        if (false == readRecord(info, header.normTagOffset + i * sizeof(tag), tag)) {
+            break;
+        }
+        tags.push_back(MediaxxInfoDictTag{tag.key, addString(readString(info, tag.value))});
+    }
+    entry.tagCount = uint32_t(tags.size()) - entry.tagOffset;
+    entries.push_back(entry);
+}
+
+std::string MediaInfoBinaryDict_c::finish() {
+    const auto entryOffset  = uint32_t(align8(sizeof(MediaxxInfoDictHeader)));
+    const auto tagOffset    = uint32_t(entryOffset + entries.size() * sizeof(MediaxxInfoDictEntry));
+    const auto stringOffset = uint32_t(tagOffset + tags.size() * sizeof(MediaxxInfoDictTag));
+    const auto poolOffset   = uint32_t(stringOffset + strings.size() * sizeof(MediaxxInfoString));
+    const auto totalSize    = uint32_t(align8(poolOffset + pool.size()));
+
+    MediaxxInfoDictHeader header{};
+    header.magic        = MEDIAXX_INFO_DICT_MAGIC;
+    header.version      = MEDIAXX_INFO_VERSION;
+    header.headerSize   = uint16_t(sizeof(MediaxxInfoDictHeader));
+    header.totalSize    = totalSize;
+    header.entrySize    = uint32_t(sizeof(MediaxxInfoDictEntry));
+    header.entryOffset  = entryOffset;
+    header.entryCount   = uint32_t(entries.size());
+    header.tagOffset    = tagOffset;
+    header.tagCount     = uint32_t(tags.size());
+    header.stringOffset = stringOffset;
+    header.stringCount  = uint32_t(strings.size());
+    for (auto& entry : entries) {
+        entry.tagOffset = tagOffset + entry.tagOffset * uint32_t(sizeof(MediaxxInfoDictTag));
+    }
+    for (auto& str : strings) {
+        rebase(str, poolOffset);
+    }
+
+    std::string result{};
+    result.reserve(totalSize);
+    result.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    result.resize(entryOffset, '\0');
+    appendRecords(result, entries);
+    appendRecords(result, tags);
+    appendRecords(result, strings);
+    result.append(pool);
+    result.resize(totalSize, '\0');
+    return result;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+extern "C" {
+#include "libavformat/avformat.h"
+}
+
+#include <cstdint>
+#include <functional>
+#include <mediaxx.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/// # 二进制格式的音视频信息
+/// - 布局见 [MediaxxInfoHeader]；字段与 [MediaInfoReader_c::toInfoMap] 的 json 一一对应
+/// - 先把记录和字符串分别收集，[finish] 时一次性拼接并把字符串偏移换算为相对结果开头
+class MediaInfoBinaryWriter_c {
+public:
+
+    /// 读取已打开的 [fmtCtx]；[fieldMask] 之外的部分为 0 或不存在
+    /// - 超过 [maxTagSize] 的标签值只保留前缀，记录在 [MediaxxInfoTruncatedTag] 中
+    static std::string build(
+        std::string_view filepath,
+        AVFormatContext* fmtCtx,
+        unsigned int     fieldMask  = MEDIAXX_FIELD_ALL,
+        size_t           maxTagSize = MEDIAXX_DEF_MAX_TAG_SIZE
+    );
+
+    /// 只有格式信息、没有流，用于 HLS/DASH 播放列表
+    static std::string buildFormatOnly(
+        std::string_view filepath,
+        std::string_view formatName,
+        double           duration,
+        int64_t          bitRate,
+        unsigned int     fieldMask = MEDIAXX_FIELD_ALL
+    );
+
+protected:
+
+    MediaxxInfoHeader                    header{};
+    std::vector<MediaxxInfoStream>       streams{};
+    std::vector<MediaxxInfoTag>          tags{};
+    std::vector<MediaxxInfoNormTag>      normTags{};
+    std::vector<MediaxxInfoTruncatedTag> truncatedTags{};
+    size_t                               maxTagSize = MEDIAXX_DEF_MAX_TAG_SIZE;
+    // 以 '\0' 开头，使偏移 0 表示不存在
+    std::string                          pool{'\0'};
+
+    // 标签字符串 -> 已写入 [pool] 的位置；键指向 AVDictionary，在 [build] 期间有效
+    std::unordered_map<std::string_view, MediaxxInfoString> interned{};
+
+    MediaxxInfoString addString(const char* str);
+    MediaxxInfoString addString(std::string_view str);
+
+    /// 相同的内容只写入一次，用于重复较多的标签；[str] 需要在 [finish] 前保持有效
+    MediaxxInfoString addInternedString(std::string_view str);
+
+    /// 追加 [metadata] 中的标签，返回追加的数量
+    uint32_t addTags(AVDictionary* metadata);
+
+    void addStream(unsigned int index, AVStream* stream, unsigned int fieldMask);
+
+    void addNormalizedTags(AVFormatContext* fmtCtx);
+
+    std::string finish();
+};
+
+/// # 二进制格式的批量结果
+/// - 布局见 [MediaxxInfoBatchHeader]
+class MediaInfoBinaryBatch_c {
+public:
+
+    /// [info] 为 [MediaInfoBinaryWriter_c] 的结果，失败时为空
+    void add(size_t index, int ret, std::string_view path, std::string_view info, std::string_view log);
+
+    std::string finish();
+
+protected:
+
+    std::vector<MediaxxInfoBatchEntry> entries{};
+    // 各项的 [MediaxxInfoHeader]，每项 8 字节对齐；偏移在 [finish] 时加上前面部分的长度
+    std::string                        infos{};
+    std::string                        pool{'\0'};
+
+    MediaxxInfoString addString(std::string_view str);
+};
+
+/// # 字典格式的批量结果
+/// - 布局见 [MediaxxInfoDictHeader]；由各项 [MediaInfoBinaryWriter_c] 的结果转换，本地和远程共用
+/// - 整批共享一个字典，相同的字符串只写入一次
+class MediaInfoBinaryDict_c {
+public:
+
+    /// 参数同 [MediaInfoBinaryBatch_c::add]
+    void add(
+        size_t           index,
+        int              ret,
+        std::string_view path,
+        std::string_view info,
+        std::string_view log
+    );
+
+    std::string finish();
+
+protected:
+
+    // 查找时直接用 string_view，不构造临时的 std::string
+    struct StringHash {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view str) const {
+            return std::hash<std::string_view>{}(str);
+        }
+    };
+
+    std::vector<MediaxxInfoDictEntry> entries{};
+    std::vector<MediaxxInfoDictTag>   tags{};
+    // 编号 -> 字符串；编号 0 为空
+    std::vector<MediaxxInfoString>    strings{MediaxxInfoString{}};
+    std::string                       pool{'\0'};
+
+    std::unordered_map<std::string, uint32_t, StringHash, std::equal_to<>> ids{};
+
+    /// 返回字典中的编号，空串返回 0
+    uint32_t addString(std::string_view str);
+};
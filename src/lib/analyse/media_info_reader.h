@@ -13,13 +13,17 @@ extern "C" {
 #include "libswscale/swscale.h"
 }
 
+#include "analyse/tag_normalizer.h"
 #include "analyse/tool.h"
 #include "simdjson.h"
+#include "util/cancel_token.h"
+#include "util/charset.h"
 #include "util/json_helper.h"
 #include "util/log.h"
 #include "util/string_util.h"
 #include "util/utilxx.h"
 #include <algorithm>
+#include <charconv>
 #include <filesystem>
 #include <format>
 #include <fstream>
@@ -54,16 +58,58 @@ public:
         "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/122.0.6261.95 Safari/537.36"
     };
 
+    // 未指定截止时间时，单次网络读写的超时（微秒）
+    inline static constexpr int64_t cDefIoTimeoutUs = 30000000;
+
     const std::string filepath;
     AVFormatContext*  fmtCtx  = nullptr;
     AVDictionary*     options = nullptr;
+    RequestInterrupt  interrupt{};
+    // 可选，调用方提供的 IO；由调用方负责释放，[dispose] 不会关闭
+    AVIOContext*      customIo = nullptr;
+    // MEDIAXX_FIELD_* 的组合，[MediaInfoReader_c::toInfoMap] 只输出其中的部分
+    unsigned int      fieldMask = MEDIAXX_FIELD_ALL;
+    // 为 false 时 [MediaInfoReader_c::openFile] 跳过 avformat_find_stream_info
+    bool              probeStreams = true;
+    // 输出的标签值的长度上限，见 [MediaxxRequestOptions.maxTagSize]
+    size_t            maxTagSize   = MEDIAXX_DEF_MAX_TAG_SIZE;
+
+    MediaInfoItem_c(
+        const std::string_view     in_filepath,
+        const char**               in_log,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    ) :
+        analyse_tool::AnalyseLogItem_c(in_log, resource),
+        filepath(in_filepath) {
+        subject = filepath;
+    }
+
+    bool isInterrupted() const {
+        return interrupt.isInterrupted();
+    }
+
+    bool hasField(unsigned int field) const {
+        return (fieldMask & field) != 0;
+    }
+
+    /// 只需要标签时不再探测流：标签在打开时已经读取，探测流需要读取并解码部分数据包
+    void setFieldMask(unsigned int mask) {
+        fieldMask    = (mask == 0) ? MEDIAXX_FIELD_ALL : mask;
+        probeStreams = hasField(MEDIAXX_FIELD_FORMAT | MEDIAXX_FIELD_STREAMS);
+    }
 
-    MediaInfoItem_c(const std::string_view in_filepath, const char** in_log) :
-        analyse_tool::AnalyseLogItem_c(in_log),
-        filepath(in_filepath) {}
+    /// 0 为默认值，< 0 不限制
+    void setMaxTagSize(int size) {
+        maxTagSize = (size < 0) ? SIZE_MAX : (size == 0 ? MEDIAXX_DEF_MAX_TAG_SIZE : size_t(size));
+    }
 
     void setOptions(const std::string_view headers) {
-        av_dict_set(&options, "timeout", "30000000", 0);
+        // 有截止时间时，单次读写也不能超过剩余时间
+        auto ioTimeoutUs = cDefIoTimeoutUs;
+        if (const auto remain = interrupt.remainingUs(); remain >= 0) {
+            ioTimeoutUs = std::clamp<int64_t>(remain, 1, cDefIoTimeoutUs);
+        }
+        av_dict_set_int(&options, "timeout", ioTimeoutUs, 0);
         av_dict_set(&options, "tls_verify", "0", 0);
         av_dict_set(&options, "verify", "0", 0);
         av_dict_set(&options, "max_redirects", "5", 0);
@@ -99,24 +145,60 @@ public:
 
     bool openFile(MediaInfoItem_c& item, const std::string_view headers) {
         if (item.filepath.empty()) {
-            item.setLog("缺少文件路径");
+            item.setError(MEDIAXX_DIAG_STAGE_OPEN, MEDIAXX_DIAG_ERR_NO_PATH);
+            return false;
+        }
+
+        if (item.isInterrupted()) {
+            item.setError(MEDIAXX_DIAG_STAGE_OPEN, MEDIAXX_DIAG_ERR_CANCELLED);
             return false;
         }
 
         item.setOptions(headers);
         LXX_DEBEG("openFile ...... : {}", item.filepath);
+        // 预先分配上下文以设置中断回调，打开/探测/读取阶段的阻塞 IO 都会检查取消和截止时间
+        item.fmtCtx = avformat_alloc_context();
+        if (nullptr == item.fmtCtx) {
+            item.setError(MEDIAXX_DIAG_STAGE_OPEN, MEDIAXX_DIAG_ERR_NO_MEMORY);
+            return false;
+        }
+        item.fmtCtx->interrupt_callback.callback = &RequestInterrupt::avCallback;
+        item.fmtCtx->interrupt_callback.opaque   = &item.interrupt;
+        if (nullptr != item.customIo) {
+            // 设置 pb 后 ffmpeg 不再自行打开协议，[filepath] 仅用于猜测格式
+            item.fmtCtx->pb = item.customIo;
+        }
+        // 失败时 [avformat_open_input] 会释放 fmtCtx 并置空
         int ret = avformat_open_input(&item.fmtCtx, item.filepath.c_str(), nullptr, &item.options);
         if (ret != 0) {
-            item.setLog(
-                std::format("无法打开文件: {}, 错误: {}", item.filepath, utilxx::av_err2str(ret))
-            );
+            // 扫描时大量非媒体文件会走到这里，[textLog] 为 false 时不格式化文字
+            if (item.isInterrupted()) {
+                item.setError(MEDIAXX_DIAG_STAGE_OPEN, MEDIAXX_DIAG_ERR_CANCELLED);
+                return false;
+            }
+            item.setError(MEDIAXX_DIAG_STAGE_OPEN, MEDIAXX_DIAG_ERR_OPEN, ret);
             return false;
         }
 
+        // 标签在打开时已读取完，这里统一转码，之后的 json、二进制、规范化等都只需要处理 UTF-8
+        repairTags(item.fmtCtx->metadata);
+        for (unsigned int i = 0; i < item.fmtCtx->nb_streams; ++i) {
+            repairTags(item.fmtCtx->streams[i]->metadata);
+        }
+
+        if (false == item.probeStreams) {
+            LXX_DEBEG("openFile success (skip stream info): {}", item.filepath);
+            return true;
+        }
+
         LXX_DEBEG("openFile | find info ...... : {}", item.filepath);
         ret = avformat_find_stream_info(item.fmtCtx, nullptr);
         if (ret < 0) {
-            item.setLog(std::format("无法获取流信息: {}", item.filepath, utilxx::av_err2str(ret)));
+            if (item.isInterrupted()) {
+                item.setError(MEDIAXX_DIAG_STAGE_STREAM_INFO, MEDIAXX_DIAG_ERR_CANCELLED);
+                return false;
+            }
+            item.setError(MEDIAXX_DIAG_STAGE_STREAM_INFO, MEDIAXX_DIAG_ERR_STREAM_INFO, ret);
             return false;
         }
 
@@ -124,6 +206,140 @@ public:
         return true;
     }
 
+    /// 转码 [metadata] 中 GBK 等编码的标签，见 [charsetxx::repairText]
+    /// - 大多数文件不需要处理，只检查不复制；有需要时按原顺序重建整个字典
+    static void repairTags(AVDictionary*& metadata) {
+        std::string        repairedKey{};
+        std::string        repairedValue{};
+        AVDictionaryEntry* tag = nullptr;
+        while ((tag = av_dict_get(metadata, "", tag, AV_DICT_IGNORE_SUFFIX))) {
+            if (charsetxx::repairText(tag->key, repairedKey)
+                || charsetxx::repairText(tag->value, repairedValue)) {
+                break;
+            }
+        }
+        if (nullptr == tag) {
+            return;
+        }
+
+        // 从头重建，需要转码的第一个标签之前的也要保留
+        AVDictionary* repaired = nullptr;
+        tag                    = nullptr;
+        while ((tag = av_dict_get(metadata, "", tag, AV_DICT_IGNORE_SUFFIX))) {
+            repairedKey.clear();
+            repairedValue.clear();
+            const auto key   = charsetxx::repairText(tag->key, repairedKey) ? repairedKey.c_str()
+                                                                            : tag->key;
+            const auto value = charsetxx::repairText(tag->value, repairedValue)
+                                 ? repairedValue.c_str()
+                                 : tag->value;
+            LXX_DEBEG("repair tag: '{}': '{}' -> '{}': '{}'", tag->key, tag->value, key, value);
+            av_dict_set(&repaired, key, value, AV_DICT_MULTIKEY);
+        }
+        av_dict_free(&metadata);
+        metadata = repaired;
+    }
+
+    /// `num/den` 写入栈上缓冲区，避免每个字段一次 std::format 堆分配
+    struct RationalText {
+        char   data[32];
+        size_t size = 0;
+
+        explicit RationalText(AVRational value) {
+            auto end = std::to_chars(data, data + sizeof(data), value.num).ptr;
+            *end++   = '/';
+            end      = std::to_chars(end, data + sizeof(data), value.den).ptr;
+            size     = size_t(end - data);
+        }
+
+        std::string_view view() const {
+            return std::string_view{data, size};
+        }
+    };
+
+    /// 输出 `"tags": {...},`；有值被截断时再输出 `"tags_truncated": {key: 完整长度},`
+    /// - 超过 [maxTagSize] 的值只输出前缀（不切断多字节字符）
+    void appendTags(
+        simdjson::builder::string_builder& result,
+        AVDictionary*                      metadata,
+        size_t                             maxTagSize
+    ) {
+        // 大多数文件没有超长的标签，不会分配
+        std::vector<std::pair<std::string_view, size_t>> truncated{};
+
+        result.escape_and_append_with_quotes("tags");
+        result.append_colon();
+        result.start_object();
+        AVDictionaryEntry* tag     = nullptr;
+        auto               isFirst = true;
+        while ((tag = av_dict_get(metadata, "", tag, AV_DICT_IGNORE_SUFFIX))) {
+            if (nullptr != tag && nullptr != tag->key && nullptr != tag->value) {
+                auto key   = std::string_view{tag->key};
+                auto value = std::string_view{tag->value};
+                if (false == charsetxx::isCleanText(key)
+                    || false == charsetxx::isCleanText(value)) {
+                    LXX_WARN("tags pair contain '�': '{}': '{}'", key, value);
+                    continue;
+                }
+                if (false == isFirst) {
+                    result.append_comma();
+                }
+                isFirst = false;
+                if (value.size() > maxTagSize) {
+                    truncated.emplace_back(key, value.size());
+                    value = stringxx::utf8Truncate(value, maxTagSize);
+                }
+                result.append_key_value(key, value);
+            }
+        }
+        result.end_object();
+        result.append_comma();
+
+        if (false == truncated.empty()) {
+            result.escape_and_append_with_quotes("tags_truncated");
+            result.append_colon();
+            result.start_object();
+            for (size_t i = 0; i < truncated.size(); ++i) {
+                if (i > 0) {
+                    result.append_comma();
+                }
+                result.append_key_value(truncated[i].first, uint64_t(truncated[i].second));
+            }
+            result.end_object();
+            result.append_comma();
+        }
+    }
+
+    /// 输出 `tags_normalized` 对象：多值字段为字符串数组，其他为字符串
+    void appendNormalizedTags(simdjson::builder::string_builder& result, AVFormatContext* fmtCtx) {
+        std::vector<NormalizedTag> tags{};
+        TagNormalizer_c::normalize(fmtCtx, tags);
+        result.start_object();
+        for (size_t i = 0; i < tags.size();) {
+            const auto key = tags[i].key;
+            if (i > 0) {
+                result.append_comma();
+            }
+            result.escape_and_append_with_quotes(TagNormalizer_c::keyName(key));
+            result.append_colon();
+            if (false == TagNormalizer_c::isMultiValue(key)) {
+                result.escape_and_append_with_quotes(tags[i].value);
+                ++i;
+                continue;
+            }
+            result.start_array();
+            for (auto first = i; i < tags.size() && tags[i].key == key; ++i) {
+                if (i > first) {
+                    result.append_comma();
+                }
+                result.escape_and_append_with_quotes(tags[i].value);
+            }
+            result.end_array();
+        }
+        result.end_object();
+    }
+
+    /// 只输出 [MediaInfoItem_c.fieldMask] 中请求的部分
     simdjson::builder::string_builder toInfoMap(MediaInfoItem_c& item) {
         LXX_DEBEG("toInfoMap ......");
         simdjson::builder::string_builder result{};
@@ -140,249 +356,213 @@ public:
         {
             result.start_object();
 
-            result.append_key_value<"filename">(item.filepath);
-            result.append_comma();
-            strBuilderAppendFixdKeyVPtr_d(result, "format_name", fmtCtx->iformat->name);
-            result.append_key_value<"nb_streams">(fmtCtx->nb_streams);
-            result.append_comma();
-            result.append_key_value<"nb_programs">(fmtCtx->nb_programs);
-            result.append_comma();
-            result.append_key_value<"nb_stream_groups">(fmtCtx->nb_stream_groups);
-            result.append_comma();
-            result.append_key_value<"start_time">(fmtCtx->start_time);
-            result.append_comma();
-            result.append_key_value<"duration">(
-                fmtCtx->duration != AV_NOPTS_VALUE ? double(fmtCtx->duration) / AV_TIME_BASE : 0
-            );
-            result.append_comma();
-            if (nullptr != fmtCtx->pb) {
-                result.append_key_value<"size">(avio_size(fmtCtx->pb));
+            if (item.hasField(MEDIAXX_FIELD_FORMAT)) {
+                strBuilderAppendFixdKeyVPtr_d(result, "format_name", fmtCtx->iformat->name);
+                result.append_key_value<"nb_streams">(fmtCtx->nb_streams);
+                result.append_comma();
+                result.append_key_value<"nb_programs">(fmtCtx->nb_programs);
+                result.append_comma();
+                result.append_key_value<"nb_stream_groups">(fmtCtx->nb_stream_groups);
+                result.append_comma();
+                result.append_key_value<"start_time">(fmtCtx->start_time);
+                result.append_comma();
+                result.append_key_value<"duration">(
+                    fmtCtx->duration != AV_NOPTS_VALUE ? double(fmtCtx->duration) / AV_TIME_BASE : 0
+                );
+                result.append_comma();
+                if (nullptr != fmtCtx->pb) {
+                    result.append_key_value<"size">(avio_size(fmtCtx->pb));
+                    result.append_comma();
+                }
+                result.append_key_value<"bit_rate">(fmtCtx->bit_rate);
+                result.append_comma();
+                result.append_key_value<"probe_score">(fmtCtx->probe_score);
                 result.append_comma();
             }
-            result.append_key_value<"bit_rate">(fmtCtx->bit_rate);
-            result.append_comma();
-            result.append_key_value<"probe_score">(fmtCtx->probe_score);
-            result.append_comma();
 
-            result.escape_and_append_with_quotes("tags");
-            result.append_colon();
-            result.start_object();
-            auto ctxMetadata = fmtCtx->metadata;
-            if (nullptr != ctxMetadata) {
-                AVDictionaryEntry* tag     = nullptr;
-                auto               isFirst = true;
-                LXX_WARN("tags =============== ");
-                while ((tag = av_dict_get(ctxMetadata, "", tag, AV_DICT_IGNORE_SUFFIX))) {
-                    if (nullptr != tag && nullptr != tag->key && nullptr != tag->value) {
-                        auto key   = std::string_view{tag->key};
-                        auto value = std::string_view{tag->value};
-                        LXX_WARN("tags =============== {} {}", key, value);
-                        if (key.contains("�") || false == stringxx::utf8IsAvail(key.data())
-                            || value.contains("�")
-                            || false == stringxx::utf8IsAvail(value.data())) {
-                            LXX_WARN("tags pair contain '�': '{}': '{}'", key, value);
-                            continue;
-                        }
-                        if (false == isFirst) {
-                            result.append_comma();
-                        }
-                        isFirst = false;
-                        result.append_key_value(key, value);
-                    }
-                }
+            if (item.hasField(MEDIAXX_FIELD_FORMAT_TAGS)) {
+                appendTags(result, fmtCtx->metadata, item.maxTagSize);
             }
-            result.end_object();
 
+            // 总是输出，放在最后以免多余的逗号
+            result.append_key_value<"filename">(item.filepath);
             result.end_object();
         }
-        result.append_comma();
 
-        result.escape_and_append_with_quotes("streams");
-        result.append_colon();
-        {
-            result.start_array();
-            for (unsigned int i = 0; i < fmtCtx->nb_streams; i++) {
-                if (i > 0) {
-                    result.append_comma();
-                }
+        if (item.hasField(MEDIAXX_FIELD_NORM_TAGS)) {
+            result.append_comma();
+            result.escape_and_append_with_quotes("tags_normalized");
+            result.append_colon();
+            appendNormalizedTags(result, fmtCtx);
+        }
 
-                result.start_object();
-                AVStream*          stream   = fmtCtx->streams[i];
-                AVCodecParameters* codecPar = stream->codecpar;
+        if (item.hasField(MEDIAXX_FIELD_STREAMS)) {
+            result.append_comma();
+            result.escape_and_append_with_quotes("streams");
+            result.append_colon();
+            appendStreams(result, fmtCtx, item.fieldMask, item.maxTagSize);
+        }
 
-                result.append_key_value<"index">(i);
-                result.append_comma();
-                result.append_key_value<"codec_id">(int(codecPar->codec_id));
-                result.append_comma();
-                strBuilderAppendFixdKeyVPtr_d(
-                    result,
-                    "codec_name",
-                    avcodec_get_name(codecPar->codec_id)
-                );
-                auto avdesc = avcodec_descriptor_get(codecPar->codec_id);
-                if (nullptr != avdesc) {
-                    strBuilderAppendFixdKeyVPtr_d(result, "codec_long_name", avdesc->long_name);
-                }
-                strBuilderAppendFixdKeyVPtr_d(
-                    result,
-                    "codec_type",
-                    av_get_media_type_string(codecPar->codec_type)
-                );
-                result.append_key_value<"codec_tag">(codecPar->codec_tag);
-                result.append_comma();
-                result.append_key_value<"bit_rate">(codecPar->bit_rate);
-                result.append_comma();
-                result.append_key_value<"bits_per_sample">(codecPar->bits_per_raw_sample);
-                result.append_comma();
-                result.append_key_value<"start_time">(stream->start_time);
+        result.end_object();
+        return result;
+    }
+
+    /// 输出 `streams` 数组，HLS/DASH 分段探测时也会复用
+    void appendStreams(
+        simdjson::builder::string_builder& result,
+        AVFormatContext*                   fmtCtx,
+        unsigned int                       fieldMask  = MEDIAXX_FIELD_ALL,
+        size_t                             maxTagSize = MEDIAXX_DEF_MAX_TAG_SIZE
+    ) {
+        const bool withRates = (fieldMask & MEDIAXX_FIELD_STREAM_RATES) != 0;
+        const bool withTags  = (fieldMask & MEDIAXX_FIELD_STREAM_TAGS) != 0;
+        const bool withVideo = (fieldMask & MEDIAXX_FIELD_VIDEO) != 0;
+        const bool withAudio = (fieldMask & MEDIAXX_FIELD_AUDIO) != 0;
+
+        result.start_array();
+        for (unsigned int i = 0; i < fmtCtx->nb_streams; i++) {
+            if (i > 0) {
                 result.append_comma();
-                result.append_key_value<"r_frame_rate">(
-                    std::format("{}/{}", stream->r_frame_rate.num, stream->r_frame_rate.den)
-                );
+            }
+
+            result.start_object();
+            AVStream*          stream   = fmtCtx->streams[i];
+            AVCodecParameters* codecPar = stream->codecpar;
+
+            result.append_key_value<"codec_id">(int(codecPar->codec_id));
+            result.append_comma();
+            strBuilderAppendFixdKeyVPtr_d(
+                result,
+                "codec_name",
+                avcodec_get_name(codecPar->codec_id)
+            );
+            auto avdesc = avcodec_descriptor_get(codecPar->codec_id);
+            if (nullptr != avdesc) {
+                strBuilderAppendFixdKeyVPtr_d(result, "codec_long_name", avdesc->long_name);
+            }
+            strBuilderAppendFixdKeyVPtr_d(
+                result,
+                "codec_type",
+                av_get_media_type_string(codecPar->codec_type)
+            );
+            result.append_key_value<"codec_tag">(codecPar->codec_tag);
+            result.append_comma();
+            result.append_key_value<"bit_rate">(codecPar->bit_rate);
+            result.append_comma();
+            result.append_key_value<"bits_per_sample">(codecPar->bits_per_raw_sample);
+            result.append_comma();
+            result.append_key_value<"start_time">(stream->start_time);
+            result.append_comma();
+            if (withRates) {
+                result.append_key_value<"r_frame_rate">(RationalText{stream->r_frame_rate}.view());
                 result.append_comma();
                 result.append_key_value<"avg_frame_rate">(
-                    std::format("{}/{}", stream->avg_frame_rate.num, stream->avg_frame_rate.den)
+                    RationalText{stream->avg_frame_rate}.view()
                 );
                 result.append_comma();
-                result.append_key_value<"time_base">(
-                    std::format("{}/{}", stream->time_base.num, stream->time_base.den)
-                );
+                result.append_key_value<"time_base">(RationalText{stream->time_base}.view());
                 result.append_comma();
-                if (stream->time_base.den && stream->time_base.num) {
-                    // 秒
-                    result.append_key_value<"duration">(
-                        (stream->duration * av_q2d(stream->time_base))
+            }
+            if (stream->time_base.den && stream->time_base.num) {
+                // 秒
+                result.append_key_value<"duration">((stream->duration * av_q2d(stream->time_base)));
+                result.append_comma();
+            }
+
+            if (withTags) {
+                appendTags(result, stream->metadata, maxTagSize);
+            }
+
+            LXX_DEBEG("toInfoMap | append stream/metadata: {} ......", int(codecPar->codec_type));
+            switch (codecPar->codec_type) {
+            case AVMEDIA_TYPE_VIDEO:
+                if (withVideo) {
+                    result.append_key_value<"width">(codecPar->width);
+                    result.append_comma();
+                    result.append_key_value<"height">(codecPar->height);
+                    result.append_comma();
+                    result.append_key_value<"framerate">(RationalText{codecPar->framerate}.view());
+                    result.append_comma();
+                    result.append_key_value<"sample_aspect_ratio">(
+                        RationalText{stream->sample_aspect_ratio}.view()
                     );
                     result.append_comma();
-                }
+                    strBuilderAppendFixdKeyVPtr_d(
+                        result,
+                        "color_range",
+                        av_color_range_name(codecPar->color_range)
+                    );
+                    strBuilderAppendFixdKeyVPtr_d(
+                        result,
+                        "color_space",
+                        av_color_space_name(codecPar->color_space)
+                    );
+                    strBuilderAppendFixdKeyVPtr_d(
+                        result,
+                        "chroma_location",
+                        av_chroma_location_name(codecPar->chroma_location)
+                    );
+                    strBuilderAppendFixdKeyVPtr_d(
+                        result,
+                        "pix_fmt",
+                        av_get_pix_fmt_name((AVPixelFormat)codecPar->format)
+                    );
+                    strBuilderAppendFixdKeyVPtr_d(
+                        result,
+                        "format",
+                        av_get_pix_fmt_name((AVPixelFormat)codecPar->format)
+                    );
 
-                result.escape_and_append_with_quotes("tags");
-                result.append_colon();
-                {
-                    result.start_object();
-                    auto               metadata = stream->metadata;
-                    AVDictionaryEntry* tag      = nullptr;
-                    auto               isFirst  = true;
-                    while ((tag = av_dict_get(metadata, "", tag, AV_DICT_IGNORE_SUFFIX))) {
-                        if (nullptr != tag && nullptr != tag->key && nullptr != tag->value) {
-                            auto key   = std::string_view{tag->key};
-                            auto value = std::string_view{tag->value};
-                            if (key.contains("�") || value.contains("�")) {
-                                LXX_WARN("tags pair contain '�': '{}': '{}'", key, value);
-                                continue;
-                            }
-                            if (false == isFirst) {
-                                result.append_comma();
-                            }
-                            isFirst = false;
-                            result.append_key_value(key, value);
-                        }
+                    if (stream->avg_frame_rate.den && stream->avg_frame_rate.num) {
+                        // 计算帧率
+                        double fps = av_q2d(stream->avg_frame_rate);
+                        result.append_key_value<"fps">(fps);
+                        result.append_comma();
                     }
-                    result.end_object();
+                    result.append_key_value<"level">(codecPar->level);
+                    result.append_comma();
                 }
-
-                LXX_DEBEG(
-                    "toInfoMap | append stream/metadata: {} ......",
-                    int(codecPar->codec_type)
-                );
-                switch (codecPar->codec_type) {
-                case AVMEDIA_TYPE_VIDEO:
+                break;
+            case AVMEDIA_TYPE_AUDIO:
+                if (withAudio) {
+                    result.append_key_value<"sample_rate">(codecPar->sample_rate);
+                    result.append_comma();
+                    result.append_key_value<"channels">(codecPar->ch_layout.nb_channels);
+                    result.append_comma();
                     {
-                        result.append_comma();
-                        result.append_key_value<"width">(codecPar->width);
-                        result.append_comma();
-                        result.append_key_value<"height">(codecPar->height);
-                        result.append_comma();
-                        result.append_key_value<"framerate">(
-                            std::format("{}/{}", codecPar->framerate.num, codecPar->framerate.den)
-                        );
-                        result.append_comma();
-                        result.append_key_value<"sample_aspect_ratio">(std::format(
-                            "{}/{}",
-                            stream->sample_aspect_ratio.num,
-                            stream->sample_aspect_ratio.den
-                        ));
-                        result.append_comma();
-                        strBuilderAppendFixdKeyVPtr_d(
-                            result,
-                            "color_range",
-                            av_color_range_name(codecPar->color_range)
-                        );
-                        strBuilderAppendFixdKeyVPtr_d(
-                            result,
-                            "color_space",
-                            av_color_space_name(codecPar->color_space)
-                        );
-                        strBuilderAppendFixdKeyVPtr_d(
-                            result,
-                            "chroma_location",
-                            av_chroma_location_name(codecPar->chroma_location)
-                        );
-                        strBuilderAppendFixdKeyVPtr_d(
-                            result,
-                            "pix_fmt",
-                            av_get_pix_fmt_name((AVPixelFormat)codecPar->format)
-                        );
-                        strBuilderAppendFixdKeyVPtr_d(
-                            result,
-                            "format",
-                            av_get_pix_fmt_name((AVPixelFormat)codecPar->format)
-                        );
-
-                        if (stream->avg_frame_rate.den && stream->avg_frame_rate.num) {
-                            // 计算帧率
-                            double fps = av_q2d(stream->avg_frame_rate);
-                            result.append_key_value<"fps">(fps);
+                        // 布局名称很短，用栈上缓冲区
+                        char layout[128];
+                        if (av_channel_layout_describe(&codecPar->ch_layout, layout, sizeof(layout))
+                            > 0) {
+                            result.append_key_value<"channel_layout">(std::string_view{layout});
                             result.append_comma();
                         }
-                        // if 块不能结尾，否则可能多余逗号 [result.append_comma()]
-                        result.append_key_value<"level">(codecPar->level);
                     }
-                    break;
-                case AVMEDIA_TYPE_AUDIO:
-                    {
-                        result.append_comma();
-                        result.append_key_value<"sample_rate">(codecPar->sample_rate);
-                        result.append_comma();
-                        result.append_key_value<"channels">(codecPar->ch_layout.nb_channels);
-                        result.append_comma();
-                        {
-                            AVBPrint bp{};
-                            av_bprint_init(&bp, 0, AV_BPRINT_SIZE_UNLIMITED);
-                            av_channel_layout_describe_bprint(&codecPar->ch_layout, &bp);
-                            char* channel_name = nullptr;
-                            av_bprint_finalize(&bp, &channel_name);
-                            strBuilderAppendFixdKeyVPtr_d(result, "channel_layout", channel_name);
-                            av_free(channel_name);
-                        }
-                        strBuilderAppendFixdKeyVPtr_d(
-                            result,
-                            "sample_fmt",
-                            av_get_sample_fmt_name((AVSampleFormat)codecPar->format)
-                        );
-                        strBuilderAppendFixdKeyVPtr_d(
-                            result,
-                            "format",
-                            av_get_sample_fmt_name((AVSampleFormat)codecPar->format)
-                        );
-                        result.append_key_value<"initial_padding">(codecPar->initial_padding);
-                        result.append_comma();
-                        result.append_key_value<"trailing_padding">(codecPar->trailing_padding);
-                        // result.append_comma();
-                    }
-                    break;
-                default:
-                    break;
+                    strBuilderAppendFixdKeyVPtr_d(
+                        result,
+                        "sample_fmt",
+                        av_get_sample_fmt_name((AVSampleFormat)codecPar->format)
+                    );
+                    strBuilderAppendFixdKeyVPtr_d(
+                        result,
+                        "format",
+                        av_get_sample_fmt_name((AVSampleFormat)codecPar->format)
+                    );
+                    result.append_key_value<"initial_padding">(codecPar->initial_padding);
+                    result.append_comma();
+                    result.append_key_value<"trailing_padding">(codecPar->trailing_padding);
+                    result.append_comma();
                 }
-
-                result.end_object();
+                break;
+            default:
+                break;
             }
-            result.end_array();
-            // result.append_comma();
-        }
 
-        result.end_object();
-        return result;
+            // 总是输出，放在最后以免多余的逗号
+            result.append_key_value<"index">(i);
+            result.end_object();
+        }
+        result.end_array();
     }
 
     int convertQualityToQscale(int quality) {
@@ -393,6 +573,7 @@ public:
         return (int)(2 + (100 - quality) * 29 / 100.0 + 0.5);
     }
 
+    /// 提取封面；返回 0 没有封面，1 保存了封面，2 同时保存了缩略图，-2 请求已取消或超时
     int savePicture(
         MediaInfoItem_c&       item,
         const std::string_view outputStr,
@@ -404,6 +585,10 @@ public:
             item.setLog("未打开文件");
             return 0;
         }
+        if (item.isInterrupted()) {
+            item.setLog("请求已取消或超时: {}", item.filepath);
+            return -2;
+        }
         for (unsigned int i = 0; i < fmtCtx->nb_streams; i++) {
             AVStream*          stream   = fmtCtx->streams[i];
             AVCodecParameters* codecPar = stream->codecpar;
@@ -732,6 +917,10 @@ public:
         bool            retryByCodecId = false;
         AVCodecContext* decCtx         = nullptr;
         AVFrame*        frame          = nullptr;
+        // 解码封面的错误都关联到 [stream]
+        const auto setPictureError = [&item, stream](unsigned short code, int avError = 0) {
+            item.setError(MEDIAXX_DIAG_STAGE_PICTURE, code, avError, {}, stream->index);
+        };
         do {
             // 查找解码器
             if (AVCodecID::AV_CODEC_ID_NONE == useCodecId) {
@@ -740,7 +929,7 @@ public:
             LXX_DEBEG("savePictureScaleByStream: try decoder: {}", int(useCodecId));
             const AVCodec* decoder = avcodec_find_decoder(useCodecId);
             if (!decoder) {
-                item.setLog(std::format("找不到解码器: {}", int(useCodecId)));
+                setPictureError(MEDIAXX_DIAG_ERR_NO_DECODER);
                 retryByCodecId = true;
                 result         = false;
                 break;
@@ -749,7 +938,7 @@ public:
             // 初始化解码器上下文
             decCtx = avcodec_alloc_context3(decoder);
             if (!decCtx) {
-                item.setLog(std::format("无法分配解码器上下文: {}", int(useCodecId)));
+                setPictureError(MEDIAXX_DIAG_ERR_NO_MEMORY);
                 result = false;
                 break;
             }
@@ -757,7 +946,7 @@ public:
             // 复制流参数到解码器上下文
             int ret = avcodec_parameters_to_context(decCtx, stream->codecpar);
             if (ret < 0) {
-                item.setLog(std::format("复制流参数失败: {}/{}", ret, utilxx::av_err2str(ret)));
+                setPictureError(MEDIAXX_DIAG_ERR_DECODER_OPEN, ret);
                 result = false;
                 break;
             }
@@ -771,7 +960,7 @@ public:
             // 打开解码器
             ret = avcodec_open2(decCtx, decoder, nullptr);
             if (ret != 0) {
-                item.setLog(std::format("无法打开解码器: {}/{}", ret, utilxx::av_err2str(ret)));
+                setPictureError(MEDIAXX_DIAG_ERR_DECODER_OPEN, ret);
                 retryByCodecId = true;
                 result         = false;
                 break;
@@ -780,7 +969,7 @@ public:
             // 分配解码帧
             frame = av_frame_alloc();
             if (!frame) {
-                item.setLog("无法分配解码帧");
+                setPictureError(MEDIAXX_DIAG_ERR_NO_MEMORY);
                 result = false;
                 break;
             }
@@ -788,9 +977,7 @@ public:
             // 发送数据包到解码器
             ret = avcodec_send_packet(decCtx, pkt);
             if (ret != 0) {
-                item.setLog(
-                    std::format("发送数据包到解码器失败: {}/{}", ret, utilxx::av_err2str(ret))
-                );
+                setPictureError(MEDIAXX_DIAG_ERR_DECODE, ret);
                 retryByCodecId = true;
                 result         = false;
                 break;
@@ -799,7 +986,7 @@ public:
             // 接收解码后的帧（封面通常只有一帧）
             ret = avcodec_receive_frame(decCtx, frame);
             if (ret != 0) {
-                item.setLog(std::format("接收解码帧失败: {}/{}", ret, utilxx::av_err2str(ret)));
+                setPictureError(MEDIAXX_DIAG_ERR_DECODE, ret);
                 retryByCodecId = true;
                 result         = false;
                 break;
@@ -895,6 +1082,12 @@ public:
                 AVFrame*  targetFrame = nullptr;
 
                 while (av_read_frame(fmtCtx, pkt) == 0) {
+                    if (item.isInterrupted()) {
+                        // 解码耗时不经过 IO 中断回调，这里单独检查
+                        item.setLog("请求已取消或超时: {}", item.filepath);
+                        av_packet_unref(pkt);
+                        break;
+                    }
                     if (pkt->stream_index == stream->index) {
                         if (avcodec_send_packet(decodeCtx, pkt) != 0) {
                             break;
@@ -909,6 +1102,10 @@ public:
                     }
                     av_packet_unref(pkt);
                 }
+                // 取消时 av_read_frame 也会因中断回调而失败
+                if (nullptr == targetFrame && item.isInterrupted()) {
+                    result = -2;
+                }
 
                 if (targetFrame) {
                     // 如果像素格式不是YUVJ420P，进行转换
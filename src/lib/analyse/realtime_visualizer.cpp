@@ -0,0 +1,180 @@
+#include "realtime_visualizer.h"
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    // 缓冲区时长的上限，避免参数错误时分配过多内存
+    constexpr int cMaxBufferMs = 10000;
+} // namespace
+
+void PcmRing_c::init(size_t capacityFrames, int in_channels) {
+    capacity = std::bit_ceil(std::max<size_t>(capacityFrames, 1));
+    mask     = capacity - 1;
+    channels = size_t(in_channels);
+    data.assign(capacity * channels, 0.0f);
+}
+
+size_t PcmRing_c::write(const float* samples, size_t frames) {
+    const auto h = head.load(std::memory_order_relaxed);
+    const auto t = tail.load(std::memory_order_acquire);
+    frames       = std::min(frames, capacity - size_t(h - t));
+    if (0 == frames) {
+        return 0;
+    }
+    // 到末尾时分两段写入
+    const auto start = size_t(h & mask);
+    const auto first = std::min(frames, capacity - start);
+    memcpy(data.data() + start * channels, samples, first * channels * sizeof(float));
+    memcpy(data.data(), samples + first * channels, (frames - first) * channels * sizeof(float));
+    head.store(h + frames, std::memory_order_release);
+    return frames;
+}
+
+RealtimeVisualizer_c::RealtimeVisualizer_c(const MediaxxVisualizerOptions& options) :
+    params(options) {
+    if (params.fftSize <= 0) {
+        params.fftSize = cDefFftSize;
+    }
+    params.fftSize = int(std::bit_ceil(unsigned(std::clamp(params.fftSize, 64, 8192))));
+    if (params.bandCount <= 0) {
+        params.bandCount = cDefBandCount;
+    }
+    params.bandCount = std::min(params.bandCount, MEDIAXX_VISUALIZER_MAX_BANDS);
+    params.bandCount = std::min(params.bandCount, params.fftSize / 2);
+    if (params.frameRate <= 0) {
+        params.frameRate = cDefFrameRate;
+    }
+    params.frameRate = std::min(params.frameRate, 240);
+    if (params.bufferMs <= 0) {
+        params.bufferMs = cDefBufferMs;
+    }
+    params.bufferMs = std::min(params.bufferMs, cMaxBufferMs);
+    if (params.minFreq <= 0) {
+        params.minFreq = cDefMinFreq;
+    }
+    if (params.maxFreq <= 0) {
+        params.maxFreq = params.sampleRate / 2.0f;
+    }
+}
+
+RealtimeVisualizer_c::~RealtimeVisualizer_c() {
+    {
+        std::lock_guard lock{mutex};
+        stopping = true;
+    }
+    cond.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+bool RealtimeVisualizer_c::start() {
+    assert(false == worker.joinable());
+    const auto& p = params;
+    if (false == analyzer.init(p.sampleRate, p.fftSize, p.bandCount, p.minFreq, p.maxFreq)) {
+        return false;
+    }
+    const auto bufferFrames = int64_t(params.sampleRate) * params.bufferMs / 1000;
+    ring.init(std::max(size_t(bufferFrames), size_t(params.fftSize)), params.channels);
+    history.assign(params.fftSize, 0.0f);
+    for (auto& snapshot : snapshots) {
+        snapshot.bandCount = params.bandCount;
+    }
+    worker = std::thread{[this] { run(); }};
+    return true;
+}
+
+void RealtimeVisualizer_c::run() {
+    using Clock         = std::chrono::steady_clock;
+    const auto interval = std::chrono::microseconds(1000000 / params.frameRate);
+
+    auto next = Clock::now();
+    while (true) {
+        next += interval;
+        // 落后超过一帧时（如系统休眠后）不补帧
+        if (const auto now = Clock::now(); next + interval < now) {
+            next = now + interval;
+        }
+        {
+            std::unique_lock lock{mutex};
+            if (cond.wait_until(lock, next, [this] { return stopping; })) {
+                return;
+            }
+        }
+        analyse();
+    }
+}
+
+void RealtimeVisualizer_c::appendSamples(
+    const float* samples,
+    size_t       frames,
+    float&       peak,
+    double&      squareSum
+) {
+    const auto channels = size_t(params.channels);
+    for (size_t i = 0; i < frames * channels; ++i) {
+        peak = std::max(peak, std::abs(samples[i]));
+        squareSum += double(samples[i]) * samples[i];
+    }
+
+    // 只有最后 [fftSize] 帧会进入窗口
+    const auto size = history.size();
+    if (frames > size) {
+        samples += (frames - size) * channels;
+        frames   = size;
+    }
+    std::memmove(history.data(), history.data() + frames, (size - frames) * sizeof(float));
+    auto       dst   = history.data() + (size - frames);
+    const auto scale = 1.0f / float(channels);
+    for (size_t i = 0; i < frames; ++i, samples += channels) {
+        float sum = 0;
+        for (size_t c = 0; c < channels; ++c) {
+            sum += samples[c];
+        }
+        dst[i] = sum * scale;
+    }
+}
+
+void RealtimeVisualizer_c::analyse() {
+    using Clock          = std::chrono::steady_clock;
+    const auto startTime = Clock::now();
+
+    float  peak      = 0;
+    double squareSum = 0;
+    size_t newFrames = 0;
+
+    const auto position = ring.consume([&](const float* samples, size_t frames) {
+        appendSamples(samples, frames, peak, squareSum);
+        newFrames += frames;
+    });
+    if (0 == newFrames) {
+        return;
+    }
+
+    auto& snapshot    = snapshots[back];
+    snapshot.sequence = ++sequence;
+    snapshot.position = position;
+    snapshot.peak     = std::min(peak, 1.0f);
+    snapshot.rms      = float(std::sqrt(squareSum / double(newFrames * params.channels)));
+    analyzer.process(history.data(), snapshot.bands);
+    const auto elapsed  = std::chrono::duration_cast<std::chrono::microseconds>(
+        Clock::now() - startTime
+    );
+    snapshot.analysisUs = int(elapsed.count());
+
+    // 发布到中间一份，换回上一次的中间一份继续写入
+    back = latest.exchange(back | cFreshBit, std::memory_order_acq_rel) & cIndexMask;
+}
+
+bool RealtimeVisualizer_c::poll(MediaxxVisualizerSnapshot& out) {
+    bool fresh = false;
+    if (0 != (latest.load(std::memory_order_relaxed) & cFreshBit)) {
+        front = latest.exchange(front, std::memory_order_acq_rel) & cIndexMask;
+        fresh = true;
+    }
+    out = snapshots[front];
+    return fresh;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "analyse/spectrum.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mediaxx.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// # 交错 PCM 的单生产者单消费者环形缓冲区
+/// - [write] 在生产者线程、[consume] 在消费者线程中调用，都不加锁也不分配内存
+/// - 写满后丢弃新写入的部分，不覆盖未取出的采样
+class PcmRing_c {
+public:
+
+    /// 在使用前调用；[capacityFrames] 向上取整为 2 的幂
+    void init(size_t capacityFrames, int channels);
+
+    /// 返回实际写入的帧数
+    size_t write(const float* samples, size_t frames);
+
+    /// 丢弃已写入但还未取出的采样，在生产者线程中调用
+    void reset() {
+        resetPos.store(head.load(std::memory_order_relaxed), std::memory_order_release);
+    }
+
+    /// 取出所有新的采样，按顺序以一到两段连续内存调用 [fn](samples, frames)
+    /// - 返回已写入的总帧数
+    template<typename Fn>
+    uint64_t consume(Fn&& fn) {
+        // 先读 [resetPos]：之后读到的 [head] 不小于它；[head] 先读时，两次读取之间写入并 [reset]
+        // 会使 [resetPos] 超过 [head]
+        const auto r = resetPos.load(std::memory_order_acquire);
+        const auto h = head.load(std::memory_order_acquire);
+        auto       t = tail.load(std::memory_order_relaxed);
+        t            = std::min(std::max(t, r), h);
+        while (t != h) {
+            const auto start  = size_t(t & mask);
+            const auto frames = std::min(size_t(h - t), capacity - start);
+            fn(data.data() + start * channels, frames);
+            t += frames;
+        }
+        tail.store(t, std::memory_order_release);
+        return h;
+    }
+
+protected:
+
+    std::vector<float> data{};
+    size_t             capacity = 0;
+    uint64_t           mask     = 0;
+    size_t             channels = 0;
+
+    // 生产者和消费者分别修改，放在不同的缓存行
+    alignas(64) std::atomic<uint64_t> head{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+    // [reset] 时的 [head]，消费者跳过之前的采样
+    alignas(64) std::atomic<uint64_t> resetPos{0};
+};
+
+/// # 实时可视化
+/// - 播放器推入 PCM 到 [PcmRing_c]，分析线程按固定帧率取出新的采样，更新峰值、RMS，
+///   并对最近的 [fftSize] 个采样（混为单声道）经 [SpectrumAnalyzer_c] 得到各频带的能量
+/// - 每次分析的工作量只与 [fftSize] 和缓冲区容量有关，积压的采样只统计峰值和 RMS
+/// - 结果写入三重缓冲区：分析线程和 [poll] 各持有一份，交换中间的一份，互不等待
+class RealtimeVisualizer_c {
+public:
+
+    static constexpr int   cDefFftSize   = 1024;
+    static constexpr int   cDefBandCount = 32;
+    static constexpr int   cDefFrameRate = 60;
+    static constexpr int   cDefBufferMs  = 500;
+    static constexpr float cDefMinFreq   = 20;
+
+    /// [options] 中为 0 的参数替换为默认值；[sampleRate]、[channels] 需要已检查
+    explicit RealtimeVisualizer_c(const MediaxxVisualizerOptions& options);
+
+    /// 停止并等待分析线程结束
+    ~RealtimeVisualizer_c();
+
+    RealtimeVisualizer_c(const RealtimeVisualizer_c&)            = delete;
+    RealtimeVisualizer_c& operator=(const RealtimeVisualizer_c&) = delete;
+
+    /// 分配缓冲区并启动分析线程，只能调用一次
+    bool start();
+
+    size_t push(const float* samples, size_t frames) {
+        return ring.write(samples, frames);
+    }
+
+    void reset() {
+        ring.reset();
+    }
+
+    /// 复制最新的结果到 [out]，返回是否是新的结果
+    bool poll(MediaxxVisualizerSnapshot& out);
+
+protected:
+
+    MediaxxVisualizerOptions params{};
+    PcmRing_c                ring{};
+    SpectrumAnalyzer_c       analyzer{};
+    // 最近的 [fftSize] 个单声道采样，最新的在末尾
+    std::vector<float>       history{};
+    uint64_t                 sequence = 0;
+
+    static constexpr uint8_t cIndexMask = 0x03;
+    static constexpr uint8_t cFreshBit  = 0x04;
+
+    std::array<MediaxxVisualizerSnapshot, 3> snapshots{};
+    // 中间一份的下标，[cFreshBit] 表示还未被 [poll] 取走
+    std::atomic<uint8_t>                     latest{1};
+    // 分析线程写入的一份
+    uint8_t                                  back  = 0;
+    // [poll] 读取的一份
+    uint8_t                                  front = 2;
+
+    bool                    stopping = false;
+    std::mutex              mutex{};
+    std::condition_variable cond{};
+    std::thread             worker{};
+
+    void run();
+
+    /// 取出新的采样并分析一次；没有新的采样时不更新结果
+    void analyse();
+
+    /// 统计 [samples] 的峰值和平方和，并混为单声道追加到 [history]
+    void appendSamples(const float* samples, size_t frames, float& peak, double& squareSum);
+};
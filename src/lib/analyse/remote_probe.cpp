@@ -0,0 +1,308 @@
+#include "remote_probe.h"
+#include "analyse/media_info_binary.h"
+#include "analyse/media_info_reader.h"
+#include "util/http_fetcher.h"
+#include "util/log.h"
+#include <condition_variable>
+#include <cstring>
+#include <map>
+
+RemoteProbe_c RemoteProbe_c::instance;
+
+// 自定义 AVIOContext 的缓冲区大小
+static constexpr int cIoBufferSize = 32 * 1024;
+
+namespace {
+    /// 已拉取的远程数据，按偏移分块保存
+    class RemoteSource {
+    public:
+
+        std::string      url{};
+        std::string      headers{};
+        RequestInterrupt interrupt{};
+        int64_t          totalSize = -1;
+        int64_t          pos       = 0;
+        // 偏移 -> 数据；新块总是从未命中的位置开始，因此最大的 <= pos 的块就是要找的块
+        std::map<int64_t, std::string> blocks{};
+
+        void addBlock(HttpRangeResult& result) {
+            if (totalSize < 0 && result.totalSize >= 0) {
+                totalSize = result.totalSize;
+            }
+            if (false == result.finalUrl.empty()) {
+                url = result.finalUrl;
+            }
+            if (false == result.data.empty()) {
+                blocks[result.offset] = std::move(result.data);
+            }
+        }
+
+        /// 在工作线程中同步补拉，返回 0 成功
+        int fetchSync(int64_t offset, int64_t length) {
+            struct Waiter {
+                std::mutex              mutex{};
+                std::condition_variable cond{};
+                bool                    done = false;
+                HttpRangeResult         result{};
+            };
+
+            auto waiter = std::make_shared<Waiter>();
+
+            HttpRangeRequest request{};
+            request.url       = url;
+            request.headers   = headers;
+            request.offset    = offset;
+            request.length    = length;
+            request.interrupt = interrupt;
+            request.onDone    = [waiter](HttpRangeResult&& result) {
+                std::lock_guard lock{waiter->mutex};
+                waiter->result = std::move(result);
+                waiter->done   = true;
+                waiter->cond.notify_one();
+            };
+            HttpFetcher_c::instance.fetch(std::move(request));
+
+            std::unique_lock lock{waiter->mutex};
+            waiter->cond.wait(lock, [&waiter] { return waiter->done; });
+            if (waiter->result.error != 0) {
+                LXX_DEBEG("RemoteSource::fetchSync failed: {} | {}", url, waiter->result.message);
+                return waiter->result.error;
+            }
+            addBlock(waiter->result);
+            return 0;
+        }
+
+        int read(uint8_t* buf, int size) {
+            if (totalSize >= 0 && pos >= totalSize) {
+                return AVERROR_EOF;
+            }
+            auto it = blocks.upper_bound(pos);
+            if (it == blocks.begin() || pos >= std::prev(it)->first + int64_t(std::prev(it)->second.size())) {
+                auto length = RemoteProbe_c::cReadAheadSize;
+                if (totalSize >= 0) {
+                    length = std::min(length, totalSize - pos);
+                }
+                const int err = fetchSync(pos, length);
+                if (err != 0) {
+                    return err == -2 ? AVERROR_EXIT : AVERROR(EIO);
+                }
+                it = blocks.upper_bound(pos);
+                if (it == blocks.begin()
+                    || pos >= std::prev(it)->first + int64_t(std::prev(it)->second.size())) {
+                    // 服务器没有返回数据，已到末尾
+                    return AVERROR_EOF;
+                }
+            }
+            const auto& [offset, data] = *std::prev(it);
+            const auto count = std::min<int64_t>(size, offset + int64_t(data.size()) - pos);
+            memcpy(buf, data.data() + (pos - offset), size_t(count));
+            pos += count;
+            return int(count);
+        }
+
+        int64_t seek(int64_t offset, int whence) {
+            switch (whence & ~AVSEEK_FORCE) {
+            case AVSEEK_SIZE:
+                return totalSize >= 0 ? totalSize : AVERROR(ENOSYS);
+            case SEEK_SET:
+                break;
+            case SEEK_CUR:
+                offset += pos;
+                break;
+            case SEEK_END:
+                if (totalSize < 0) {
+                    return AVERROR(ENOSYS);
+                }
+                offset += totalSize;
+                break;
+            default:
+                return AVERROR(EINVAL);
+            }
+            if (offset < 0) {
+                return AVERROR(EINVAL);
+            }
+            pos = offset;
+            return pos;
+        }
+
+        static int avRead(void* opaque, uint8_t* buf, int size) {
+            return static_cast<RemoteSource*>(opaque)->read(buf, size);
+        }
+
+        static int64_t avSeek(void* opaque, int64_t offset, int whence) {
+            return static_cast<RemoteSource*>(opaque)->seek(offset, whence);
+        }
+    };
+
+    /// 在工作线程中解析；[source] 为空时回退到 ffmpeg 自身的协议实现
+    RemoteProbeResult parse(
+        size_t                               index,
+        const std::string&                   url,
+        const std::string&                   headers,
+        const RequestInterrupt&              interrupt,
+        bool                                 binary,
+        unsigned int                         fieldMask,
+        int                                  maxTagSize,
+        const std::shared_ptr<RemoteSource>& source
+    ) {
+        RemoteProbeResult result{};
+        result.index = index;
+
+        AVIOContext* io = nullptr;
+        if (nullptr != source) {
+            auto buffer = static_cast<unsigned char*>(av_malloc(cIoBufferSize));
+            io          = avio_alloc_context(
+                buffer,
+                cIoBufferSize,
+                0,
+                source.get(),
+                &RemoteSource::avRead,
+                nullptr,
+                &RemoteSource::avSeek
+            );
+            if (nullptr == io) {
+                av_free(buffer);
+                result.log = "无法分配 AVIOContext";
+                return result;
+            }
+        }
+
+        auto item      = MediaInfoItem_c{nullptr != source ? source->url : url, nullptr};
+        item.interrupt = interrupt;
+        // 回退到 ffmpeg 时没有经过事件循环，从工作线程开始处理时计时
+        item.interrupt.startDeadline();
+        item.customIo  = io;
+        item.setFieldMask(fieldMask);
+        item.setMaxTagSize(maxTagSize);
+        if (MediaInfoReader_c::instance.openFile(item, headers)) {
+            if (binary) {
+                result.info = MediaInfoBinaryWriter_c::build(
+                    item.filepath,
+                    item.fmtCtx,
+                    item.fieldMask,
+                    item.maxTagSize
+                );
+            } else {
+                auto jsonsb = MediaInfoReader_c::instance.toInfoMap(item);
+                result.info = std::string{jsonsb.view().value_unsafe()};
+            }
+            result.ret = 0;
+        } else {
+            result.ret = item.isInterrupted() ? -2 : -1;
+        }
+        item.dispose();
+        if (nullptr != io) {
+            // avio_alloc_context 的缓冲区在读取过程中可能被替换，需要释放当前的
+            av_freep(&io->buffer);
+            avio_context_free(&io);
+        }
+        result.log = item.logView();
+        return result;
+    }
+} // namespace
+
+bool RemoteProbe_c::isSupported(std::string_view url) {
+    return HttpFetcher_c::instance.isAvail() && HttpFetcher_c::isSupportedUrl(url);
+}
+
+ThreadPool_c& RemoteProbe_c::workerPool() {
+    std::call_once(poolOnce, [this] {
+        pool = std::make_unique<ThreadPool_c>(ThreadPool_c::defaultThreadCount());
+    });
+    return *pool;
+}
+
+void RemoteProbe_c::probe(
+    size_t           index,
+    std::string_view url,
+    std::string_view headers,
+    RequestInterrupt interrupt,
+    bool             binary,
+    unsigned int     fieldMask,
+    int              maxTagSize,
+    Callback         onDone
+) {
+    auto& workers = workerPool();
+    if (false == isSupported(url)) {
+        workers.post([=, url = std::string{url}, headers = std::string{headers}] {
+            onDone(parse(index, url, headers, interrupt, binary, fieldMask, maxTagSize, nullptr));
+        });
+        return;
+    }
+
+    auto source       = std::make_shared<RemoteSource>();
+    source->url       = std::string{url};
+    source->headers   = std::string{headers};
+    source->interrupt = interrupt;
+
+    // 数据到齐后交给工作线程
+    auto schedule = [&workers, index, source, binary, fieldMask, maxTagSize, onDone](bool fallback) {
+        workers.post([index, source, binary, fieldMask, maxTagSize, onDone, fallback] {
+            onDone(parse(
+                index,
+                source->url,
+                source->headers,
+                source->interrupt,
+                binary,
+                fieldMask,
+                maxTagSize,
+                fallback ? nullptr : source
+            ));
+        });
+    };
+
+    HttpRangeRequest head{};
+    head.url       = source->url;
+    head.headers   = source->headers;
+    head.offset    = 0;
+    head.length    = cHeadSize;
+    head.interrupt = interrupt;
+    head.onDone    = [source, schedule, index, onDone, &workers](HttpRangeResult&& result) {
+        if (result.error == -2) {
+            workers.post([index, onDone, message = std::move(result.message)] {
+                RemoteProbeResult cancelled{};
+                cancelled.index = index;
+                cancelled.ret   = -2;
+                cancelled.log   = message;
+                onDone(std::move(cancelled));
+            });
+            return;
+        }
+        if (result.error != 0) {
+            source->interrupt.deadlineUs = result.deadlineUs;
+            // 重定向到 https、连接失败等，交给 ffmpeg 重试并给出具体错误
+            LXX_DEBEG("RemoteProbe_c head failed, fallback: {} | {}", source->url, result.message);
+            schedule(true);
+            return;
+        }
+        // 尾部、补拉和解析沿用头部开始连接时确定的截止时间
+        source->interrupt.deadlineUs = result.deadlineUs;
+        const bool rangeUnsupported  = (result.status == 200);
+        source->addBlock(result);
+        if (rangeUnsupported && (source->totalSize < 0 || source->totalSize > cHeadSize)) {
+            // 服务器不支持范围请求，无法随机读取，由 ffmpeg 顺序读取
+            schedule(true);
+            return;
+        }
+        if (source->totalSize <= cHeadSize + cTailSize) {
+            schedule(false);
+            return;
+        }
+        // 头部到齐后紧接着拉取尾部：此时已知文件大小，且重定向已经解析，解析阶段不再需要等待网络
+        HttpRangeRequest tail{};
+        tail.url       = source->url;
+        tail.headers   = source->headers;
+        tail.offset    = source->totalSize - cTailSize;
+        tail.length    = cTailSize;
+        tail.interrupt = source->interrupt;
+        tail.onDone    = [source, schedule](HttpRangeResult&& result) {
+            // 尾部失败不影响解析，缺失的部分会在解析时补拉
+            if (result.error == 0) {
+                source->addBlock(result);
+            }
+            schedule(false);
+        };
+        HttpFetcher_c::instance.fetch(std::move(tail));
+    };
+    HttpFetcher_c::instance.fetch(std::move(head));
+}
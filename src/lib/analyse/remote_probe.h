@@ -0,0 +1,65 @@
+#pragma once
+
+#include "util/cancel_token.h"
+#include "util/thread_pool.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+struct RemoteProbeResult {
+    // 调用方传入的下标，原样返回
+    size_t      index = 0;
+    // 0 成功，-1 失败，-2 取消或超时
+    int         ret   = -1;
+    // [MediaInfoReader_c::toInfoMap] 的 json，或 [MediaInfoBinaryWriter_c] 的二进制数据
+    std::string info{};
+    std::string log{};
+};
+
+/// # 远程地址的并发探测
+/// - 网络读取由 [HttpFetcher_c] 的事件循环完成：先并发拉取文件头部和尾部，数据到齐后才交给工作线程解析，
+///   等待网络期间不占用任何工作线程
+/// - 解析时通过自定义 `AVIOContext` 读取已拉取的数据；超出范围的读取（如位于中部的 moov）会在工作线程中同步补拉
+/// - 不支持的地址（https、其他协议）或服务器不支持范围请求时，在工作线程中回退到 ffmpeg 自身的协议实现
+class RemoteProbe_c {
+public:
+
+    // 首次拉取的头部长度
+    inline static constexpr int64_t cHeadSize      = 256 * 1024;
+    // 同时拉取的尾部长度，覆盖 ID3v1/APE 标签和尾部的 moov
+    inline static constexpr int64_t cTailSize      = 64 * 1024;
+    // 解析时缓存未命中，单次补拉的长度
+    inline static constexpr int64_t cReadAheadSize = 256 * 1024;
+
+    using Callback = std::function<void(RemoteProbeResult&&)>;
+
+    static RemoteProbe_c instance;
+
+    /// 是否可以走事件循环
+    static bool isSupported(std::string_view url);
+
+    /// 提交探测，完成后在工作线程中调用 [onDone]；[interrupt] 中的取消句柄必须在回调之前保持有效
+    /// - [interrupt] 可以用 [RequestInterrupt::deferTimeout]，从开始连接（回退时从开始解析）时计时
+    /// - [binary] 为 true 时结果为二进制格式；[fieldMask] 见 [MediaInfoItem_c::setFieldMask]，
+    ///   [maxTagSize] 见 [MediaInfoItem_c::setMaxTagSize]
+    void probe(
+        size_t           index,
+        std::string_view url,
+        std::string_view headers,
+        RequestInterrupt interrupt,
+        bool             binary,
+        unsigned int     fieldMask,
+        int              maxTagSize,
+        Callback         onDone
+    );
+
+protected:
+
+    std::once_flag                poolOnce{};
+    std::unique_ptr<ThreadPool_c> pool{};
+
+    ThreadPool_c& workerPool();
+};
@@ -0,0 +1,342 @@
+#include "rhythm_analyzer.h"
+#include "analyse/audio_decoder.h"
+#include "analyse/spectrum.h"
+#include "util/log.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+RhythmAnalyzer_c RhythmAnalyzer_c::instance = RhythmAnalyzer_c();
+
+namespace {
+    constexpr int   cSampleRate      = 11025;
+    // 分析窗口的长度
+    constexpr int   cWindowSeconds   = 60;
+    // 起音包络：约 93ms 的窗，步长约 23ms（约 43 帧/秒）
+    constexpr int   cOnsetFftSize    = 1024;
+    constexpr int   cOnsetBandCount  = 24;
+    constexpr float cOnsetMinFreq    = 30;
+    constexpr float cOnsetMaxFreq    = 5000;
+    constexpr int   cHopSize         = 256;
+    // 频带能量的下限（dBFS），避免静音段的噪声产生起音
+    constexpr float cOnsetFloorDb    = -80;
+    // 减去的局部均值的半径（帧），约 0.37s
+    constexpr int   cOnsetMeanRadius = 8;
+    // 色度：约 372ms 的窗，分辨率约 2.7Hz；每 4 个步长计算一次
+    constexpr int   cChromaFftSize   = 4096;
+    constexpr int   cChromaEvery     = 4;
+    constexpr float cChromaMinFreq   = 65;
+    constexpr float cChromaMaxFreq   = 2100;
+
+    // 节拍的范围和先验
+    constexpr double cMinBpm          = 60;
+    constexpr double cMaxBpm          = 200;
+    constexpr double cBpmStep         = 0.1;
+    constexpr double cPriorBpm        = 120;
+    // 先验的标准差（倍频程）
+    constexpr double cPriorOctaves    = 1.0;
+    // 梳状加权的周期倍数
+    constexpr int    cCombCount       = 4;
+    // 包络短于该时长时不估计节拍
+    constexpr int    cMinTempoSeconds = 6;
+
+    // Krumhansl-Kessler 调性模板，从主音开始
+    constexpr std::array<double, 12> cMajorProfile
+        = {6.35, 2.23, 3.48, 2.33, 4.38, 4.09, 2.52, 5.19, 2.39, 3.66, 2.29, 2.88};
+    constexpr std::array<double, 12> cMinorProfile
+        = {6.33, 2.68, 3.52, 5.38, 2.60, 3.53, 2.54, 4.75, 3.98, 2.69, 3.34, 3.17};
+
+    constexpr std::array<std::string_view, 24> cKeyNames = {
+        "C major",  "C# major", "D major",  "Eb major", "E major",  "F major",
+        "F# major", "G major",  "Ab major", "A major",  "Bb major", "B major",
+        "C minor",  "C# minor", "D minor",  "Eb minor", "E minor",  "F minor",
+        "F# minor", "G minor",  "Ab minor", "A minor",  "Bb minor", "B minor",
+    };
+    constexpr std::array<std::string_view, 24> cCamelot = {
+        "8B", "3B", "10B", "5B", "12B", "7B", "2B", "9B", "4B", "11B", "6B", "1B",
+        "5A", "12A", "7A", "2A", "9A", "4A", "11A", "6A", "1A", "8A", "3A", "10A",
+    };
+
+    /// 减去局部均值后半波整流，再减去整体均值，供自相关使用
+    void normalizeOnset(std::vector<float>& onset) {
+        const auto         n = onset.size();
+        std::vector<float> prefix(n + 1, 0.0f);
+        for (size_t i = 0; i < n; ++i) {
+            prefix[i + 1] = prefix[i] + onset[i];
+        }
+        double sum = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const auto lo   = i > size_t(cOnsetMeanRadius) ? i - cOnsetMeanRadius : 0;
+            const auto hi   = std::min(n, i + cOnsetMeanRadius + 1);
+            const auto mean = (prefix[hi] - prefix[lo]) / float(hi - lo);
+            onset[i]        = std::max(onset[i] - mean, 0.0f);
+            sum += onset[i];
+        }
+        const auto mean = float(sum / double(n));
+        for (auto& value : onset) {
+            value -= mean;
+        }
+    }
+
+    /// 归一化的自相关，[0] 为 1；包络为常数时返回空
+    std::vector<double> autocorrelate(const std::vector<float>& onset, size_t maxLag) {
+        const auto          n = onset.size();
+        std::vector<double> result(maxLag + 1, 0.0);
+        for (size_t lag = 0; lag <= maxLag && lag < n; ++lag) {
+            const auto a   = onset.data();
+            const auto b   = onset.data() + lag;
+            float      sum = 0;
+            for (size_t i = 0; i < n - lag; ++i) {
+                sum += a[i] * b[i];
+            }
+            // 无偏估计，长周期不因重叠变短而吃亏
+            result[lag] = double(sum) / double(n - lag);
+        }
+        if (result[0] <= 0) {
+            return {};
+        }
+        const auto energy = result[0];
+        for (auto& value : result) {
+            value /= energy;
+        }
+        return result;
+    }
+
+    /// 在小数周期上线性插值
+    double lagValue(const std::vector<double>& acf, double lag) {
+        const auto index = size_t(lag);
+        if (index + 1 >= acf.size()) {
+            return 0;
+        }
+        const auto frac = lag - double(index);
+        return acf[index] * (1.0 - frac) + acf[index + 1] * frac;
+    }
+
+    /// 整数周期之间的线性插值有偏差，误差约 1%；在 [cCombCount] 倍周期附近找自相关的峰，
+    /// 抛物线插值后除以倍数，误差缩小到约 1/[cCombCount]
+    double refineLag(const std::vector<double>& acf, double lag) {
+        const auto center = long(std::lround(lag * cCombCount));
+        const auto last   = long(acf.size()) - 2;
+        if (center - 2 < 1 || center + 2 > last) {
+            return lag;
+        }
+        long peak = center;
+        for (long i = center - 2; i <= center + 2; ++i) {
+            if (acf[i] > acf[peak]) {
+                peak = i;
+            }
+        }
+        const auto left   = acf[peak - 1];
+        const auto right  = acf[peak + 1];
+        const auto denom  = left - 2.0 * acf[peak] + right;
+        const auto offset = (denom < 0) ? std::clamp(0.5 * (left - right) / denom, -0.5, 0.5) : 0.0;
+        const auto result = (double(peak) + offset) / cCombCount;
+        // 峰不明显时可能落到相邻的周期上，偏离太多时不采用
+        return std::abs(result - lag) <= lag * 0.02 ? result : lag;
+    }
+
+    void estimateTempo(std::vector<float>& onset, double frameRate, RhythmInfo& out) {
+        if (onset.size() < size_t(frameRate * cMinTempoSeconds)) {
+            return;
+        }
+        normalizeOnset(onset);
+        // 留出 [refineLag] 搜索的余量
+        const auto maxLag = size_t(std::ceil(60.0 * frameRate / cMinBpm * cCombCount)) + 3;
+        const auto acf    = autocorrelate(onset, maxLag);
+        if (acf.empty()) {
+            return;
+        }
+
+        double bestScore = 0;
+        double bestBpm   = 0;
+        for (double bpm = cMinBpm; bpm <= cMaxBpm; bpm += cBpmStep) {
+            const auto lag   = 60.0 * frameRate / bpm;
+            double     score = 0;
+            for (int k = 1; k <= cCombCount; ++k) {
+                score += std::max(lagValue(acf, lag * k), 0.0) / k;
+            }
+            const auto octaves = std::log2(bpm / cPriorBpm) / cPriorOctaves;
+            score *= std::exp(-0.5 * octaves * octaves);
+            if (score > bestScore) {
+                bestScore = score;
+                bestBpm   = bpm;
+            }
+        }
+        if (bestBpm <= 0) {
+            return;
+        }
+        const auto lag    = 60.0 * frameRate / bestBpm;
+        out.bpm           = 60.0 * frameRate / refineLag(acf, lag);
+        out.bpmConfidence = std::clamp(lagValue(acf, lag), 0.0, 1.0);
+    }
+
+    /// 皮尔逊相关系数
+    double correlate(const std::array<double, 12>& chroma, const std::array<double, 12>& profile) {
+        double meanA = 0, meanB = 0;
+        for (size_t i = 0; i < 12; ++i) {
+            meanA += chroma[i];
+            meanB += profile[i];
+        }
+        meanA /= 12;
+        meanB /= 12;
+        double cov = 0, varA = 0, varB = 0;
+        for (size_t i = 0; i < 12; ++i) {
+            const auto a = chroma[i] - meanA;
+            const auto b = profile[i] - meanB;
+            cov += a * b;
+            varA += a * a;
+            varB += b * b;
+        }
+        return (varA > 0 && varB > 0) ? cov / std::sqrt(varA * varB) : 0;
+    }
+
+    void estimateKey(const std::array<double, 12>& chroma, RhythmInfo& out) {
+        double bestCorr = 0;
+        for (int tonic = 0; tonic < 12; ++tonic) {
+            // 把以 [tonic] 为主音的模板旋转到 C 开始的色度上
+            std::array<double, 12> major{};
+            std::array<double, 12> minor{};
+            for (int i = 0; i < 12; ++i) {
+                major[(tonic + i) % 12] = cMajorProfile[i];
+                minor[(tonic + i) % 12] = cMinorProfile[i];
+            }
+            const auto majorCorr = correlate(chroma, major);
+            const auto minorCorr = correlate(chroma, minor);
+            if (majorCorr > bestCorr) {
+                bestCorr = majorCorr;
+                out.key  = tonic;
+            }
+            if (minorCorr > bestCorr) {
+                bestCorr = minorCorr;
+                out.key  = tonic + 12;
+            }
+        }
+        out.keyConfidence = std::min(bestCorr, 1.0);
+    }
+} // namespace
+
+std::string_view RhythmAnalyzer_c::keyName(int key) {
+    return (key >= 0 && key < int(cKeyNames.size())) ? cKeyNames[key] : std::string_view{};
+}
+
+std::string_view RhythmAnalyzer_c::camelot(int key) {
+    return (key >= 0 && key < int(cCamelot.size())) ? cCamelot[key] : std::string_view{};
+}
+
+int RhythmAnalyzer_c::analyse(MediaInfoItem_c& item, std::string_view headers, RhythmInfo& out) {
+    // 解码需要完整的流参数
+    item.probeStreams = true;
+    if (false == MediaInfoReader_c::instance.openFile(item, headers)) {
+        return item.isInterrupted() ? -2 : -1;
+    }
+    AudioDecoder_c decoder{};
+    if (false == decoder.open(item, cSampleRate, 1)) {
+        return 0;
+    }
+    SpectrumAnalyzer_c onsetAnalyzer{};
+    SpectrumAnalyzer_c chromaAnalyzer{};
+    // 色度只用 [SpectrumAnalyzer_c::power]，频带不使用
+    const bool inited
+        = onsetAnalyzer.init(
+              cSampleRate, cOnsetFftSize, cOnsetBandCount, cOnsetMinFreq, cOnsetMaxFreq
+          )
+          && chromaAnalyzer.init(cSampleRate, cChromaFftSize, 1, cChromaMinFreq, cChromaMaxFreq);
+    if (false == inited) {
+        const int avError = (0 != onsetAnalyzer.initError()) ? onsetAnalyzer.initError()
+                                                              : chromaAnalyzer.initError();
+        item.setError(MEDIAXX_DIAG_STAGE_AUDIO, MEDIAXX_DIAG_ERR_NO_MEMORY, avError);
+        return 0;
+    }
+
+    // 曲目比窗口长时跳转到中间；跳转失败时从头开始（错误已记录）
+    const auto windowFrames = int64_t(cSampleRate) * cWindowSeconds;
+    const auto totalFrames  = decoder.estimatedFrames();
+    if (totalFrames > windowFrames) {
+        decoder.seek((totalFrames - windowFrames) / 2);
+    }
+
+    // 每个 FFT 下标对应的音高类，超出范围的为 -1
+    const auto          binCount = size_t(cChromaFftSize / 2 + 1);
+    std::vector<int8_t> pitchClass(binCount, -1);
+    for (size_t k = 1; k < binCount; ++k) {
+        const auto freq = float(k) * cSampleRate / cChromaFftSize;
+        if (freq >= cChromaMinFreq && freq <= cChromaMaxFreq) {
+            pitchClass[k] = int8_t(SpectrumAnalyzer_c::pitchClass(freq));
+        }
+    }
+
+    // 最近的 [cChromaFftSize] 个采样，起音使用其末尾的 [cOnsetFftSize] 个
+    std::vector<float>     window(cChromaFftSize, 0.0f);
+    std::vector<float>     bandDb(cOnsetBandCount);
+    std::vector<float>     prevDb(cOnsetBandCount, cOnsetFloorDb);
+    std::vector<float>     onset{};
+    std::array<double, 12> chroma{};
+    onset.reserve(size_t(windowFrames / cHopSize) + 1);
+
+    const auto onsetInput = window.data() + (cChromaFftSize - cOnsetFftSize);
+    const auto tail       = window.data() + (cChromaFftSize - cHopSize);
+    int64_t    decoded    = 0;
+    for (size_t hop = 0; decoded < windowFrames; ++hop) {
+        std::memmove(
+            window.data(),
+            window.data() + cHopSize,
+            (cChromaFftSize - cHopSize) * sizeof(float)
+        );
+        const auto filled = std::max(decoder.read(tail, cHopSize), 0);
+        if (0 == filled) {
+            break;
+        }
+        std::fill(tail + filled, tail + cHopSize, 0.0f);
+        decoded += filled;
+
+        if (decoded >= cOnsetFftSize) {
+            onsetAnalyzer.process(onsetInput, bandDb.data());
+            float flux = 0;
+            for (int b = 0; b < cOnsetBandCount; ++b) {
+                const auto db = std::max(bandDb[b], cOnsetFloorDb);
+                flux += std::max(db - prevDb[b], 0.0f);
+                prevDb[b] = db;
+            }
+            onset.push_back(flux);
+        }
+        if (decoded >= cChromaFftSize && 0 == hop % cChromaEvery) {
+            const auto power = chromaAnalyzer.power(window.data());
+            // 用幅度而不是功率，避免少数强音主导；每帧归一化，响度不影响权重
+            std::array<float, 12> frame{};
+            float                 total = 0;
+            for (size_t k = 1; k < binCount; ++k) {
+                if (pitchClass[k] >= 0) {
+                    const auto magnitude = std::sqrt(power[k]);
+                    frame[pitchClass[k]] += magnitude;
+                    total += magnitude;
+                }
+            }
+            if (total > 1e-3f) {
+                for (size_t i = 0; i < 12; ++i) {
+                    chroma[i] += frame[i] / total;
+                }
+            }
+        }
+    }
+    if (item.isInterrupted()) {
+        return -2;
+    }
+    if (0 == decoded) {
+        item.setError(MEDIAXX_DIAG_STAGE_AUDIO, MEDIAXX_DIAG_ERR_DECODE);
+        return 0;
+    }
+
+    estimateTempo(onset, double(cSampleRate) / cHopSize, out);
+    estimateKey(chroma, out);
+    LXX_DEBEG(
+        "RhythmAnalyzer | {:.1f} BPM ({:.2f}), {} ({:.2f}): {}",
+        out.bpm,
+        out.bpmConfidence,
+        keyName(out.key),
+        out.keyConfidence,
+        item.filepath
+    );
+    return 1;
+}
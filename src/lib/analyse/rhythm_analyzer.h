@@ -0,0 +1,44 @@
+#pragma once
+
+#include "analyse/media_info_reader.h"
+#include <string_view>
+
+/// 节拍和调性的分析结果
+struct RhythmInfo {
+    /// 每分钟拍数，0 表示无法确定
+    double bpm           = 0;
+    /// 0~1，起音包络在该周期上的归一化自相关
+    double bpmConfidence = 0;
+    /// 0~11 为 C~B 大调，12~23 为 C~B 小调，-1 表示无法确定
+    int    key           = -1;
+    /// 0~1，色度与调性模板的相关系数
+    double keyConfidence = 0;
+};
+
+/// # 节拍（BPM）和调性检测
+/// - 只解码一个有限的窗口：跳转到中间前后共 60s，时长未知或不能跳转时从当前位置开始；
+///   重采样为 11025Hz 单声道，解码和分析的开销与曲目时长无关
+/// - 起音包络：短窗 FFT 按对数频带求 dB，相邻帧正向差分之和减去局部均值；
+///   对包络求自相关，在 60~200 BPM 内按整数倍周期梳状加权并乘以以 120 BPM 为中心的先验，
+///   以 0.1 BPM 的步长取最大值
+/// - 调性：长窗 FFT 的功率按音高类（12 平均律，A4 = 440Hz）累计为色度，
+///   与 Krumhansl-Schmuckler 的 24 个调性模板求相关，取最大者
+/// - FFT 使用 av_tx（各平台有 SIMD 实现），其余是连续内存上的简单循环，由编译器自动向量化
+class RhythmAnalyzer_c {
+public:
+
+    static RhythmAnalyzer_c instance;
+
+    RhythmAnalyzer_c() {}
+
+    ~RhythmAnalyzer_c() {}
+
+    /// 返回值同 [mediaxx_get_audio_visualization]；节拍和调性可能只有一个能确定
+    int analyse(MediaInfoItem_c& item, std::string_view headers, RhythmInfo& out);
+
+    /// 调性的名称，如 `C major`、`F# minor`；[key] 无效时为空
+    static std::string_view keyName(int key);
+
+    /// Camelot 记法，如 `8B`、`8A`（C 大调、A 小调），用于 DJ 的和声混音；[key] 无效时为空
+    static std::string_view camelot(int key);
+};
@@ -0,0 +1,203 @@
+#include "scan_order.h"
+#include "util/log.h"
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+
+#if _ISLINUX || _ISANDROID
+#include <fcntl.h>
+#include <fstream>
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+namespace {
+    struct DiskKey {
+        uint64_t dev         = 0;
+        uint64_t inode       = 0;
+        uint64_t physical    = 0;
+        bool     hasPhysical = false;
+        bool     valid       = false;
+    };
+
+    enum class DiskKind {
+        Unknown,
+        Rotational,
+        NonRotational,
+    };
+
+    DiskKind readDiskKind(uint64_t dev) {
+        if (major(dev) == 0) {
+            // 网络文件系统(NFS/SMB)等没有块设备，通常背后是机械硬盘，按 inode 排序即可
+            return DiskKind::Unknown;
+        }
+        const auto base = std::string{"/sys/dev/block/"}
+                              .append(std::to_string(major(dev)))
+                              .append(":")
+                              .append(std::to_string(minor(dev)));
+        // 分区没有 queue 目录，需要读取所在磁盘的
+        for (const auto& path : {base + "/queue/rotational", base + "/../queue/rotational"}) {
+            std::ifstream file{path};
+            int           value = -1;
+            if (file.is_open() && (file >> value)) {
+                return value == 0 ? DiskKind::NonRotational : DiskKind::Rotational;
+            }
+        }
+        // 有块设备但读不到属性（如安卓限制访问 /sys），当作闪存处理，不改变顺序
+        return DiskKind::NonRotational;
+    }
+
+    bool readFirstPhysicalOffset(int fd, uint64_t& physical) {
+        alignas(struct fiemap) char buffer[sizeof(struct fiemap) + sizeof(struct fiemap_extent)]{};
+        auto                        fm = reinterpret_cast<struct fiemap*>(buffer);
+        fm->fm_start                   = 0;
+        fm->fm_length                  = FIEMAP_MAX_OFFSET;
+        fm->fm_extent_count            = 1;
+        if (ioctl(fd, FS_IOC_FIEMAP, fm) != 0 || fm->fm_mapped_extents == 0) {
+            return false;
+        }
+        const auto& extent = fm->fm_extents[0];
+        if (extent.fe_flags & (FIEMAP_EXTENT_UNKNOWN | FIEMAP_EXTENT_DELALLOC)) {
+            // 尚未落盘或位置未知
+            return false;
+        }
+        physical = extent.fe_physical;
+        return true;
+    }
+
+    /// 只 stat，不打开文件
+    DiskKey readDiskKey(const std::string& path) {
+        DiskKey     key{};
+        struct stat st{};
+        if (0 == stat(path.c_str(), &st) && S_ISREG(st.st_mode)) {
+            key.valid = true;
+            key.dev   = st.st_dev;
+            key.inode = st.st_ino;
+        }
+        return key;
+    }
+
+    bool readPhysicalOffset(const std::string& path, uint64_t& physical) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NOCTTY);
+        if (fd < 0) {
+            return false;
+        }
+        const bool ret = readFirstPhysicalOffset(fd, physical);
+        close(fd);
+        return ret;
+    }
+} // namespace
+
+std::vector<size_t>
+    ScanOrder_c::sortByDiskLocality(const std::vector<std::string>& paths, ScanOrderMode mode) {
+    std::vector<size_t> order(paths.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (mode == ScanOrderMode::Input || paths.size() < 2) {
+        return order;
+    }
+
+    std::vector<DiskKey> keys{};
+    keys.reserve(paths.size());
+    for (const auto& path : paths) {
+        keys.push_back(readDiskKey(path));
+    }
+
+    // 按设备分组：设备首次出现的顺序、是否需要排序、是否全部支持 FIEMAP
+    struct DevInfo {
+        size_t firstSeen;
+        bool   sortable;
+        bool   usePhysical;
+    };
+
+    std::unordered_map<uint64_t, DevInfo> devs{};
+    bool                                  anySortable = false;
+    for (const auto& key : keys) {
+        if (false == key.valid) {
+            continue;
+        }
+        if (false == devs.contains(key.dev)) {
+            const bool sortable = (mode == ScanOrderMode::Force)
+                               || (readDiskKind(key.dev) != DiskKind::NonRotational);
+            devs.emplace(key.dev, DevInfo{devs.size(), sortable, true});
+            anySortable = anySortable || sortable;
+        }
+    }
+    if (false == anySortable) {
+        // 全部在 SSD 上，保持原有顺序
+        return order;
+    }
+
+    // 只对需要排序的设备上的文件打开并读取 FIEMAP，SSD 上的文件只有一次 stat；
+    // 同一设备有一个文件不支持时整个设备按 inode 排序，其余文件不再读取
+    for (size_t i = 0; i < paths.size(); ++i) {
+        auto& key = keys[i];
+        if (false == key.valid) {
+            continue;
+        }
+        auto& dev = devs[key.dev];
+        if (dev.sortable && dev.usePhysical) {
+            key.hasPhysical = readPhysicalOffset(paths[i], key.physical);
+            dev.usePhysical = key.hasPhysical;
+        }
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        const auto& ka = keys[a];
+        const auto& kb = keys[b];
+        // 无法读取的文件放到最后，它们会很快失败
+        if (ka.valid != kb.valid) {
+            return ka.valid;
+        }
+        if (false == ka.valid) {
+            return false;
+        }
+        const auto& da = devs[ka.dev];
+        const auto& db = devs[kb.dev];
+        if (da.firstSeen != db.firstSeen) {
+            return da.firstSeen < db.firstSeen;
+        }
+        if (false == da.sortable) {
+            return false;
+        }
+        if (da.usePhysical) {
+            return ka.physical < kb.physical;
+        }
+        return ka.inode < kb.inode;
+    });
+    LXX_DEBEG("ScanOrder_c::sortByDiskLocality: {} files, {} devices", paths.size(), devs.size());
+    return order;
+}
+
+void ScanOrder_c::prefetchHeadTail(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NOCTTY);
+    if (fd < 0) {
+        return;
+    }
+    struct stat st{};
+    if (0 == fstat(fd, &st) && S_ISREG(st.st_mode)) {
+        const int64_t size = st.st_size;
+        // 只提交异步预读，不等待完成；关闭 fd 不影响已提交的预读
+        posix_fadvise(fd, 0, std::min(size, cHeadPrefetchSize), POSIX_FADV_WILLNEED);
+        if (size > cHeadPrefetchSize) {
+            const auto tailStart = std::max(cHeadPrefetchSize, size - cTailPrefetchSize);
+            posix_fadvise(fd, tailStart, size - tailStart, POSIX_FADV_WILLNEED);
+        }
+    }
+    close(fd);
+}
+
+#else
+
+std::vector<size_t>
+    ScanOrder_c::sortByDiskLocality(const std::vector<std::string>& paths, ScanOrderMode mode) {
+    std::vector<size_t> order(paths.size());
+    std::iota(order.begin(), order.end(), 0);
+    return order;
+}
+
+void ScanOrder_c::prefetchHeadTail(const std::string& path) {}
+
+#endif
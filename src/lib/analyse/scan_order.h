@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// 批量扫描的排序方式
+enum class ScanOrderMode : int {
+    // 保持输入顺序
+    Input = 0,
+    // 仅对机械硬盘/网络存储按磁盘位置排序，SSD 保持输入顺序
+    Auto  = 1,
+    // 总是按磁盘位置排序
+    Force = 2,
+};
+
+/// # 批量扫描的磁盘局部性排序
+/// - 机械硬盘上按目录列举顺序读取会频繁寻道，这里按文件在磁盘上的物理位置排序
+/// - 优先使用 `FIEMAP` 获取首个 extent 的物理偏移，不支持时退化为 inode 顺序
+/// - 仅 Linux/Android 生效，其他平台保持输入顺序
+class ScanOrder_c {
+public:
+
+    // 预读文件头部的长度，覆盖大部分容器的头部和 ID3v2/内嵌封面
+    inline static constexpr int64_t cHeadPrefetchSize = 512 * 1024;
+    // 预读文件尾部的长度，覆盖 ID3v1/APE 标签和尾部的 moov
+    inline static constexpr int64_t cTailPrefetchSize = 128 * 1024;
+
+    /// 返回排序后的下标列表
+    static std::vector<size_t>
+        sortByDiskLocality(const std::vector<std::string>& paths, ScanOrderMode mode);
+
+    /// 同时提交文件头部和尾部的异步预读，让 IO 调度器在一次磁头移动中完成
+    static void prefetchHeadTail(const std::string& path);
+};
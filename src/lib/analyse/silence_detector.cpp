@@ -0,0 +1,177 @@
+#include "silence_detector.h"
+#include "analyse/audio_decoder.h"
+#include "util/log.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+SilenceDetector_c SilenceDetector_c::instance = SilenceDetector_c();
+
+namespace {
+    // 每次解码的帧数
+    constexpr int     cReadFrames   = 8192;
+    // 结尾的窗口全是静音时，每次向前扩大的倍数
+    constexpr int64_t cWindowGrowth = 4;
+
+    /// 顺序读取并记录超过阈值的帧
+    class LoudScanner {
+    public:
+
+        LoudScanner(AudioDecoder_c& in_decoder, float in_threshold)
+            : decoder(in_decoder),
+              threshold(in_threshold),
+              channels(size_t(in_decoder.channels())),
+              buffer(size_t(cReadFrames) * in_decoder.channels()) {}
+
+        int64_t first = -1;
+        int64_t last  = -1;
+
+        /// 读取一次，返回读取的帧数，0 表示已结束或出错
+        int read(int maxFrames = cReadFrames) {
+            const auto base   = decoder.position();
+            const auto ret    = decoder.read(buffer.data(), std::min(maxFrames, cReadFrames));
+            const auto frames = std::max(ret, 0);
+            const auto count  = size_t(frames) * channels;
+            const auto data   = buffer.data();
+
+            size_t head = 0;
+            while (head < count && std::abs(data[head]) <= threshold) {
+                ++head;
+            }
+            if (head == count) {
+                return frames;
+            }
+            size_t tail = count;
+            while (std::abs(data[tail - 1]) <= threshold) {
+                --tail;
+            }
+            if (first < 0) {
+                first = base + int64_t(head / channels);
+            }
+            last = base + int64_t((tail - 1) / channels);
+            return frames;
+        }
+
+        /// 读取到第 [until] 帧（不含）或结束
+        void readUntil(int64_t until) {
+            while (decoder.position() < until) {
+                const auto remain = until - decoder.position();
+                if (0 == read(int(std::min<int64_t>(remain, cReadFrames)))) {
+                    return;
+                }
+            }
+        }
+
+        /// 读取到结束，返回读取的帧数
+        int64_t readToEnd() {
+            int64_t total = 0;
+            while (const auto frames = read()) {
+                total += frames;
+            }
+            return total;
+        }
+
+    protected:
+
+        AudioDecoder_c&    decoder;
+        float              threshold;
+        size_t             channels;
+        std::vector<float> buffer;
+    };
+} // namespace
+
+int SilenceDetector_c::detect(
+    MediaInfoItem_c& item,
+    std::string_view headers,
+    float            thresholdDb,
+    int              windowMs,
+    SilenceInfo&     out
+) {
+    thresholdDb = (thresholdDb < 0) ? thresholdDb : cDefThresholdDb;
+    windowMs    = (windowMs > 0) ? windowMs : cDefWindowMs;
+
+    // 解码需要完整的流参数
+    item.probeStreams = true;
+    if (false == MediaInfoReader_c::instance.openFile(item, headers)) {
+        return item.isInterrupted() ? -2 : -1;
+    }
+    AudioDecoder_c decoder{};
+    if (false == decoder.open(item)) {
+        return 0;
+    }
+    out.sampleRate          = decoder.sampleRate();
+    const auto windowFrames = int64_t(out.sampleRate) * windowMs / 1000;
+    const auto threshold    = std::pow(10.0f, thresholdDb / 20.0f);
+    LoudScanner scanner{decoder, threshold};
+
+    // 开头：至少读取一个窗口，直到找到有声的帧
+    bool eof = false;
+    while (false == eof && (decoder.position() < windowFrames || scanner.first < 0)) {
+        eof = (0 == scanner.read());
+    }
+    const auto headEnd = decoder.position();
+
+    // 结尾：从倒数一个窗口读到结束，全是静音时向前扩大窗口，补读到上一次的起点
+    int64_t tailLast = -1;
+    auto    span     = windowFrames;
+    auto    scanEnd  = int64_t(-1);
+    while (false == eof) {
+        const auto tailStart = std::max(headEnd, decoder.estimatedFrames() - span);
+        if (tailStart != decoder.position() && false == decoder.seek(tailStart)) {
+            if (scanEnd < 0) {
+                // 不能跳转，从开头读取的位置顺序读完
+                scanner.readToEnd();
+                tailLast        = scanner.last;
+                out.totalFrames = decoder.position();
+            } else {
+                // 已知 [scanEnd] 之后全是静音，之前的无法确认，按有声处理
+                tailLast = scanEnd - 1;
+            }
+            break;
+        }
+        LoudScanner tail{decoder, threshold};
+        if (scanEnd < 0) {
+            if (0 == tail.readToEnd()) {
+                // 跳转的位置已在实际的结尾之后，容器的时长不准：从开头读取的位置顺序读完
+                if (decoder.position() != headEnd && false == decoder.seek(headEnd)) {
+                    break;
+                }
+                scanner.readToEnd();
+                tailLast        = scanner.last;
+                out.totalFrames = decoder.position();
+                break;
+            }
+            out.totalFrames = decoder.position();
+        } else {
+            tail.readUntil(scanEnd);
+        }
+        if (tail.last >= 0 || tailStart <= headEnd) {
+            tailLast = tail.last;
+            break;
+        }
+        scanEnd = tailStart;
+        span *= cWindowGrowth;
+    }
+    if (item.isInterrupted()) {
+        return -2;
+    }
+    if (eof) {
+        out.totalFrames = headEnd;
+    }
+    if (0 == out.totalFrames) {
+        item.setError(MEDIAXX_DIAG_STAGE_AUDIO, MEDIAXX_DIAG_ERR_DECODE);
+        return 0;
+    }
+    if (scanner.first >= 0) {
+        out.audioStart = scanner.first;
+        out.audioEnd   = std::max(scanner.last, tailLast) + 1;
+    }
+    LXX_DEBEG(
+        "SilenceDetector | audio {}~{} of {} frames: {}",
+        out.audioStart,
+        out.audioEnd,
+        out.totalFrames,
+        item.filepath
+    );
+    return 1;
+}
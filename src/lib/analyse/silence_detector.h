@@ -0,0 +1,45 @@
+#pragma once
+
+#include "analyse/media_info_reader.h"
+#include <cstdint>
+#include <string_view>
+
+/// 首尾静音的检测结果，帧数为源采样率下每声道的采样数
+struct SilenceInfo {
+    int     sampleRate  = 0;
+    /// 解码得到的总帧数
+    int64_t totalFrames = 0;
+    /// 第一个超过阈值的帧，-1 表示全部是静音
+    int64_t audioStart  = -1;
+    /// 最后一个超过阈值的帧之后的一帧
+    int64_t audioEnd    = -1;
+};
+
+/// # 首尾静音检测
+/// - 以源的采样率和声道数解码，任一声道的采样绝对值超过阈值即为有声
+/// - 只解码开头和结尾：开头读到第一个有声的帧（至少 [windowMs]），结尾跳转到倒数 [windowMs]
+///   读到结束；结尾的窗口内全是静音时，窗口依次扩大 4 倍向前补读，直到找到有声的帧或与开头衔接
+/// - 解码器按时间戳精确到采样地跳转；不能跳转，或容器的时长偏大、跳转后读不到数据时，
+///   从开头读取的位置顺序读完
+class SilenceDetector_c {
+public:
+
+    static constexpr float cDefThresholdDb = -60.0f;
+    static constexpr int   cDefWindowMs    = 10000;
+
+    static SilenceDetector_c instance;
+
+    SilenceDetector_c() {}
+
+    ~SilenceDetector_c() {}
+
+    /// 返回值同 [mediaxx_get_audio_visualization]
+    /// - [thresholdDb] >= 0 时为 [cDefThresholdDb]；[windowMs] <= 0 时为 [cDefWindowMs]
+    int detect(
+        MediaInfoItem_c& item,
+        std::string_view headers,
+        float            thresholdDb,
+        int              windowMs,
+        SilenceInfo&     out
+    );
+};
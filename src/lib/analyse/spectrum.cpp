@@ -0,0 +1,125 @@
+#include "spectrum.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+extern "C" {
+#include "libavutil/error.h"
+#include "libavutil/mem.h"
+}
+
+namespace {
+    // 功率为 0 时的下限，避免 log10(0)
+    constexpr float cMinPower = 1e-20f;
+} // namespace
+
+bool SpectrumAnalyzer_c::init(
+    int   sampleRate,
+    int   fftSize,
+    int   bandCount,
+    float minFreq,
+    float maxFreq
+) {
+    close();
+    if (sampleRate <= 0 || fftSize < 4 || (fftSize & (fftSize - 1)) != 0 || bandCount <= 0
+        || bandCount > fftSize / 2) {
+        error = AVERROR(EINVAL);
+        return false;
+    }
+    const float scale = 1.0f;
+    if (const int ret = av_tx_init(&tx, &txFn, AV_TX_FLOAT_RDFT, 0, fftSize, &scale, 0); ret < 0) {
+        close();
+        error = ret;
+        return false;
+    }
+    size   = fftSize;
+    input  = static_cast<float*>(av_malloc(sizeof(float) * fftSize));
+    // N / 2 + 1 个复数
+    output = static_cast<float*>(av_malloc(sizeof(float) * (fftSize + 2)));
+    if (nullptr == input || nullptr == output) {
+        close();
+        error = AVERROR(ENOMEM);
+        return false;
+    }
+
+    window.resize(fftSize);
+    float windowSquareSum = 0;
+    for (int i = 0; i < fftSize; ++i) {
+        window[i] = 0.5f - 0.5f * std::cos(2 * std::numbers::pi_v<float> * i / fftSize);
+        windowSquareSum += window[i] * window[i];
+    }
+    // 幅度为 A 的正弦波在单侧频谱上的能量之和为 A² * N * sum(w²) / 4
+    powerScale = 4.0f / (float(fftSize) * windowSquareSum);
+
+    // 对数间隔的边界
+    const float nyquist = sampleRate / 2.0f;
+    maxFreq             = std::clamp(maxFreq, 1.0f, nyquist);
+    minFreq             = std::clamp(minFreq, 1.0f, maxFreq);
+    const auto lastBin  = uint32_t(fftSize / 2);
+    const auto ratio    = std::log(maxFreq / minFreq);
+    edges.resize(bandCount + 1);
+    bandBins.resize(bandCount + 1);
+    for (int i = 0; i <= bandCount; ++i) {
+        edges[i] = minFreq * std::exp(ratio * i / bandCount);
+        auto bin = uint32_t(std::ceil(edges[i] * fftSize / sampleRate));
+        // 低频的频带比 FFT 的分辨率窄时，至少包含一个下标，后面的依次顺延
+        if (i > 0) {
+            bin = std::max(bin, bandBins[i - 1] + 1);
+        }
+        bandBins[i] = std::min(bin, lastBin + 1);
+    }
+    // 顺延到末尾的频带从后往前各让出一个下标
+    for (int i = bandCount - 1; i >= 0; --i) {
+        if (bandBins[i] >= bandBins[i + 1]) {
+            bandBins[i] = bandBins[i + 1] - 1;
+        }
+    }
+    return true;
+}
+
+int SpectrumAnalyzer_c::pitchClass(float freq) {
+    // MIDI 音符号 60 为 C4
+    const auto midi = std::lround(69.0 + 12.0 * std::log2(freq / 440.0));
+    return int(((midi % 12) + 12) % 12);
+}
+
+void SpectrumAnalyzer_c::close() {
+    av_tx_uninit(&tx);
+    av_freep(&input);
+    av_freep(&output);
+    txFn  = nullptr;
+    size  = 0;
+    error = 0;
+    window.clear();
+    bandBins.clear();
+    edges.clear();
+}
+
+const float* SpectrumAnalyzer_c::power(const float* samples) {
+    for (int i = 0; i < size; ++i) {
+        input[i] = samples[i] * window[i];
+    }
+    // 正向 RDFT 的步长是输入的两个实数采样之间的字节数
+    txFn(tx, output, input, sizeof(float));
+
+    // 原地算出每个下标的功率，前 N / 2 + 1 个位置
+    const int bins = size / 2 + 1;
+    for (int k = 0; k < bins; ++k) {
+        const auto re = output[k * 2];
+        const auto im = output[k * 2 + 1];
+        output[k]     = re * re + im * im;
+    }
+    return output;
+}
+
+void SpectrumAnalyzer_c::process(const float* samples, float* outDb) {
+    power(samples);
+    const auto bands = bandCount();
+    for (int b = 0; b < bands; ++b) {
+        float sum = 0;
+        for (auto k = bandBins[b]; k < bandBins[b + 1]; ++k) {
+            sum += output[k];
+        }
+        outDb[b] = 10.0f * std::log10(std::max(sum * powerScale, cMinPower));
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+extern "C" {
+#include "libavutil/tx.h"
+}
+
+#include <cstdint>
+#include <vector>
+
+/// # 频谱分析
+/// - 加 Hann 窗后用 ffmpeg 的 av_tx 做实数 FFT（各平台有 SIMD 实现），按对数频率合并为频带
+/// - 结果为各频带的能量（dBFS），满幅的正弦波落在哪个频带都为 0 dB
+/// - 初始化后 [process] 不分配内存；一个实例只能在一个线程中使用
+class SpectrumAnalyzer_c {
+public:
+
+    SpectrumAnalyzer_c() = default;
+
+    ~SpectrumAnalyzer_c() {
+        close();
+    }
+
+    SpectrumAnalyzer_c(const SpectrumAnalyzer_c&)            = delete;
+    SpectrumAnalyzer_c& operator=(const SpectrumAnalyzer_c&) = delete;
+
+    /// [fftSize] 为 2 的幂，[bandCount] 不超过 fftSize / 2；[minFreq]、[maxFreq] 超出
+    /// 0 ~ sampleRate / 2 时截断；失败的原因见 [initError]
+    bool init(int sampleRate, int fftSize, int bandCount, float minFreq, float maxFreq);
+
+    /// [samples] 为 [fftSize] 个单声道采样，[outDb] 写入 [bandCount] 个值
+    void process(const float* samples, float* outDb);
+
+    /// 只计算各 FFT 下标的功率（未归一化），返回内部缓冲区，[fftSize] / 2 + 1 个，
+    /// 下一次调用前有效
+    const float* power(const float* samples);
+
+    void close();
+
+    /// [freq] 最接近的 12 平均律音高类（A4 = 440Hz），C 为 0，B 为 11
+    static int pitchClass(float freq);
+
+    int fftSize() const {
+        return size;
+    }
+
+    /// 上一次 [init] 失败时的 AVERROR，成功时为 0
+    int initError() const {
+        return error;
+    }
+
+    int bandCount() const {
+        return int(bandBins.size()) - 1;
+    }
+
+    /// 频带的名义边界（Hz），共 [bandCount] + 1 个，第 i 个频带为 [i, i + 1)
+    /// - 低频的频带比 FFT 的分辨率窄时，实际使用的下标依次顺延
+    const std::vector<float>& bandEdges() const {
+        return edges;
+    }
+
+protected:
+
+    AVTXContext* tx     = nullptr;
+    av_tx_fn     txFn   = nullptr;
+    // av_tx 要求对齐，用 av_malloc 分配
+    float*       input  = nullptr;
+    float*       output = nullptr;
+    int          size   = 0;
+    int          error  = 0;
+
+    std::vector<float>    window{};
+    // 频带 i 包含的 FFT 下标为 [bandBins[i], bandBins[i + 1])，至少一个
+    std::vector<uint32_t> bandBins{};
+    std::vector<float>    edges{};
+    // 功率的归一化系数，使满幅的正弦波为 0 dB
+    float                 powerScale = 1;
+};
@@ -0,0 +1,274 @@
+#include "tag_normalizer.h"
+#include "util/charset.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <string>
+#include <unordered_map>
+
+namespace {
+    // 键名的长度上限，更长的一定不是已知的键
+    constexpr size_t cMaxKeySize = 32;
+
+    /// 小写的键名 -> 规范的键；包括 ffmpeg 已转换的名称和各容器的原始名称
+    const std::unordered_map<std::string_view, uint32_t>& keyTable() {
+        static const std::unordered_map<std::string_view, uint32_t> table{
+            {"title",          MEDIAXX_TAG_TITLE       },
+            {"tit2",           MEDIAXX_TAG_TITLE       },
+            {"tt2",            MEDIAXX_TAG_TITLE       },
+            {"\xC2\xA9nam",    MEDIAXX_TAG_TITLE       },
+            {"wm/title",       MEDIAXX_TAG_TITLE       },
+            {"artist",         MEDIAXX_TAG_ARTIST      },
+            {"artists",        MEDIAXX_TAG_ARTIST      },
+            {"author",         MEDIAXX_TAG_ARTIST      },
+            {"tpe1",           MEDIAXX_TAG_ARTIST      },
+            {"tp1",            MEDIAXX_TAG_ARTIST      },
+            {"\xC2\xA9" "art", MEDIAXX_TAG_ARTIST      },
+            {"wm/author",      MEDIAXX_TAG_ARTIST      },
+            {"album",          MEDIAXX_TAG_ALBUM       },
+            {"talb",           MEDIAXX_TAG_ALBUM       },
+            {"tal",            MEDIAXX_TAG_ALBUM       },
+            {"\xC2\xA9" "alb", MEDIAXX_TAG_ALBUM       },
+            {"wm/albumtitle",  MEDIAXX_TAG_ALBUM       },
+            {"album_artist",   MEDIAXX_TAG_ALBUM_ARTIST},
+            {"albumartist",    MEDIAXX_TAG_ALBUM_ARTIST},
+            {"album artist",   MEDIAXX_TAG_ALBUM_ARTIST},
+            {"tpe2",           MEDIAXX_TAG_ALBUM_ARTIST},
+            {"tp2",            MEDIAXX_TAG_ALBUM_ARTIST},
+            {"aart",           MEDIAXX_TAG_ALBUM_ARTIST},
+            {"wm/albumartist", MEDIAXX_TAG_ALBUM_ARTIST},
+            {"genre",          MEDIAXX_TAG_GENRE       },
+            {"tcon",           MEDIAXX_TAG_GENRE       },
+            {"tco",            MEDIAXX_TAG_GENRE       },
+            {"\xC2\xA9gen",    MEDIAXX_TAG_GENRE       },
+            {"wm/genre",       MEDIAXX_TAG_GENRE       },
+            {"composer",       MEDIAXX_TAG_COMPOSER    },
+            {"tcom",           MEDIAXX_TAG_COMPOSER    },
+            {"tcm",            MEDIAXX_TAG_COMPOSER    },
+            {"\xC2\xA9wrt",    MEDIAXX_TAG_COMPOSER    },
+            {"wm/composer",    MEDIAXX_TAG_COMPOSER    },
+            {"lyricist",       MEDIAXX_TAG_LYRICIST    },
+            {"text",           MEDIAXX_TAG_LYRICIST    },
+            {"txt",            MEDIAXX_TAG_LYRICIST    },
+            {"wm/writer",      MEDIAXX_TAG_LYRICIST    },
+            {"performer",      MEDIAXX_TAG_PERFORMER   },
+            {"date",           MEDIAXX_TAG_DATE        },
+            {"year",           MEDIAXX_TAG_DATE        },
+            {"tyer",           MEDIAXX_TAG_DATE        },
+            {"tye",            MEDIAXX_TAG_DATE        },
+            {"tdrc",           MEDIAXX_TAG_DATE        },
+            {"\xC2\xA9" "day", MEDIAXX_TAG_DATE        },
+            {"wm/year",        MEDIAXX_TAG_DATE        },
+            {"track",          MEDIAXX_TAG_TRACK       },
+            {"tracknumber",    MEDIAXX_TAG_TRACK       },
+            {"trck",           MEDIAXX_TAG_TRACK       },
+            {"trk",            MEDIAXX_TAG_TRACK       },
+            {"trkn",           MEDIAXX_TAG_TRACK       },
+            {"wm/tracknumber", MEDIAXX_TAG_TRACK       },
+            {"disc",           MEDIAXX_TAG_DISC        },
+            {"discnumber",     MEDIAXX_TAG_DISC        },
+            {"disk",           MEDIAXX_TAG_DISC        },
+            {"tpos",           MEDIAXX_TAG_DISC        },
+            {"tpa",            MEDIAXX_TAG_DISC        },
+            {"wm/partofset",   MEDIAXX_TAG_DISC        },
+            {"comment",        MEDIAXX_TAG_COMMENT     },
+            {"comm",           MEDIAXX_TAG_COMMENT     },
+            {"\xC2\xA9" "cmt", MEDIAXX_TAG_COMMENT     },
+            {"publisher",      MEDIAXX_TAG_PUBLISHER   },
+            {"organization",   MEDIAXX_TAG_PUBLISHER   },
+            {"label",          MEDIAXX_TAG_PUBLISHER   },
+            {"tpub",           MEDIAXX_TAG_PUBLISHER   },
+            {"wm/publisher",   MEDIAXX_TAG_PUBLISHER   },
+            {"copyright",      MEDIAXX_TAG_COPYRIGHT   },
+            {"tcop",           MEDIAXX_TAG_COPYRIGHT   },
+            {"cprt",           MEDIAXX_TAG_COPYRIGHT   },
+            {"\xC2\xA9" "cpy", MEDIAXX_TAG_COPYRIGHT   },
+        };
+        return table;
+    }
+
+    /// 只去掉 ASCII 空白
+    std::string_view trim(std::string_view str) {
+        constexpr std::string_view cSpaces = " \t\r\n";
+        const auto                 begin   = str.find_first_not_of(cSpaces);
+        if (begin == std::string_view::npos) {
+            return {};
+        }
+        return str.substr(begin, str.find_last_not_of(cSpaces) - begin + 1);
+    }
+
+    bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+        return a.size() == b.size()
+            && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+                   return std::tolower(static_cast<unsigned char>(x))
+                       == std::tolower(static_cast<unsigned char>(y));
+               });
+    }
+
+    /// 追加不重复的非空值
+    void appendUnique(std::vector<std::string_view>& out, std::string_view value) {
+        value = trim(value);
+        if (value.empty()) {
+            return;
+        }
+        for (const auto exist : out) {
+            if (equalsIgnoreCase(exist, value)) {
+                return;
+            }
+        }
+        out.push_back(value);
+    }
+
+    /// 按 `;`、`、`、NUL 拆分，返回是否出现过这些分隔符
+    bool splitPrimary(std::string_view value, std::vector<std::string_view>& parts) {
+        constexpr std::string_view cIdeographicComma = "\xE3\x80\x81";
+
+        bool   found = false;
+        size_t start = 0;
+        for (size_t i = 0; i < value.size();) {
+            size_t sepSize = 0;
+            if (value[i] == ';' || value[i] == '\0') {
+                sepSize = 1;
+            } else if (value.substr(i).starts_with(cIdeographicComma)) {
+                sepSize = cIdeographicComma.size();
+            }
+            if (0 == sepSize) {
+                ++i;
+                continue;
+            }
+            found = true;
+            parts.push_back(value.substr(start, i - start));
+            i += sepSize;
+            start = i;
+        }
+        parts.push_back(value.substr(start));
+        return found;
+    }
+} // namespace
+
+uint32_t TagNormalizer_c::canonicalKey(std::string_view key) {
+    if (key.empty() || key.size() > cMaxKeySize) {
+        return MEDIAXX_TAG_UNKNOWN;
+    }
+    // 在栈上转小写，不分配内存
+    std::array<char, cMaxKeySize> lower{};
+    std::transform(key.begin(), key.end(), lower.begin(), [](char ch) {
+        return char(std::tolower(static_cast<unsigned char>(ch)));
+    });
+    const auto& table = keyTable();
+    const auto  it    = table.find(std::string_view{lower.data(), key.size()});
+    return it == table.end() ? MEDIAXX_TAG_UNKNOWN : it->second;
+}
+
+bool TagNormalizer_c::isMultiValue(uint32_t key) {
+    switch (key) {
+    case MEDIAXX_TAG_ARTIST:
+    case MEDIAXX_TAG_ALBUM_ARTIST:
+    case MEDIAXX_TAG_GENRE:
+    case MEDIAXX_TAG_COMPOSER:
+    case MEDIAXX_TAG_LYRICIST:
+    case MEDIAXX_TAG_PERFORMER:
+        return true;
+    default:
+        return false;
+    }
+}
+
+std::string_view TagNormalizer_c::keyName(uint32_t key) {
+    switch (key) {
+    case MEDIAXX_TAG_TITLE:
+        return "title";
+    case MEDIAXX_TAG_ARTIST:
+        return "artist";
+    case MEDIAXX_TAG_ALBUM:
+        return "album";
+    case MEDIAXX_TAG_ALBUM_ARTIST:
+        return "album_artist";
+    case MEDIAXX_TAG_GENRE:
+        return "genre";
+    case MEDIAXX_TAG_COMPOSER:
+        return "composer";
+    case MEDIAXX_TAG_LYRICIST:
+        return "lyricist";
+    case MEDIAXX_TAG_PERFORMER:
+        return "performer";
+    case MEDIAXX_TAG_DATE:
+        return "date";
+    case MEDIAXX_TAG_TRACK:
+        return "track";
+    case MEDIAXX_TAG_DISC:
+        return "disc";
+    case MEDIAXX_TAG_COMMENT:
+        return "comment";
+    case MEDIAXX_TAG_PUBLISHER:
+        return "publisher";
+    case MEDIAXX_TAG_COPYRIGHT:
+        return "copyright";
+    default:
+        return "unknown";
+    }
+}
+
+void TagNormalizer_c::splitValues(std::string_view value, std::vector<std::string_view>& out) {
+    std::vector<std::string_view> parts{};
+    if (false == splitPrimary(value, parts)) {
+        // 没有其他分隔符时才按 `/` 拆分
+        parts.clear();
+        size_t start = 0;
+        size_t slash = 0;
+        while ((slash = value.find('/', start)) != std::string_view::npos) {
+            parts.push_back(value.substr(start, slash - start));
+            start = slash + 1;
+        }
+        parts.push_back(value.substr(start));
+        const auto isShort = [](std::string_view part) { return trim(part).size() <= 2; };
+        if (parts.size() > 1 && std::any_of(parts.begin(), parts.end(), isShort)) {
+            parts.assign(1, value);
+        }
+    }
+    for (const auto part : parts) {
+        appendUnique(out, part);
+    }
+}
+
+void TagNormalizer_c::normalize(AVFormatContext* fmtCtx, std::vector<NormalizedTag>& out) {
+    out.clear();
+    std::vector<std::string_view> values{};
+    const auto                    addTags = [&](AVDictionary* metadata) {
+        AVDictionaryEntry* tag = nullptr;
+        while ((tag = av_dict_get(metadata, "", tag, AV_DICT_IGNORE_SUFFIX))) {
+            if (nullptr == tag->key || nullptr == tag->value) {
+                continue;
+            }
+            const auto key = canonicalKey(tag->key);
+            // 与原始标签一致，跳过乱码
+            if (MEDIAXX_TAG_UNKNOWN == key || false == charsetxx::isCleanText(tag->value)) {
+                continue;
+            }
+            // 同一 key 已有的值，多个来源（如 `artist` 和 `TPE1`）合并去重
+            values.clear();
+            for (const auto& exist : out) {
+                if (exist.key == key) {
+                    values.push_back(exist.value);
+                }
+            }
+            const auto existCount = values.size();
+            if (isMultiValue(key)) {
+                splitValues(tag->value, values);
+            } else if (0 == existCount) {
+                appendUnique(values, tag->value);
+            }
+            for (auto i = existCount; i < values.size(); ++i) {
+                out.push_back(NormalizedTag{key, values[i]});
+            }
+        }
+    };
+
+    addTags(fmtCtx->metadata);
+    for (unsigned int i = 0; out.empty() && i < fmtCtx->nb_streams; ++i) {
+        addTags(fmtCtx->streams[i]->metadata);
+    }
+    std::stable_sort(out.begin(), out.end(), [](const auto& a, const auto& b) {
+        return a.key < b.key;
+    });
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+extern "C" {
+#include "libavformat/avformat.h"
+}
+
+#include <cstdint>
+#include <mediaxx.h>
+#include <string_view>
+#include <vector>
+
+/// 规范化后的一个值；[value] 指向 AVDictionary 内的字符串，在 AVFormatContext 释放前有效
+struct NormalizedTag {
+    uint32_t         key;
+    std::string_view value;
+};
+
+/// # 标签规范化
+/// - 各容器的键名不同（`artist`、`ARTIST`、`TPE1`、`©ART`），统一映射为 [MEDIAXX_TAG_TITLE] 等
+/// - 多值字段（艺术家、流派等）按 `;`、`、`、NUL、`/` 拆分，去掉首尾空白后去重（ASCII 不区分大小写）
+/// - 只切分视图，不复制字符串
+class TagNormalizer_c {
+public:
+
+    /// 未知的键返回 [MEDIAXX_TAG_UNKNOWN]
+    static uint32_t canonicalKey(std::string_view key);
+
+    static bool isMultiValue(uint32_t key);
+
+    /// json 中使用的名称，如 `album_artist`
+    static std::string_view keyName(uint32_t key);
+
+    /// 拆分多值并去重，追加到 [out]
+    /// - `;`、`、`、NUL 优先；都没有时才按 `/` 拆分，拆出的部分有不超过 2 字节的（如 `AC/DC`）时不拆
+    static void splitValues(std::string_view value, std::vector<std::string_view>& out);
+
+    /// 读取格式级别的标签，没有可识别的标签时读取各个流的（Ogg 等容器的标签在流上）
+    /// - 结果按 key 升序排列，同一 key 的多个值保持原顺序；单值字段只保留第一个
+    static void normalize(AVFormatContext* fmtCtx, std::vector<NormalizedTag>& out);
+};
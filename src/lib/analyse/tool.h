@@ -9,45 +9,104 @@ extern "C" {
 #include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <map>
 #include <memory>
+#include <memory_resource>
 #include <sstream>
 #include <string>
 #include <vector>
 
 #include "simdjson.h"
+#include "util/diag.h"
 #include "util/log.h"
 #include "util/string_util.h"
 #include "util/utilxx.h"
 
 namespace analyse_tool {
+    /// # 请求的日志
+    /// - 日志先追加到 [logText]，[flushLog] 或析构时才一次性复制到 [log]
+    /// - [log] 为空时只保留在 [logText]，由调用方通过 [logView] 读取
+    /// - [setError] 在 [textLog] 为 true 时生成文字，为 false 时只记录结构化错误
     class AnalyseLogItem_c {
     public:
 
-        const char** log;
-        size_t       logNum = 0;
+        const char**     log;
+        size_t           logNum = 0;
+        // 可以使用调用方的 [RequestArena_c]，此时日志不会单独分配堆内存
+        std::pmr::string logText;
+        // 为 false 时 [setError] 只写入 [Diagnostics_c]，为 true 时只写入 [logText]
+        bool             textLog = true;
+        // [setError] 默认的路径/地址
+        std::string_view subject{};
+
+        AnalyseLogItem_c(
+            const char**               in_log,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+        ) :
+            log(in_log),
+            logText(resource) {
+            // log 容器可以为空；非空时内容必须為空
+            assert(nullptr == log || nullptr == *log);
+        }
 
-        AnalyseLogItem_c(const char** in_log) :
-            log(in_log) {
-            // log 容器非空，但内容為空
-            assert(nullptr != log && nullptr == *log);
+        ~AnalyseLogItem_c() {
+            flushLog();
         }
 
-        void setLog(const std::string_view data) {
-            ++logNum;
-            auto temp = *log;
-            if (nullptr == temp) {
-                *log = stringxx::stringCopyMalloc(data).data();
-            } else {
-                // 已经有内容，附加
-                *log = stringxx::stringCopyMalloc(*log, "\n\n", data).data();
+        AnalyseLogItem_c(const AnalyseLogItem_c&)            = delete;
+        AnalyseLogItem_c& operator=(const AnalyseLogItem_c&) = delete;
+
+        std::string_view logView() const {
+            return logText;
+        }
+
+        /// 把累积的日志复制到 [log]；只在有新日志时重新分配
+        void flushLog() {
+            if (nullptr == log || logText.size() == flushedSize) {
+                return;
             }
-            mediaxx_free(temp);
+            mediaxx_free(*log);
+            *log        = stringxx::stringCopyMalloc(logText).data();
+            flushedSize = logText.size();
+        }
+
+        void setLog(const std::string_view data) {
+            beginLog();
+            logText.append(data);
         }
 
         template<typename... _Args>
         void setLog(std::format_string<_Args...> fmt, _Args&&... args) {
-            setLog(std::format(fmt, std::forward<_Args>(args)...));
+            beginLog();
+            std::format_to(std::back_inserter(logText), fmt, std::forward<_Args>(args)...);
+        }
+
+        /// 记录错误；[in_subject] 为空时使用 [subject]
+        void setError(
+            unsigned short   stage,
+            unsigned short   code,
+            int              avError     = 0,
+            std::string_view in_subject  = {},
+            int              streamIndex = -1
+        ) {
+            const auto target = in_subject.empty() ? subject : in_subject;
+            if (textLog) {
+                beginLog();
+                Diagnostics_c::formatTo(logText, code, avError, streamIndex, target);
+            } else {
+                Diagnostics_c::instance.report(stage, code, avError, streamIndex, target);
+            }
+        }
+
+    protected:
+
+        size_t flushedSize = 0;
+
+        void beginLog() {
+            if (0 != logNum++) {
+                logText.append("\n\n");
+            }
         }
     };
 
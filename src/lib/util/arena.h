@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+/// # 单个请求的临时内存
+/// - 分配只移动指针，不单独释放；对象析构时整体归还
+/// - 前 [cInlineSize] 字节在对象内部，作为局部变量时小请求完全不访问堆
+/// - 不是线程安全的，只在发起请求的线程内使用
+class RequestArena_c {
+public:
+
+    inline static constexpr size_t cInlineSize = 8 * 1024;
+
+    RequestArena_c() :
+        resource(inlineBuffer, sizeof(inlineBuffer)) {}
+
+    RequestArena_c(const RequestArena_c&)            = delete;
+    RequestArena_c& operator=(const RequestArena_c&) = delete;
+
+    std::pmr::memory_resource* get() {
+        return &resource;
+    }
+
+protected:
+
+    alignas(std::max_align_t) std::byte inlineBuffer[cInlineSize];
+    std::pmr::monotonic_buffer_resource resource;
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/// # 请求取消句柄
+/// - 由调用方创建并持有，可在任意线程调用 [cancel]
+/// - 同一个句柄可以同时传给多个请求，取消后所有请求都会尽快结束
+class CancelToken_c {
+public:
+
+    void cancel() {
+        cancelled.store(true, std::memory_order_release);
+    }
+
+    bool isCancelled() const {
+        return cancelled.load(std::memory_order_acquire);
+    }
+
+protected:
+
+    std::atomic<bool> cancelled{false};
+};
+
+/// # 单个请求的中断条件：外部取消句柄 + 截止时间
+/// - 作为 `AVFormatContext::interrupt_callback` 的 opaque 使用，阻塞的网络读取也能及时退出
+struct RequestInterrupt {
+    const CancelToken_c* token      = nullptr;
+    // steady_clock 微秒；0 表示不限制
+    int64_t              deadlineUs = 0;
+    // 尚未开始计时的超时（微秒），见 [deferTimeout]
+    int64_t              timeoutUs  = 0;
+
+    static int64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()
+        )
+            .count();
+    }
+
+    void setTimeout(int64_t timeoutMs) {
+        deadlineUs = (timeoutMs > 0) ? (nowUs() + timeoutMs * 1000) : 0;
+    }
+
+    /// 排队的请求在 [startDeadline] 时才开始计时，排队的时间不计入超时
+    void deferTimeout(int64_t timeoutMs) {
+        deadlineUs = 0;
+        timeoutUs  = (timeoutMs > 0) ? timeoutMs * 1000 : 0;
+    }
+
+    /// 从 [startUs] 开始计时；没有延迟的超时或已经开始时不变
+    void startDeadline(int64_t startUs = nowUs()) {
+        if (timeoutUs > 0 && deadlineUs <= 0) {
+            deadlineUs = startUs + timeoutUs;
+        }
+    }
+
+    /// 剩余时间（微秒），不限制时返回 -1
+    int64_t remainingUs() const {
+        if (deadlineUs <= 0) {
+            return -1;
+        }
+        const auto remain = deadlineUs - nowUs();
+        return remain > 0 ? remain : 0;
+    }
+
+    bool isInterrupted() const {
+        if (nullptr != token && token->isCancelled()) {
+            return true;
+        }
+        return deadlineUs > 0 && nowUs() >= deadlineUs;
+    }
+
+    static int avCallback(void* opaque) {
+        return static_cast<const RequestInterrupt*>(opaque)->isInterrupted() ? 1 : 0;
+    }
+};
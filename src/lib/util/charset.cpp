@@ -0,0 +1,274 @@
+#include "charset.h"
+#include "charset_tables.h"
+#include "simdjson.h"
+#include "util/log.h"
+#include "util/string_util.h"
+#include <algorithm>
+#include <array>
+
+namespace charsetxx {
+    namespace {
+        /// 解码过程中统计的双字节字符：常用区（GB2312、Big5 常用字、JIS 第一水准和假名）和其他
+        struct Score {
+            uint32_t common = 0;
+            uint32_t rare   = 0;
+        };
+
+        bool isTrail(uint8_t ch) {
+            return ch >= tables::cTrailFirst && ch < tables::cTrailFirst + tables::cTrailCount
+                && ch != 0x7F;
+        }
+
+        /// GB18030 四字节中 BMP 部分的线性序号 -> 码点，0 表示未定义
+        uint32_t gb18030BmpCodePoint(uint32_t linear) {
+            const auto& ranges = tables::cGb18030Ranges;
+            // 最后一个起始序号不大于 [linear] 的段
+            const auto it = std::upper_bound(
+                std::begin(ranges),
+                std::end(ranges),
+                linear,
+                [](uint32_t value, const uint32_t(&range)[2]) { return value < range[0]; }
+            );
+            if (it == std::begin(ranges)) {
+                return 0;
+            }
+            const auto& range = *(it - 1);
+            const auto  cp    = range[1] + (linear - range[0]);
+            return (cp <= 0xFFFF && (cp < 0xD800 || cp > 0xDFFF)) ? cp : 0;
+        }
+
+        bool decodeGb18030(std::string_view data, std::string& out, Score& score) {
+            const auto byteAt = [&data](size_t i) { return static_cast<uint8_t>(data[i]); };
+            for (size_t i = 0; i < data.size();) {
+                const auto b1 = byteAt(i);
+                if (b1 < 0x80) {
+                    out.push_back(char(b1));
+                    ++i;
+                    continue;
+                }
+                if (b1 == 0x80 || b1 == 0xFF || i + 1 >= data.size()) {
+                    return false;
+                }
+                const auto b2 = byteAt(i + 1);
+                if (b2 >= 0x30 && b2 <= 0x39) {
+                    // 四字节
+                    if (i + 3 >= data.size()) {
+                        return false;
+                    }
+                    const auto b3 = byteAt(i + 2);
+                    const auto b4 = byteAt(i + 3);
+                    if (b3 < 0x81 || b3 == 0xFF || b4 < 0x30 || b4 > 0x39) {
+                        return false;
+                    }
+                    const auto linear
+                        = (((b1 - 0x81u) * 10 + (b2 - 0x30u)) * 126 + (b3 - 0x81u)) * 10
+                        + (b4 - 0x30u);
+                    // 0x90308130 开始为 U+10000 之后的码点
+                    constexpr uint32_t cSupplementaryFirst = 189000;
+
+                    uint32_t cp = 0;
+                    if (linear < tables::cGb18030BmpCount) {
+                        cp = gb18030BmpCodePoint(linear);
+                    } else if (linear >= cSupplementaryFirst
+                               && linear - cSupplementaryFirst <= 0xFFFFF) {
+                        cp = 0x10000 + (linear - cSupplementaryFirst);
+                    }
+                    if (0 == cp) {
+                        return false;
+                    }
+                    // 不计入常用字或其他字符：西文被误判时几乎不会出现合法的四字节序列
+                    stringxx::utf8AppendCodePoint(out, cp);
+                    i += 4;
+                    continue;
+                }
+                if (false == isTrail(b2)) {
+                    return false;
+                }
+                const auto cp = tables::cGbk
+                    [(b1 - 0x81u) * tables::cTrailCount + (b2 - tables::cTrailFirst)];
+                if (0 == cp) {
+                    return false;
+                }
+                stringxx::utf8AppendCodePoint(out, cp);
+                // GB2312 的符号区和汉字区，AA~AF 行未使用
+                const bool isGb2312 = ((b1 >= 0xA1 && b1 <= 0xA9) || (b1 >= 0xB0 && b1 <= 0xF7))
+                                   && b2 >= 0xA1;
+                ++(isGb2312 ? score.common : score.rare);
+                i += 2;
+            }
+            return true;
+        }
+
+        bool decodeBig5(std::string_view data, std::string& out, Score& score) {
+            for (size_t i = 0; i < data.size();) {
+                const auto b1 = static_cast<uint8_t>(data[i]);
+                if (b1 < 0x80) {
+                    out.push_back(char(b1));
+                    ++i;
+                    continue;
+                }
+                if (b1 < 0xA1 || b1 > 0xF9 || i + 1 >= data.size()) {
+                    return false;
+                }
+                const auto b2 = static_cast<uint8_t>(data[i + 1]);
+                if (false == isTrail(b2)) {
+                    return false;
+                }
+                const auto cp = tables::cBig5
+                    [(b1 - 0xA1u) * tables::cTrailCount + (b2 - tables::cTrailFirst)];
+                if (0 == cp) {
+                    return false;
+                }
+                stringxx::utf8AppendCodePoint(out, cp);
+                // A1~A3 为符号，A4~C6 为常用字
+                ++(b1 <= 0xC6 ? score.common : score.rare);
+                i += 2;
+            }
+            return true;
+        }
+
+        bool decodeShiftJis(std::string_view data, std::string& out, Score& score) {
+            for (size_t i = 0; i < data.size();) {
+                const auto b1 = static_cast<uint8_t>(data[i]);
+                if (b1 < 0x80) {
+                    out.push_back(char(b1));
+                    ++i;
+                    continue;
+                }
+                if (b1 >= 0xA1 && b1 <= 0xDF) {
+                    // 半角片假名，GBK 等被误判时常出现，不算常用
+                    stringxx::utf8AppendCodePoint(out, 0xFF61 + (b1 - 0xA1u));
+                    ++score.rare;
+                    ++i;
+                    continue;
+                }
+                const bool isLead = (b1 >= 0x81 && b1 <= 0x9F) || (b1 >= 0xE0 && b1 <= 0xFC);
+                if (false == isLead || i + 1 >= data.size()) {
+                    return false;
+                }
+                const auto b2 = static_cast<uint8_t>(data[i + 1]);
+                if (false == isTrail(b2)) {
+                    return false;
+                }
+                const auto row = (b1 <= 0x9F) ? (b1 - 0x81u) : (b1 - 0xE0u + 0x1Fu);
+                const auto cp
+                    = tables::cShiftJis[row * tables::cTrailCount + (b2 - tables::cTrailFirst)];
+                if (0 == cp) {
+                    return false;
+                }
+                stringxx::utf8AppendCodePoint(out, cp);
+                // 81~84 为符号、假名，88~98 为第一水准汉字
+                const bool isCommon = (b1 <= 0x84) || (b1 >= 0x88 && b1 <= 0x98);
+                ++(isCommon ? score.common : score.rare);
+                i += 2;
+            }
+            return true;
+        }
+
+        bool decodeScored(std::string_view data, Charset charset, std::string& out, Score& score) {
+            switch (charset) {
+            case Charset::Utf8:
+                if (false == isUtf8(data)) {
+                    return false;
+                }
+                out.append(data);
+                return true;
+            case Charset::Gb18030:
+                return decodeGb18030(data, out, score);
+            case Charset::Big5:
+                return decodeBig5(data, out, score);
+            case Charset::ShiftJis:
+                return decodeShiftJis(data, out, score);
+            case Charset::Latin1:
+                stringxx::latin1AppendToUtf8(out, data);
+                return true;
+            }
+            return false;
+        }
+
+        /// 能严格解码、且常用字多于其他字符的编码中，差值最大的；相同时按 GB18030、Big5、Shift-JIS 的顺序
+        bool detectCjk(std::string_view data, Charset& outCharset) {
+            constexpr std::array cCandidates{Charset::Gb18030, Charset::Big5, Charset::ShiftJis};
+
+            std::string buffer{};
+            bool        found = false;
+            int64_t     best  = 0;
+            for (const auto charset : cCandidates) {
+                Score score{};
+                buffer.clear();
+                if (false == decodeScored(data, charset, buffer, score)) {
+                    continue;
+                }
+                const auto diff = int64_t(score.common) - int64_t(score.rare);
+                if (diff > best) {
+                    best       = diff;
+                    outCharset = charset;
+                    found      = true;
+                }
+            }
+            return found;
+        }
+    } // namespace
+
+    bool isUtf8(std::string_view str) {
+        return simdjson::validate_utf8(str.data(), str.size());
+    }
+
+    bool isCleanText(std::string_view str) {
+        return false == str.empty() && isUtf8(str) && false == str.contains("\xEF\xBF\xBD");
+    }
+
+    bool decode(std::string_view data, Charset charset, std::string& out) {
+        Score score{};
+        return decodeScored(data, charset, out, score);
+    }
+
+    Charset detect(std::string_view data) {
+        auto charset = Charset::Latin1;
+        detectCjk(data, charset);
+        return charset;
+    }
+
+    bool repairText(std::string_view str, std::string& out) {
+        if (false == isUtf8(str)) {
+            return decode(str, detect(str), out);
+        }
+
+        // 只含 U+0000~U+00FF 时首字节只有 C2、C3
+        bool hasHigh = false;
+        for (const auto ch : str) {
+            const auto byte = static_cast<uint8_t>(ch);
+            if (byte >= 0xC4) {
+                return false;
+            }
+            hasHigh |= (byte >= 0x80);
+        }
+        if (false == hasHigh) {
+            return false;
+        }
+
+        // 还原为 ISO-8859-1 之前的字节
+        std::string raw{};
+        raw.reserve(str.size());
+        for (size_t i = 0; i < str.size(); ++i) {
+            const auto byte = static_cast<uint8_t>(str[i]);
+            if (byte < 0x80) {
+                raw.push_back(char(byte));
+            } else {
+                const auto next = static_cast<uint8_t>(str[++i]);
+                raw.push_back(char(byte == 0xC3 ? (next + 0x40) : next));
+            }
+        }
+        // UTF-8 被当作 ISO-8859-1 又编码了一次
+        if (isUtf8(raw)) {
+            out.append(raw);
+            return true;
+        }
+        // 正常的西文（如 `Motörhead`）按 CJK 解码时几乎都落在非常用区，保持原样
+        auto charset = Charset::Latin1;
+        if (false == detectCjk(raw, charset)) {
+            return false;
+        }
+        return decode(raw, charset, out);
+    }
+} // namespace charsetxx
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/// # 字符集检测和转码
+/// - 主要用于标签：很多中文/日文音乐的标签是 GBK/Big5/Shift-JIS 编码，而不是 UTF-8
+/// - 解码表由 `script/gen_charset_tables.py` 生成，不依赖系统的 iconv（Android 的 iconv 不支持这些编码）
+namespace charsetxx {
+
+    enum class Charset : uint8_t {
+        Utf8,
+        Gb18030,
+        Big5,
+        ShiftJis,
+        Latin1,
+    };
+
+    /// 向量化校验（simdjson），比逐字节的 [stringxx::utf8IsAvail] 快很多
+    bool isUtf8(std::string_view str);
+
+    /// 可以直接输出的标签文本：非空、是有效的 UTF-8、不含 U+FFFD
+    bool isCleanText(std::string_view str);
+
+    /// 严格解码 [data] 为 UTF-8 追加到 [out]；有未定义的字节序列时返回 false，[out] 的内容不确定
+    bool decode(std::string_view data, Charset charset, std::string& out);
+
+    /// 检测非 UTF-8 文本的编码：在 GB18030、Big5、Shift-JIS 中选择常用字比例最高的，都不合适时为 Latin-1
+    Charset detect(std::string_view data);
+
+    /// # 恢复乱码的标签文本
+    /// - 不是 UTF-8 时检测编码并转码
+    /// - 是 UTF-8 但只含 U+0000~U+00FF 时，可能是 ffmpeg 把 GBK 等字节按 ISO-8859-1 读取的结果
+    ///   （ID3v1、编码为 0 的 ID3v2 帧），还原为字节后能以常用字比例较高的编码解码时才替换
+    /// - 返回 true 表示已转码，结果在 [out] 中；返回 false 表示原文不需要处理
+    bool repairText(std::string_view str, std::string& out);
+} // namespace charsetxx
@@ -0,0 +1,192 @@
+#include "diag.h"
+#include "util/log.h"
+#include "util/string_util.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+    std::atomic<unsigned int> gNextThreadId{1};
+
+    /// 线程结束时交给 [Diagnostics_c::retire]，未取出的记录留在 [Diagnostics_c::rings] 中
+    struct LocalRing {
+        std::shared_ptr<DiagRing_c> ring{};
+        unsigned int                threadId = 0;
+
+        ~LocalRing() {
+            if (nullptr != ring) {
+                Diagnostics_c::instance.retire(std::move(ring));
+            }
+        }
+    };
+
+    thread_local LocalRing tLocalRing{};
+
+    int64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::system_clock::now().time_since_epoch()
+        )
+            .count();
+    }
+} // namespace
+
+DiagRing_c& Diagnostics_c::localRing() {
+    if (nullptr == tLocalRing.ring) {
+        // 每个线程只在第一次出错时注册一次
+        tLocalRing.ring     = std::make_shared<DiagRing_c>();
+        tLocalRing.threadId = gNextThreadId.fetch_add(1, std::memory_order_relaxed);
+        std::lock_guard lock{mutex};
+        rings.push_back(tLocalRing.ring);
+    }
+    return *tLocalRing.ring;
+}
+
+void Diagnostics_c::report(
+    unsigned short   stage,
+    unsigned short   code,
+    int              avError,
+    int              streamIndex,
+    std::string_view subject
+) {
+    auto& ring = localRing();
+
+    MediaxxDiagRecord record;
+    record.timeUs      = nowUs();
+    record.avError     = avError;
+    record.streamIndex = streamIndex;
+    record.threadId    = tLocalRing.threadId;
+    record.stage       = stage;
+    record.code        = code;
+    // 路径的末尾（文件名）更有用，过长时截掉开头，不切断多字节字符
+    constexpr size_t cMaxSubject = sizeof(record.subject) - 1;
+    subject                      = stringxx::utf8TruncateFront(subject, cMaxSubject);
+    memcpy(record.subject, subject.data(), subject.size());
+    record.subject[subject.size()] = '\0';
+    ring.push(record);
+}
+
+void Diagnostics_c::retire(std::shared_ptr<DiagRing_c>&& ring) {
+    std::lock_guard lock{mutex};
+    if (ring->empty()) {
+        retiredDropped += ring->dropped.load(std::memory_order_relaxed);
+        std::erase(rings, ring);
+        return;
+    }
+    ring.reset();
+    // 线程池每次调用都会创建新线程，没有人取出时保留的缓冲区不能无限增长
+    size_t retired = 0;
+    for (const auto& item : rings) {
+        retired += (item.use_count() == 1) ? 1 : 0;
+    }
+    if (retired <= cMaxRetiredRings) {
+        return;
+    }
+    auto excess = retired - cMaxRetiredRings;
+    std::erase_if(rings, [this, &excess](const std::shared_ptr<DiagRing_c>& item) {
+        if (excess > 0 && item.use_count() == 1) {
+            retiredDropped += item->dropped.load(std::memory_order_relaxed) + item->size();
+            --excess;
+            return true;
+        }
+        return false;
+    });
+}
+
+size_t Diagnostics_c::drain(MediaxxDiagRecord* out, size_t capacity) {
+    std::lock_guard lock{mutex};
+    size_t          count = 0;
+    for (auto& ring : rings) {
+        count += ring->pop(out + count, capacity - count);
+    }
+    // 所属线程已结束且已取完的缓冲区
+    std::erase_if(rings, [this](const std::shared_ptr<DiagRing_c>& ring) {
+        if (ring.use_count() == 1 && ring->empty()) {
+            retiredDropped += ring->dropped.load(std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    });
+    return count;
+}
+
+uint64_t Diagnostics_c::droppedCount() {
+    std::lock_guard lock{mutex};
+    auto            count = retiredDropped;
+    for (const auto& ring : rings) {
+        count += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+std::string_view Diagnostics_c::stageName(unsigned short stage) {
+    switch (stage) {
+    case MEDIAXX_DIAG_STAGE_OPEN:
+        return "打开";
+    case MEDIAXX_DIAG_STAGE_STREAM_INFO:
+        return "流信息";
+    case MEDIAXX_DIAG_STAGE_PICTURE:
+        return "封面";
+    case MEDIAXX_DIAG_STAGE_MANIFEST:
+        return "播放列表";
+    case MEDIAXX_DIAG_STAGE_BATCH:
+        return "批量";
+    case MEDIAXX_DIAG_STAGE_AUDIO:
+        return "音频分析";
+    case MEDIAXX_DIAG_STAGE_CLIP:
+        return "片段提取";
+    default:
+        return "未知";
+    }
+}
+
+std::string_view Diagnostics_c::codeText(unsigned short code) {
+    switch (code) {
+    case MEDIAXX_DIAG_ERR_CANCELLED:
+        return "请求已取消或超时";
+    case MEDIAXX_DIAG_ERR_NO_PATH:
+        return "缺少文件路径";
+    case MEDIAXX_DIAG_ERR_NO_MEMORY:
+        return "内存分配失败";
+    case MEDIAXX_DIAG_ERR_OPEN:
+        return "无法打开文件";
+    case MEDIAXX_DIAG_ERR_READ:
+        return "读取失败";
+    case MEDIAXX_DIAG_ERR_STREAM_INFO:
+        return "无法获取流信息";
+    case MEDIAXX_DIAG_ERR_UNKNOWN_MANIFEST:
+        return "无法识别的播放列表";
+    case MEDIAXX_DIAG_ERR_NO_DECODER:
+        return "找不到解码器";
+    case MEDIAXX_DIAG_ERR_DECODER_OPEN:
+        return "无法打开解码器";
+    case MEDIAXX_DIAG_ERR_DECODE:
+        return "解码失败";
+    case MEDIAXX_DIAG_ERR_NO_AUDIO:
+        return "没有音频流";
+    case MEDIAXX_DIAG_ERR_WRITE:
+        return "无法写入输出文件";
+    case MEDIAXX_DIAG_ERR_NO_ENCODER:
+        return "找不到可用的编码器";
+    case MEDIAXX_DIAG_ERR_ENCODE:
+        return "编码失败";
+    default:
+        return "未知错误";
+    }
+}
+
+std::string Diagnostics_c::format(const MediaxxDiagRecord* records, size_t count) {
+    std::string result{};
+    for (size_t i = 0; i < count; ++i) {
+        const auto& record = records[i];
+        if (i > 0) {
+            result.push_back('\n');
+        }
+        result.push_back('[');
+        result.append(stageName(record.stage));
+        result.append("] ");
+        formatTo(result, record.code, record.avError, record.streamIndex, record.subject);
+    }
+    return result;
+}
+
+Diagnostics_c Diagnostics_c::instance;
@@ -0,0 +1,137 @@
+#pragma once
+
+extern "C" {
+#include "libavutil/error.h"
+}
+
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <memory>
+#include <mediaxx.h>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// # 单个线程的诊断记录缓冲区
+/// - 单生产者（所属线程）单消费者（持有 [Diagnostics_c] 的锁取出），写入不加锁也不分配内存
+/// - 写满后丢弃新记录，保留最早的错误
+class DiagRing_c {
+public:
+
+    inline static constexpr size_t cCapacity = 256;
+
+    std::atomic<uint64_t> dropped{0};
+
+    bool push(const MediaxxDiagRecord& record) {
+        const auto h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= cCapacity) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        records[h % cCapacity] = record;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t pop(MediaxxDiagRecord* out, size_t capacity) {
+        auto       t     = tail.load(std::memory_order_relaxed);
+        const auto h     = head.load(std::memory_order_acquire);
+        size_t     count = 0;
+        for (; t != h && count < capacity; ++t, ++count) {
+            out[count] = records[t % cCapacity];
+        }
+        tail.store(t, std::memory_order_release);
+        return count;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    /// 未取出的记录数
+    size_t size() const {
+        return size_t(head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire));
+    }
+
+protected:
+
+    std::array<MediaxxDiagRecord, cCapacity> records{};
+    // 生产者和消费者分别修改，放在不同的缓存行
+    alignas(64) std::atomic<uint64_t>        head{0};
+    alignas(64) std::atomic<uint64_t>        tail{0};
+};
+
+/// # 结构化的错误记录
+/// - 出错时只写入当前线程的 [DiagRing_c]；文字在需要时才由 [formatTo] 生成
+/// - 只有 [MEDIAXX_LOG_MODE_RECORD] 的请求写入，见 [MediaInfoItem_c::setError]
+/// - 线程结束时缓冲区为空则立即释放，否则保留到记录被取出；保留的缓冲区最多 [cMaxRetiredRings] 个，
+///   超出时丢弃最早的，其中的记录计入 [droppedCount]
+class Diagnostics_c {
+public:
+
+    inline static constexpr size_t cMaxRetiredRings = 16;
+
+    static Diagnostics_c instance;
+
+    void report(
+        unsigned short   stage,
+        unsigned short   code,
+        int              avError,
+        int              streamIndex,
+        std::string_view subject
+    );
+
+    size_t drain(MediaxxDiagRecord* out, size_t capacity);
+
+    /// 线程结束时调用，[ring] 为该线程的缓冲区
+    void retire(std::shared_ptr<DiagRing_c>&& ring);
+
+    uint64_t droppedCount();
+
+    static std::string_view stageName(unsigned short stage);
+
+    static std::string_view codeText(unsigned short code);
+
+    /// 追加一条错误的文字：`说明: 路径, 流: 下标, 错误: ffmpeg 错误`
+    template<typename String>
+    static void formatTo(
+        String&          out,
+        unsigned short   code,
+        int              avError,
+        int              streamIndex,
+        std::string_view subject
+    ) {
+        out.append(codeText(code));
+        if (false == subject.empty()) {
+            out.append(": ");
+            out.append(subject);
+        }
+        if (streamIndex >= 0) {
+            char buffer[16];
+            auto end = std::to_chars(buffer, buffer + sizeof(buffer), streamIndex).ptr;
+            out.append(", 流: ");
+            out.append(buffer, end - buffer);
+        }
+        if (0 != avError) {
+            char buffer[AV_ERROR_MAX_STRING_SIZE] = {0};
+            av_make_error_string(buffer, sizeof(buffer), avError);
+            out.append(", 错误: ");
+            out.append(buffer);
+        }
+    }
+
+    /// 每条一行，带阶段前缀
+    static std::string format(const MediaxxDiagRecord* records, size_t count);
+
+protected:
+
+    std::mutex                               mutex{};
+    std::vector<std::shared_ptr<DiagRing_c>> rings{};
+    // 已移除的缓冲区丢弃的数量
+    uint64_t                                 retiredDropped = 0;
+
+    DiagRing_c& localRing();
+};
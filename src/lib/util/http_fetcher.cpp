@@ -0,0 +1,722 @@
+#include "http_fetcher.h"
+#include "util/log.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <format>
+#include <vector>
+
+namespace {
+    // 解析 `http://host[:port]/path`，不支持 userinfo
+    bool parseHttpUrl(
+        std::string_view url,
+        std::string&     host,
+        std::string&     port,
+        std::string&     target
+    ) {
+        constexpr auto scheme = std::string_view{"http://"};
+        if (url.size() <= scheme.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < scheme.size(); ++i) {
+            if (std::tolower(static_cast<unsigned char>(url[i])) != scheme[i]) {
+                return false;
+            }
+        }
+        url.remove_prefix(scheme.size());
+        const auto end       = url.find_first_of("/?#");
+        auto       authority = url.substr(0, end);
+        target               = (end == std::string_view::npos) ? "/" : std::string{url.substr(end)};
+        if (target.front() != '/') {
+            target.insert(0, "/");
+        }
+        if (const auto hash = target.find('#'); hash != std::string::npos) {
+            target.resize(hash);
+        }
+        port = "80";
+        if (authority.starts_with('[')) {
+            // IPv6 字面量
+            const auto close = authority.find(']');
+            if (close == std::string_view::npos) {
+                return false;
+            }
+            host = std::string{authority.substr(1, close - 1)};
+            if (close + 1 < authority.size() && authority[close + 1] == ':') {
+                port = std::string{authority.substr(close + 2)};
+            }
+        } else if (const auto colon = authority.rfind(':'); colon != std::string_view::npos) {
+            host = std::string{authority.substr(0, colon)};
+            port = std::string{authority.substr(colon + 1)};
+        } else {
+            host = std::string{authority};
+        }
+        return false == host.empty() && false == port.empty();
+    }
+
+    bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+                   return std::tolower(static_cast<unsigned char>(x))
+                       == std::tolower(static_cast<unsigned char>(y));
+               });
+    }
+
+    std::string_view trim(std::string_view str) {
+        while (false == str.empty() && (str.front() == ' ' || str.front() == '\t')) {
+            str.remove_prefix(1);
+        }
+        while (false == str.empty() && (str.back() == ' ' || str.back() == '\t' || str.back() == '\r')) {
+            str.remove_suffix(1);
+        }
+        return str;
+    }
+
+    int64_t parseInt64(std::string_view str, int base = 10) {
+        int64_t value = 0;
+        bool    any   = false;
+        for (char c : str) {
+            int digit = -1;
+            if (c >= '0' && c <= '9') {
+                digit = c - '0';
+            } else if (base == 16 && c >= 'a' && c <= 'f') {
+                digit = c - 'a' + 10;
+            } else if (base == 16 && c >= 'A' && c <= 'F') {
+                digit = c - 'A' + 10;
+            }
+            if (digit < 0) {
+                break;
+            }
+            value = value * base + digit;
+            any   = true;
+        }
+        return any ? value : -1;
+    }
+} // namespace
+
+bool HttpFetcher_c::isSupportedUrl(std::string_view url) {
+    std::string host{}, port{}, target{};
+    return parseHttpUrl(url, host, port, target);
+}
+
+#if _ISLINUX || _ISANDROID
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// 域名解析线程数；大部分请求指向同一服务器，命中缓存后不再占用
+static constexpr size_t cResolverThreads = 4;
+
+struct HttpFetcher_c::Connection {
+    HttpRangeRequest request{};
+    std::string      url{};
+    std::string      host{};
+    std::string      port{};
+    std::string      target{};
+    // sockaddr 的原始字节
+    std::string      addr{};
+    int              fd        = -1;
+    int              redirects = 0;
+    int64_t          lastActiveMs = 0;
+
+    std::string sendBuf{};
+    size_t      sent = 0;
+
+    std::string headerBuf{};
+    bool        headerDone    = false;
+    bool        chunked       = false;
+    int64_t     contentLength = -1;
+    int64_t     bodyReceived  = 0;
+    // 服务器忽略 Range 返回 200 时，需要丢弃的前置字节
+    int64_t     skip          = 0;
+    std::string location{};
+
+    // chunked 解码状态：-1 读取长度行，-2 读取数据后的 CRLF，>= 0 当前块剩余字节
+    std::string chunkBuf{};
+    int64_t     chunkRemain = -1;
+
+    HttpRangeResult result{};
+
+    bool setUrl(const std::string_view in_url) {
+        url = std::string{in_url};
+        return parseHttpUrl(url, host, port, target);
+    }
+
+    std::string addrKey() const {
+        return std::string{host}.append(":").append(port);
+    }
+
+    /// `host[:port]`，用于 Host 头和重定向；IPv6 字面量加上方括号，默认端口省略
+    std::string authority() const {
+        auto result = (host.find(':') != std::string::npos) ? std::format("[{}]", host) : host;
+        if (port != "80") {
+            result.append(":").append(port);
+        }
+        return result;
+    }
+
+    /// 按 RFC 3986 把 Location 解析为绝对地址：完整地址、`//host/path`、`/path` 和相对路径
+    std::string resolveLocation(std::string_view location) const {
+        if (location.find("://") != std::string_view::npos) {
+            return std::string{location};
+        }
+        if (location.starts_with("//")) {
+            return std::string{"http:"}.append(location);
+        }
+        auto result = std::string{"http://"}.append(authority());
+        if (location.starts_with('/')) {
+            return result.append(location);
+        }
+        // 相对当前路径所在的目录；`?query` 只替换查询参数
+        auto path = std::string_view{target}.substr(0, target.find('?'));
+        if (location.starts_with('?')) {
+            return result.append(path).append(location);
+        }
+        return result.append(path.substr(0, path.rfind('/') + 1)).append(location);
+    }
+
+    void resetForRedirect() {
+        fd = -1;
+        sendBuf.clear();
+        sent = 0;
+        headerBuf.clear();
+        headerDone    = false;
+        chunked       = false;
+        contentLength = -1;
+        bodyReceived  = 0;
+        skip          = 0;
+        location.clear();
+        chunkBuf.clear();
+        chunkRemain = -1;
+        result      = HttpRangeResult{};
+    }
+};
+
+static int64_t _nowMs() {
+    return RequestInterrupt::nowUs() / 1000;
+}
+
+void HttpFetcher_c::complete(Connection& conn, int error, std::string message) {
+    conn.result.error      = error;
+    conn.result.finalUrl   = conn.url;
+    conn.result.deadlineUs = conn.request.interrupt.deadlineUs;
+    conn.result.message    = std::move(message);
+    if (conn.request.onDone) {
+        auto onDone = std::move(conn.request.onDone);
+        onDone(std::move(conn.result));
+    }
+}
+
+HttpFetcher_c::HttpFetcher_c() {}
+
+HttpFetcher_c::~HttpFetcher_c() {
+    // 先等待解析线程退出，之后不会再有新的请求进入 [incoming]
+    resolver.reset();
+    if (loopThread.joinable()) {
+        {
+            std::lock_guard lock{mutex};
+            stopping = true;
+        }
+        uint64_t one = 1;
+        write(wakefd, &one, sizeof(one));
+        loopThread.join();
+    }
+    for (auto& [fd, conn] : active) {
+        close(fd);
+        complete(*conn, -1, "请求被终止");
+    }
+    active.clear();
+    for (auto& conn : waiting) {
+        complete(*conn, -1, "请求被终止");
+    }
+    waiting.clear();
+    for (auto& conn : incoming) {
+        complete(*conn, -1, "请求被终止");
+    }
+    incoming.clear();
+    if (epfd >= 0) {
+        close(epfd);
+    }
+    if (wakefd >= 0) {
+        close(wakefd);
+    }
+}
+
+bool HttpFetcher_c::isAvail() const {
+    return true;
+}
+
+void HttpFetcher_c::ensureStarted() {
+    // 首次使用时才创建线程，避免加载动态库时就启动
+    std::call_once(startOnce, [this] {
+        epfd   = epoll_create1(EPOLL_CLOEXEC);
+        wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epfd < 0 || wakefd < 0) {
+            LXX_ERR("HttpFetcher_c: 创建 epoll/eventfd 失败: {}", strerror(errno));
+            return;
+        }
+        struct epoll_event ev{};
+        ev.events  = EPOLLIN;
+        ev.data.fd = wakefd;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, wakefd, &ev);
+        resolver   = std::make_unique<ThreadPool_c>(cResolverThreads);
+        loopThread = std::thread{[this] { runLoop(); }};
+    });
+}
+
+void HttpFetcher_c::fetch(HttpRangeRequest&& request) {
+    auto conn     = std::make_unique<Connection>();
+    conn->request = std::move(request);
+    if (false == conn->setUrl(conn->request.url)) {
+        complete(*conn, -1, std::format("不支持的地址: {}", conn->request.url));
+        return;
+    }
+    ensureStarted();
+    if (false == loopThread.joinable()) {
+        complete(*conn, -1, "事件循环不可用");
+        return;
+    }
+    resolveAndQueue(std::move(conn));
+}
+
+void HttpFetcher_c::queueIncoming(std::unique_ptr<Connection> conn) {
+    {
+        std::lock_guard lock{mutex};
+        incoming.push_back(std::move(conn));
+    }
+    uint64_t one = 1;
+    write(wakefd, &one, sizeof(one));
+}
+
+void HttpFetcher_c::resolveAndQueue(std::unique_ptr<Connection> conn) {
+    const auto key = conn->addrKey();
+    {
+        std::lock_guard lock{dnsMutex};
+        auto            it = dnsCache.find(key);
+        if (it != dnsCache.end()) {
+            conn->addr = it->second;
+            queueIncoming(std::move(conn));
+            return;
+        }
+    }
+    // std::function 要求可拷贝，这里转交裸指针
+    resolver->post([this, raw = conn.release(), key] {
+        auto            conn  = std::unique_ptr<Connection>{raw};
+        struct addrinfo hints{};
+        hints.ai_family      = AF_UNSPEC;
+        hints.ai_socktype    = SOCK_STREAM;
+        struct addrinfo* res = nullptr;
+        const int        err = getaddrinfo(conn->host.c_str(), conn->port.c_str(), &hints, &res);
+        if (err != 0 || nullptr == res) {
+            complete(*conn, -1, std::format("域名解析失败: {} | {}", conn->host, gai_strerror(err)));
+            return;
+        }
+        conn->addr.assign(reinterpret_cast<const char*>(res->ai_addr), res->ai_addrlen);
+        freeaddrinfo(res);
+        {
+            std::lock_guard lock{dnsMutex};
+            dnsCache[key] = conn->addr;
+        }
+        queueIncoming(std::move(conn));
+    });
+}
+
+void HttpFetcher_c::runLoop() {
+    std::vector<struct epoll_event> events(256);
+    while (true) {
+        const int count = epoll_wait(epfd, events.data(), int(events.size()), 100);
+        for (int i = 0; i < count; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == wakefd) {
+                uint64_t value = 0;
+                read(wakefd, &value, sizeof(value));
+                continue;
+            }
+            auto it = active.find(fd);
+            if (it != active.end()) {
+                onEvent(*it->second, events[i].events);
+            }
+        }
+        {
+            std::lock_guard lock{mutex};
+            if (stopping) {
+                return;
+            }
+            while (false == incoming.empty()) {
+                waiting.push_back(std::move(incoming.front()));
+                incoming.pop_front();
+            }
+        }
+        while (active.size() < cMaxConnections && false == waiting.empty()) {
+            auto conn = std::move(waiting.front());
+            waiting.pop_front();
+            startConnection(std::move(conn));
+        }
+        checkTimeouts();
+    }
+}
+
+void HttpFetcher_c::startConnection(std::unique_ptr<Connection> conn) {
+    conn->request.interrupt.startDeadline();
+    if (conn->request.interrupt.isInterrupted()) {
+        complete(*conn, -2, "请求已取消或超时");
+        return;
+    }
+    const auto sa = reinterpret_cast<const struct sockaddr*>(conn->addr.data());
+    const int  fd = socket(sa->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        complete(*conn, -1, std::format("创建 socket 失败: {}", strerror(errno)));
+        return;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(fd, sa, socklen_t(conn->addr.size())) != 0 && errno != EINPROGRESS) {
+        const auto message = std::format("连接失败: {} | {}", conn->url, strerror(errno));
+        close(fd);
+        forgetAddress(*conn);
+        complete(*conn, -1, message);
+        return;
+    }
+
+    auto& req    = conn->request;
+    auto  header = std::format("GET {} HTTP/1.1\r\nHost: {}", conn->target, conn->authority());
+    header.append("\r\nAccept: */*\r\nAccept-Encoding: identity\r\nConnection: close\r\n");
+    if (req.length > 0) {
+        header.append(std::format("Range: bytes={}-{}\r\n", req.offset, req.offset + req.length - 1));
+    }
+    if (false == req.headers.empty()) {
+        header.append(req.headers);
+        if (false == req.headers.ends_with("\r\n")) {
+            header.append("\r\n");
+        }
+    }
+    header.append("\r\n");
+    conn->sendBuf      = std::move(header);
+    conn->fd           = fd;
+    conn->lastActiveMs = _nowMs();
+
+    struct epoll_event ev{};
+    ev.events  = EPOLLOUT | EPOLLIN | EPOLLRDHUP;
+    ev.data.fd = fd;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        const auto message = std::format("epoll_ctl 失败: {}", strerror(errno));
+        close(fd);
+        complete(*conn, -1, message);
+        return;
+    }
+    active.emplace(fd, std::move(conn));
+}
+
+void HttpFetcher_c::onEvent(Connection& conn, uint32_t events) {
+    const int fd = conn.fd;
+    if ((events & EPOLLOUT) && conn.sent < conn.sendBuf.size()) {
+        if (conn.sent == 0) {
+            // 非阻塞 connect 的结果
+            int       err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            if (err != 0) {
+                forgetAddress(conn);
+                finish(fd, -1, std::format("连接失败: {} | {}", conn.url, strerror(err)));
+                return;
+            }
+        }
+        while (conn.sent < conn.sendBuf.size()) {
+            const auto n = send(
+                fd,
+                conn.sendBuf.data() + conn.sent,
+                conn.sendBuf.size() - conn.sent,
+                MSG_NOSIGNAL
+            );
+            if (n < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    return;
+                }
+                finish(fd, -1, std::format("发送请求失败: {}", strerror(errno)));
+                return;
+            }
+            conn.sent         += size_t(n);
+            conn.lastActiveMs  = _nowMs();
+        }
+        struct epoll_event ev{};
+        ev.events  = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev);
+    }
+    if (0 == (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+        return;
+    }
+    char buffer[64 * 1024];
+    while (true) {
+        const auto n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+            finish(fd, -1, std::format("接收数据失败: {}", strerror(errno)));
+            return;
+        }
+        if (n == 0) {
+            // 对端关闭：头部完整时，已收到的数据就是资源末尾
+            if (conn.headerDone) {
+                finish(fd, 0, {});
+            } else {
+                finish(fd, -1, std::format("连接被关闭: {}", conn.url));
+            }
+            return;
+        }
+        conn.lastActiveMs = _nowMs();
+        const char* data  = buffer;
+        size_t      size  = size_t(n);
+        if (false == conn.headerDone) {
+            const auto oldSize = conn.headerBuf.size();
+            conn.headerBuf.append(data, size);
+            const auto end = conn.headerBuf.find("\r\n\r\n");
+            if (end == std::string::npos) {
+                if (conn.headerBuf.size() > 64 * 1024) {
+                    finish(fd, -1, "响应头过长");
+                    return;
+                }
+                continue;
+            }
+            conn.headerDone = true;
+            // 头部之后的部分属于响应体
+            const auto bodyStart  = end + 4 - oldSize;
+            data                 += bodyStart;
+            size                 -= bodyStart;
+            conn.headerBuf.resize(end + 2);
+            if (false == parseHeader(conn)) {
+                return;
+            }
+        }
+        if (consumeBody(conn, data, size)) {
+            finish(fd, 0, {});
+            return;
+        }
+    }
+}
+
+bool HttpFetcher_c::parseHeader(Connection& conn) {
+    const int  fd    = conn.fd;
+    auto       view  = std::string_view{conn.headerBuf};
+    const auto eol   = view.find("\r\n");
+    const auto line  = view.substr(0, eol);
+    const auto space = line.find(' ');
+    if (false == line.starts_with("HTTP/") || space == std::string_view::npos) {
+        finish(fd, -1, "无效的 HTTP 响应");
+        return false;
+    }
+    conn.result.status = int(parseInt64(line.substr(space + 1)));
+    view.remove_prefix(eol + 2);
+
+    int64_t rangeStart = -1;
+    while (false == view.empty()) {
+        const auto end    = view.find("\r\n");
+        const auto header = view.substr(0, end);
+        view.remove_prefix(end == std::string_view::npos ? view.size() : end + 2);
+        const auto colon = header.find(':');
+        if (colon == std::string_view::npos) {
+            continue;
+        }
+        const auto name  = trim(header.substr(0, colon));
+        const auto value = trim(header.substr(colon + 1));
+        if (equalsIgnoreCase(name, "content-length")) {
+            conn.contentLength = parseInt64(value);
+        } else if (equalsIgnoreCase(name, "transfer-encoding")) {
+            conn.chunked = (value.find("chunked") != std::string_view::npos);
+        } else if (equalsIgnoreCase(name, "location")) {
+            conn.location = std::string{value};
+        } else if (equalsIgnoreCase(name, "content-range")) {
+            // bytes 0-1023/4096 或 bytes */4096
+            const auto slash = value.rfind('/');
+            if (slash != std::string_view::npos) {
+                conn.result.totalSize = parseInt64(value.substr(slash + 1));
+            }
+            const auto space = value.find(' ');
+            if (space != std::string_view::npos) {
+                rangeStart = parseInt64(value.substr(space + 1));
+            }
+        }
+    }
+
+    const auto status = conn.result.status;
+    const auto& req   = conn.request;
+    if (status >= 300 && status < 400 && false == conn.location.empty()) {
+        if (++conn.redirects > cMaxRedirects) {
+            finish(fd, -1, "重定向次数过多");
+            return false;
+        }
+        const auto next = conn.resolveLocation(conn.location);
+        if (false == isSupportedUrl(next)) {
+            // 多为跳转到 https，由调用方回退
+            finish(fd, -1, std::format("不支持的重定向地址: {}", next));
+            return false;
+        }
+        auto node = active.extract(fd);
+        close(fd);
+        auto moved = std::move(node.mapped());
+        moved->resetForRedirect();
+        moved->setUrl(next);
+        resolveAndQueue(std::move(moved));
+        return false;
+    }
+    if (status == 206) {
+        conn.result.offset = rangeStart >= 0 ? rangeStart : req.offset;
+    } else if (status == 200) {
+        // 服务器不支持 Range，从头返回整个资源：丢弃 [offset] 之前的部分，读够 [length] 后断开
+        conn.skip          = req.offset;
+        conn.result.offset = req.offset;
+        if (false == conn.chunked) {
+            conn.result.totalSize = conn.contentLength;
+        }
+    } else if (status == 416) {
+        // 请求的范围超出资源末尾
+        conn.result.offset = req.offset;
+        finish(fd, 0, {});
+        return false;
+    } else {
+        finish(fd, -1, std::format("HTTP 状态码: {} | {}", status, conn.url));
+        return false;
+    }
+    return true;
+}
+
+bool HttpFetcher_c::consumeBody(Connection& conn, const char* data, size_t size) {
+    const auto limit  = conn.request.length;
+    auto       append = [&conn, limit](const char* ptr, size_t len) {
+        if (conn.skip > 0) {
+            const auto drop  = std::min<int64_t>(conn.skip, int64_t(len));
+            ptr             += drop;
+            len             -= size_t(drop);
+            conn.skip       -= drop;
+        }
+        if (limit > 0) {
+            len = std::min<size_t>(len, size_t(limit - int64_t(conn.result.data.size())));
+        }
+        conn.result.data.append(ptr, len);
+        return limit > 0 && int64_t(conn.result.data.size()) >= limit;
+    };
+
+    if (false == conn.chunked) {
+        conn.bodyReceived += int64_t(size);
+        if (append(data, size)) {
+            return true;
+        }
+        return conn.contentLength >= 0 && conn.bodyReceived >= conn.contentLength;
+    }
+
+    conn.chunkBuf.append(data, size);
+    size_t pos = 0;
+    while (pos < conn.chunkBuf.size()) {
+        if (conn.chunkRemain == -1) {
+            const auto eol = conn.chunkBuf.find("\r\n", pos);
+            if (eol == std::string::npos) {
+                break;
+            }
+            const auto chunkSize = parseInt64(std::string_view{conn.chunkBuf}.substr(pos, eol - pos), 16);
+            pos                  = eol + 2;
+            if (chunkSize <= 0) {
+                // 最后一个块
+                return true;
+            }
+            conn.chunkRemain = chunkSize;
+        } else if (conn.chunkRemain == -2) {
+            if (conn.chunkBuf.size() - pos < 2) {
+                break;
+            }
+            pos              += 2;
+            conn.chunkRemain  = -1;
+        } else {
+            const auto take = std::min<size_t>(size_t(conn.chunkRemain), conn.chunkBuf.size() - pos);
+            if (append(conn.chunkBuf.data() + pos, take)) {
+                return true;
+            }
+            pos              += take;
+            conn.chunkRemain -= int64_t(take);
+            if (conn.chunkRemain == 0) {
+                conn.chunkRemain = -2;
+            }
+        }
+    }
+    conn.chunkBuf.erase(0, pos);
+    return false;
+}
+
+void HttpFetcher_c::forgetAddress(const Connection& conn) {
+    // 地址可能已经变化（如 DNS 轮换、服务器迁移），下次重新解析
+    std::lock_guard lock{dnsMutex};
+    dnsCache.erase(conn.addrKey());
+}
+
+void HttpFetcher_c::finish(int fd, int error, std::string message) {
+    auto node = active.extract(fd);
+    close(fd);
+    if (node.empty()) {
+        return;
+    }
+    auto& conn = *node.mapped();
+    if (error == 0 && conn.result.totalSize < 0 && conn.request.length > 0
+        && int64_t(conn.result.data.size()) < conn.request.length) {
+        // 提前结束，说明已读到资源末尾
+        conn.result.totalSize = conn.result.offset + int64_t(conn.result.data.size());
+    }
+    complete(conn, error, std::move(message));
+}
+
+void HttpFetcher_c::checkTimeouts() {
+    const auto           now = _nowMs();
+    std::vector<int>     interrupted{};
+    std::vector<int>     idle{};
+    for (const auto& [fd, conn] : active) {
+        if (conn->request.interrupt.isInterrupted()) {
+            interrupted.push_back(fd);
+        } else if (now - conn->lastActiveMs > cIdleTimeoutMs) {
+            idle.push_back(fd);
+        }
+    }
+    for (const auto fd : interrupted) {
+        finish(fd, -2, "请求已取消或超时");
+    }
+    for (const auto fd : idle) {
+        finish(fd, -1, "网络读写超时");
+    }
+    // 排队中的请求也要及时响应取消
+    for (auto it = waiting.begin(); it != waiting.end();) {
+        if ((*it)->request.interrupt.isInterrupted()) {
+            complete(**it, -2, "请求已取消或超时");
+            it = waiting.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+#else
+
+struct HttpFetcher_c::Connection {};
+
+HttpFetcher_c::HttpFetcher_c() {}
+
+HttpFetcher_c::~HttpFetcher_c() {}
+
+bool HttpFetcher_c::isAvail() const {
+    return false;
+}
+
+void HttpFetcher_c::fetch(HttpRangeRequest&& request) {
+    HttpRangeResult result{};
+    result.error   = -1;
+    result.message = "当前平台不支持";
+    if (request.onDone) {
+        request.onDone(std::move(result));
+    }
+}
+
+#endif
+
+// 定义放在 [Connection] 完整定义之后
+HttpFetcher_c HttpFetcher_c::instance;
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "util/cancel_token.h"
+#include "util/thread_pool.h"
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+/// 一次范围请求的结果
+struct HttpRangeResult {
+    // 0 成功，-1 失败，-2 取消或超时
+    int         error     = -1;
+    int         status    = 0;
+    // 整个资源的大小，未知时为 -1
+    int64_t     totalSize = -1;
+    // [data] 在资源中的起始位置
+    int64_t     offset    = 0;
+    std::string data{};
+    // 跟随重定向后的最终地址，后续请求直接使用，避免重复跳转
+    std::string finalUrl{};
+    // 请求的截止时间：延迟计时的请求在开始连接时才确定，后续请求沿用
+    int64_t     deadlineUs = 0;
+    std::string message{};
+};
+
+struct HttpRangeRequest {
+    std::string     url{};
+    // 附加请求头，格式同 ffmpeg 的 `headers` 选项：`Key: Value\r\n`
+    std::string     headers{};
+    int64_t         offset = 0;
+    int64_t         length = 0;
+    // 取消句柄和截止时间；取消句柄必须在回调之前保持有效
+    // - [RequestInterrupt::deferTimeout] 的超时在开始连接时计时，排队等待连接数的时间不计入
+    RequestInterrupt interrupt{};
+    // 在内部的网络线程中调用，不能执行耗时操作
+    std::function<void(HttpRangeResult&&)> onDone{};
+};
+
+/// # 基于 epoll 的 HTTP 范围请求
+/// - 所有连接在同一个事件循环线程中以非阻塞方式收发，数千个请求同时进行也只占用一个线程
+/// - 仅支持 `http://`；`https://` 需要 TLS，由调用方回退到 ffmpeg 自身的协议实现
+/// - 域名解析是阻塞调用，放在单独的小线程池中执行，并缓存结果
+/// - 仅 Linux/Android 可用，其他平台 [isAvail] 返回 false
+class HttpFetcher_c {
+public:
+
+    // 同时进行的最大连接数，超出的请求会排队
+    inline static constexpr size_t  cMaxConnections = 1024;
+    // 连接在此时间内没有任何收发则视为超时（毫秒）
+    inline static constexpr int64_t cIdleTimeoutMs  = 30000;
+    inline static constexpr int     cMaxRedirects   = 5;
+
+    static HttpFetcher_c instance;
+
+    HttpFetcher_c();
+
+    ~HttpFetcher_c();
+
+    bool isAvail() const;
+
+    static bool isSupportedUrl(std::string_view url);
+
+    /// 提交请求，结果通过 [HttpRangeRequest::onDone] 返回；任何情况下回调都只会调用一次
+    void fetch(HttpRangeRequest&& request);
+
+protected:
+
+    struct Connection;
+
+    std::once_flag startOnce{};
+    int         epfd     = -1;
+    // 用于唤醒事件循环
+    int         wakefd   = -1;
+    bool        stopping = false;
+    std::thread loopThread{};
+
+    // 以下容器不写 `{}` 初始化，否则会在 [Connection] 不完整的翻译单元中实例化析构
+    std::mutex                                   mutex{};
+    // 已解析地址、等待建立连接的请求
+    std::deque<std::unique_ptr<Connection>>      incoming;
+    // 仅事件循环线程访问
+    std::deque<std::unique_ptr<Connection>>      waiting;
+    std::unordered_map<int, std::unique_ptr<Connection>> active;
+
+    std::mutex                                   dnsMutex{};
+    std::unordered_map<std::string, std::string> dnsCache{};
+    std::unique_ptr<ThreadPool_c>                resolver{};
+
+    static void complete(Connection& conn, int error, std::string message);
+
+    void ensureStarted();
+
+    void queueIncoming(std::unique_ptr<Connection> conn);
+
+    void resolveAndQueue(std::unique_ptr<Connection> conn);
+
+    /// 连接失败时移除 [dnsCache] 中的地址
+    void forgetAddress(const Connection& conn);
+
+    void runLoop();
+
+    void startConnection(std::unique_ptr<Connection> conn);
+
+    void onEvent(Connection& conn, uint32_t events);
+
+    bool parseHeader(Connection& conn);
+
+    bool consumeBody(Connection& conn, const char* data, size_t size);
+
+    void finish(int fd, int error, std::string message);
+
+    void checkTimeouts();
+};
@@ -1,5 +1,10 @@
 #pragma once
 
+#include "simdjson.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
 #define strBuilderAppendFixdKeyVPtr_d(result, key, vptr) \
     {                                                    \
         auto vp = vptr;                                  \
@@ -8,3 +13,26 @@
             result.append_comma();                       \
         }                                                \
     }
+
+/// 解析 json 字符串数组，如 `["a", "b"]`
+inline bool jsonParseStringArray(const std::string_view json, std::vector<std::string>& out) {
+    simdjson::ondemand::parser   parser{};
+    auto                         padded = simdjson::padded_string{json};
+    simdjson::ondemand::document doc{};
+    if (parser.iterate(padded).get(doc) != simdjson::SUCCESS) {
+        return false;
+    }
+    simdjson::ondemand::array arr{};
+    if (doc.get_array().get(arr) != simdjson::SUCCESS) {
+        return false;
+    }
+    for (auto element : arr) {
+        std::string_view str{};
+        if (element.get_string().get(str) != simdjson::SUCCESS) {
+            return false;
+        }
+        // string_view 指向解析器内部缓冲区，需要拷贝
+        out.emplace_back(str);
+    }
+    return true;
+}
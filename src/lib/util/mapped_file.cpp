@@ -0,0 +1,70 @@
+#include "mapped_file.h"
+
+#if _ISLINUX || _ISANDROID || _ISMACOS || _ISIOS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool MappedFile_c::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NOCTTY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st{};
+    if (0 != fstat(fd, &st) || false == S_ISREG(st.st_mode) || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    const auto size = size_t(st.st_size);
+    void*      addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // 映射建立后即可关闭 fd
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    madvise(addr, size, MADV_SEQUENTIAL);
+    begin  = static_cast<const uint8_t*>(addr);
+    length = size;
+    return true;
+}
+
+void MappedFile_c::close() {
+    if (nullptr != begin) {
+        munmap(const_cast<uint8_t*>(begin), length);
+    }
+    begin  = nullptr;
+    length = 0;
+}
+
+#else
+#include <filesystem>
+#include <fstream>
+
+bool MappedFile_c::open(const std::string& path) {
+    close();
+    std::error_code ec{};
+    const auto      filePath = std::filesystem::path(path);
+    const auto      size     = std::filesystem::file_size(filePath, ec);
+    if (ec || 0 == size) {
+        return false;
+    }
+    std::ifstream file{filePath, std::ios::binary};
+    buffer.resize(size_t(size));
+    if (false == bool(file.read(buffer.data(), std::streamsize(size)))) {
+        buffer = std::string{};
+        return false;
+    }
+    begin  = reinterpret_cast<const uint8_t*>(buffer.data());
+    length = buffer.size();
+    return true;
+}
+
+void MappedFile_c::close() {
+    buffer = std::string{};
+    begin  = nullptr;
+    length = 0;
+}
+
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// # 只读映射整个文件
+/// - Linux/Android/macOS/iOS 使用 mmap，按顺序访问提示内核预读，不经过用户态缓冲区的拷贝；
+///   Windows 读取到内存中
+/// - 映射期间文件被截断时访问可能出错，只用于本地的媒体文件
+class MappedFile_c {
+public:
+
+    MappedFile_c() {}
+
+    ~MappedFile_c() {
+        close();
+    }
+
+    MappedFile_c(const MappedFile_c&)            = delete;
+    MappedFile_c& operator=(const MappedFile_c&) = delete;
+
+    /// 不是普通文件或为空时返回 false
+    bool open(const std::string& path);
+
+    void close();
+
+    const uint8_t* data() const {
+        return begin;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+protected:
+
+    const uint8_t* begin  = nullptr;
+    size_t         length = 0;
+    // 非 mmap 时的数据
+    std::string    buffer{};
+};
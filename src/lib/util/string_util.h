@@ -1,10 +1,15 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <mediaxx.h>
+#include <sstream>
 #include <string>
 #include <tuple>
 #include <unordered_set>
+#include <vector>
 
 namespace stringxx {
 
@@ -90,6 +95,81 @@ namespace stringxx {
         return true;
     }
 
+    /// 截取不超过 [maxSize] 字节的前缀，不切断多字节字符
+    inline std::string_view utf8Truncate(std::string_view str, size_t maxSize) {
+        if (str.size() <= maxSize) {
+            return str;
+        }
+        while (maxSize > 0 && utf8IsContinuationChar(static_cast<unsigned char>(str[maxSize]))) {
+            --maxSize;
+        }
+        return str.substr(0, maxSize);
+    }
+
+    /// 截取不超过 [maxSize] 字节的后缀，不切断多字节字符
+    inline std::string_view utf8TruncateFront(std::string_view str, size_t maxSize) {
+        if (str.size() <= maxSize) {
+            return str;
+        }
+        auto start = str.size() - maxSize;
+        while (start < str.size()
+               && utf8IsContinuationChar(static_cast<unsigned char>(str[start]))) {
+            ++start;
+        }
+        return str.substr(start);
+    }
+
+    /// 追加 Unicode 码点的 UTF-8 编码；无效的码点写入 U+FFFD
+    inline void utf8AppendCodePoint(std::string& out, uint32_t cp) {
+        if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+            cp = 0xFFFD;
+        }
+        if (cp < 0x80) {
+            out.push_back(char(cp));
+        } else if (cp < 0x800) {
+            out.push_back(char(0xC0 | (cp >> 6)));
+            out.push_back(char(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            out.push_back(char(0xE0 | (cp >> 12)));
+            out.push_back(char(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(char(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back(char(0xF0 | (cp >> 18)));
+            out.push_back(char(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(char(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(char(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    /// ISO-8859-1 转为 UTF-8 追加到 [out]
+    inline void latin1AppendToUtf8(std::string& out, std::string_view data) {
+        for (const auto ch : data) {
+            utf8AppendCodePoint(out, static_cast<unsigned char>(ch));
+        }
+    }
+
+    /// UTF-16 转为 UTF-8 追加到 [out]
+    /// - [data] 为原始字节，不含 BOM；奇数长度时忽略最后一个字节
+    /// - 不成对的代理项写入 U+FFFD
+    inline void utf16AppendToUtf8(std::string& out, std::string_view data, bool bigEndian) {
+        const auto unitAt = [&](size_t i) -> uint32_t {
+            const auto b0 = static_cast<unsigned char>(data[i]);
+            const auto b1 = static_cast<unsigned char>(data[i + 1]);
+            return bigEndian ? (uint32_t(b0) << 8 | b1) : (uint32_t(b1) << 8 | b0);
+        };
+        for (size_t i = 0; i + 1 < data.size(); i += 2) {
+            auto cp = unitAt(i);
+            if (cp >= 0xD800 && cp <= 0xDBFF && i + 3 < data.size()) {
+                const auto low = unitAt(i + 2);
+                if (low >= 0xDC00 && low <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    i += 2;
+                }
+            }
+            utf8AppendCodePoint(out, cp);
+        }
+    }
+
     inline std::vector<std::string> strSplit(const std::string& in_str, char in_char) {
         std::vector<std::string> re_strlist{};
         std::istringstream       iss{in_str};                         // 输入流
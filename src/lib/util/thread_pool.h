@@ -0,0 +1,80 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// # 固定大小的线程池
+/// - 任务按提交顺序执行；析构时会执行完已提交的任务再退出
+class ThreadPool_c {
+public:
+
+    explicit ThreadPool_c(size_t threadCount) {
+        if (threadCount == 0) {
+            threadCount = 1;
+        }
+        workers.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; ++i) {
+            workers.emplace_back([this] { run(); });
+        }
+    }
+
+    ~ThreadPool_c() {
+        {
+            std::lock_guard lock{mutex};
+            stopping = true;
+        }
+        cond.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool_c(const ThreadPool_c&)            = delete;
+    ThreadPool_c& operator=(const ThreadPool_c&) = delete;
+
+    void post(std::function<void()> task) {
+        {
+            std::lock_guard lock{mutex};
+            tasks.push_back(std::move(task));
+        }
+        cond.notify_one();
+    }
+
+    size_t size() const {
+        return workers.size();
+    }
+
+    /// 默认线程数：CPU 核心数
+    static size_t defaultThreadCount() {
+        const auto count = std::thread::hardware_concurrency();
+        return count > 0 ? count : 4;
+    }
+
+protected:
+
+    std::vector<std::thread>          workers{};
+    std::deque<std::function<void()>> tasks{};
+    std::mutex                        mutex{};
+    std::condition_variable           cond{};
+    bool                              stopping = false;
+
+    void run() {
+        while (true) {
+            std::function<void()> task{};
+            {
+                std::unique_lock lock{mutex};
+                cond.wait(lock, [this] { return stopping || false == tasks.empty(); });
+                if (tasks.empty()) {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
@@ -1,3 +1,5 @@
+#pragma once
+
 #if _WIN32
 #include <windows.h>
 #undef max
@@ -19,6 +21,590 @@
 extern "C" {
 #endif
 
+/// # 请求参数
+/// - 字段为 0/nullptr 时使用默认值
+typedef struct MediaxxRequestOptions {
+    /// 可选，[mediaxx_cancel_token_create] 创建的取消句柄
+    void*        cancelToken;
+    /// 可选，整个请求的截止时长（毫秒），<= 0 时不限制；
+    /// 网络单次读写的超时同时受此限制，默认 30 秒
+    long long    timeoutMs;
+    /// 可选，HLS/DASH 地址非 0 时额外下载初始化分段和第一个媒体分段，以获取 `streams` 的编码详情；
+    /// 为 0 时只解析播放列表，`streams` 为空
+    int          streamDetails;
+    /// 可选，[outResult] 的格式：[MEDIAXX_RESULT_FORMAT_JSON]（默认）或 [MEDIAXX_RESULT_FORMAT_BINARY]
+    int          resultFormat;
+    /// 可选，需要输出的字段，[MEDIAXX_FIELD_FORMAT] 等的组合，0 表示全部；
+    /// 不需要 [MEDIAXX_FIELD_FORMAT] 和 [MEDIAXX_FIELD_STREAMS] 时跳过流探测，只读取标签会快很多
+    /// HLS/DASH 播放列表的 `manifest` 随 [MEDIAXX_FIELD_FORMAT] 输出
+    unsigned int fieldMask;
+    /// 可选，错误的记录方式：[MEDIAXX_LOG_MODE_TEXT]（默认）或 [MEDIAXX_LOG_MODE_RECORD]
+    int          logMode;
+    /// 可选，信息中单个标签值的长度上限（字节），0 为 [MEDIAXX_DEF_MAX_TAG_SIZE]，< 0 不限制；
+    /// 超出的值（内嵌歌词、`METADATA_BLOCK_PICTURE`、cuesheet 等）截断，完整内容用 [mediaxx_get_tag_malloc] 获取
+    int          maxTagSize;
+} MediaxxRequestOptions;
+
+#define MEDIAXX_RESULT_FORMAT_JSON   0
+#define MEDIAXX_RESULT_FORMAT_BINARY 1
+/// 只用于批量读取：重复的字符串存入共享的字典，各项只保存编号，见 [MediaxxInfoDictHeader]；
+/// 其他接口按 [MEDIAXX_RESULT_FORMAT_BINARY] 处理
+#define MEDIAXX_RESULT_FORMAT_DICT   2
+
+/// 错误只写入 [outLog] 的文字日志，不写入诊断记录
+#define MEDIAXX_LOG_MODE_TEXT   0
+/// 错误只写入诊断记录，不格式化文字；批量扫描大量非媒体文件时可省去字符串的开销
+#define MEDIAXX_LOG_MODE_RECORD 1
+
+/// [MediaxxRequestOptions.maxTagSize] 的默认值
+#define MEDIAXX_DEF_MAX_TAG_SIZE 16384
+
+/// format 的基本字段：时长、码率、大小等
+#define MEDIAXX_FIELD_FORMAT       0x01
+/// format 的标签：标题、艺术家、歌词等
+#define MEDIAXX_FIELD_FORMAT_TAGS  0x02
+/// streams 的基本字段；以下 stream 相关的位只在包含此位时有效
+#define MEDIAXX_FIELD_STREAMS      0x04
+/// json 中 stream 的 `r_frame_rate`、`avg_frame_rate`、`time_base` 字符串
+#define MEDIAXX_FIELD_STREAM_RATES 0x08
+#define MEDIAXX_FIELD_STREAM_TAGS  0x10
+/// 视频流的宽高、帧率、颜色等
+#define MEDIAXX_FIELD_VIDEO        0x20
+/// 音频流的采样率、声道、采样格式等
+#define MEDIAXX_FIELD_AUDIO        0x40
+/// 规范化的标签：键统一为 [MEDIAXX_TAG_TITLE] 等，多值字段已拆分去重；json 中为 `tags_normalized`
+#define MEDIAXX_FIELD_NORM_TAGS    0x80
+#define MEDIAXX_FIELD_ALL          0xFF
+
+/// 规范化的标签键，见 [MediaxxInfoNormTag]
+#define MEDIAXX_TAG_UNKNOWN      0
+#define MEDIAXX_TAG_TITLE        1
+/// 多值
+#define MEDIAXX_TAG_ARTIST       2
+#define MEDIAXX_TAG_ALBUM        3
+/// 多值
+#define MEDIAXX_TAG_ALBUM_ARTIST 4
+/// 多值
+#define MEDIAXX_TAG_GENRE        5
+/// 多值
+#define MEDIAXX_TAG_COMPOSER     6
+/// 多值
+#define MEDIAXX_TAG_LYRICIST     7
+/// 多值
+#define MEDIAXX_TAG_PERFORMER    8
+#define MEDIAXX_TAG_DATE         9
+/// 原始文本，可能为 `3/12` 的形式
+#define MEDIAXX_TAG_TRACK        10
+#define MEDIAXX_TAG_DISC         11
+#define MEDIAXX_TAG_COMMENT      12
+#define MEDIAXX_TAG_PUBLISHER    13
+#define MEDIAXX_TAG_COPYRIGHT    14
+
+/// 二进制结果的标识，内存中的字节为 "MXIF" / "MXBT" / "MXDT"
+#define MEDIAXX_INFO_MAGIC       0x4649584D
+#define MEDIAXX_INFO_BATCH_MAGIC 0x5442584D
+#define MEDIAXX_INFO_DICT_MAGIC  0x5444584D
+/// 布局变化时递增；只在结构体末尾追加字段时不变，读取方用 `headerSize`/`streamSize` 跳过未知字段
+#define MEDIAXX_INFO_VERSION     1
+
+/// # 二进制结果中的字符串
+/// - [offset] 相对于所在结果（[MediaxxInfoHeader] 或 [MediaxxInfoBatchHeader]）开头的偏移，0 表示不存在
+/// - 字符串均为 UTF-8，以 '\0' 结尾，[length] 不含 '\0'
+typedef struct MediaxxInfoString {
+    unsigned int offset;
+    unsigned int length;
+} MediaxxInfoString;
+
+typedef struct MediaxxInfoRational {
+    int num;
+    int den;
+} MediaxxInfoRational;
+
+typedef struct MediaxxInfoTag {
+    MediaxxInfoString key;
+    MediaxxInfoString value;
+} MediaxxInfoTag;
+
+/// # 被截断的标签，见 [MediaxxRequestOptions.maxTagSize]
+typedef struct MediaxxInfoTruncatedTag {
+    /// 在 [MediaxxInfoTag] 数组中的下标：从 [MediaxxInfoHeader.tagOffset] 开始，格式级别的在前，
+    /// 各流的依次在后
+    unsigned int tag;
+    /// 完整的长度（字节）
+    unsigned int length;
+} MediaxxInfoTruncatedTag;
+
+/// # 规范化的标签中的一个值
+/// - 按 [key] 升序排列；多值字段的每个值各占一项，保持原顺序
+typedef struct MediaxxInfoNormTag {
+    /// [MEDIAXX_TAG_TITLE] 等
+    unsigned int      key;
+    MediaxxInfoString value;
+} MediaxxInfoNormTag;
+
+/// # 二进制结果中的一个流
+/// - 与 json 的 `streams` 对应；不属于该类型的字段为 0
+typedef struct MediaxxInfoStream {
+    int                 index;
+    int                 codecId;
+    /// AVMediaType：0 视频，1 音频，3 字幕……
+    int                 codecType;
+    unsigned int        codecTag;
+    long long           bitRate;
+    long long           startTime;
+    /// 秒，时间基无效时为 0
+    double              duration;
+    int                 bitsPerSample;
+    int                 level;
+    MediaxxInfoRational rFrameRate;
+    MediaxxInfoRational avgFrameRate;
+    MediaxxInfoRational timeBase;
+    MediaxxInfoString   codecName;
+    MediaxxInfoString   codecLongName;
+    MediaxxInfoString   codecTypeName;
+    /// 该流的 [MediaxxInfoTag] 数组
+    unsigned int        tagOffset;
+    unsigned int        tagCount;
+    // 视频
+    int                 width;
+    int                 height;
+    MediaxxInfoRational framerate;
+    MediaxxInfoRational sampleAspectRatio;
+    double              fps;
+    MediaxxInfoString   colorRange;
+    MediaxxInfoString   colorSpace;
+    MediaxxInfoString   chromaLocation;
+    MediaxxInfoString   pixFmt;
+    // 音频
+    int                 sampleRate;
+    int                 channels;
+    int                 initialPadding;
+    int                 trailingPadding;
+    MediaxxInfoString   channelLayout;
+    MediaxxInfoString   sampleFmt;
+} MediaxxInfoStream;
+
+/// # 二进制格式的音视频信息
+/// - 布局：[MediaxxInfoHeader] | [MediaxxInfoStream] 数组 | [MediaxxInfoTag] 数组 |
+///   [MediaxxInfoNormTag] 数组 | [MediaxxInfoTruncatedTag] 数组 | 字符串
+/// - 所有偏移都相对于本结构体的开头，可以直接在原内存上读取，无需解析
+/// - 相同的标签字符串只存储一份
+/// - 总长度为 [totalSize]，8 字节对齐
+typedef struct MediaxxInfoHeader {
+    /// [MEDIAXX_INFO_MAGIC]
+    unsigned int      magic;
+    /// [MEDIAXX_INFO_VERSION]
+    unsigned short    version;
+    /// sizeof(MediaxxInfoHeader)
+    unsigned short    headerSize;
+    unsigned int      totalSize;
+    /// sizeof(MediaxxInfoStream)，遍历流时的步长
+    unsigned int      streamSize;
+    unsigned int      streamOffset;
+    unsigned int      streamCount;
+    /// 格式（容器）级别的 [MediaxxInfoTag] 数组
+    unsigned int      tagOffset;
+    unsigned int      tagCount;
+    long long         startTime;
+    /// 秒
+    double            duration;
+    /// 文件大小，未知时为 -1
+    long long         size;
+    long long         bitRate;
+    int               probeScore;
+    unsigned int      nbPrograms;
+    unsigned int      nbStreamGroups;
+    unsigned int      reserved;
+    MediaxxInfoString filename;
+    MediaxxInfoString formatName;
+    /// [MEDIAXX_FIELD_NORM_TAGS]：[MediaxxInfoNormTag] 数组
+    unsigned int      normTagOffset;
+    unsigned int      normTagCount;
+    /// 值被截断的标签：[MediaxxInfoTruncatedTag] 数组
+    unsigned int      truncatedTagOffset;
+    unsigned int      truncatedTagCount;
+} MediaxxInfoHeader;
+
+/// # 二进制格式的批量结果中的一项
+/// - 与 json 的 `{"index", "path", "ret", "info", "log"}` 对应
+typedef struct MediaxxInfoBatchEntry {
+    unsigned int      index;
+    int               ret;
+    /// 该项的 [MediaxxInfoHeader] 相对于 [MediaxxInfoBatchHeader] 开头的偏移，失败时为 0；
+    /// 其中的偏移仍相对于 [MediaxxInfoHeader] 自身
+    unsigned int      infoOffset;
+    unsigned int      infoSize;
+    MediaxxInfoString path;
+    MediaxxInfoString log;
+} MediaxxInfoBatchEntry;
+
+/// # 二进制格式的批量结果
+/// - 布局：[MediaxxInfoBatchHeader] | [MediaxxInfoBatchEntry] 数组 | 各项的 [MediaxxInfoHeader] | 字符串
+typedef struct MediaxxInfoBatchHeader {
+    /// [MEDIAXX_INFO_BATCH_MAGIC]
+    unsigned int   magic;
+    unsigned short version;
+    unsigned short headerSize;
+    unsigned int   totalSize;
+    unsigned int   entrySize;
+    unsigned int   entryOffset;
+    unsigned int   entryCount;
+} MediaxxInfoBatchHeader;
+
+/// # 字典格式的批量结果中的一项
+/// - 只有媒体库列表需要的字段；`unsigned int` 的字符串字段为字典中的编号，0 表示不存在
+typedef struct MediaxxInfoDictEntry {
+    unsigned int index;
+    int          ret;
+    unsigned int path;
+    unsigned int log;
+    unsigned int formatName;
+    /// 第一个音频流的编码名称
+    unsigned int audioCodec;
+    /// 第一个视频流的编码名称；音频文件的封面也是视频流，如 `mjpeg`
+    unsigned int videoCodec;
+    int          sampleRate;
+    int          channels;
+    int          bitsPerSample;
+    int          width;
+    int          height;
+    /// 该项的 [MediaxxInfoDictTag] 数组，需要请求 [MEDIAXX_FIELD_NORM_TAGS]
+    unsigned int tagOffset;
+    unsigned int tagCount;
+    /// 文件大小，未知时为 -1
+    long long    size;
+    long long    bitRate;
+    /// 秒
+    double       duration;
+} MediaxxInfoDictEntry;
+
+/// # 字典格式的规范化标签，同 [MediaxxInfoNormTag]
+typedef struct MediaxxInfoDictTag {
+    /// [MEDIAXX_TAG_TITLE] 等
+    unsigned int key;
+    /// 字典中的编号
+    unsigned int value;
+} MediaxxInfoDictTag;
+
+/// # 字典格式的批量结果
+/// - 布局：[MediaxxInfoDictHeader] | [MediaxxInfoDictEntry] 数组 | [MediaxxInfoDictTag] 数组 |
+///   字典（[MediaxxInfoString] 数组）| 字符串
+/// - 整批中相同的字符串（艺术家、专辑、流派、编码名称等）只存储一份，编号为在字典中的下标；
+///   编号 0 为空，表示不存在
+/// - 所有偏移都相对于本结构体的开头
+typedef struct MediaxxInfoDictHeader {
+    /// [MEDIAXX_INFO_DICT_MAGIC]
+    unsigned int   magic;
+    unsigned short version;
+    unsigned short headerSize;
+    unsigned int   totalSize;
+    unsigned int   entrySize;
+    unsigned int   entryOffset;
+    unsigned int   entryCount;
+    unsigned int   tagOffset;
+    unsigned int   tagCount;
+    unsigned int   stringOffset;
+    unsigned int   stringCount;
+} MediaxxInfoDictHeader;
+
+/// [MediaxxDiagRecord.stage]：出错的阶段
+#define MEDIAXX_DIAG_STAGE_OPEN        1
+#define MEDIAXX_DIAG_STAGE_STREAM_INFO 2
+#define MEDIAXX_DIAG_STAGE_PICTURE     3
+#define MEDIAXX_DIAG_STAGE_MANIFEST    4
+#define MEDIAXX_DIAG_STAGE_BATCH       5
+#define MEDIAXX_DIAG_STAGE_AUDIO       6
+#define MEDIAXX_DIAG_STAGE_CLIP        7
+
+/// [MediaxxDiagRecord.code]：错误类型
+#define MEDIAXX_DIAG_ERR_CANCELLED        1
+#define MEDIAXX_DIAG_ERR_NO_PATH          2
+#define MEDIAXX_DIAG_ERR_NO_MEMORY        3
+#define MEDIAXX_DIAG_ERR_OPEN             4
+#define MEDIAXX_DIAG_ERR_READ             5
+#define MEDIAXX_DIAG_ERR_STREAM_INFO      6
+#define MEDIAXX_DIAG_ERR_UNKNOWN_MANIFEST 7
+#define MEDIAXX_DIAG_ERR_NO_DECODER       8
+#define MEDIAXX_DIAG_ERR_DECODER_OPEN     9
+#define MEDIAXX_DIAG_ERR_DECODE           10
+#define MEDIAXX_DIAG_ERR_NO_AUDIO         11
+#define MEDIAXX_DIAG_ERR_WRITE            12
+#define MEDIAXX_DIAG_ERR_NO_ENCODER       13
+#define MEDIAXX_DIAG_ERR_ENCODE           14
+
+/// # 结构化的错误记录
+/// - 出错时只写入定长记录，不分配内存；需要文字时由 [mediaxx_diag_format_malloc] 格式化
+typedef struct MediaxxDiagRecord {
+    /// 系统时间，微秒
+    long long      timeUs;
+    /// ffmpeg 的 AVERROR，没有时为 0
+    int            avError;
+    /// 相关的流下标，没有时为 -1
+    int            streamIndex;
+    /// 产生记录的线程编号；同一线程的记录按产生顺序取出
+    unsigned int   threadId;
+    /// [MEDIAXX_DIAG_STAGE_OPEN] 等
+    unsigned short stage;
+    /// [MEDIAXX_DIAG_ERR_CANCELLED] 等
+    unsigned short code;
+    /// 相关的路径/地址，过长时只保留末尾；以 '\0' 结尾
+    char           subject[104];
+} MediaxxDiagRecord;
+
+/// # 结果和日志在同一块内存中的返回值
+/// - 由 `*_block_malloc` 接口返回，整块只需调用一次 [mediaxx_free]
+/// - 布局：[MediaxxResultBlock] | 结果（8 字节对齐）| 日志
+typedef struct MediaxxResultBlock {
+    /// 同对应的 `*_malloc` 接口的返回值
+    int          ret;
+    /// 整块的长度，包含本结构体
+    unsigned int totalSize;
+    unsigned int resultSize;
+    unsigned int logSize;
+    /// 指向本块内部，以 '\0' 结尾；没有结果/日志时为空指针
+    const char*  result;
+    const char*  log;
+} MediaxxResultBlock;
+
+/// [mediaxx_batch_stream_start] 的任务，可组合
+#define MEDIAXX_STREAM_JOB_INFO    0x01
+/// 封面保存为 `{coverDir}/{index}.jpg` 和 `{coverDir}/{index}_96.jpg`
+#define MEDIAXX_STREAM_JOB_COVER   0x02
+/// 封面的主色调；需要先保存封面，[coverDir] 同样必要
+#define MEDIAXX_STREAM_JOB_PALETTE 0x04
+
+/// [MediaxxStreamRecord.kind]
+#define MEDIAXX_STREAM_KIND_INFO    1
+#define MEDIAXX_STREAM_KIND_COVER   2
+#define MEDIAXX_STREAM_KIND_PALETTE 3
+/// 最后一条记录，[MediaxxStreamRecord.ret] 为成功读取信息的数量
+#define MEDIAXX_STREAM_KIND_DONE    4
+
+/// # 流式批量结果中的一条记录
+/// - 与字符串在同一块内存中，处理完后调用 [mediaxx_free] 释放
+typedef struct MediaxxStreamRecord {
+    /// [MEDIAXX_STREAM_KIND_INFO] 等
+    int          kind;
+    /// 在输入列表中的下标；[MEDIAXX_STREAM_KIND_DONE] 时为 -1
+    int          index;
+    /// 信息：同 [mediaxx_get_media_info_ex_malloc]；封面：同 [mediaxx_get_media_picture_ex]；
+    /// 主色调：1 成功，0 失败
+    int          ret;
+    unsigned int resultSize;
+    /// 信息为 json 或二进制（见 [MediaxxRequestOptions.resultFormat]），8 字节对齐；
+    /// 封面为完整封面的路径；主色调为 json；没有时为空指针
+    const char*  result;
+    const char*  path;
+    /// 该项自上一条记录以来的日志，没有时为空指针
+    const char*  log;
+} MediaxxStreamRecord;
+
+/// 在任务线程中调用；[record] 由调用方用 [mediaxx_free] 释放，处理完后调用 [mediaxx_batch_stream_ack]
+typedef void (*MediaxxStreamCallback)(void* userData, const MediaxxStreamRecord* record);
+
+/// [MediaxxLyricsHeader.source]：歌词来源
+#define MEDIAXX_LYRICS_SOURCE_NONE     0
+/// 内嵌的标签：ID3 USLT、Vorbis `LYRICS`、MP4 `©lyr` 等
+#define MEDIAXX_LYRICS_SOURCE_EMBEDDED 1
+/// ID3 SYLT 同步歌词帧
+#define MEDIAXX_LYRICS_SOURCE_SYLT     2
+/// 同目录同名的 `.lrc` 文件
+#define MEDIAXX_LYRICS_SOURCE_SIDECAR  3
+/// [mediaxx_parse_lyrics_malloc] 传入的文本
+#define MEDIAXX_LYRICS_SOURCE_TEXT     4
+
+/// 歌词二进制结果的标识，内存中的字节为 "MXLY"
+#define MEDIAXX_LYRICS_MAGIC   0x594C584D
+#define MEDIAXX_LYRICS_VERSION 1
+
+/// # 一行带时间的歌词
+typedef struct MediaxxLyricsLine {
+    /// 毫秒，已应用 [MediaxxLyricsHeader.offsetMs]
+    unsigned int      timeMs;
+    /// 空行（常用于标记上一行结束）时不存在
+    MediaxxInfoString text;
+} MediaxxLyricsLine;
+
+/// # 二进制格式的歌词
+/// - 布局：[MediaxxLyricsHeader] | [MediaxxLyricsLine] 数组 | 字符串
+/// - 行按 [MediaxxLyricsLine.timeMs] 升序排列，时间相同时保持原文顺序（如翻译行），
+///   播放时二分查找当前行
+/// - 一行有多个时间戳时展开为多行，共用同一个字符串
+/// - 偏移都相对于本结构体的开头，字符串规则同 [MediaxxInfoString]
+typedef struct MediaxxLyricsHeader {
+    /// [MEDIAXX_LYRICS_MAGIC]
+    unsigned int      magic;
+    /// [MEDIAXX_LYRICS_VERSION]
+    unsigned short    version;
+    /// sizeof(MediaxxLyricsHeader)
+    unsigned short    headerSize;
+    unsigned int      totalSize;
+    /// [MEDIAXX_LYRICS_SOURCE_NONE] 等
+    int               source;
+    /// LRC `[offset:]` 的值，正数表示提前显示
+    int               offsetMs;
+    /// sizeof(MediaxxLyricsLine)，遍历行时的步长
+    unsigned int      lineSize;
+    unsigned int      lineOffset;
+    /// 为 0 时歌词没有时间，全文见 [plainText]
+    unsigned int      lineCount;
+    MediaxxInfoString plainText;
+    /// LRC 的 `[ti:]`、`[ar:]`、`[al:]`、`[by:]`
+    MediaxxInfoString title;
+    MediaxxInfoString artist;
+    MediaxxInfoString album;
+    MediaxxInfoString by;
+} MediaxxLyricsHeader;
+
+#define MEDIAXX_WAVEFORM_MAGIC      0x5657584D
+#define MEDIAXX_WAVEFORM_VERSION    1
+/// [MediaxxWaveformHeader.levels] 的容量
+#define MEDIAXX_WAVEFORM_MAX_LEVELS 16
+
+/// # 波形中的一个点：一段采样的范围和响度
+/// - 已混为单声道，[min]、[max] 为 -127~127 对应 -1.0~1.0，[rms] 为 0~255 对应 0~1.0
+typedef struct MediaxxWaveformPoint {
+    signed char   min;
+    signed char   max;
+    unsigned char rms;
+    unsigned char reserved;
+} MediaxxWaveformPoint;
+
+/// # 波形的一级精度
+typedef struct MediaxxWaveformLevel {
+    /// 每个点对应的采样数，下一级为本级的 2 倍
+    unsigned int samplesPerPoint;
+    unsigned int pointCount;
+    /// [MediaxxWaveformPoint] 数组相对于文件开头的偏移
+    unsigned int pointOffset;
+} MediaxxWaveformLevel;
+
+/// # 波形文件，由 [mediaxx_get_audio_visualization] 生成
+/// - 布局：[MediaxxWaveformHeader] | 第 0 级的 [MediaxxWaveformPoint] 数组 | 第 1 级的 | ...
+/// - 第 0 级最精细，之后每级的点数减半，直到不超过 1024 个点；绘制时选择点数略多于像素数的一级
+/// - 可以整个映射到内存后直接读取
+typedef struct MediaxxWaveformHeader {
+    /// [MEDIAXX_WAVEFORM_MAGIC]
+    unsigned int         magic;
+    /// [MEDIAXX_WAVEFORM_VERSION]
+    unsigned short       version;
+    /// sizeof(MediaxxWaveformHeader)
+    unsigned short       headerSize;
+    unsigned int         totalSize;
+    unsigned int         sampleRate;
+    /// 源的声道数
+    unsigned int         channels;
+    unsigned int         levelCount;
+    /// 解码得到的总采样数（每声道）
+    unsigned long long   totalSamples;
+    MediaxxWaveformLevel levels[MEDIAXX_WAVEFORM_MAX_LEVELS];
+} MediaxxWaveformHeader;
+
+#define MEDIAXX_SPECTRUM_MAGIC   0x5053584D
+#define MEDIAXX_SPECTRUM_VERSION 1
+
+/// # 频谱分析的参数，都为 0 时使用默认值
+typedef struct MediaxxSpectrumOptions {
+    /// 分析前重采样到的采样率，0 为 22050，< 0 为源的采样率；降低采样率可以加快分析，
+    /// 能分析的最高频率为其一半
+    int   sampleRate;
+    /// FFT 长度，0 为 2048；不是 2 的幂时向上取整，范围 64 ~ 32768
+    int   fftSize;
+    /// 相邻两帧间隔的采样数，0 为 [fftSize] 的一半（50% 重叠）
+    int   hopSize;
+    /// 频带数，0 为 64，不超过 [fftSize] 的一半
+    int   bandCount;
+    /// 频带的频率范围（Hz），按对数均分；0 分别为 20 和采样率的一半
+    float minFreq;
+    float maxFreq;
+} MediaxxSpectrumOptions;
+
+/// # 频谱文件，由 [mediaxx_get_audio_spectrum] 生成
+/// - 布局：[MediaxxSpectrumHeader] | 频带边界 | 各帧的频带能量
+/// - 第 i 帧的中心时间为 (i * [hopSize] + [fftSize] / 2) / [sampleRate] 秒
+typedef struct MediaxxSpectrumHeader {
+    /// [MEDIAXX_SPECTRUM_MAGIC]
+    unsigned int   magic;
+    /// [MEDIAXX_SPECTRUM_VERSION]
+    unsigned short version;
+    /// sizeof(MediaxxSpectrumHeader)
+    unsigned short headerSize;
+    unsigned int   totalSize;
+    unsigned int   sampleRate;
+    unsigned int   fftSize;
+    unsigned int   hopSize;
+    unsigned int   bandCount;
+    unsigned int   frameCount;
+    /// 能量的量化范围（dBFS）：0 对应 [minDb] 及以下，255 对应 [maxDb]，线性插值
+    float          minDb;
+    float          maxDb;
+    /// 频带边界（Hz），[bandCount] + 1 个 float，第 i 个频带为 [i, i + 1)
+    unsigned int   bandEdgeOffset;
+    /// [frameCount] * [bandCount] 个 unsigned char，按帧依次排列
+    unsigned int   dataOffset;
+} MediaxxSpectrumHeader;
+
+#define MEDIAXX_VISUALIZER_MAX_BANDS 128
+
+/// # 实时可视化的参数，除 [sampleRate]、[channels] 外为 0 时使用默认值
+typedef struct MediaxxVisualizerOptions {
+    /// 推入的 PCM 的采样率，必要
+    int   sampleRate;
+    /// 推入的 PCM 的声道数，必要，1 ~ 8
+    int   channels;
+    /// FFT 长度，0 为 1024；不是 2 的幂时向上取整，范围 64 ~ 8192
+    int   fftSize;
+    /// 频带数，0 为 32，不超过 [MEDIAXX_VISUALIZER_MAX_BANDS] 和 [fftSize] 的一半
+    int   bandCount;
+    /// 每秒分析的次数，0 为 60，范围 1 ~ 240
+    int   frameRate;
+    /// 环形缓冲区能容纳的时长（毫秒），0 为 500；分析线程跟不上时超出的部分被丢弃
+    int   bufferMs;
+    /// 频带的频率范围（Hz），按对数均分；0 分别为 20 和采样率的一半
+    float minFreq;
+    float maxFreq;
+} MediaxxVisualizerOptions;
+
+/// # 实时可视化的一次分析结果
+typedef struct MediaxxVisualizerSnapshot {
+    /// 每次分析加 1，为 0 时还没有结果
+    unsigned long long sequence;
+    /// 分析窗口的末尾对应的已推入的帧数（每声道的采样数），可据此与播放位置对齐
+    unsigned long long position;
+    /// 距上一次分析推入的采样中，所有声道的峰值和 RMS，0 ~ 1.0
+    float              peak;
+    float              rms;
+    /// 本次分析的耗时（微秒）
+    int                analysisUs;
+    int                bandCount;
+    /// 前 [bandCount] 个有效，各频带的能量（dBFS），满幅的正弦波为 0
+    float              bands[MEDIAXX_VISUALIZER_MAX_BANDS];
+} MediaxxVisualizerSnapshot;
+
+/// # 指纹索引的一个匹配，见 [mediaxx_fingerprint_index_query]
+typedef struct MediaxxFingerprintMatch {
+    /// 插入时的曲目 id
+    long long id;
+    /// 0 ~ 1，对齐后相同的位的比例；不相关的音频一般在 0.5 ~ 0.65
+    float     similarity;
+    /// 该曲目相对查询的指纹的帧偏移，每帧约 124ms
+    int       offset;
+} MediaxxFingerprintMatch;
+
+/// # PCM 解码会话的参数，见 [mediaxx_decoder_get_info]
+typedef struct MediaxxDecoderInfo {
+    /// 输出的采样率和声道数，[mediaxx_decoder_read] 写入交错排列的 float
+    int       sampleRate;
+    int       channels;
+    /// 源的采样率和声道数
+    int       sourceSampleRate;
+    int       sourceChannels;
+    /// 按容器时长估计的总帧数（输出采样率），未知时为 0
+    long long estimatedFrames;
+    /// 下一次 [mediaxx_decoder_read] 的第一帧的序号
+    long long position;
+} MediaxxDecoderInfo;
+
 FFI_PLUGIN_EXPORT void* mediaxx_malloc(unsigned long long size);
 FFI_PLUGIN_EXPORT void  mediaxx_free(const void* ptr);
 
@@ -36,7 +622,10 @@ FFI_PLUGIN_EXPORT const char* mediaxx_get_label_malloc();
 /// 后这个参数才有效
 ///
 /// ## Return:
-/// - 返回 json 格式的音视频信息
+/// - 返回 json 格式的音视频信息；[mediaxx_get_media_info_ex_malloc] 可通过
+///   [MediaxxRequestOptions.resultFormat] 改为返回 [MediaxxInfoHeader] 开头的二进制数据
+/// - http(s) 的 HLS/DASH 播放列表（`.m3u8`/`.mpd`）直接解析，额外返回 `manifest` 字段（码率列表、分段数等），
+///   不会提取封面
 FFI_PLUGIN_EXPORT int mediaxx_get_media_info_malloc(
     const char*  filepath,
     const char*  headers,
@@ -64,6 +653,152 @@ FFI_PLUGIN_EXPORT int mediaxx_get_media_picture(
     const char** outLog
 );
 
+/// # 创建请求取消句柄
+/// - 通过 [MediaxxRequestOptions.cancelToken] 传给请求，可在任意线程调用
+/// [mediaxx_cancel_token_cancel] 取消
+/// - 需要在所有使用它的请求结束后，才能调用 [mediaxx_cancel_token_free] 释放
+FFI_PLUGIN_EXPORT void* mediaxx_cancel_token_create();
+
+FFI_PLUGIN_EXPORT void mediaxx_cancel_token_cancel(void* token);
+
+FFI_PLUGIN_EXPORT int mediaxx_cancel_token_is_cancelled(void* token);
+
+FFI_PLUGIN_EXPORT void mediaxx_cancel_token_free(void* token);
+
+/// # 获取音视频的信息和封面，支持取消和截止时间
+/// - 参数同 [mediaxx_get_media_info_malloc]
+/// - [options] 可选
+///
+/// ## Return:
+/// - 返回 -2 表示请求已取消或超时
+FFI_PLUGIN_EXPORT int mediaxx_get_media_info_ex_malloc(
+    const char*                  filepath,
+    const char*                  headers,
+    const char*                  pictureOutputPath,
+    const char*                  picture96OutputPath,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    const char**                 outLog
+);
+
+/// # 批量获取音视频的信息
+/// - 机械硬盘/网络存储上会按文件在磁盘上的位置排序后读取，减少寻道；
+///   并提前预读后续文件的头部和尾部
+/// - `http://` 地址在后台事件循环中并发读取，只拉取解析所需的头部和尾部
+///
+/// ## Args:
+/// - [pathsJson] 必要，json 字符串数组，文件路径列表
+/// - [order] 读取顺序：0 保持输入顺序，1 自动（仅机械硬盘/网络存储排序），2 总是排序
+/// - [options] 可选，[timeoutMs] 对每个文件单独计时，远程地址从开始连接时计时，排队的时间不计入；
+///   取消后不再读取剩余的文件
+///
+/// ## Return:
+/// - 返回成功读取的数量，参数错误返回 -1
+/// - [outResult] json 数组，每项为 `{"index", "path", "ret", "info", "log"}`，`index` 为在输入列表中的下标；
+///   本地文件按实际读取顺序排列，远程地址按完成顺序排在最后
+/// - [MediaxxRequestOptions.resultFormat] 为 [MEDIAXX_RESULT_FORMAT_BINARY] 时，[outResult] 为
+///   [MediaxxInfoBatchHeader] 开头的二进制数据，顺序同上
+/// - 为 [MEDIAXX_RESULT_FORMAT_DICT] 时，[outResult] 为 [MediaxxInfoDictHeader] 开头的二进制数据，
+///   顺序同上
+FFI_PLUGIN_EXPORT int mediaxx_get_media_info_batch_malloc(
+    const char*                  pathsJson,
+    const char*                  headers,
+    int                          order,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    const char**                 outLog
+);
+
+/// # 获取音视频的信息和封面，结果和日志在同一块内存中返回
+/// - 参数同 [mediaxx_get_media_info_ex_malloc]
+/// - 读取过程中的临时数据使用单次请求的 arena，结束时整体释放
+///
+/// ## Return:
+/// - [MediaxxResultBlock]，使用 [mediaxx_free] 释放；内存不足时返回空指针
+FFI_PLUGIN_EXPORT const MediaxxResultBlock* mediaxx_get_media_info_block_malloc(
+    const char*                  filepath,
+    const char*                  headers,
+    const char*                  pictureOutputPath,
+    const char*                  picture96OutputPath,
+    const MediaxxRequestOptions* options
+);
+
+/// # 批量获取音视频的信息，结果和日志在同一块内存中返回
+/// - 参数同 [mediaxx_get_media_info_batch_malloc]
+///
+/// ## Return:
+/// - [MediaxxResultBlock]，[MediaxxResultBlock.ret] 为成功读取的数量；使用 [mediaxx_free] 释放
+FFI_PLUGIN_EXPORT const MediaxxResultBlock* mediaxx_get_media_info_batch_block_malloc(
+    const char*                  pathsJson,
+    const char*                  headers,
+    int                          order,
+    const MediaxxRequestOptions* options
+);
+
+/// # 流式批量任务：每完成一项就通过 [callback] 投递一条记录
+/// - 在后台线程中按 [order] 读取（同 [mediaxx_get_media_info_batch_malloc]），函数立即返回
+/// - 已投递但未确认的记录达到 [maxPending]（<= 0 时为 16）时暂停，直到调用 [mediaxx_batch_stream_ack]
+/// - Dart 可使用 `NativeCallable.listener` 作为 [callback]，记录会投递到创建它的 isolate
+///
+/// ## Args:
+/// - [jobs] 必要，[MEDIAXX_STREAM_JOB_INFO] 等的组合
+/// - [coverDir] 包含封面或主色调任务时必要，已存在的目录
+/// - [options] 可选，内容会被复制；其中的取消句柄需要保持有效，直到 [mediaxx_batch_stream_free]
+///
+/// ## Return:
+/// - 任务句柄，用 [mediaxx_batch_stream_free] 释放；参数错误时返回空指针，原因见 [outLog]
+FFI_PLUGIN_EXPORT void* mediaxx_batch_stream_start(
+    const char*                  pathsJson,
+    const char*                  headers,
+    int                          order,
+    int                          jobs,
+    const char*                  coverDir,
+    const MediaxxRequestOptions* options,
+    int                          maxPending,
+    MediaxxStreamCallback        callback,
+    void*                        userData,
+    const char**                 outLog
+);
+
+/// # 确认已处理 [count] 条记录，允许继续投递
+FFI_PLUGIN_EXPORT void mediaxx_batch_stream_ack(void* stream, int count);
+
+/// # 停止并释放流式批量任务
+/// - 会等待正在处理的一项完成；返回后不再回调，已投递的记录仍需调用方释放
+FFI_PLUGIN_EXPORT void mediaxx_batch_stream_free(void* stream);
+
+/// # 取出诊断记录
+/// - 只有 [MEDIAXX_LOG_MODE_RECORD] 的请求写入记录
+/// - 每个线程的记录写入各自的无锁环形缓冲区，写满后丢弃新记录，见 [mediaxx_diag_dropped_count]
+/// - 已结束的线程最多保留 16 个缓冲区，超出时丢弃最早的，其中的记录也计入丢弃的数量
+/// - 取出后从缓冲区移除；可在任意线程调用
+///
+/// ## Return:
+/// - 写入 [outRecords] 的数量，最多 [capacity] 条
+FFI_PLUGIN_EXPORT int mediaxx_diag_drain(MediaxxDiagRecord* outRecords, int capacity);
+
+/// # 把诊断记录格式化为文字，每条一行
+FFI_PLUGIN_EXPORT const char*
+    mediaxx_diag_format_malloc(const MediaxxDiagRecord* records, int count);
+
+/// # 缓冲区写满而丢弃的记录总数
+FFI_PLUGIN_EXPORT unsigned long long mediaxx_diag_dropped_count();
+
+/// # 获取音视频的封面，支持取消和截止时间
+/// - 参数同 [mediaxx_get_media_picture]
+/// - [options] 可选
+///
+/// ## Return:
+/// - 返回 -2 表示请求已取消或超时
+FFI_PLUGIN_EXPORT int mediaxx_get_media_picture_ex(
+    const char*                  filepath,
+    const char*                  headers,
+    const char*                  pictureOutputPath,
+    const char*                  picture96OutputPath,
+    const MediaxxRequestOptions* options,
+    const char**                 outLog
+);
+
 FFI_PLUGIN_EXPORT int mediaxx_analyse_picture_color(
     const char*  filepath,
     const char*  data,
@@ -81,7 +816,477 @@ FFI_PLUGIN_EXPORT int mediaxx_analyse_picture_color_from_decoded_data(
 
 FFI_PLUGIN_EXPORT const char* mediaxx_get_available_hwcodec_list();
 
-FFI_PLUGIN_EXPORT int mediaxx_get_audio_visualization(const char* filepath, const char* output);
+/// # 生成音频的波形
+/// - 流式解码，内存占用与时长无关；多级精度，见 [MediaxxWaveformHeader]
+///
+/// ## Args:
+/// - [filepath] 必要，音视频文件路径
+/// - [outputPath] 必要，波形文件的输出路径，已存在时覆盖
+/// - [options] 可选，其中的 [MediaxxRequestOptions.fieldMask]、[MediaxxRequestOptions.resultFormat]、
+///   [MediaxxRequestOptions.maxTagSize] 无效
+///
+/// ## Return:
+/// - 1 成功，0 没有可解码的音频，-1 无法打开或无法写入输出文件，-2 请求已取消或超时
+FFI_PLUGIN_EXPORT int mediaxx_get_audio_visualization(
+    const char*                  filepath,
+    const char*                  headers,
+    const char*                  outputPath,
+    const MediaxxRequestOptions* options,
+    const char**                 outLog
+);
+
+/// # 生成音频的频谱图
+/// - 解码并重采样为单声道，加窗重叠做 FFT，按对数频率合并为频带后量化，见 [MediaxxSpectrumHeader]
+/// - 流式写入，内存占用与时长无关
+///
+/// ## Args:
+/// - [filepath] 必要，音视频文件路径
+/// - [outputPath] 必要，频谱文件的输出路径，已存在时覆盖
+/// - [spectrum] 可选，为空时全部使用默认值
+/// - [options] 可选，其中的 [MediaxxRequestOptions.fieldMask]、[MediaxxRequestOptions.resultFormat]、
+///   [MediaxxRequestOptions.maxTagSize] 无效
+///
+/// ## Return:
+/// - 同 [mediaxx_get_audio_visualization]
+FFI_PLUGIN_EXPORT int mediaxx_get_audio_spectrum(
+    const char*                   filepath,
+    const char*                   headers,
+    const char*                   outputPath,
+    const MediaxxSpectrumOptions* spectrum,
+    const MediaxxRequestOptions*  options,
+    const char**                  outLog
+);
+
+/// # 创建实时可视化
+/// - 播放器用 [mediaxx_visualizer_push] 把正在播放的 PCM 推入单生产者单消费者的无锁环形缓冲区
+/// - 分析线程按 [MediaxxVisualizerOptions.frameRate] 定时取出新的采样，对最近的 [fftSize] 个采样
+///   （混为单声道）做 FFT，结果写入三重缓冲区；窗口总是以最新的采样结尾，延迟不随积压增加
+/// - UI 用 [mediaxx_visualizer_poll] 取最新的结果，不加锁也不分配内存
+///
+/// ## Return:
+/// - 句柄，用 [mediaxx_visualizer_free] 释放；参数错误时返回空指针，原因见 [outLog]
+FFI_PLUGIN_EXPORT void* mediaxx_visualizer_create(
+    const MediaxxVisualizerOptions* options,
+    const char**                    outLog
+);
+
+/// # 推入 PCM
+/// - 只能在一个线程中调用（如播放器的音频回调），不加锁、不分配内存、不阻塞
+///
+/// ## Args:
+/// - [samples] 交错排列的 float，共 [frames] * [MediaxxVisualizerOptions.channels] 个
+///
+/// ## Return:
+/// - 实际写入的帧数；缓冲区已满时少于 [frames]，多余的被丢弃
+FFI_PLUGIN_EXPORT int mediaxx_visualizer_push(void* visualizer, const float* samples, int frames);
+
+/// # 丢弃已推入但还未分析的采样
+/// - 在推入的线程中调用，如跳转、切换曲目时；之后的结果只包含新推入的采样
+FFI_PLUGIN_EXPORT void mediaxx_visualizer_reset(void* visualizer);
+
+/// # 取最新的分析结果
+/// - 只能在一个线程中调用（如 UI 线程），不加锁、不分配内存
+///
+/// ## Return:
+/// - 1 有新的结果；0 没有新的结果，[outSnapshot] 为上一次的结果
+FFI_PLUGIN_EXPORT int
+    mediaxx_visualizer_poll(void* visualizer, MediaxxVisualizerSnapshot* outSnapshot);
+
+/// # 停止分析线程并释放
+/// - 调用前需要确保不再推入和获取结果
+FFI_PLUGIN_EXPORT void mediaxx_visualizer_free(void* visualizer);
+
+/// # 打开 PCM 解码会话
+/// - 解码文件的最佳音频流，经 libswresample 转为交错排列的 float，可以同时改变采样率和声道数
+/// - 拉取式：[mediaxx_decoder_read] 直接写入调用方的缓冲区，只有一帧放不下时才经过内部缓冲
+/// - 每个会话有独立的解复用和解码状态，不同会话可以在不同线程中同时使用；同一个会话不能同时调用
+///
+/// ## Args:
+/// - [sampleRate]、[channels] 输出的采样率和声道数，<= 0 时与源相同；声道数不同时混音
+/// - [options] 可选，[timeoutMs] 只限制打开；取消句柄对之后的读取和跳转也有效，
+///   需要保持有效直到 [mediaxx_decoder_free]
+///
+/// ## Return:
+/// - 会话句柄，用 [mediaxx_decoder_free] 释放；失败时返回空指针，原因见 [outLog]
+FFI_PLUGIN_EXPORT void* mediaxx_decoder_open(
+    const char*                  filepath,
+    const char*                  headers,
+    int                          sampleRate,
+    int                          channels,
+    const MediaxxRequestOptions* options,
+    const char**                 outLog
+);
+
+/// # 获取解码会话的参数和当前位置
+FFI_PLUGIN_EXPORT void mediaxx_decoder_get_info(void* decoder, MediaxxDecoderInfo* outInfo);
+
+/// # 读取 PCM
+///
+/// ## Args:
+/// - [dst] 交错排列的 float，至少 [frames] * [MediaxxDecoderInfo.channels] 个
+///
+/// ## Return:
+/// - 实际读取的帧数，只有结束时才少于 [frames]；0 表示已结束
+/// - -1 读取失败，-2 已取消；错误写入诊断记录，见 [mediaxx_diag_drain]
+FFI_PLUGIN_EXPORT int mediaxx_decoder_read(void* decoder, float* dst, int frames);
+
+/// # 跳转到第 [frame] 帧（输出采样率下的序号），精确到采样
+///
+/// ## Return:
+/// - 1 成功；0 不能跳转，之后从原来的位置继续读取；-2 已取消
+FFI_PLUGIN_EXPORT int mediaxx_decoder_seek(void* decoder, long long frame);
+
+/// # 关闭解码会话
+FFI_PLUGIN_EXPORT void mediaxx_decoder_free(void* decoder);
+
+/// # 批量扫描响度（EBU R128），计算 ReplayGain 2.0 的曲目增益和专辑增益
+/// - 以源的采样率和声道数解码，计算综合响度、响度范围、采样峰值和真峰值
+/// - 多个文件在线程池中并行扫描；文件数少于线程数时，空闲的线程分给解码器做帧/切片多线程
+/// - 专辑的综合响度由专辑内所有曲目的门限块合并计算，不是各曲目响度的平均
+///
+/// ## Args:
+/// - [pathsJson] 必要，json 字符串数组，文件路径列表
+/// - [albumsJson] 可选，与 [pathsJson] 等长的 json 字符串数组，相同的非空字符串为同一专辑；
+///   为空指针时不计算专辑增益
+/// - [threadCount] 并行的线程数，<= 0 为 CPU 核心数
+/// - [options] 可选，[timeoutMs] 对每个文件单独计时；取消后剩余的文件返回 -2
+///
+/// ## Return:
+/// - 返回成功扫描的数量，参数错误返回 -1
+/// - [outResult] json 对象 `{"reference", "tracks", "albums"}`，`reference` 为参考响度（-18 LUFS）
+///   - `tracks` 按输入顺序，每项为 `{"index", "path", "ret", "loudness", "log"}`，`ret` 同
+///     [mediaxx_get_audio_visualization]；`loudness` 只在成功时存在，可以直接合并到缓存的音视频信息中：
+///     `integrated`（LUFS）、`range`（LU）、`sample_peak`、`true_peak`（线性）、
+///     `replaygain_track_gain`（dB）、`replaygain_track_peak`，属于专辑时还有 `album`、
+///     `replaygain_album_gain`、`replaygain_album_peak`；静音或过短时没有响度和增益
+///   - `albums` 每项为 `{"key", "count", "integrated", "range", "true_peak", "replaygain_album_gain"}`
+FFI_PLUGIN_EXPORT int mediaxx_scan_loudness_malloc(
+    const char*                  pathsJson,
+    const char*                  albumsJson,
+    const char*                  headers,
+    int                          threadCount,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    const char**                 outLog
+);
+
+/// # 批量检测节拍（BPM）和调性
+/// - 每个文件只解码中间的 60s（跳转到中间，时长未知或不能跳转时从头开始），重采样为 11025Hz 单声道，
+///   开销与曲目时长无关，可以在后台扫描媒体库时使用
+/// - 节拍范围为 60~200 BPM，倍速/半速的歧义按 120 BPM 附近优先；调性为 24 个大小调之一
+/// - 多个文件在线程池中并行分析
+///
+/// ## Args:
+/// - [pathsJson] 必要，json 字符串数组，文件路径列表
+/// - [threadCount] 并行的线程数，<= 0 为 CPU 核心数
+/// - [options] 可选，[timeoutMs] 对每个文件单独计时；取消后剩余的文件返回 -2
+///
+/// ## Return:
+/// - 返回成功分析的数量，参数错误返回 -1
+/// - [outResult] json 数组，按输入顺序，每项为 `{"index", "path", "ret", "rhythm", "log"}`，`ret` 同
+///   [mediaxx_get_audio_visualization]；`rhythm` 只在成功时存在，可以直接合并到缓存的音视频信息中：
+///   - `bpm`（保留一位小数）、`bpm_confidence`（0~1），无法确定节拍（如过短）时没有
+///   - `key`（如 `A minor`）、`key_index`（0~11 为 C~B 大调，12~23 为 C~B 小调）、`camelot`（如 `8A`）、
+///     `key_confidence`（0~1），无法确定调性（如静音）时没有
+FFI_PLUGIN_EXPORT int mediaxx_scan_rhythm_malloc(
+    const char*                  pathsJson,
+    const char*                  headers,
+    int                          threadCount,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    const char**                 outLog
+);
+
+/// # 批量检测首尾的静音
+/// - 信息中的 `initial_padding`/`trailing_padding` 只是编码器的填充，这里是实际听不到的部分，
+///   用于无缝播放和淡入淡出
+/// - 以源的采样率解码，任一声道的采样绝对值超过阈值即为有声；只解码开头和结尾的 [windowMs]，
+///   结尾通过跳转到达，不解码中间部分；结尾的窗口全是静音时向前扩大窗口补读
+/// - 多个文件在线程池中并行检测
+///
+/// ## Args:
+/// - [pathsJson] 必要，json 字符串数组，文件路径列表
+/// - [thresholdDb] 阈值（dBFS），>= 0 时为 -60
+/// - [windowMs] 开头和结尾各解码的时长，<= 0 时为 10000
+/// - [threadCount] 并行的线程数，<= 0 为 CPU 核心数
+/// - [options] 可选，[timeoutMs] 对每个文件单独计时；取消后剩余的文件返回 -2
+///
+/// ## Return:
+/// - 返回成功检测的数量，参数错误返回 -1
+/// - [outResult] json 数组，按输入顺序，每项为 `{"index", "path", "ret", "silence", "log"}`，`ret` 同
+///   [mediaxx_get_audio_visualization]；`silence` 只在成功时存在：
+///   - `sample_rate`、`total_frames`（解码得到的总帧数，每声道的采样数）
+///   - `audio_start`（第一个有声的帧）、`audio_end`（最后一个有声的帧之后的一帧）、
+///     `leading_silence`、`trailing_silence`（秒，精确到毫秒）；全部是静音时没有，而是 `"silent": true`
+FFI_PLUGIN_EXPORT int mediaxx_scan_silence_malloc(
+    const char*                  pathsJson,
+    const char*                  headers,
+    float                        thresholdDb,
+    int                          windowMs,
+    int                          threadCount,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    const char**                 outLog
+);
+
+/// # 批量扫描 MP3/ADTS AAC 的精确时长和无缝播放信息
+/// - 没有 Xing/VBRI 头的 VBR MP3、裸 ADTS 流，信息中的 `duration` 按码率估算，误差可达数秒；
+///   这里逐个解析帧头累计采样数，不解码，开销约为顺序读一遍文件
+/// - 读取 LAME 标签（或 ID3v2 的 iTunSMPB 注释）中编码器的延迟和填充，用于无缝播放
+/// - 只支持本地文件；多个文件在线程池中并行扫描
+///
+/// ## Args:
+/// - [pathsJson] 必要，json 字符串数组，文件路径列表
+/// - [threadCount] 并行的线程数，<= 0 为 CPU 核心数
+/// - [options] 可选，[timeoutMs] 对每个文件单独计时；取消后剩余的文件返回 -2
+///
+/// ## Return:
+/// - 返回成功扫描的数量，参数错误返回 -1
+/// - [outResult] json 数组，按输入顺序，每项为 `{"index", "path", "ret", "exact", "log"}`，`ret` 为
+///   1 成功，0 不是 MP3/ADTS 流，-1 无法打开，-2 已取消；`exact` 只在成功时存在：
+///   - `format`（`mp3` 或 `aac`）、`sample_rate`、`channels`
+///   - `frames`（音频帧数，不含 Xing/Info/VBRI 信息帧）、`samples`（所有帧解码得到的每声道采样数）
+///   - `valid_samples`（去掉延迟和填充后的采样数，即原始音频的长度）、`duration`（秒）
+///   - `encoder_delay`、`encoder_padding`、`gapless_source`（`lame` 或 `itunsmpb`），文件中没有记录时没有
+///   - `header_frames`：Xing/VBRI 头记录的帧数，与 `frames` 不同说明文件被截断或拼接过
+///   - `skipped_bytes`：帧之间无法识别的字节数，没有时不存在
+FFI_PLUGIN_EXPORT int mediaxx_scan_exact_duration_malloc(
+    const char*                  pathsJson,
+    int                          threadCount,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    const char**                 outLog
+);
+
+/// # 提取片段
+/// - 从 [startMs] 开始截取 [durationMs] 写入 [outputPath]，输出的容器按扩展名选择（如 `.m4a`、`.mp3`、
+///   `.mkv`）；直接复制数据包，不解码也不编码，开销与片段的字节数相当，可以在 UI 线程外用于预览、分享
+/// - 从起点之前最近的关键帧开始（只有音频时为包含起点的帧），实际的起点和时长见结果
+/// - 只复制输出容器支持的音频和视频流；封面、字幕和数据流跳过
+/// - [accurate] 非 0 且输出中没有视频时，改为精确到采样地解码后重新编码：优先使用源的编码，
+///   没有该编码器或容器不支持时使用容器默认的音频编码；有视频时忽略（视频只能从关键帧开始）
+///
+/// ## Args:
+/// - [outputPath] 必要，本地路径，已存在时覆盖
+/// - [startMs] 起点，< 0 为 0
+/// - [durationMs] 时长，必须 > 0
+/// - [options] 可选，其中的 [MediaxxRequestOptions.fieldMask]、[MediaxxRequestOptions.resultFormat]、
+///   [MediaxxRequestOptions.maxTagSize] 无效
+///
+/// ## Return:
+/// - 同 [mediaxx_get_audio_visualization]，起点超出时长时返回 0；失败时不保留本次创建的输出文件
+/// - [outResult] 成功时为 json 对象 `{"start", "duration", "packets", "reencoded"}`：实际的起点和时长
+///   （秒，相对源的开头）、写入的数据包数、音频是否重新编码
+FFI_PLUGIN_EXPORT int mediaxx_extract_clip_malloc(
+    const char*                  filepath,
+    const char*                  headers,
+    const char*                  outputPath,
+    long long                    startMs,
+    long long                    durationMs,
+    int                          accurate,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    const char**                 outLog
+);
+
+/// # 从解码会话提取片段
+/// - 同 [mediaxx_extract_clip_malloc]，直接使用 [mediaxx_decoder_open] 已打开的解复用器，
+///   不再重新打开和探测文件，适合播放中的曲目
+/// - 结束后跳转回原来的位置，之后的 [mediaxx_decoder_read] 不受影响；不能与会话的其他调用同时进行
+/// - 取消句柄沿用打开会话时的 [MediaxxRequestOptions.cancelToken]
+///
+/// ## Return:
+/// - 同 [mediaxx_extract_clip_malloc]；本次的错误写入 [outLog]，不写入诊断记录
+FFI_PLUGIN_EXPORT int mediaxx_decoder_extract_clip_malloc(
+    void*        decoder,
+    const char*  outputPath,
+    long long    startMs,
+    long long    durationMs,
+    int          accurate,
+    const char** outResult,
+    const char** outLog
+);
+
+/// # 生成声学指纹
+/// - 从开头解码 [seconds] 秒，重采样为 11025Hz 单声道，由色度图上的 16 个滤波器得到每帧（约 124ms）
+///   一个 32 位哈希；与 Chromaprint 同类的算法，但结果不兼容
+/// - 同一录音的不同格式、码率、音量的文件，指纹大部分相同，用于查找重复的曲目
+///
+/// ## Args:
+/// - [seconds] 解码的时长，<= 0 为 30，不超过 300
+/// - [options] 可选，其中的 [MediaxxRequestOptions.fieldMask]、[MediaxxRequestOptions.resultFormat]、
+///   [MediaxxRequestOptions.maxTagSize] 无效
+///
+/// ## Return:
+/// - 同 [mediaxx_get_audio_visualization]，没有可解码的音频或过短（约 2s 以内）时返回 0
+/// - [outResult] 为 [outCount] 个 unsigned int 的数组，成功时才有；可以保存下来，下次启动时重新插入索引
+/// - [outCount] 哈希的个数，失败时为 0
+FFI_PLUGIN_EXPORT int mediaxx_get_fingerprint_malloc(
+    const char*                  filepath,
+    const char*                  headers,
+    int                          seconds,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    int*                         outCount,
+    const char**                 outLog
+);
+
+/// # 比较两个指纹
+///
+/// ## Return:
+/// - 相似度，同 [MediaxxFingerprintMatch.similarity]；重叠部分过短时为 0
+/// - [outOffset] 可选，[b] 相对 [a] 的帧偏移
+FFI_PLUGIN_EXPORT float mediaxx_fingerprint_compare(
+    const unsigned int* a,
+    int                 aCount,
+    const unsigned int* b,
+    int                 bCount,
+    int*                outOffset
+);
+
+/// # 创建指纹索引
+/// - 内存中的倒排索引，扫描时每得到一个指纹就用 [mediaxx_fingerprint_index_add] 插入
+/// - 查询只与指纹长度和命中的条目数有关，10 万首曲目时一般在 1ms 以内
+/// - 插入、移除和查询可以在不同线程中同时调用
+///
+/// ## Return:
+/// - 句柄，用 [mediaxx_fingerprint_index_free] 释放
+FFI_PLUGIN_EXPORT void* mediaxx_fingerprint_index_create();
+
+/// # 插入一个曲目的指纹
+/// - [id] 由调用方决定，如数据库中的主键；已存在时替换
+///
+/// ## Return:
+/// - 1 成功，0 指纹为空
+FFI_PLUGIN_EXPORT int mediaxx_fingerprint_index_add(
+    void*               index,
+    long long           id,
+    const unsigned int* hashes,
+    int                 count
+);
+
+/// # 移除一个曲目
+///
+/// ## Return:
+/// - 1 成功，0 不存在
+FFI_PLUGIN_EXPORT int mediaxx_fingerprint_index_remove(void* index, long long id);
+
+/// # 索引中的曲目数
+FFI_PLUGIN_EXPORT int mediaxx_fingerprint_index_size(void* index);
+
+/// # 查找与指纹匹配的曲目
+/// - 用索引中的曲目自己的指纹查询时，结果也包含它自己
+///
+/// ## Args:
+/// - [minSimilarity] 相似度的下限，<= 0 时为 0.75
+/// - [outMatches] 调用方分配的 [maxMatches] 个 [MediaxxFingerprintMatch]
+///
+/// ## Return:
+/// - 写入的匹配数，按相似度降序
+FFI_PLUGIN_EXPORT int mediaxx_fingerprint_index_query(
+    void*                    index,
+    const unsigned int*      hashes,
+    int                      count,
+    float                    minSimilarity,
+    MediaxxFingerprintMatch* outMatches,
+    int                      maxMatches
+);
+
+/// # 释放指纹索引
+FFI_PLUGIN_EXPORT void mediaxx_fingerprint_index_free(void* index);
+
+/// # 获取歌词
+/// - 依次尝试：内嵌的带时间戳的歌词（ID3 USLT、Vorbis `LYRICS`/`UNSYNCEDLYRICS`、MP4 `©lyr`）、
+///   ID3 SYLT 同步歌词、同目录同名的 `.lrc` 文件、内嵌的没有时间戳的歌词
+/// - SYLT 和 `.lrc` 只在本地文件上查找
+///
+/// ## Args:
+/// - [filepath] 必要，音视频文件路径
+/// - [options] 可选，其中的 [MediaxxRequestOptions.fieldMask] 和 [MediaxxRequestOptions.resultFormat] 无效
+///
+/// ## Return:
+/// - 1 找到歌词，0 没有歌词，-1 无法打开且没有 `.lrc` 文件，-2 请求已取消或超时
+/// - [outResult] 为 [MediaxxLyricsHeader] 开头的二进制数据，找到歌词时才有
+FFI_PLUGIN_EXPORT int mediaxx_get_lyrics_malloc(
+    const char*                  filepath,
+    const char*                  headers,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    const char**                 outLog
+);
+
+/// # 解析 LRC 歌词文本
+/// - 用于从其他来源（如网络）获取的歌词，[text] 为 UTF-8，可以带 BOM
+///
+/// ## Return:
+/// - 返回带时间的行数；[outResult] 同 [mediaxx_get_lyrics_malloc]，总是有结果
+FFI_PLUGIN_EXPORT int mediaxx_parse_lyrics_malloc(
+    const char*  text,
+    const size_t textSize,
+    const char** outResult
+);
+
+/// # 获取一个标签的完整内容
+/// - 用于信息中被截断的标签（见 [MediaxxRequestOptions.maxTagSize]）；只读取标签，不探测流
+///
+/// ## Args:
+/// - [filepath] 必要，音视频文件路径
+/// - [key] 必要，标签名，不区分大小写
+/// - [streamIndex] 流的下标，< 0 时为格式级别的标签
+/// - [options] 可选，其中的 [MediaxxRequestOptions.fieldMask]、[MediaxxRequestOptions.resultFormat]、
+///   [MediaxxRequestOptions.maxTagSize] 无效
+///
+/// ## Return:
+/// - 1 找到，0 没有该标签，-1 无法打开，-2 请求已取消或超时
+/// - [outResult] 为完整的标签值（UTF-8，GBK 等编码已转码），找到时才有
+FFI_PLUGIN_EXPORT int mediaxx_get_tag_malloc(
+    const char*                  filepath,
+    const char*                  headers,
+    const char*                  key,
+    int                          streamIndex,
+    const MediaxxRequestOptions* options,
+    const char**                 outResult,
+    const char**                 outLog
+);
+
+/// # 创建媒体库目录监听
+/// - 仅 Linux/Android 可用，基于 inotify；其他平台返回 nullptr
+///
+/// ## Return:
+/// - 返回监听句柄，需要使用 [mediaxx_library_watcher_free] 释放
+FFI_PLUGIN_EXPORT void* mediaxx_library_watcher_create(const char** outLog);
+
+/// # 添加需要监听的媒体库根目录
+/// - 会递归监听所有子目录；已有文件不会上报，由首次全量扫描负责
+///
+/// ## Return:
+/// - 返回是否成功
+FFI_PLUGIN_EXPORT int mediaxx_library_watcher_add_root(
+    void*        watcher,
+    const char*  rootPath,
+    const char** outLog
+);
+
+/// # 获取媒体库变更
+/// - 阻塞等待最多 [timeoutMs] 毫秒；有事件后继续收集，直到 [debounceMs] 内没有新事件
+///
+/// ## Args:
+/// - [probe] 非 0 时，对新增/修改的文件读取音视频信息，附加到结果的 `info` 字段
+///
+/// ## Return:
+/// - 返回变更数量，失败返回 -1
+/// - [outResult] json 数组，每项为 `{"type", "path", "is_dir", "ret", "info"}`；
+///   `type`: 0 需要全量扫描(事件溢出)，1 新增，2 修改，3 删除
+FFI_PLUGIN_EXPORT int mediaxx_library_watcher_poll_malloc(
+    void*        watcher,
+    int          timeoutMs,
+    int          debounceMs,
+    int          probe,
+    const char** outResult,
+    const char** outLog
+);
+
+FFI_PLUGIN_EXPORT void mediaxx_library_watcher_free(void* watcher);
 
 #if __cplusplus
 }
@@ -0,0 +1,321 @@
+#include "analyse/remote_probe.h"
+#include "mediaxx.h"
+#include "util/http_fetcher.h"
+#include <cassert>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#if _ISLINUX || _ISANDROID
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+    /// 8kHz 单声道 16 位的 WAV，比 [RemoteProbe_c::cHeadSize] 大，解析时需要拉取尾部
+    std::string makeWav() {
+        constexpr uint32_t cDataSize = 400 * 1024;
+        std::string        wav{};
+        const auto         put = [&wav](uint32_t value, int bytes) {
+            for (int i = 0; i < bytes; ++i) {
+                wav.push_back(char((value >> (8 * i)) & 0xFF));
+            }
+        };
+        wav.append("RIFF");
+        put(36 + cDataSize, 4);
+        wav.append("WAVEfmt ");
+        put(16, 4);
+        put(1, 2);
+        put(1, 2);
+        put(8000, 4);
+        put(16000, 4);
+        put(2, 2);
+        put(16, 2);
+        wav.append("data");
+        put(cDataSize, 4);
+        for (uint32_t i = 0; i < cDataSize; ++i) {
+            wav.push_back(char(i * 7));
+        }
+        return wav;
+    }
+
+    /// # 本地的 HTTP 测试服务器
+    /// - `/media.wav`、`/dir/media.wav` 支持范围请求
+    /// - `/norange.wav` 忽略 Range 返回 200，`/chunked.wav` 忽略 Range 并以 chunked 返回
+    /// - `/redirect` 跳转到 `/media.wav`，`/dir/relative` 以相对路径跳转到 `media.wav`，
+    ///   `/loop` 跳转到自身
+    class LocalHttpServer {
+    public:
+
+        std::string body = makeWav();
+
+        ~LocalHttpServer() {
+            stop();
+        }
+
+        /// 监听回环地址的随机端口，返回 `http://host:port`，失败时为空
+        std::string start(int family) {
+            fd = socket(family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd < 0) {
+                return {};
+            }
+            sockaddr_storage addr{};
+            socklen_t        len = 0;
+            if (family == AF_INET6) {
+                auto in6       = reinterpret_cast<sockaddr_in6*>(&addr);
+                in6->sin6_family = AF_INET6;
+                in6->sin6_addr   = in6addr_loopback;
+                len              = sizeof(sockaddr_in6);
+            } else {
+                auto in4             = reinterpret_cast<sockaddr_in*>(&addr);
+                in4->sin_family      = AF_INET;
+                in4->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                len                  = sizeof(sockaddr_in);
+            }
+            if (bind(fd, reinterpret_cast<sockaddr*>(&addr), len) != 0 || listen(fd, 64) != 0
+                || getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+                close(fd);
+                fd = -1;
+                return {};
+            }
+            const auto port = (family == AF_INET6)
+                                ? ntohs(reinterpret_cast<sockaddr_in6*>(&addr)->sin6_port)
+                                : ntohs(reinterpret_cast<sockaddr_in*>(&addr)->sin_port);
+            thread = std::thread{[this] {
+                while (true) {
+                    const int client = accept(fd, nullptr, nullptr);
+                    if (client < 0) {
+                        return;
+                    }
+                    serve(client);
+                    close(client);
+                }
+            }};
+            const auto host = (family == AF_INET6) ? std::string{"[::1]"} : "127.0.0.1";
+            return "http://" + host + ":" + std::to_string(port);
+        }
+
+        void stop() {
+            if (fd >= 0) {
+                shutdown(fd, SHUT_RDWR);
+                close(fd);
+                fd = -1;
+            }
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+
+    protected:
+
+        int         fd = -1;
+        std::thread thread{};
+
+        static void sendAll(int client, std::string_view data) {
+            while (false == data.empty()) {
+                const auto n = send(client, data.data(), data.size(), MSG_NOSIGNAL);
+                if (n <= 0) {
+                    return;
+                }
+                data.remove_prefix(size_t(n));
+            }
+        }
+
+        void serve(int client) {
+            std::string request{};
+            char        buffer[4096];
+            while (request.find("\r\n\r\n") == std::string::npos) {
+                const auto n = recv(client, buffer, sizeof(buffer), 0);
+                if (n <= 0) {
+                    return;
+                }
+                request.append(buffer, size_t(n));
+            }
+            const auto pathStart = request.find(' ') + 1;
+            const auto pathEnd   = request.find(' ', pathStart);
+            const auto path      = request.substr(pathStart, pathEnd - pathStart);
+
+            if (path == "/redirect" || path == "/dir/relative" || path == "/loop") {
+                const auto location = (path == "/redirect") ? "/media.wav"
+                                    : (path == "/loop")     ? "/loop"
+                                                            : "media.wav";
+                sendAll(
+                    client,
+                    std::string{"HTTP/1.1 302 Found\r\nLocation: "} + location
+                        + "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"
+                );
+                return;
+            }
+            if (path == "/chunked.wav") {
+                sendAll(
+                    client,
+                    "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\nConnection: close\r\n\r\n"
+                );
+                constexpr size_t cChunkSize = 1000;
+                for (size_t pos = 0; pos < body.size(); pos += cChunkSize) {
+                    const auto chunk = std::string_view{body}.substr(pos, cChunkSize);
+                    char       size[16];
+                    snprintf(size, sizeof(size), "%zx\r\n", chunk.size());
+                    sendAll(client, size);
+                    sendAll(client, chunk);
+                    sendAll(client, "\r\n");
+                }
+                sendAll(client, "0\r\n\r\n");
+                return;
+            }
+            if (path != "/media.wav" && path != "/dir/media.wav" && path != "/norange.wav") {
+                sendAll(client, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n");
+                return;
+            }
+
+            size_t     first = 0;
+            size_t     last  = body.size() - 1;
+            const auto range = request.find("Range: bytes=");
+            const bool ranged = (range != std::string::npos) && path != "/norange.wav";
+            if (ranged) {
+                const auto spec = request.c_str() + range + 13;
+                char*      end  = nullptr;
+                first           = strtoull(spec, &end, 10);
+                if (*end == '-' && end[1] >= '0' && end[1] <= '9') {
+                    last = std::min<size_t>(strtoull(end + 1, nullptr, 10), body.size() - 1);
+                }
+                if (first >= body.size()) {
+                    sendAll(
+                        client,
+                        "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */"
+                            + std::to_string(body.size()) + "\r\nContent-Length: 0\r\n\r\n"
+                    );
+                    return;
+                }
+            }
+            const auto  size   = last - first + 1;
+            std::string header = ranged ? "HTTP/1.1 206 Partial Content\r\n"
+                                        : "HTTP/1.1 200 OK\r\n";
+            if (ranged) {
+                header.append("Content-Range: bytes ")
+                    .append(std::to_string(first))
+                    .append("-")
+                    .append(std::to_string(last))
+                    .append("/")
+                    .append(std::to_string(body.size()))
+                    .append("\r\n");
+            }
+            header.append("Accept-Ranges: ")
+                .append(path == "/norange.wav" ? "none" : "bytes")
+                .append("\r\nContent-Type: audio/wav\r\nContent-Length: ")
+                .append(std::to_string(size))
+                .append("\r\nConnection: close\r\n\r\n");
+            sendAll(client, header);
+            sendAll(client, std::string_view{body}.substr(first, size));
+        }
+    };
+
+    HttpRangeResult fetchRange(const std::string& url, int64_t offset, int64_t length) {
+        auto             done = std::make_shared<std::promise<HttpRangeResult>>();
+        HttpRangeRequest request{};
+        request.url    = url;
+        request.offset = offset;
+        request.length = length;
+        request.interrupt.setTimeout(10000);
+        request.onDone = [done](HttpRangeResult&& result) { done->set_value(std::move(result)); };
+        auto future    = done->get_future();
+        HttpFetcher_c::instance.fetch(std::move(request));
+        return future.get();
+    }
+
+    RemoteProbeResult probeRemote(const std::string& url) {
+        auto             done = std::make_shared<std::promise<RemoteProbeResult>>();
+        RequestInterrupt interrupt{};
+        interrupt.setTimeout(10000);
+        RemoteProbe_c::instance.probe(
+            0,
+            url,
+            "",
+            interrupt,
+            false,
+            MEDIAXX_FIELD_ALL,
+            0,
+            [done](RemoteProbeResult&& result) { done->set_value(std::move(result)); }
+        );
+        return done->get_future().get();
+    }
+
+    void testRedirects(const std::string& base) {
+        auto result = fetchRange(base + "/redirect", 0, 64);
+        assert(result.error == 0);
+        assert(result.finalUrl == base + "/media.wav");
+
+        result = fetchRange(base + "/dir/relative", 0, 64);
+        assert(result.error == 0);
+        assert(result.finalUrl == base + "/dir/media.wav");
+
+        result = fetchRange(base + "/loop", 0, 64);
+        assert(result.error == -1);
+    }
+} // namespace
+
+void testHttpFetcher() {
+    std::cout << std::endl << "## HttpFetcher_c" << std::endl;
+    LocalHttpServer server{};
+    const auto      base = server.start(AF_INET);
+    assert(false == base.empty());
+    const auto& body = server.body;
+
+    // 范围请求
+    auto result = fetchRange(base + "/media.wav", 100, 50);
+    assert(result.error == 0 && result.status == 206);
+    assert(result.offset == 100 && result.data == body.substr(100, 50));
+    assert(result.totalSize == int64_t(body.size()));
+
+    // 超出末尾
+    result = fetchRange(base + "/media.wav", int64_t(body.size()) + 10, 50);
+    assert(result.error == 0 && result.status == 416 && result.data.empty());
+
+    // 服务器忽略 Range：丢弃前置的字节
+    result = fetchRange(base + "/norange.wav", 100, 50);
+    assert(result.error == 0 && result.status == 200);
+    assert(result.offset == 100 && result.data == body.substr(100, 50));
+    assert(result.totalSize == int64_t(body.size()));
+
+    // chunked：整个资源，以及跨块的范围
+    result = fetchRange(base + "/chunked.wav", 0, 0);
+    assert(result.error == 0 && result.data == body);
+    result = fetchRange(base + "/chunked.wav", 2500, 1200);
+    assert(result.error == 0 && result.data == body.substr(2500, 1200));
+
+    testRedirects(base);
+
+    result = fetchRange(base + "/missing", 0, 64);
+    assert(result.error == -1 && result.status == 404);
+
+    // 没有监听的端口：连接失败
+    const auto closedBase = base.substr(0, base.rfind(':')) + ":1";
+    result                = fetchRange(closedBase + "/media.wav", 0, 64);
+    assert(result.error == -1);
+
+    // IPv6 字面量：Host 头和重定向都需要方括号
+    LocalHttpServer server6{};
+    const auto      base6 = server6.start(AF_INET6);
+    if (base6.empty()) {
+        std::cout << "不支持 IPv6 回环地址，跳过" << std::endl;
+    } else {
+        testRedirects(base6);
+    }
+
+    // 远程探测：支持范围请求时拉取头部和尾部，否则回退到 ffmpeg
+    for (const auto* path : {"/media.wav", "/norange.wav"}) {
+        const auto probe = probeRemote(base + path);
+        std::cout << "RemoteProbe_c " << path << " ret: " << probe.ret << std::endl;
+        assert(probe.ret == 0);
+        assert(probe.info.find("\"wav\"") != std::string::npos);
+    }
+    std::cout << "HttpFetcher_c: ok" << std::endl;
+}
+
+#else
+
+void testHttpFetcher() {}
+
+#endif
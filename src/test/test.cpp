@@ -3,6 +3,7 @@ extern "C" {
 }
 
 #include "analyse/codec_info.h"
+#include "analyse/media_info_reader.h"
 #include "analyse/tool.h"
 #include "mediaxx.h"
 #include "simdjson.h"
@@ -13,6 +14,8 @@ extern "C" {
 
 using namespace std;
 
+void testHttpFetcher();
+
 void test() {
     {
         std::map<std::string, std::string> data{
@@ -43,6 +46,27 @@ void test() {
         assert(stringxx::utf8IsAvail("12 \xFC\xFD fd") == false);
     }
 
+    {
+        // 转码 GBK 标签时，前后的标签按原顺序保留
+        AVDictionary* metadata = nullptr;
+        av_dict_set(&metadata, "title", "clean", 0);
+        av_dict_set(&metadata, "artist", "\xD6\xDC\xBD\xDC\xC2\xD7 \xC6\xDF\xC0\xEF\xCF\xE3", 0);
+        av_dict_set(&metadata, "album", "tail", 0);
+        MediaInfoReader_c::repairTags(metadata);
+        const std::vector<std::pair<std::string, std::string>> expected{
+            {"title",  "clean"        },
+            {"artist", "周杰伦 七里香"},
+            {"album",  "tail"         },
+        };
+        std::vector<std::pair<std::string, std::string>> entries{};
+        const AVDictionaryEntry*                         tag = nullptr;
+        while ((tag = av_dict_get(metadata, "", tag, AV_DICT_IGNORE_SUFFIX))) {
+            entries.emplace_back(tag->key, tag->value);
+        }
+        assert(entries == expected);
+        av_dict_free(&metadata);
+    }
+
     mediaxx_set_log_level(AV_LOG_TRACE);
 
     auto result = mediaxx_get_available_hwcodec_list();
@@ -70,11 +94,10 @@ void test() {
     }
 
     {
-        const char* log     = nullptr;
-        auto        logItem = analyse_tool::AnalyseLogItem_c{&log};
-        auto result = analyse_tool::analysePictureColorFromPath("./temp/output.jpg", logItem);
-        if (nullptr != *logItem.log) {
-            std::cout << "log: " << *logItem.log << std::endl;
+        auto logItem = analyse_tool::AnalyseLogItem_c{nullptr};
+        auto result  = analyse_tool::analysePictureColorFromPath("./temp/output.jpg", logItem);
+        if (false == logItem.logView().empty()) {
+            std::cout << "log: " << logItem.logView() << std::endl;
         }
         if (nullptr != result) {
             std::cout << std::endl
@@ -96,12 +119,11 @@ void test() {
                       << "## analyzePictureColorFromData: " << file.good()
                       << " size:" << buffer.size() << std::endl;
             file.close();
-            const char* log     = nullptr;
-            auto        logItem = analyse_tool::AnalyseLogItem_c{&log};
-            auto        result
+            auto logItem = analyse_tool::AnalyseLogItem_c{nullptr};
+            auto result
                 = analyse_tool::analyzePictureColorFromData(buffer.data(), buffer.size(), logItem);
-            if (nullptr != *logItem.log) {
-                std::cout << "log: " << *logItem.log << std::endl;
+            if (false == logItem.logView().empty()) {
+                std::cout << "log: " << logItem.logView() << std::endl;
             }
             if (nullptr != result) {
                 std::cout << std::endl
@@ -144,6 +166,8 @@ void test() {
             std::cout << "无法打开文件进行二进制读取" << std::endl;
         }
     }
+
+    testHttpFetcher();
 }
 
 int main(int argn, char** argv) {